@@ -554,6 +554,9 @@
 /* Use input thread */
 #undef INPUTTHREAD
 
+/* Push shadow framebuffer updates from worker threads */
+#define SHADOW_THREADS 1
+
 /* Have poll() */
 #undef HAVE_POLL
 
@@ -92,6 +92,11 @@ extern int pcfReadFont ( FontPtr pFont, FontFilePtr file,
 			 int bit, int byte, int glyph, int scan );
 extern int pcfReadFontInfo ( FontInfoPtr pFontInfo, FontFilePtr file );
 extern int pcfWriteFont ( FontPtr pFont, FontFilePtr file );
+extern int pcfCacheReadFont ( FontPtr pFont, const char *fileName,
+			      int bit, int byte, int glyph, int scan );
+extern int pcfCacheReadFontInfo ( FontInfoPtr pFontInfo, const char *fileName,
+				  int bit, int byte, int glyph, int scan );
+extern void pcfCacheWriteFont ( FontPtr pFont, const char *fileName );
 extern void pcfError ( const char *, ... ) _X_ATTRIBUTE_PRINTF(1, 2);
 
 #endif				/* _PCF_H_ */
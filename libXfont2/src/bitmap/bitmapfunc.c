@@ -115,13 +115,9 @@ BitmapOpenBitmap (FontPathElementPtr fpe, FontPtr *ppFont, int flags,
 		image;
 
     i = BitmapGetRenderIndex(entry->u.bitmap.renderer);
-    file = FontFileOpen (fileName);
-    if (!file)
-	return BadFontName;
     if (!(pFont = CreateFontRec())) {
 	fprintf(stderr, "Error: Couldn't allocate pFont (%ld)\n",
 		(unsigned long)sizeof(FontRec));
-	FontFileClose (file);
 	return AllocError;
     }
     /* set up default values */
@@ -132,12 +128,31 @@ BitmapOpenBitmap (FontPathElementPtr fpe, FontPtr *ppFont, int flags,
     /* Fill in font record. Data format filled in by reader. */
     pFont->refcnt = 0;
 
+#if XFONT_PCFFORMAT
+    /* PCF fonts read before are mapped from the cache, if it is current */
+    if (readers[i].ReadFont == pcfReadFont &&
+	pcfCacheReadFont(pFont, fileName, bit, byte, glyph, scan) == Successful) {
+	*ppFont = pFont;
+	return Successful;
+    }
+#endif
+
+    file = FontFileOpen (fileName);
+    if (!file) {
+	free(pFont);
+	return BadFontName;
+    }
+
     ret = (*readers[i].ReadFont) (pFont, file, bit, byte, glyph, scan);
 
     FontFileClose (file);
     if (ret != Successful) {
 	free(pFont);
     } else {
+#if XFONT_PCFFORMAT
+	if (readers[i].ReadFont == pcfReadFont)
+	    pcfCacheWriteFont(pFont, fileName);
+#endif
 	*ppFont = pFont;
     }
     return ret;
@@ -156,6 +171,16 @@ BitmapGetInfoBitmap (FontPathElementPtr fpe, FontInfoPtr pFontInfo,
     if (!renderer)
 	return BadFontName;
     i = BitmapGetRenderIndex(renderer);
+#if XFONT_PCFFORMAT
+    if (readers[i].ReadInfo == pcfReadFontInfo) {
+	int bit, byte, glyph, scan;
+
+	FontDefaultFormat(&bit, &byte, &glyph, &scan);
+	if (pcfCacheReadFontInfo(pFontInfo, fileName,
+				 bit, byte, glyph, scan) == Successful)
+	    return Successful;
+    }
+#endif
     file = FontFileOpen (fileName);
     if (!file)
 	return BadFontName;
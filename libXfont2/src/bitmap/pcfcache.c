@@ -0,0 +1,782 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Cache of PCF fonts in the layout the reader produces
+ *
+ * Parsing a PCF font means decompressing it a byte at a time, decoding
+ * every metric field by field and copying all the glyphs to the heap, and
+ * every server pays for that again on each start.  Once a font has been
+ * read, it is therefore also written to a cache file holding its
+ * FontInfoRec, metrics, ink metrics, encoding and glyphs exactly as
+ * pcfReadFont would lay them out in memory for the requested bit, byte,
+ * glyph and scan format.  Later opens map that file and use the metrics
+ * and glyphs in place, so servers using the same fonts share the glyph
+ * pages.  The mapping is private: the glyph pointers in the metrics are
+ * stored as offsets from the start of the glyphs and relocated on load,
+ * which only copies the pages holding the metrics.
+ *
+ * A cache file is named after a hash of the font's path and the glyph
+ * format, and records the path, size and modification time of the font it
+ * was made from; it is ignored if any of them differ, if it was written
+ * by a build with a different memory layout, or if it fails any of the
+ * bounds checks below.  A stale file is simply replaced the next time the
+ * font is read.
+ *
+ * Files go in $XFONT_PCF_CACHE_DIR, or by default in libXfont2 under the
+ * user's cache directory.  Setting XFONT_PCF_CACHE_DIR to the empty
+ * string disables the cache, as does running setuid.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include "libxfontint.h"
+#include "src/util/replace.h"
+
+#include <X11/fonts/fntfilst.h>
+#include <X11/fonts/bitmap.h>
+#include <X11/fonts/pcf.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef WIN32
+#include <direct.h>
+#include <io.h>
+#include <process.h>
+#include "X11/Xwindows.h"
+#define mkdir(path, mode)	_mkdir(path)
+#define getpid()		_getpid()
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+#define PCF_CACHE_MAGIC		(('p'<<24)|('c'<<16)|('f'<<8)|'C')
+#define PCF_CACHE_VERSION	1
+
+#define PCF_CACHE_ALIGN(n)	(((n) + 15) & ~(CARD32) 15)
+#define PCF_CACHE_NO_CHAR	0xFFFF
+
+typedef struct _PCFCacheHeader {
+    CARD32      magic;
+    CARD32      version;
+    CARD16      headerSize;	/* these catch files from other builds */
+    CARD16      infoSize;
+    CARD16      charInfoSize;
+    CARD16      format;		/* PCF_FORMAT(bit, byte, glyph, scan) */
+    CARD32      fileSize;
+    CARD32      sourceSize;	/* of the font the cache was made from */
+    CARD32      pad;
+    int64_t     sourceTime;
+    CARD32      pathOffset;	/* path of the font, with its nul */
+    CARD32      pathSize;
+    CARD32      numProps;
+    CARD32      propsOffset;	/* PCFCachePropRec[numProps] */
+    CARD32      stringsOffset;	/* property names and string values */
+    CARD32      stringsSize;
+    CARD32      numChars;
+    CARD32      metricsOffset;	/* CharInfoRec[numChars] */
+    CARD32      inkMetricsOffset;	/* xCharInfo[numChars], or 0 */
+    CARD32      numEncoding;
+    CARD32      encodingOffset;	/* CARD16[numEncoding] metric indices */
+    CARD32      defaultChar;	/* metric index, or PCF_CACHE_NO_CHAR */
+    CARD32      bitmapsOffset;
+    CARD32      bitmapsSize;
+    FontInfoRec info;		/* without props and isStringProp */
+}           PCFCacheHeaderRec, *PCFCacheHeaderPtr;
+
+typedef struct _PCFCacheProp {
+    CARD32      name;		/* offset in the strings */
+    CARD32      value;		/* or offset in the strings */
+    CARD32      isString;
+}           PCFCachePropRec, *PCFCachePropPtr;
+
+/* What a font read from the cache has in fontPrivate */
+typedef struct _PCFCacheFont {
+    BitmapFontRec bitmap;	/* must be first */
+    char       *map;
+    size_t      mapSize;
+}           PCFCacheFontRec, *PCFCacheFontPtr;
+
+static char *pcfCacheDir;
+static Bool pcfCacheDirInit;
+
+static char *
+pcfCacheConcat(const char *a, const char *b, const char *c)
+{
+    size_t      la = strlen(a), lb = strlen(b), lc = strlen(c);
+    char       *s;
+
+    if (!(s = malloc(la + lb + lc + 1)))
+	return NULL;
+    memcpy(s, a, la);
+    memcpy(s + la, b, lb);
+    memcpy(s + la + lb, c, lc + 1);
+    return s;
+}
+
+static char *
+pcfCacheMakeDir(const char *base, const char *sub)
+{
+    if (!base || !*base)
+	return NULL;
+    return pcfCacheConcat(base, "/", sub);
+}
+
+static const char *
+pcfCacheDirectory(void)
+{
+    const char *env;
+    char       *parent = NULL;
+
+    if (pcfCacheDirInit)
+	return pcfCacheDir;
+    pcfCacheDirInit = TRUE;
+
+#ifndef WIN32
+    if (getuid() != geteuid() || getgid() != getegid())
+	return NULL;
+#endif
+
+    env = getenv("XFONT_PCF_CACHE_DIR");
+    if (env) {
+	if (*env)
+	    pcfCacheDir = strdup(env);
+    } else {
+#ifdef WIN32
+	pcfCacheDir = pcfCacheMakeDir(getenv("LOCALAPPDATA"), "libXfont2");
+#else
+	env = getenv("XDG_CACHE_HOME");
+	if (env && *env)
+	    parent = strdup(env);
+	else
+	    parent = pcfCacheMakeDir(getenv("HOME"), ".cache");
+	if (parent) {
+	    (void) mkdir(parent, 0700);
+	    pcfCacheDir = pcfCacheMakeDir(parent, "libXfont2");
+	    free(parent);
+	}
+#endif
+    }
+
+    if (pcfCacheDir && mkdir(pcfCacheDir, 0700) != 0 && errno != EEXIST) {
+	free(pcfCacheDir);
+	pcfCacheDir = NULL;
+    }
+    return pcfCacheDir;
+}
+
+/* FNV-1a of the font's path, which names its cache files */
+static char *
+pcfCacheFileName(const char *dir, const char *fileName, int format)
+{
+    CARD32      hi = 0xcbf29ce4, lo = 0x84222325;
+    const unsigned char *p;
+    char        base[32];
+
+    for (p = (const unsigned char *) fileName; *p; p++) {
+	uint64_t    h = ((uint64_t) hi << 32 | lo) ^ *p;
+
+	h *= 0x100000001b3ULL;
+	hi = h >> 32;
+	lo = h;
+    }
+    snprintf(base, sizeof(base), "%08lx%08lx-%02x.pcfc",
+	     (unsigned long) hi, (unsigned long) lo, format);
+    return pcfCacheConcat(dir, "/", base);
+}
+
+static void *
+pcfCacheMap(int fd, size_t size)
+{
+#ifdef WIN32
+    HANDLE      mapping;
+    void       *map;
+
+    mapping = CreateFileMapping((HANDLE) _get_osfhandle(fd), NULL,
+				PAGE_WRITECOPY, 0, 0, NULL);
+    if (!mapping)
+	return NULL;
+    map = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, size);
+    CloseHandle(mapping);
+    return map;
+#else
+    void       *map;
+
+    map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    return map == MAP_FAILED ? NULL : map;
+#endif
+}
+
+static void
+pcfCacheUnmap(void *map, size_t size)
+{
+#ifdef WIN32
+    UnmapViewOfFile(map);
+#else
+    munmap(map, size);
+#endif
+}
+
+static Bool
+pcfCacheSectionValid(PCFCacheHeaderPtr header, CARD32 offset,
+		     CARD32 count, size_t size)
+{
+    return offset >= sizeof(PCFCacheHeaderRec) &&
+	(offset & (sizeof(void *) - 1)) == 0 &&
+	offset <= header->fileSize &&
+	count <= (header->fileSize - offset) / size;
+}
+
+/*
+ * Map the cache file of fileName in the given format, if there is one
+ * that matches the font and can be trusted to be laid out as expected.
+ */
+static PCFCacheHeaderPtr
+pcfCacheOpen(const char *fileName, int format, size_t *sizep)
+{
+    const char *dir;
+    char       *name;
+    struct stat source, st;
+    PCFCacheHeaderPtr header;
+    CARD16     *offsets;
+    char       *map;
+    int         fd;
+    int         i, nencoding;
+
+    if (!(dir = pcfCacheDirectory()))
+	return NULL;
+    if (stat(fileName, &source) != 0)
+	return NULL;
+    if (!(name = pcfCacheFileName(dir, fileName, format)))
+	return NULL;
+    fd = open(name, O_RDONLY | O_BINARY);
+    free(name);
+    if (fd < 0)
+	return NULL;
+    if (fstat(fd, &st) != 0 ||
+	st.st_size < (off_t) sizeof(PCFCacheHeaderRec) ||
+	st.st_size > UINT32_MAX ||
+	!(map = pcfCacheMap(fd, st.st_size))) {
+	close(fd);
+	return NULL;
+    }
+    close(fd);
+
+    header = (PCFCacheHeaderPtr) map;
+    if (header->magic != PCF_CACHE_MAGIC ||
+	header->version != PCF_CACHE_VERSION ||
+	header->headerSize != sizeof(PCFCacheHeaderRec) ||
+	header->infoSize != sizeof(FontInfoRec) ||
+	header->charInfoSize != sizeof(CharInfoRec) ||
+	header->format != format ||
+	header->fileSize != st.st_size ||
+	header->sourceSize != source.st_size ||
+	header->sourceTime != source.st_mtime)
+	goto Bail;
+
+    if (!pcfCacheSectionValid(header, header->pathOffset,
+			      header->pathSize, 1) ||
+	header->pathSize != strlen(fileName) + 1 ||
+	memcmp(map + header->pathOffset, fileName, header->pathSize) != 0)
+	goto Bail;
+
+    if (header->info.firstCol > header->info.lastCol ||
+	header->info.firstRow > header->info.lastRow ||
+	header->info.lastCol - header->info.firstCol > 255)
+	goto Bail;
+    nencoding = (header->info.lastCol - header->info.firstCol + 1) *
+	(header->info.lastRow - header->info.firstRow + 1);
+
+    if (header->numProps != header->info.nprops ||
+	header->numProps > INT32_MAX / sizeof(FontPropRec) ||
+	!pcfCacheSectionValid(header, header->propsOffset,
+			      header->numProps, sizeof(PCFCachePropRec)) ||
+	!pcfCacheSectionValid(header, header->stringsOffset,
+			      header->stringsSize, 1) ||
+	!header->stringsSize ||
+	map[header->stringsOffset + header->stringsSize - 1] != '\0' ||
+	header->numChars > INT32_MAX / sizeof(CharInfoRec) ||
+	!pcfCacheSectionValid(header, header->metricsOffset,
+			      header->numChars, sizeof(CharInfoRec)) ||
+	(header->inkMetricsOffset &&
+	 !pcfCacheSectionValid(header, header->inkMetricsOffset,
+			       header->numChars, sizeof(xCharInfo))) ||
+	header->numEncoding != nencoding ||
+	!pcfCacheSectionValid(header, header->encodingOffset,
+			      header->numEncoding, sizeof(CARD16)) ||
+	(header->defaultChar != PCF_CACHE_NO_CHAR &&
+	 header->defaultChar >= header->numChars) ||
+	!pcfCacheSectionValid(header, header->bitmapsOffset,
+			      header->bitmapsSize, 1))
+	goto Bail;
+
+    /* bitmapGetGlyphs relies on allExist to skip checking the encoding */
+    offsets = (CARD16 *) (map + header->encodingOffset);
+    header->info.allExist = TRUE;
+    for (i = 0; i < nencoding; i++) {
+	if (offsets[i] == PCF_CACHE_NO_CHAR)
+	    header->info.allExist = FALSE;
+	else if (offsets[i] >= header->numChars)
+	    goto Bail;
+    }
+
+    *sizep = st.st_size;
+    return header;
+Bail:
+    pcfCacheUnmap(map, st.st_size);
+    return NULL;
+}
+
+static Bool
+pcfCacheGetProperties(FontInfoPtr pFontInfo, PCFCacheHeaderPtr header)
+{
+    char       *map = (char *) header;
+    PCFCachePropPtr cprops = (PCFCachePropPtr) (map + header->propsOffset);
+    char       *strings = map + header->stringsOffset;
+    FontPropPtr props;
+    char       *isStringProp;
+    int         i;
+
+    props = mallocarray(header->numProps, sizeof(FontPropRec));
+    isStringProp = malloc(header->numProps ? header->numProps : 1);
+    if (!props || !isStringProp)
+	goto Bail;
+
+    for (i = 0; i < header->numProps; i++) {
+	if (cprops[i].name >= header->stringsSize ||
+	    (cprops[i].isString && cprops[i].value >= header->stringsSize))
+	    goto Bail;
+	props[i].name = MakeAtom(strings + cprops[i].name,
+				 strlen(strings + cprops[i].name), TRUE);
+	isStringProp[i] = cprops[i].isString != 0;
+	if (isStringProp[i])
+	    props[i].value = MakeAtom(strings + cprops[i].value,
+				      strlen(strings + cprops[i].value), TRUE);
+	else
+	    props[i].value = (INT32) cprops[i].value;
+    }
+
+    *pFontInfo = header->info;
+    pFontInfo->nprops = header->numProps;
+    pFontInfo->props = props;
+    pFontInfo->isStringProp = isStringProp;
+    return TRUE;
+Bail:
+    free(props);
+    free(isStringProp);
+    return FALSE;
+}
+
+static void
+pcfCacheUnloadFont(FontPtr pFont)
+{
+    PCFCacheFontPtr cached = (PCFCacheFontPtr) pFont->fontPrivate;
+    BitmapFontPtr bitmapFont = &cached->bitmap;
+    char       *ink = (char *) bitmapFont->ink_metrics;
+    int         i, nencoding;
+
+    /* bitmapAddInkMetrics may have replaced them with its own */
+    if (ink < cached->map || ink >= cached->map + cached->mapSize)
+	free(bitmapFont->ink_metrics);
+    nencoding = (pFont->info.lastCol - pFont->info.firstCol + 1) *
+	(pFont->info.lastRow - pFont->info.firstRow + 1);
+    for (i = 0; i < NUM_SEGMENTS(nencoding); i++)
+	free(bitmapFont->encoding[i]);
+    free(bitmapFont->encoding);
+    free(pFont->info.isStringProp);
+    free(pFont->info.props);
+    pcfCacheUnmap(cached->map, cached->mapSize);
+    free(cached);
+    DestroyFontRec(pFont);
+}
+
+/*
+ * Set up pFont from the cache of fileName, if there is a valid one for
+ * this format.  Returns Successful, or BadFontName when the font has to
+ * be read from fileName instead.
+ */
+int
+pcfCacheReadFont(FontPtr pFont, const char *fileName,
+		 int bit, int byte, int glyph, int scan)
+{
+    PCFCacheHeaderPtr header;
+    PCFCacheFontPtr cached = NULL;
+    BitmapFontPtr bitmapFont;
+    CharInfoPtr metrics;
+    CharInfoPtr **encoding = NULL;
+    CARD16     *offsets;
+    char       *map;
+    size_t      size;
+    int         i, nencoding = 0;
+
+    header = pcfCacheOpen(fileName, PCF_FORMAT(bit, byte, glyph, scan), &size);
+    if (!header)
+	return BadFontName;
+    map = (char *) header;
+
+    /* Turn the glyph offsets back into pointers into the mapping */
+    metrics = (CharInfoPtr) (map + header->metricsOffset);
+    for (i = 0; i < header->numChars; i++) {
+	uintptr_t   offset = (uintptr_t) metrics[i].bits;
+
+	if (offset > header->bitmapsSize ||
+	    BYTES_FOR_GLYPH(&metrics[i], glyph) > header->bitmapsSize - offset)
+	    goto Bail;
+	metrics[i].bits = map + header->bitmapsOffset + offset;
+    }
+
+    nencoding = header->numEncoding;
+    encoding = calloc(NUM_SEGMENTS(nencoding), sizeof(CharInfoPtr*));
+    if (!encoding)
+	goto Bail;
+    offsets = (CARD16 *) (map + header->encodingOffset);
+    for (i = 0; i < nencoding; i++) {
+	if (offsets[i] == PCF_CACHE_NO_CHAR)
+	    continue;
+	if (!encoding[SEGMENT_MAJOR(i)]) {
+	    encoding[SEGMENT_MAJOR(i)] =
+		calloc(BITMAP_FONT_SEGMENT_SIZE, sizeof(CharInfoPtr));
+	    if (!encoding[SEGMENT_MAJOR(i)])
+		goto Bail;
+	}
+	ACCESSENCODINGL(encoding, i) = metrics + offsets[i];
+    }
+
+    cached = malloc(sizeof *cached);
+    if (!cached || !pcfCacheGetProperties(&pFont->info, header))
+	goto Bail;
+
+    cached->map = map;
+    cached->mapSize = size;
+    bitmapFont = &cached->bitmap;
+    bitmapFont->version_num = PCF_FILE_VERSION;
+    bitmapFont->num_chars = header->numChars;
+    bitmapFont->num_tables = 0;
+    bitmapFont->metrics = metrics;
+    bitmapFont->ink_metrics = header->inkMetricsOffset ?
+	(xCharInfo *) (map + header->inkMetricsOffset) : NULL;
+    bitmapFont->bitmaps = map + header->bitmapsOffset;
+    bitmapFont->encoding = encoding;
+    bitmapFont->pDefault = header->defaultChar != PCF_CACHE_NO_CHAR ?
+	metrics + header->defaultChar : NULL;
+    bitmapFont->bitmapExtra = (BitmapExtraPtr) 0;
+    pFont->fontPrivate = (pointer) bitmapFont;
+    pFont->get_glyphs = bitmapGetGlyphs;
+    pFont->get_metrics = bitmapGetMetrics;
+    pFont->unload_font = pcfCacheUnloadFont;
+    pFont->unload_glyphs = NULL;
+    pFont->bit = bit;
+    pFont->byte = byte;
+    pFont->glyph = glyph;
+    pFont->scan = scan;
+    return Successful;
+Bail:
+    if (encoding) {
+	for (i = 0; i < NUM_SEGMENTS(nencoding); i++)
+	    free(encoding[i]);
+    }
+    free(encoding);
+    free(cached);
+    pcfCacheUnmap(map, size);
+    return BadFontName;
+}
+
+int
+pcfCacheReadFontInfo(FontInfoPtr pFontInfo, const char *fileName,
+		     int bit, int byte, int glyph, int scan)
+{
+    PCFCacheHeaderPtr header;
+    size_t      size;
+    int         ret = BadFontName;
+
+    header = pcfCacheOpen(fileName, PCF_FORMAT(bit, byte, glyph, scan), &size);
+    if (!header)
+	return BadFontName;
+    if (pcfCacheGetProperties(pFontInfo, header))
+	ret = Successful;
+    pcfCacheUnmap(header, size);
+    return ret;
+}
+
+static Bool
+pcfCacheWrite(int fd, CARD32 *position, const void *data, CARD32 size)
+{
+    static const char zeros[16];
+    const char *p = data;
+
+    if (!p) {
+	/* pad to the next section */
+	size = PCF_CACHE_ALIGN(*position) - *position;
+	p = zeros;
+    }
+    *position += size;
+    while (size) {
+	int         n = write(fd, p, size);
+
+	if (n <= 0)
+	    return FALSE;
+	p += n;
+	size -= n;
+    }
+    return TRUE;
+}
+
+static Bool
+pcfCacheWriteSections(int fd, PCFCacheHeaderPtr header, FontPtr pFont,
+		      const char *fileName, CARD16 *offsets,
+		      PCFCachePropPtr cprops)
+{
+    BitmapFontPtr bitmapFont = (BitmapFontPtr) pFont->fontPrivate;
+    CARD32      position = 0;
+    CharInfoRec chunk[256];
+    const char *name;
+    int         i, j, n;
+
+    if (!pcfCacheWrite(fd, &position, header, sizeof(*header)) ||
+	!pcfCacheWrite(fd, &position, NULL, 0) ||
+	!pcfCacheWrite(fd, &position, fileName, header->pathSize) ||
+	!pcfCacheWrite(fd, &position, NULL, 0) ||
+	!pcfCacheWrite(fd, &position, cprops,
+		       header->numProps * sizeof(PCFCachePropRec)) ||
+	!pcfCacheWrite(fd, &position, NULL, 0))
+	return FALSE;
+
+    for (i = 0; i < pFont->info.nprops; i++) {
+	name = NameForAtom(pFont->info.props[i].name);
+	if (!pcfCacheWrite(fd, &position, name, strlen(name) + 1))
+	    return FALSE;
+	if (pFont->info.isStringProp[i]) {
+	    name = NameForAtom(pFont->info.props[i].value);
+	    if (!pcfCacheWrite(fd, &position, name, strlen(name) + 1))
+		return FALSE;
+	}
+    }
+    if (!pcfCacheWrite(fd, &position, "", 1) ||
+	!pcfCacheWrite(fd, &position, NULL, 0))
+	return FALSE;
+
+    for (i = 0; i < bitmapFont->num_chars; i += n) {
+	n = bitmapFont->num_chars - i;
+	if (n > 256)
+	    n = 256;
+	for (j = 0; j < n; j++) {
+	    chunk[j].metrics = bitmapFont->metrics[i + j].metrics;
+	    chunk[j].bits = (char *) (uintptr_t)
+		(bitmapFont->metrics[i + j].bits - bitmapFont->bitmaps);
+	}
+	if (!pcfCacheWrite(fd, &position, chunk, n * sizeof(CharInfoRec)))
+	    return FALSE;
+    }
+    if (!pcfCacheWrite(fd, &position, NULL, 0))
+	return FALSE;
+
+    if (bitmapFont->ink_metrics &&
+	(!pcfCacheWrite(fd, &position, bitmapFont->ink_metrics,
+			header->numChars * sizeof(xCharInfo)) ||
+	 !pcfCacheWrite(fd, &position, NULL, 0)))
+	return FALSE;
+
+    return pcfCacheWrite(fd, &position, offsets,
+			 header->numEncoding * sizeof(CARD16)) &&
+	pcfCacheWrite(fd, &position, NULL, 0) &&
+	pcfCacheWrite(fd, &position, bitmapFont->bitmaps,
+		      header->bitmapsSize) &&
+	position == header->fileSize;
+}
+
+/*
+ * Write the cache of a font pcfReadFont just read from fileName.  Failing
+ * to do so is not an error; the font is just read again next time.
+ */
+void
+pcfCacheWriteFont(FontPtr pFont, const char *fileName)
+{
+    BitmapFontPtr bitmapFont = (BitmapFontPtr) pFont->fontPrivate;
+    PCFCacheHeaderRec header;
+    PCFCachePropPtr cprops = NULL;
+    CARD16     *offsets = NULL;
+    CharInfoPtr pci;
+    const char *dir;
+    char       *name = NULL, *temp = NULL;
+    struct stat source;
+    size_t      bitmapsSize = 0, strings = 0, total;
+    int         format;
+    int         fd = -1;
+    int         i;
+
+    if (!(dir = pcfCacheDirectory()) || stat(fileName, &source) != 0 ||
+	source.st_size > UINT32_MAX)
+	return;
+
+    memset(&header, 0, sizeof(header));
+    format = PCF_FORMAT(pFont->bit, pFont->byte, pFont->glyph, pFont->scan);
+    header.magic = PCF_CACHE_MAGIC;
+    header.version = PCF_CACHE_VERSION;
+    header.headerSize = sizeof(PCFCacheHeaderRec);
+    header.infoSize = sizeof(FontInfoRec);
+    header.charInfoSize = sizeof(CharInfoRec);
+    header.format = format;
+    header.sourceSize = source.st_size;
+    header.sourceTime = source.st_mtime;
+    header.info = pFont->info;
+    header.info.props = NULL;
+    header.info.isStringProp = NULL;
+
+    /* The glyphs all live in one block, from pcfReadFont */
+    for (i = 0; i < bitmapFont->num_chars; i++) {
+	pci = &bitmapFont->metrics[i];
+	if (pci->bits < bitmapFont->bitmaps)
+	    return;
+	total = (pci->bits - bitmapFont->bitmaps) +
+	    BYTES_FOR_GLYPH(pci, pFont->glyph);
+	if (total > bitmapsSize)
+	    bitmapsSize = total;
+    }
+
+    header.numProps = pFont->info.nprops;
+    cprops = calloc(header.numProps ? header.numProps : 1,
+		    sizeof(PCFCachePropRec));
+    if (!cprops)
+	goto Bail;
+    for (i = 0; i < header.numProps; i++) {
+	const char *atom = NameForAtom(pFont->info.props[i].name);
+
+	if (!atom)
+	    goto Bail;
+	cprops[i].name = strings;
+	strings += strlen(atom) + 1;
+	cprops[i].isString = pFont->info.isStringProp[i];
+	if (cprops[i].isString) {
+	    if (!(atom = NameForAtom(pFont->info.props[i].value)))
+		goto Bail;
+	    cprops[i].value = strings;
+	    strings += strlen(atom) + 1;
+	} else
+	    cprops[i].value = pFont->info.props[i].value;
+    }
+
+    header.numEncoding = (pFont->info.lastCol - pFont->info.firstCol + 1) *
+	(pFont->info.lastRow - pFont->info.firstRow + 1);
+    offsets = mallocarray(header.numEncoding, sizeof(CARD16));
+    if (!offsets)
+	goto Bail;
+    for (i = 0; i < header.numEncoding; i++) {
+	pci = ACCESSENCODING(bitmapFont->encoding, i);
+	offsets[i] = pci ? pci - bitmapFont->metrics : PCF_CACHE_NO_CHAR;
+	if (pci && offsets[i] != pci - bitmapFont->metrics)
+	    goto Bail;
+    }
+    header.defaultChar = bitmapFont->pDefault ?
+	bitmapFont->pDefault - bitmapFont->metrics : PCF_CACHE_NO_CHAR;
+
+    /* Lay the sections out in the order pcfCacheWriteSections writes them */
+    header.numChars = bitmapFont->num_chars;
+    header.pathOffset = PCF_CACHE_ALIGN(sizeof(header));
+    header.pathSize = strlen(fileName) + 1;
+    header.propsOffset = PCF_CACHE_ALIGN(header.pathOffset + header.pathSize);
+    header.stringsOffset = PCF_CACHE_ALIGN(header.propsOffset +
+					   header.numProps *
+					   sizeof(PCFCachePropRec));
+    header.stringsSize = strings + 1;	/* and a nul to end them */
+    header.metricsOffset = PCF_CACHE_ALIGN(header.stringsOffset +
+					   header.stringsSize);
+    total = header.metricsOffset +
+	(size_t) header.numChars * sizeof(CharInfoRec);
+    if (bitmapFont->ink_metrics) {
+	header.inkMetricsOffset = PCF_CACHE_ALIGN(total);
+	total = header.inkMetricsOffset +
+	    (size_t) header.numChars * sizeof(xCharInfo);
+    }
+    header.encodingOffset = PCF_CACHE_ALIGN(total);
+    header.bitmapsOffset = PCF_CACHE_ALIGN(header.encodingOffset +
+					   header.numEncoding *
+					   sizeof(CARD16));
+    header.bitmapsSize = bitmapsSize;
+    total = (size_t) header.bitmapsOffset + bitmapsSize;
+    if (total > UINT32_MAX)
+	goto Bail;
+    header.fileSize = total;
+
+    /* Written under a temporary name so nobody maps a partial file */
+    if (!(name = pcfCacheFileName(dir, fileName, format)))
+	goto Bail;
+#ifdef WIN32
+    {
+	char        suffix[16];
+
+	snprintf(suffix, sizeof(suffix), ".%d", getpid());
+	if (!(temp = pcfCacheConcat(name, suffix, "")))
+	    goto Bail;
+	fd = open(temp, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0600);
+    }
+#else
+    if (!(temp = pcfCacheConcat(name, ".XXXXXX", "")))
+	goto Bail;
+    fd = mkstemp(temp);
+#endif
+    if (fd < 0) {
+	free(temp);
+	temp = NULL;
+	goto Bail;
+    }
+
+    if (!pcfCacheWriteSections(fd, &header, pFont, fileName, offsets, cprops))
+	goto Bail;
+    if (close(fd) != 0) {
+	fd = -1;
+	goto Bail;
+    }
+    fd = -1;
+#ifdef WIN32
+    /* Fails while another server has the old file mapped */
+    if (!MoveFileExA(temp, name, MOVEFILE_REPLACE_EXISTING))
+	goto Bail;
+#else
+    if (rename(temp, name) != 0)
+	goto Bail;
+#endif
+    free(temp);
+    temp = NULL;
+
+Bail:
+    if (fd >= 0)
+	close(fd);
+    if (temp) {
+	unlink(temp);
+	free(temp);
+    }
+    free(name);
+    free(offsets);
+    free(cprops);
+}
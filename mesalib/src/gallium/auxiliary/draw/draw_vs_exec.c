@@ -45,11 +45,16 @@
 #include "tgsi/tgsi_parse.h"
 #include "tgsi/tgsi_scan.h"
 #include "tgsi/tgsi_exec.h"
+#include "tgsi/tgsi_sse2.h"
 
 
 struct exec_vertex_shader {
    struct draw_vertex_shader base;
    struct tgsi_exec_machine *machine;
+
+   /** Native code for the tokens, compiled on first prepare */
+   struct tgsi_sse2_function *sse2;
+   bool sse2_tried;
 };
 
 
@@ -79,6 +84,14 @@ vs_exec_prepare(struct draw_vertex_shader *shader,
                                     draw->vs.tgsi.image,
                                     draw->vs.tgsi.buffer);
    }
+
+   if (!evs->sse2_tried) {
+      evs->sse2 = tgsi_sse2_create(evs->machine);
+      evs->sse2_tried = true;
+   }
+
+   /* The machine is shared by all vertex shaders, so always reset this. */
+   evs->machine->Jit = evs->sse2 ? tgsi_sse2_get_func(evs->sse2) : NULL;
 }
 
 
@@ -209,6 +222,9 @@ vs_exec_run_linear(struct draw_vertex_shader *shader,
 static void
 vs_exec_delete(struct draw_vertex_shader *dvs)
 {
+   struct exec_vertex_shader *evs = exec_vertex_shader(dvs);
+
+   tgsi_sse2_destroy(evs->sse2);
    FREE((void*) dvs->state.tokens);
    FREE(dvs);
 }
@@ -997,6 +997,15 @@ void sse_maxss( struct x86_function *p,
    emit_modrm( p, dst, src );
 }
 
+void sse_divps( struct x86_function *p,
+                struct x86_reg dst,
+                struct x86_reg src )
+{
+   DUMP_RR( dst, src );
+   emit_2ub(p, X86_TWOB, 0x5E);
+   emit_modrm( p, dst, src );
+}
+
 void sse_divss( struct x86_function *p,
                 struct x86_reg dst,
                 struct x86_reg src )
@@ -1087,6 +1096,15 @@ void sse_rsqrtps( struct x86_function *p,
    emit_modrm( p, dst, src );
 }
 
+void sse_sqrtps( struct x86_function *p,
+                 struct x86_reg dst,
+                 struct x86_reg src )
+{
+   DUMP_RR( dst, src );
+   emit_2ub(p, X86_TWOB, 0x51);
+   emit_modrm( p, dst, src );
+}
+
 void sse_rsqrtss( struct x86_function *p,
                   struct x86_reg dst,
                   struct x86_reg src )
@@ -967,6 +967,9 @@ enum tgsi_exec_datatype {
 #define UPDATE_EXEC_MASK(MACH) \
       MACH->ExecMask = MACH->CondMask & MACH->LoopMask & MACH->ContMask & MACH->Switch.mask & MACH->FuncMask
 
+/** Execution mask with all lanes of the quad enabled */
+#define TGSI_EXEC_FULL_MASK ((1 << TGSI_QUAD_SIZE) - 1)
+
 
 static const union tgsi_exec_channel ZeroVec =
    { { 0.0, 0.0, 0.0, 0.0 } };
@@ -1050,6 +1053,7 @@ tgsi_exec_machine_bind_shader(
 #endif
 
    mach->Tokens = tokens;
+   mach->Jit = NULL;
    mach->Sampler = sampler;
    mach->Image = image;
    mach->Buffer = buffer;
@@ -1595,6 +1599,55 @@ get_index_registers(const struct tgsi_exec_machine *mach,
 }
 
 
+/**
+ * Fast path of fetch_src_file_channel() for registers without indirect
+ * addressing, where every lane reads the same register.  This skips
+ * building per-lane index vectors and copies the channel as a whole.
+ * \return false if the register file is not handled here
+ */
+static inline bool
+fetch_src_file_channel_direct(const struct tgsi_exec_machine *mach,
+                              const unsigned file,
+                              const unsigned swizzle,
+                              const int index,
+                              const int index2D,
+                              union tgsi_exec_channel *chan)
+{
+   switch (file) {
+   case TGSI_FILE_TEMPORARY:
+      assert(index < TGSI_EXEC_NUM_TEMPS);
+      assert(index2D == 0);
+      *chan = mach->Temps[index].xyzw[swizzle];
+      return true;
+
+   case TGSI_FILE_INPUT:
+      assert(index2D * TGSI_EXEC_MAX_INPUT_ATTRIBS + index <
+             TGSI_MAX_PRIM_VERTICES * PIPE_MAX_ATTRIBS);
+      *chan = mach->Inputs[index2D * TGSI_EXEC_MAX_INPUT_ATTRIBS + index].xyzw[swizzle];
+      return true;
+
+   case TGSI_FILE_CONSTANT: {
+      const unsigned pos = index * 4 + swizzle;
+      unsigned value = 0;
+
+      if (pos < mach->ConstsSize[index2D] / 4)
+         value = ((const unsigned *)mach->Consts[index2D])[pos];
+      chan->u[0] = chan->u[1] = chan->u[2] = chan->u[3] = value;
+      return true;
+   }
+
+   case TGSI_FILE_IMMEDIATE:
+      assert(index >= 0 && index < (int)mach->ImmLimit);
+      assert(index2D == 0);
+      chan->f[0] = chan->f[1] = chan->f[2] = chan->f[3] =
+         mach->Imms[index][swizzle];
+      return true;
+
+   default:
+      return false;
+   }
+}
+
 static void
 fetch_source_d(const struct tgsi_exec_machine *mach,
                union tgsi_exec_channel *chan,
@@ -1605,6 +1658,19 @@ fetch_source_d(const struct tgsi_exec_machine *mach,
    union tgsi_exec_channel index2D;
    unsigned swizzle;
 
+   if (!reg->Register.Indirect &&
+       !(reg->Register.Dimension && reg->Dimension.Indirect)) {
+      swizzle = tgsi_util_get_full_src_register_swizzle( reg, chan_index );
+      if (fetch_src_file_channel_direct(mach,
+                                        reg->Register.File,
+                                        swizzle,
+                                        reg->Register.Index,
+                                        reg->Register.Dimension ?
+                                           reg->Dimension.Index : 0,
+                                        chan))
+         return;
+   }
+
    get_index_registers(mach, reg, &index, &index2D);
 
 
@@ -1765,6 +1831,11 @@ store_dest(struct tgsi_exec_machine *mach,
       return;
 
    if (!inst->Instruction.Saturate) {
+      if ((execmask & TGSI_EXEC_FULL_MASK) == TGSI_EXEC_FULL_MASK) {
+         /* all lanes enabled, the common case outside of control flow */
+         *dst = *chan;
+         return;
+      }
       for (i = 0; i < TGSI_QUAD_SIZE; i++)
          if (execmask & (1 << i))
             dst->i[i] = chan->i[i];
@@ -4056,10 +4127,22 @@ static void
 exec_atomop(struct tgsi_exec_machine *mach,
             const struct tgsi_full_instruction *inst)
 {
+   /* Shared memory belongs to a single workgroup, so only images and
+    * buffers can be accessed by other threads.
+    */
+   const bool lock = mach->AtomicMutex &&
+                     inst->Src[0].Register.File != TGSI_FILE_MEMORY;
+
+   if (lock)
+      mtx_lock(mach->AtomicMutex);
+
    if (inst->Src[0].Register.File == TGSI_FILE_IMAGE)
       exec_atomop_img(mach, inst);
    else
       exec_atomop_membuf(mach, inst);
+
+   if (lock)
+      mtx_unlock(mach->AtomicMutex);
 }
 
 static void
@@ -5990,6 +6073,37 @@ tgsi_exec_machine_setup_masks(struct tgsi_exec_machine *mach)
    assert(mach->CallStackTop == 0);
 }
 
+
+/**
+ * Expand ExecMask into the per-lane masks generated code tests.
+ */
+static void
+update_jit_exec_mask(struct tgsi_exec_machine *mach)
+{
+   unsigned i;
+
+   for (i = 0; i < TGSI_QUAD_SIZE; i++)
+      mach->JitExecMask.u[i] = (mach->ExecMask & (1 << i)) ? ~0u : 0u;
+}
+
+
+/**
+ * Called from generated code for instructions it does not translate.
+ * Branches taken by the interpreter are ignored: generated code only
+ * contains IF/ELSE/ENDIF, which execute correctly straight through under
+ * the updated exec mask.
+ */
+static void
+exec_jit_instruction(struct tgsi_exec_machine *mach, unsigned pc)
+{
+   int next_pc = pc;
+
+   assert(pc < mach->NumInstructions);
+   exec_instruction(mach, mach->Instructions + pc, &next_pc);
+   update_jit_exec_mask(mach);
+}
+
+
 /**
  * Run TGSI interpreter.
  * \return bitmask of "alive" quad components
@@ -6008,6 +6122,12 @@ tgsi_exec_machine_run( struct tgsi_exec_machine *mach, int start_pc )
       for (i = 0; i < mach->NumDeclarations; i++) {
          exec_declaration( mach, mach->Declarations+i );
       }
+
+      if (mach->Jit) {
+         update_jit_exec_mask(mach);
+         mach->Jit(mach, exec_jit_instruction);
+         mach->pc = -1;
+      }
    }
 
    {
@@ -30,6 +30,7 @@
 #define TGSI_EXEC_H
 
 #include "util/compiler.h"
+#include "c11/threads.h"
 #include "pipe/p_state.h"
 #include "pipe/p_shader_tokens.h"
 
@@ -300,6 +301,19 @@ typedef void (* apply_sample_offset_func)(
    float ofs_y,
    union tgsi_exec_channel *out_chan);
 
+/**
+ * Executes the instruction at \p pc through the interpreter.  Passed to
+ * generated code so it can fall back for opcodes it does not translate.
+ */
+typedef void (*tgsi_exec_jit_helper)(struct tgsi_exec_machine *mach,
+                                     unsigned pc);
+
+/**
+ * Natively compiled shader body, see tgsi_sse2.h.
+ */
+typedef void (*tgsi_exec_jit_func)(struct tgsi_exec_machine *mach,
+                                   tgsi_exec_jit_helper helper);
+
 /**
  * Run-time virtual machine state for executing TGSI shader.
  */
@@ -361,6 +375,10 @@ tgsi_exec_machine
    /* Compute Only */
    void                          *LocalMem;
    unsigned                      LocalMemSize;
+   /** If set, held around image and buffer atomics, for machines which
+    * run workgroups on several threads at once.
+    */
+   mtx_t                         *AtomicMutex;
 
    /* See GLSL 4.50 specification for definition of helper invocations */
    unsigned NonHelperMask;  /**< non-helpers */
@@ -421,6 +439,15 @@ tgsi_exec_machine
    bool UsedGeometryShader;
 
    int pc;
+
+   /**
+    * Compiled code for the bound shader, run instead of the interpreter
+    * loop when set.  Cleared by tgsi_exec_machine_bind_shader().
+    */
+   tgsi_exec_jit_func Jit;
+
+   /** ExecMask expanded to one all-ones/all-zeros dword per lane, for Jit */
+   union tgsi_exec_channel JitExecMask;
 };
 
 struct tgsi_exec_machine *
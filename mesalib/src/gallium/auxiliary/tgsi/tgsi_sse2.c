@@ -0,0 +1,912 @@
+/**************************************************************************
+ *
+ * Copyright 2007-2008 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * TGSI to SSE2 translation.
+ *
+ * The generated function has the signature of tgsi_exec_jit_func and runs
+ * after tgsi_exec_machine_run() has executed the declarations.  It keeps
+ * the machine pointer in EBX/RBX and the interpreter helper in EBP/RBP,
+ * both callee-saved on every supported ABI, and only uses XMM0-XMM5 so
+ * nothing needs saving on Win64.
+ *
+ * Every instruction is either emitted natively or as a call to the helper,
+ * which executes that one instruction through the interpreter.  Results
+ * match the interpreter bit for bit: the float ops below are the same
+ * IEEE single precision operations micro_*() perform, in the same order.
+ *
+ * IF/UIF/ELSE/ENDIF are run by the helper, which keeps
+ * tgsi_exec_machine::JitExecMask up to date; native stores in such shaders
+ * are then masked with it, and the interpreter's "no lane takes this
+ * branch" jumps are replicated in generated code.
+ */
+
+#include "util/detect.h"
+
+#if DETECT_ARCH_X86 || DETECT_ARCH_X86_64
+
+#include "util/bitscan.h"
+#include "util/u_debug.h"
+#include "util/u_memory.h"
+#include "util/u_cpu_detect.h"
+#include "pipe/p_shader_tokens.h"
+#include "tgsi/tgsi_parse.h"
+#include "tgsi/tgsi_util.h"
+#include "rtasm/rtasm_x86sse.h"
+#include "tgsi_sse2.h"
+
+
+DEBUG_GET_ONCE_BOOL_OPTION(nosse, "GALLIUM_NOSSE", false)
+
+
+#define FLOAT_ONE       0x3f800000
+#define FLOAT_SIGN      0x80000000
+#define FLOAT_NOSIGN    0x7fffffff
+
+/** Stack space for four channels of results that need to be buffered */
+#define SCRATCH_SIZE    (4 * 16)
+
+/**
+ * Bytes to subtract from the stack pointer after pushing EBX/EBP so that
+ * it stays 16-byte aligned for helper calls.  On x86-64 this includes
+ * the 32 byte Win64 shadow area, on x86 the two helper arguments.
+ */
+#define FRAME_SIZE_64   (8 + 32 + SCRATCH_SIZE)
+#define SCRATCH_OFS_64  32
+#define FRAME_SIZE_32   (4 + 8 + SCRATCH_SIZE + 8)
+#define SCRATCH_OFS_32  8
+
+
+struct tgsi_sse2_function
+{
+   struct x86_function func;
+};
+
+
+struct sse2_branch
+{
+   unsigned target;   /**< instruction index, ~0 once patched */
+   int fixup;         /**< x86_jcc_forward() label */
+};
+
+
+struct sse2_gen
+{
+   struct x86_function *func;
+   const struct tgsi_exec_machine *mach;
+
+   struct x86_reg machine;    /**< EBX, machine pointer */
+   struct x86_reg helper;     /**< EBP, interpreter helper */
+   struct x86_reg tmp;        /**< EAX, scratch pointer */
+   struct x86_reg scratch;    /**< stack scratch area */
+
+   /** Shader has IF/ELSE, so stores must honour JitExecMask */
+   bool masked;
+
+   struct sse2_branch *branches;
+   unsigned num_branches;
+};
+
+
+#define MACH_OFS(field) ((int) offsetof(struct tgsi_exec_machine, field))
+
+
+static inline struct x86_reg
+make_xmm(unsigned idx)
+{
+   return x86_make_reg(file_XMM, idx);
+}
+
+
+static inline struct x86_reg
+mach_field(const struct sse2_gen *gen, int offset)
+{
+   return x86_make_disp(gen->machine, offset);
+}
+
+
+static struct x86_reg
+scratch_chan(const struct sse2_gen *gen, unsigned chan)
+{
+   return x86_make_disp(gen->scratch, chan * 16);
+}
+
+
+/**
+ * Load a pointer member of the machine into gen->tmp.
+ */
+static void
+emit_load_ptr(struct sse2_gen *gen, int offset)
+{
+   if (x86_target(gen->func) == X86_32)
+      x86_mov(gen->func, gen->tmp, mach_field(gen, offset));
+   else
+      x64_mov64(gen->func, gen->tmp, mach_field(gen, offset));
+}
+
+
+/**
+ * Broadcast a 32-bit constant to all four lanes of an XMM register.
+ */
+static void
+emit_const(struct sse2_gen *gen, unsigned xmm, unsigned bits)
+{
+   x86_mov_reg_imm(gen->func, gen->tmp, (int) bits);
+   sse2_movd(gen->func, make_xmm(xmm), gen->tmp);
+   sse_shufps(gen->func, make_xmm(xmm), make_xmm(xmm), 0);
+}
+
+
+static void
+emit_broadcast_load(struct sse2_gen *gen, unsigned xmm, struct x86_reg src)
+{
+   sse_movss(gen->func, make_xmm(xmm), src);
+   sse_shufps(gen->func, make_xmm(xmm), make_xmm(xmm), 0);
+}
+
+
+/**
+ * Fetch one channel of a source register, see fetch_source() in
+ * tgsi_exec.c.  Clobbers XMM5 and EAX.
+ */
+static void
+emit_fetch(struct sse2_gen *gen, unsigned xmm,
+           const struct tgsi_full_src_register *reg, unsigned chan)
+{
+   struct x86_function *f = gen->func;
+   const unsigned swizzle = tgsi_util_get_full_src_register_swizzle(reg, chan);
+   const int index = reg->Register.Index;
+
+   switch (reg->Register.File) {
+   case TGSI_FILE_TEMPORARY:
+      sse_movaps(f, make_xmm(xmm),
+                 mach_field(gen, MACH_OFS(Temps) +
+                                 index * sizeof(struct tgsi_exec_vector) +
+                                 swizzle * sizeof(union tgsi_exec_channel)));
+      break;
+
+   case TGSI_FILE_INPUT:
+      emit_load_ptr(gen, MACH_OFS(Inputs));
+      sse_movups(f, make_xmm(xmm),
+                 x86_make_disp(gen->tmp,
+                               index * sizeof(struct tgsi_exec_vector) +
+                               swizzle * sizeof(union tgsi_exec_channel)));
+      break;
+
+   case TGSI_FILE_CONSTANT: {
+      const unsigned buf = reg->Register.Dimension ? reg->Dimension.Index : 0;
+      const unsigned pos = index * 4 + swizzle;
+      int skip;
+
+      /* Out of bounds constants read as zero. */
+      sse_xorps(f, make_xmm(xmm), make_xmm(xmm));
+      x86_mov(f, gen->tmp,
+              mach_field(gen, MACH_OFS(ConstsSize) + buf * sizeof(unsigned)));
+      x86_cmp_imm(f, gen->tmp, (pos + 1) * 4);
+      skip = x86_jcc_forward(f, cc_NAE);
+      emit_load_ptr(gen, MACH_OFS(Consts) + buf * sizeof(void *));
+      emit_broadcast_load(gen, xmm, x86_make_disp(gen->tmp, pos * 4));
+      x86_fixup_fwd_jump(f, skip);
+      break;
+   }
+
+   case TGSI_FILE_IMMEDIATE:
+      emit_load_ptr(gen, MACH_OFS(Imms));
+      emit_broadcast_load(gen, xmm,
+                          x86_make_disp(gen->tmp,
+                                        index * sizeof(float4) +
+                                        swizzle * sizeof(float)));
+      break;
+
+   default:
+      unreachable("unexpected register file");
+   }
+
+   if (reg->Register.Absolute) {
+      emit_const(gen, 5, FLOAT_NOSIGN);
+      sse_andps(f, make_xmm(xmm), make_xmm(5));
+   }
+   if (reg->Register.Negate) {
+      emit_const(gen, 5, FLOAT_SIGN);
+      sse_xorps(f, make_xmm(xmm), make_xmm(5));
+   }
+}
+
+
+/**
+ * Clamp XMM register to [0, 1] like store_dest() does.  A NaN becomes 0
+ * because MAXPS returns its second operand when either one is NaN.
+ */
+static void
+emit_saturate(struct sse2_gen *gen, unsigned xmm)
+{
+   sse_xorps(gen->func, make_xmm(4), make_xmm(4));
+   sse_maxps(gen->func, make_xmm(xmm), make_xmm(4));
+   emit_const(gen, 4, FLOAT_ONE);
+   sse_minps(gen->func, make_xmm(xmm), make_xmm(4));
+}
+
+
+/**
+ * Store an XMM register to one channel of the destination.  Clobbers
+ * XMM3-XMM5 and EAX, but not the source register.
+ */
+static void
+emit_store(struct sse2_gen *gen, unsigned xmm,
+           const struct tgsi_full_dst_register *reg, unsigned chan)
+{
+   struct x86_function *f = gen->func;
+   const int index = reg->Register.Index;
+   struct x86_reg dst;
+   bool aligned;
+
+   if (reg->Register.File == TGSI_FILE_TEMPORARY) {
+      dst = mach_field(gen, MACH_OFS(Temps) +
+                            index * sizeof(struct tgsi_exec_vector) +
+                            chan * sizeof(union tgsi_exec_channel));
+      aligned = true;
+   }
+   else {
+      assert(reg->Register.File == TGSI_FILE_OUTPUT);
+      emit_load_ptr(gen, MACH_OFS(Outputs));
+      dst = x86_make_disp(gen->tmp,
+                          index * sizeof(struct tgsi_exec_vector) +
+                          chan * sizeof(union tgsi_exec_channel));
+      aligned = false;
+   }
+
+   if (gen->masked) {
+      sse_movaps(f, make_xmm(3), make_xmm(xmm));
+      sse_movups(f, make_xmm(4), dst);
+      sse_movaps(f, make_xmm(5), mach_field(gen, MACH_OFS(JitExecMask)));
+      sse_andps(f, make_xmm(3), make_xmm(5));
+      sse_andnps(f, make_xmm(5), make_xmm(4));
+      sse_orps(f, make_xmm(3), make_xmm(5));
+      xmm = 3;
+   }
+
+   if (aligned)
+      sse_movaps(f, dst, make_xmm(xmm));
+   else
+      sse_movups(f, dst, make_xmm(xmm));
+}
+
+
+/**
+ * Store XMM0 to all channels in the write mask, for instructions that
+ * produce one value (see exec_scalar_unary() and exec_dp4()).
+ */
+static void
+emit_store_replicated(struct sse2_gen *gen,
+                      const struct tgsi_full_instruction *inst)
+{
+   unsigned chan;
+
+   if (inst->Instruction.Saturate)
+      emit_saturate(gen, 0);
+
+   for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++) {
+      if (inst->Dst[0].Register.WriteMask & (1 << chan))
+         emit_store(gen, 0, &inst->Dst[0], chan);
+   }
+}
+
+
+/**
+ * fminf()/fmaxf() return the non-NaN operand, MINPS/MAXPS always return
+ * the second one.  Select src0 in lanes where src1 is NaN.
+ * XMM0 = op(XMM0, XMM1), clobbers XMM1 and XMM2.
+ */
+static void
+emit_min_max(struct sse2_gen *gen, bool is_max)
+{
+   struct x86_function *f = gen->func;
+
+   sse_movaps(f, make_xmm(2), make_xmm(0));
+   if (is_max)
+      sse_maxps(f, make_xmm(2), make_xmm(1));
+   else
+      sse_minps(f, make_xmm(2), make_xmm(1));
+   sse_cmpps(f, make_xmm(1), make_xmm(1), cc_Unordered);
+   sse_andps(f, make_xmm(0), make_xmm(1));
+   sse_andnps(f, make_xmm(1), make_xmm(2));
+   sse_orps(f, make_xmm(0), make_xmm(1));
+}
+
+
+/**
+ * Compute one channel of a component-wise instruction into XMM0.
+ */
+static void
+emit_vector_channel(struct sse2_gen *gen,
+                    const struct tgsi_full_instruction *inst,
+                    unsigned chan)
+{
+   struct x86_function *f = gen->func;
+   unsigned i;
+
+   for (i = 0; i < inst->Instruction.NumSrcRegs; i++)
+      emit_fetch(gen, i, &inst->Src[i], chan);
+
+   switch (inst->Instruction.Opcode) {
+   case TGSI_OPCODE_MOV:
+      break;
+   case TGSI_OPCODE_ADD:
+      sse_addps(f, make_xmm(0), make_xmm(1));
+      break;
+   case TGSI_OPCODE_MUL:
+      sse_mulps(f, make_xmm(0), make_xmm(1));
+      break;
+   case TGSI_OPCODE_MAD:
+      sse_mulps(f, make_xmm(0), make_xmm(1));
+      sse_addps(f, make_xmm(0), make_xmm(2));
+      break;
+   case TGSI_OPCODE_LRP:
+      sse_subps(f, make_xmm(1), make_xmm(2));
+      sse_mulps(f, make_xmm(0), make_xmm(1));
+      sse_addps(f, make_xmm(0), make_xmm(2));
+      break;
+   case TGSI_OPCODE_MIN:
+      emit_min_max(gen, false);
+      break;
+   case TGSI_OPCODE_MAX:
+      emit_min_max(gen, true);
+      break;
+   case TGSI_OPCODE_SLT:
+      sse_cmpps(f, make_xmm(0), make_xmm(1), cc_LessThan);
+      emit_const(gen, 4, FLOAT_ONE);
+      sse_andps(f, make_xmm(0), make_xmm(4));
+      break;
+   case TGSI_OPCODE_SGE:
+      /* src1 <= src0 rather than !(src0 < src1), which is true for NaN */
+      sse_cmpps(f, make_xmm(1), make_xmm(0), cc_LessThanEqual);
+      emit_const(gen, 0, FLOAT_ONE);
+      sse_andps(f, make_xmm(0), make_xmm(1));
+      break;
+   case TGSI_OPCODE_SEQ:
+      sse_cmpps(f, make_xmm(0), make_xmm(1), cc_Equal);
+      emit_const(gen, 4, FLOAT_ONE);
+      sse_andps(f, make_xmm(0), make_xmm(4));
+      break;
+   case TGSI_OPCODE_SNE:
+      sse_cmpps(f, make_xmm(0), make_xmm(1), cc_NotEqual);
+      emit_const(gen, 4, FLOAT_ONE);
+      sse_andps(f, make_xmm(0), make_xmm(4));
+      break;
+   case TGSI_OPCODE_CMP:
+      sse_xorps(f, make_xmm(4), make_xmm(4));
+      sse_cmpps(f, make_xmm(0), make_xmm(4), cc_LessThan);
+      sse_andps(f, make_xmm(1), make_xmm(0));
+      sse_andnps(f, make_xmm(0), make_xmm(2));
+      sse_orps(f, make_xmm(0), make_xmm(1));
+      break;
+   default:
+      unreachable("unexpected opcode");
+   }
+}
+
+
+static bool
+src_aliases_dst(const struct tgsi_full_instruction *inst)
+{
+   const struct tgsi_dst_register *dst = &inst->Dst[0].Register;
+   unsigned i;
+
+   for (i = 0; i < inst->Instruction.NumSrcRegs; i++) {
+      if (inst->Src[i].Register.File == dst->File &&
+          inst->Src[i].Register.Index == dst->Index)
+         return true;
+   }
+   return false;
+}
+
+
+static void
+emit_vector(struct sse2_gen *gen, const struct tgsi_full_instruction *inst)
+{
+   const unsigned writemask = inst->Dst[0].Register.WriteMask;
+   /* Buffer the results if a later channel could read an earlier store. */
+   const bool buffer = util_bitcount(writemask) > 1 && src_aliases_dst(inst);
+   unsigned chan;
+
+   for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++) {
+      if (!(writemask & (1 << chan)))
+         continue;
+
+      emit_vector_channel(gen, inst, chan);
+      if (buffer) {
+         sse_movups(gen->func, scratch_chan(gen, chan), make_xmm(0));
+      }
+      else {
+         if (inst->Instruction.Saturate)
+            emit_saturate(gen, 0);
+         emit_store(gen, 0, &inst->Dst[0], chan);
+      }
+   }
+
+   if (buffer) {
+      for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++) {
+         if (!(writemask & (1 << chan)))
+            continue;
+
+         sse_movups(gen->func, make_xmm(0), scratch_chan(gen, chan));
+         if (inst->Instruction.Saturate)
+            emit_saturate(gen, 0);
+         emit_store(gen, 0, &inst->Dst[0], chan);
+      }
+   }
+}
+
+
+/**
+ * DP2/DP3/DP4 as mul followed by mads, in the order exec_dp4() uses.
+ */
+static void
+emit_dot(struct sse2_gen *gen, const struct tgsi_full_instruction *inst,
+         unsigned num_chans)
+{
+   struct x86_function *f = gen->func;
+   unsigned chan;
+
+   emit_fetch(gen, 0, &inst->Src[0], TGSI_CHAN_X);
+   emit_fetch(gen, 1, &inst->Src[1], TGSI_CHAN_X);
+   sse_mulps(f, make_xmm(0), make_xmm(1));
+
+   for (chan = TGSI_CHAN_Y; chan < num_chans; chan++) {
+      emit_fetch(gen, 1, &inst->Src[0], chan);
+      emit_fetch(gen, 2, &inst->Src[1], chan);
+      sse_mulps(f, make_xmm(1), make_xmm(2));
+      sse_addps(f, make_xmm(0), make_xmm(1));
+   }
+
+   emit_store_replicated(gen, inst);
+}
+
+
+static void
+emit_scalar(struct sse2_gen *gen, const struct tgsi_full_instruction *inst)
+{
+   struct x86_function *f = gen->func;
+
+   emit_fetch(gen, 1, &inst->Src[0], TGSI_CHAN_X);
+
+   switch (inst->Instruction.Opcode) {
+   case TGSI_OPCODE_RCP:
+      emit_const(gen, 0, FLOAT_ONE);
+      sse_divps(f, make_xmm(0), make_xmm(1));
+      break;
+   case TGSI_OPCODE_RSQ:
+      /* exact 1.0f / sqrtf(x), not the RSQRTPS estimate */
+      sse_sqrtps(f, make_xmm(1), make_xmm(1));
+      emit_const(gen, 0, FLOAT_ONE);
+      sse_divps(f, make_xmm(0), make_xmm(1));
+      break;
+   case TGSI_OPCODE_SQRT:
+      sse_sqrtps(f, make_xmm(0), make_xmm(1));
+      break;
+   default:
+      unreachable("unexpected opcode");
+   }
+
+   emit_store_replicated(gen, inst);
+}
+
+
+static void
+emit_helper_call(struct sse2_gen *gen, unsigned pc)
+{
+   struct x86_function *f = gen->func;
+
+   switch (x86_target(f)) {
+   case X86_32:
+      x86_mov(f, x86_make_disp(x86_make_reg(file_REG32, reg_SP), 0),
+              gen->machine);
+      x86_mov_imm(f, x86_make_disp(x86_make_reg(file_REG32, reg_SP), 4),
+                  pc);
+      break;
+   case X86_64_WIN64_ABI:
+      x64_mov64(f, x86_make_reg(file_REG32, reg_CX), gen->machine);
+      x86_mov_reg_imm(f, x86_make_reg(file_REG32, reg_DX), pc);
+      break;
+   case X86_64_STD_ABI:
+      x64_mov64(f, x86_make_reg(file_REG32, reg_DI), gen->machine);
+      x86_mov_reg_imm(f, x86_make_reg(file_REG32, reg_SI), pc);
+      break;
+   }
+
+   x86_call(f, gen->helper);
+}
+
+
+/**
+ * Emit the interpreter's jump past an IF/ELSE body when no lane takes it.
+ */
+static void
+emit_branch(struct sse2_gen *gen, const struct tgsi_full_instruction *inst,
+            unsigned pc)
+{
+   struct sse2_branch *branch;
+
+   if (inst->Label.Label <= pc)
+      return;
+
+   x86_mov(gen->func, gen->tmp, mach_field(gen, MACH_OFS(CondMask)));
+   x86_cmp_imm(gen->func, gen->tmp, 0);
+
+   branch = &gen->branches[gen->num_branches++];
+   branch->target = inst->Label.Label;
+   branch->fixup = x86_jcc_forward(gen->func, cc_E);
+}
+
+
+static void
+resolve_branches(struct sse2_gen *gen, unsigned pc)
+{
+   unsigned i;
+
+   for (i = 0; i < gen->num_branches; i++) {
+      if (gen->branches[i].target == pc) {
+         x86_fixup_fwd_jump(gen->func, gen->branches[i].fixup);
+         gen->branches[i].target = ~0u;
+      }
+   }
+}
+
+
+static bool
+src_is_native(const struct tgsi_full_src_register *reg)
+{
+   if (reg->Register.Indirect || reg->Register.Index < 0)
+      return false;
+
+   switch (reg->Register.File) {
+   case TGSI_FILE_TEMPORARY:
+      return !reg->Register.Dimension &&
+             reg->Register.Index < TGSI_EXEC_NUM_TEMPS;
+   case TGSI_FILE_INPUT:
+      return !reg->Register.Dimension &&
+             reg->Register.Index < PIPE_MAX_SHADER_INPUTS;
+   case TGSI_FILE_CONSTANT:
+      return !reg->Register.Dimension ||
+             (!reg->Dimension.Indirect &&
+              reg->Dimension.Index < PIPE_MAX_CONSTANT_BUFFERS);
+   case TGSI_FILE_IMMEDIATE:
+      return !reg->Register.Dimension;
+   default:
+      return false;
+   }
+}
+
+
+static bool
+dst_is_native(const struct tgsi_full_dst_register *reg)
+{
+   if (reg->Register.Indirect || reg->Register.Dimension ||
+       reg->Register.Index < 0)
+      return false;
+
+   switch (reg->Register.File) {
+   case TGSI_FILE_TEMPORARY:
+      return reg->Register.Index < TGSI_EXEC_NUM_TEMPS;
+   case TGSI_FILE_OUTPUT:
+      return reg->Register.Index < PIPE_MAX_SHADER_OUTPUTS;
+   default:
+      return false;
+   }
+}
+
+
+static bool
+inst_is_native(const struct tgsi_full_instruction *inst)
+{
+   unsigned i;
+
+   switch (inst->Instruction.Opcode) {
+   case TGSI_OPCODE_MOV:
+   case TGSI_OPCODE_ADD:
+   case TGSI_OPCODE_MUL:
+   case TGSI_OPCODE_MAD:
+   case TGSI_OPCODE_LRP:
+   case TGSI_OPCODE_MIN:
+   case TGSI_OPCODE_MAX:
+   case TGSI_OPCODE_SLT:
+   case TGSI_OPCODE_SGE:
+   case TGSI_OPCODE_SEQ:
+   case TGSI_OPCODE_SNE:
+   case TGSI_OPCODE_CMP:
+   case TGSI_OPCODE_DP2:
+   case TGSI_OPCODE_DP3:
+   case TGSI_OPCODE_DP4:
+   case TGSI_OPCODE_RCP:
+   case TGSI_OPCODE_RSQ:
+   case TGSI_OPCODE_SQRT:
+      break;
+   default:
+      return false;
+   }
+
+   if (inst->Instruction.NumDstRegs != 1 || !dst_is_native(&inst->Dst[0]))
+      return false;
+
+   for (i = 0; i < inst->Instruction.NumSrcRegs; i++) {
+      if (!src_is_native(&inst->Src[i]))
+         return false;
+   }
+
+   return true;
+}
+
+
+/**
+ * Check the whole shader can run straight through, and count the
+ * branches to allocate.
+ */
+static bool
+scan_control_flow(const struct tgsi_exec_machine *mach,
+                  unsigned *num_branches)
+{
+   unsigned i;
+
+   *num_branches = 0;
+
+   for (i = 0; i < mach->NumInstructions; i++) {
+      switch (mach->Instructions[i].Instruction.Opcode) {
+      case TGSI_OPCODE_IF:
+      case TGSI_OPCODE_UIF:
+      case TGSI_OPCODE_ELSE:
+         (*num_branches)++;
+         break;
+      case TGSI_OPCODE_BGNLOOP:
+      case TGSI_OPCODE_ENDLOOP:
+      case TGSI_OPCODE_BRK:
+      case TGSI_OPCODE_CONT:
+      case TGSI_OPCODE_CAL:
+      case TGSI_OPCODE_RET:
+      case TGSI_OPCODE_BGNSUB:
+      case TGSI_OPCODE_ENDSUB:
+      case TGSI_OPCODE_SWITCH:
+      case TGSI_OPCODE_CASE:
+      case TGSI_OPCODE_DEFAULT:
+      case TGSI_OPCODE_ENDSWITCH:
+      case TGSI_OPCODE_BARRIER:
+      case TGSI_OPCODE_EMIT:
+      case TGSI_OPCODE_ENDPRIM:
+         return false;
+      default:
+         break;
+      }
+   }
+
+   return true;
+}
+
+
+static void
+emit_prologue(struct sse2_gen *gen)
+{
+   struct x86_function *f = gen->func;
+
+   x86_push(f, gen->machine);
+   x86_push(f, gen->helper);
+
+   if (x86_target(f) == X86_32) {
+      x86_mov(f, gen->machine, x86_fn_arg(f, 1));
+      x86_mov(f, gen->helper, x86_fn_arg(f, 2));
+      x86_sub_imm(f, x86_make_reg(file_REG32, reg_SP), FRAME_SIZE_32);
+   }
+   else {
+      x64_mov64(f, gen->machine, x86_fn_arg(f, 1));
+      x64_mov64(f, gen->helper, x86_fn_arg(f, 2));
+      x64_rexw(f);
+      x86_sub_imm(f, x86_make_reg(file_REG32, reg_SP), FRAME_SIZE_64);
+   }
+}
+
+
+static void
+emit_epilogue(struct sse2_gen *gen)
+{
+   struct x86_function *f = gen->func;
+
+   if (x86_target(f) == X86_32) {
+      x86_add_imm(f, x86_make_reg(file_REG32, reg_SP), FRAME_SIZE_32);
+   }
+   else {
+      x64_rexw(f);
+      x86_add_imm(f, x86_make_reg(file_REG32, reg_SP), FRAME_SIZE_64);
+   }
+
+   x86_pop(f, gen->helper);
+   x86_pop(f, gen->machine);
+   x86_ret(f);
+}
+
+
+static void
+emit_shader(struct sse2_gen *gen)
+{
+   const struct tgsi_exec_machine *mach = gen->mach;
+   unsigned pc, i;
+
+   emit_prologue(gen);
+
+   for (pc = 0; pc < mach->NumInstructions; pc++) {
+      const struct tgsi_full_instruction *inst = &mach->Instructions[pc];
+
+      resolve_branches(gen, pc);
+
+      if (inst->Instruction.Opcode == TGSI_OPCODE_END)
+         break;
+      if (inst->Instruction.Opcode == TGSI_OPCODE_NOP)
+         continue;
+
+      if (!inst_is_native(inst)) {
+         emit_helper_call(gen, pc);
+
+         if (inst->Instruction.Opcode == TGSI_OPCODE_IF ||
+             inst->Instruction.Opcode == TGSI_OPCODE_UIF ||
+             inst->Instruction.Opcode == TGSI_OPCODE_ELSE)
+            emit_branch(gen, inst, pc);
+         continue;
+      }
+
+      switch (inst->Instruction.Opcode) {
+      case TGSI_OPCODE_DP2:
+         emit_dot(gen, inst, 2);
+         break;
+      case TGSI_OPCODE_DP3:
+         emit_dot(gen, inst, 3);
+         break;
+      case TGSI_OPCODE_DP4:
+         emit_dot(gen, inst, 4);
+         break;
+      case TGSI_OPCODE_RCP:
+      case TGSI_OPCODE_RSQ:
+      case TGSI_OPCODE_SQRT:
+         emit_scalar(gen, inst);
+         break;
+      default:
+         emit_vector(gen, inst);
+         break;
+      }
+   }
+
+   /* Branches to END or past the last instruction. */
+   resolve_branches(gen, pc);
+   for (i = 0; i < gen->num_branches; i++) {
+      if (gen->branches[i].target != ~0u)
+         x86_fixup_fwd_jump(gen->func, gen->branches[i].fixup);
+   }
+
+   emit_epilogue(gen);
+}
+
+
+/**
+ * Compile the shader bound to \p mach.  The code only depends on the
+ * instructions, so it may be used with any machine the same tokens are
+ * bound to.  Returns NULL if the shader or CPU is not supported, in which
+ * case the interpreter should be used.
+ */
+struct tgsi_sse2_function *
+tgsi_sse2_create(const struct tgsi_exec_machine *mach)
+{
+   struct tgsi_sse2_function *func;
+   struct sse2_gen gen;
+   unsigned num_branches;
+
+   if (!util_get_cpu_caps()->has_sse2 || debug_get_option_nosse())
+      return NULL;
+
+   if (mach->ShaderType != PIPE_SHADER_VERTEX &&
+       mach->ShaderType != PIPE_SHADER_FRAGMENT)
+      return NULL;
+
+   if (!mach->NumInstructions ||
+       !scan_control_flow(mach, &num_branches))
+      return NULL;
+
+   func = CALLOC_STRUCT(tgsi_sse2_function);
+   if (!func)
+      return NULL;
+
+   memset(&gen, 0, sizeof(gen));
+   gen.func = &func->func;
+   gen.mach = mach;
+   gen.machine = x86_make_reg(file_REG32, reg_BX);
+   gen.helper = x86_make_reg(file_REG32, reg_BP);
+   gen.tmp = x86_make_reg(file_REG32, reg_AX);
+   gen.scratch = x86_make_disp(x86_make_reg(file_REG32, reg_SP),
+                               x86_target(gen.func) == X86_32 ?
+                               SCRATCH_OFS_32 : SCRATCH_OFS_64);
+   gen.masked = num_branches > 0;
+
+   if (num_branches) {
+      gen.branches = MALLOC(num_branches * sizeof(*gen.branches));
+      if (!gen.branches) {
+         FREE(func);
+         return NULL;
+      }
+   }
+
+   x86_init_func(&func->func);
+   emit_shader(&gen);
+   FREE(gen.branches);
+
+   if (!x86_get_func(&func->func)) {
+      tgsi_sse2_destroy(func);
+      return NULL;
+   }
+
+   return func;
+}
+
+
+tgsi_exec_jit_func
+tgsi_sse2_get_func(const struct tgsi_sse2_function *func)
+{
+   x86_func code = x86_get_func((struct x86_function *) &func->func);
+
+   return (tgsi_exec_jit_func) code;
+}
+
+
+void
+tgsi_sse2_destroy(struct tgsi_sse2_function *func)
+{
+   if (!func)
+      return;
+
+   x86_release_func(&func->func);
+   FREE(func);
+}
+
+#else /* !(DETECT_ARCH_X86 || DETECT_ARCH_X86_64) */
+
+#include "tgsi_sse2.h"
+
+
+struct tgsi_sse2_function *
+tgsi_sse2_create(const struct tgsi_exec_machine *mach)
+{
+   return NULL;
+}
+
+
+tgsi_exec_jit_func
+tgsi_sse2_get_func(const struct tgsi_sse2_function *func)
+{
+   return NULL;
+}
+
+
+void
+tgsi_sse2_destroy(struct tgsi_sse2_function *func)
+{
+}
+
+#endif
@@ -0,0 +1,63 @@
+/**************************************************************************
+ *
+ * Copyright 2007-2008 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * SSE2 code generator for TGSI vertex and fragment shaders.
+ *
+ * Float ALU instructions on directly addressed registers are translated to
+ * native code; everything else (texturing, kills, integer ops, indirect
+ * addressing, ...) is handed back to the interpreter one instruction at a
+ * time.  Shaders with loops, subroutines or switches are not compiled.
+ */
+
+#ifndef TGSI_SSE2_H
+#define TGSI_SSE2_H
+
+#include "tgsi_exec.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+struct tgsi_sse2_function;
+
+
+struct tgsi_sse2_function *
+tgsi_sse2_create(const struct tgsi_exec_machine *mach);
+
+tgsi_exec_jit_func
+tgsi_sse2_get_func(const struct tgsi_sse2_function *func);
+
+void
+tgsi_sse2_destroy(struct tgsi_sse2_function *func);
+
+
+#if defined __cplusplus
+}
+#endif
+
+#endif /* TGSI_SSE2_H */
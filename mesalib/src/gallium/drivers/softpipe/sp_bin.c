@@ -0,0 +1,777 @@
+/**************************************************************************
+ *
+ * Copyright 2007 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * Tile-binned, multi-threaded fragment processing.
+ *
+ * Setup hands us runs of up to 16 quads (the same batches it would pass
+ * to the quad pipeline) together with the interpolation coefficients of
+ * the primitive they belong to.  Runs are appended to the bin of the
+ * framebuffer tile (TILE_SIZE x TILE_SIZE, the tile cache granularity)
+ * they fall in.  Since a run never crosses a tile boundary and tiles are
+ * statically assigned to workers, each worker can replay its bins in
+ * submission order through a private quad pipeline without any locking.
+ *
+ * While binning is active the workers' tile caches own the framebuffer;
+ * sp_bin_release() writes them back before the context's own caches are
+ * used again.
+ */
+
+#include "pipe/p_defines.h"
+#include "util/u_math.h"
+#include "util/u_memory.h"
+#include "util/u_queue.h"
+#include "tgsi/tgsi_exec.h"
+
+#include "sp_bin.h"
+#include "sp_context.h"
+#include "sp_quad.h"
+#include "sp_quad_pipe.h"
+#include "sp_state.h"
+#include "sp_texture.h"
+#include "sp_tex_sample.h"
+#include "sp_tex_tile_cache.h"
+#include "sp_tile_cache.h"
+
+
+/** Max quads per run, matches MAX_QUADS in sp_setup.c */
+#define RUN_QUADS 16
+
+/** Batches with fewer runs than this are replayed on the calling thread */
+#define MIN_THREADED_RUNS 64
+
+/** Size of the blocks primitive records are allocated from */
+#define PRIM_BLOCK_SIZE (64 * 1024)
+
+
+/**
+ * Per-primitive state captured at setup time.
+ */
+struct sp_bin_prim {
+   struct tgsi_interp_coef posCoef;
+   unsigned layer;
+   unsigned viewport_index;
+   unsigned facing;
+   struct tgsi_interp_coef coef[];   /**< one per fragment shader input */
+};
+
+
+/**
+ * A horizontal run of quads on one pair of rows, see flush_spans().
+ */
+struct sp_bin_run {
+   const struct sp_bin_prim *prim;
+   int x, y;
+   unsigned mask0, mask1;   /**< two bits per quad for rows y and y + 1 */
+};
+
+
+struct sp_bin_tile {
+   struct sp_bin_run *runs;
+   unsigned count;
+   unsigned size;
+};
+
+
+struct sp_bin_block {
+   struct sp_bin_block *next;
+   unsigned used;
+   float data[PRIM_BLOCK_SIZE / sizeof(float)];
+};
+
+
+struct sp_bin_worker {
+   struct sp_bin_context *bin;
+   struct util_queue_fence fence;
+
+   /** Owned tiles with runs in the current batch, in first-use order */
+   unsigned *tiles;
+   unsigned num_tiles;
+
+   struct sp_quad_target target;
+   struct quad_stage *shade;
+   struct quad_stage *depth_test;
+   struct quad_stage *blend;
+   struct quad_stage *first;
+
+   /** Shader variant bound to target.machine */
+   const struct sp_fragment_shader_variant *fs_variant;
+
+   struct sp_tgsi_sampler *sampler;
+   struct softpipe_tex_tile_cache *tex_cache[PIPE_MAX_SHADER_SAMPLER_VIEWS];
+   unsigned num_sampler_views;
+
+   struct quad_header quad[RUN_QUADS];
+   struct quad_header *quad_ptrs[RUN_QUADS];
+};
+
+
+struct sp_bin_context {
+   struct softpipe_context *softpipe;
+
+   struct util_queue queue;
+   unsigned num_workers;
+   struct sp_bin_worker workers[SP_BIN_MAX_THREADS];
+
+   struct sp_bin_tile *tiles;
+   unsigned max_tiles;
+   unsigned tiles_x, tiles_y;
+   unsigned num_runs;
+
+   /** Primitive records, reset after every flush */
+   struct sp_bin_block *blocks;
+   struct sp_bin_block *cur_block;
+   unsigned prim_size;
+
+   /** Do the workers' tile caches own the framebuffer? */
+   bool workers_own_fb;
+};
+
+
+static inline unsigned
+tile_owner(const struct sp_bin_context *bin, unsigned tx, unsigned ty)
+{
+   return (tx + ty) % bin->num_workers;
+}
+
+
+/**
+ * Make the worker tile caches the owners of the framebuffer contents.
+ */
+static void
+acquire_framebuffer(struct sp_bin_context *bin)
+{
+   struct softpipe_context *sp = bin->softpipe;
+   unsigned i;
+
+   if (bin->workers_own_fb)
+      return;
+
+   for (i = 0; i < sp->framebuffer.nr_cbufs; i++) {
+      if (sp->cbuf_cache[i])
+         sp_flush_tile_cache(sp->cbuf_cache[i]);
+   }
+   sp_flush_tile_cache(sp->zsbuf_cache);
+
+   bin->workers_own_fb = true;
+}
+
+
+/**
+ * Bind the current fragment samplers and views to a worker, using the
+ * worker's private texture tile caches.
+ */
+static void
+update_worker_samplers(struct sp_bin_context *bin, struct sp_bin_worker *w)
+{
+   struct softpipe_context *sp = bin->softpipe;
+   const struct sp_tgsi_sampler *src = sp->tgsi.sampler[PIPE_SHADER_FRAGMENT];
+   const unsigned num_views = sp->num_sampler_views[PIPE_SHADER_FRAGMENT];
+   unsigned i;
+
+   memcpy(w->sampler->sp_sampler, src->sp_sampler,
+          sizeof(src->sp_sampler));
+
+   for (i = 0; i < MAX2(num_views, w->num_sampler_views); i++) {
+      struct pipe_sampler_view *view =
+         i < num_views ? sp->sampler_views[PIPE_SHADER_FRAGMENT][i] : NULL;
+      struct softpipe_tex_tile_cache *tc = w->tex_cache[i];
+
+      if (view && !tc) {
+         tc = w->tex_cache[i] = sp_create_tex_tile_cache(&sp->pipe);
+         if (!tc)
+            view = NULL;
+      }
+
+      if (tc) {
+         sp_tex_tile_cache_set_sampler_view(tc, view);
+
+         if (tc->texture) {
+            struct softpipe_resource *spt = softpipe_resource(tc->texture);
+            if (spt->timestamp != tc->timestamp) {
+               sp_tex_tile_cache_validate_texture(tc);
+               tc->timestamp = spt->timestamp;
+            }
+         }
+      }
+
+      w->sampler->sp_sview[i] = src->sp_sview[i];
+      w->sampler->sp_sview[i].cache = view ? tc : NULL;
+   }
+
+   w->num_sampler_views = num_views;
+}
+
+
+/**
+ * Bring a worker's quad pipeline up to date with the context state.
+ */
+static void
+prepare_worker(struct sp_bin_context *bin, struct sp_bin_worker *w)
+{
+   struct softpipe_context *sp = bin->softpipe;
+   unsigned i;
+
+   for (i = 0; i < PIPE_MAX_COLOR_BUFS; i++) {
+      struct pipe_surface *cbuf =
+         i < sp->framebuffer.nr_cbufs ? sp->framebuffer.cbufs[i] : NULL;
+
+      if (sp_tile_cache_get_surface(w->target.cbuf_cache[i]) != cbuf)
+         sp_tile_cache_set_surface(w->target.cbuf_cache[i], cbuf);
+   }
+   if (sp_tile_cache_get_surface(w->target.zsbuf_cache) != sp->framebuffer.zsbuf)
+      sp_tile_cache_set_surface(w->target.zsbuf_cache, sp->framebuffer.zsbuf);
+
+   update_worker_samplers(bin, w);
+
+   if (w->fs_variant != sp->fs_variant) {
+      sp->fs_variant->prepare(sp->fs_variant,
+                              w->target.machine,
+                              (struct tgsi_sampler *) w->sampler,
+                              (struct tgsi_image *) sp->tgsi.image[PIPE_SHADER_FRAGMENT],
+                              (struct tgsi_buffer *) sp->tgsi.buffer[PIPE_SHADER_FRAGMENT]);
+      w->fs_variant = sp->fs_variant;
+   }
+
+   /* Same stage order as sp_build_quad_pipeline() */
+   if (sp->early_depth) {
+      w->depth_test->next = w->shade;
+      w->shade->next = w->blend;
+      w->first = w->depth_test;
+   }
+   else {
+      w->shade->next = w->depth_test;
+      w->depth_test->next = w->blend;
+      w->first = w->shade;
+   }
+
+   w->first->begin(w->first);
+}
+
+
+/**
+ * Expand a run back into quads and send them down the worker's pipeline.
+ */
+static void
+replay_run(struct sp_bin_worker *w, const struct sp_bin_run *run)
+{
+   const struct sp_bin_prim *prim = run->prim;
+   unsigned mask0 = run->mask0;
+   unsigned mask1 = run->mask1;
+   int lx = run->x;
+   unsigned q = 0;
+
+   do {
+      unsigned quadmask = (mask0 & 3) | ((mask1 & 3) << 2);
+      if (quadmask) {
+         struct quad_header *quad = &w->quad[q];
+
+         quad->input.x0 = lx;
+         quad->input.y0 = run->y;
+         quad->input.facing = prim->facing;
+         quad->inout.mask = quadmask;
+         quad->coef = prim->coef;
+         quad->posCoef = &prim->posCoef;
+         w->quad_ptrs[q] = quad;
+         q++;
+      }
+      mask0 >>= 2;
+      mask1 >>= 2;
+      lx += 2;
+   } while (mask0 | mask1);
+
+   w->quad[0].input.layer = prim->layer;
+   w->quad[0].input.viewport_index = prim->viewport_index;
+
+   w->first->run(w->first, w->quad_ptrs, q);
+}
+
+
+/**
+ * Replay all bins owned by one worker.
+ * Called via util_queue or directly on the calling thread.
+ */
+static void
+worker_execute(void *data, void *gdata, int thread_index)
+{
+   struct sp_bin_worker *w = (struct sp_bin_worker *) data;
+   const struct sp_bin_context *bin = w->bin;
+   unsigned i, j;
+
+   for (i = 0; i < w->num_tiles; i++) {
+      const struct sp_bin_tile *tile = &bin->tiles[w->tiles[i]];
+
+      for (j = 0; j < tile->count; j++)
+         replay_run(w, &tile->runs[j]);
+   }
+}
+
+
+static void
+reset_bins(struct sp_bin_context *bin)
+{
+   struct sp_bin_block *block;
+   unsigned i, j;
+
+   for (i = 0; i < bin->num_workers; i++) {
+      struct sp_bin_worker *w = &bin->workers[i];
+
+      for (j = 0; j < w->num_tiles; j++)
+         bin->tiles[w->tiles[j]].count = 0;
+      w->num_tiles = 0;
+   }
+
+   for (block = bin->blocks; block; block = block->next)
+      block->used = 0;
+   bin->cur_block = bin->blocks;
+
+   bin->num_runs = 0;
+}
+
+
+/**
+ * Grow the bin grid to hold the current framebuffer.
+ */
+static bool
+resize_bins(struct sp_bin_context *bin, unsigned num_tiles)
+{
+   struct sp_bin_tile *tiles;
+   unsigned i;
+
+   tiles = CALLOC(num_tiles, sizeof *tiles);
+   if (!tiles)
+      return false;
+
+   for (i = 0; i < bin->num_workers; i++) {
+      struct sp_bin_worker *w = &bin->workers[i];
+      unsigned *owned = MALLOC(num_tiles * sizeof *owned);
+
+      if (!owned) {
+         FREE(tiles);
+         return false;
+      }
+      FREE(w->tiles);
+      w->tiles = owned;
+   }
+
+   if (bin->tiles) {
+      for (i = 0; i < bin->max_tiles; i++)
+         FREE(bin->tiles[i].runs);
+      FREE(bin->tiles);
+   }
+
+   bin->tiles = tiles;
+   bin->max_tiles = num_tiles;
+   return true;
+}
+
+
+/**
+ * Called by sp_setup_prepare() before a batch of primitives is set up.
+ * \return true if the batch should be binned, false if it has to go
+ *         through the context's quad pipeline.
+ */
+bool
+sp_bin_begin(struct sp_bin_context *bin)
+{
+   struct softpipe_context *sp = bin->softpipe;
+   unsigned tiles_x, tiles_y;
+
+   assert(bin->num_runs == 0);
+
+   if (!sp->fs_variant || sp->fs_variant->info.writes_memory)
+      goto serial;
+
+   tiles_x = DIV_ROUND_UP(sp->framebuffer.width, TILE_SIZE);
+   tiles_y = DIV_ROUND_UP(sp->framebuffer.height, TILE_SIZE);
+   if (!tiles_x || !tiles_y)
+      goto serial;
+
+   if (tiles_x * tiles_y > bin->max_tiles &&
+       !resize_bins(bin, tiles_x * tiles_y))
+      goto serial;
+
+   bin->tiles_x = tiles_x;
+   bin->tiles_y = tiles_y;
+   bin->prim_size = align(sizeof(struct sp_bin_prim) +
+                          sp->fs_variant->info.num_inputs *
+                          sizeof(struct tgsi_interp_coef), 16);
+   return true;
+
+serial:
+   sp_bin_release(bin);
+   return false;
+}
+
+
+/**
+ * Record the interpolants of the primitive currently being set up.
+ * \return the record, or NULL if out of memory
+ */
+const struct sp_bin_prim *
+sp_bin_add_prim(struct sp_bin_context *bin,
+                const struct tgsi_interp_coef *coef,
+                const struct tgsi_interp_coef *posCoef,
+                unsigned layer,
+                unsigned viewport_index,
+                unsigned facing)
+{
+   const struct softpipe_context *sp = bin->softpipe;
+   struct sp_bin_block *block = bin->cur_block;
+   struct sp_bin_prim *prim;
+
+   if (!block || block->used + bin->prim_size > sizeof(block->data)) {
+      struct sp_bin_block *next = block ? block->next : NULL;
+
+      if (!next) {
+         next = MALLOC_STRUCT(sp_bin_block);
+         if (!next)
+            return NULL;
+         next->next = NULL;
+
+         if (block)
+            block->next = next;
+         else
+            bin->blocks = next;
+      }
+
+      next->used = 0;
+      block = bin->cur_block = next;
+   }
+
+   prim = (struct sp_bin_prim *) ((uint8_t *) block->data + block->used);
+   block->used += bin->prim_size;
+
+   prim->posCoef = *posCoef;
+   prim->layer = layer;
+   prim->viewport_index = viewport_index;
+   prim->facing = facing;
+   memcpy(prim->coef, coef,
+          sp->fs_variant->info.num_inputs * sizeof(struct tgsi_interp_coef));
+
+   return prim;
+}
+
+
+/**
+ * Append a run of quads to the bin of the tile containing it.
+ */
+void
+sp_bin_add_run(struct sp_bin_context *bin,
+               const struct sp_bin_prim *prim,
+               int x, int y,
+               unsigned mask0, unsigned mask1)
+{
+   const unsigned tx = (unsigned) x >> TILE_SIZE_LOG2;
+   const unsigned ty = (unsigned) y >> TILE_SIZE_LOG2;
+   struct sp_bin_tile *tile;
+   struct sp_bin_run *run;
+
+   assert(tx < bin->tiles_x && ty < bin->tiles_y);
+   if (!prim || tx >= bin->tiles_x || ty >= bin->tiles_y)
+      return;
+
+   tile = &bin->tiles[ty * bin->tiles_x + tx];
+
+   if (tile->count == tile->size) {
+      unsigned size = MAX2(2 * tile->size, 32);
+      struct sp_bin_run *runs = REALLOC(tile->runs,
+                                        tile->size * sizeof *runs,
+                                        size * sizeof *runs);
+      if (!runs)
+         return;
+      tile->runs = runs;
+      tile->size = size;
+   }
+
+   if (tile->count == 0) {
+      struct sp_bin_worker *w = &bin->workers[tile_owner(bin, tx, ty)];
+      w->tiles[w->num_tiles++] = ty * bin->tiles_x + tx;
+   }
+
+   run = &tile->runs[tile->count++];
+   run->prim = prim;
+   run->x = x;
+   run->y = y;
+   run->mask0 = mask0;
+   run->mask1 = mask1;
+
+   bin->num_runs++;
+}
+
+
+/**
+ * Replay everything binned since the last flush.
+ */
+void
+sp_bin_flush(struct sp_bin_context *bin)
+{
+   struct softpipe_context *sp = bin->softpipe;
+   unsigned i;
+
+   if (!bin->num_runs)
+      return;
+
+   acquire_framebuffer(bin);
+
+   for (i = 0; i < bin->num_workers; i++) {
+      if (bin->workers[i].num_tiles)
+         prepare_worker(bin, &bin->workers[i]);
+   }
+
+   /* Queries accumulate into the context, so keep them single threaded. */
+   if (bin->num_workers > 1 &&
+       bin->num_runs >= MIN_THREADED_RUNS &&
+       !sp->active_query_count &&
+       !sp->active_statistics_queries) {
+      for (i = 1; i < bin->num_workers; i++) {
+         struct sp_bin_worker *w = &bin->workers[i];
+         if (w->num_tiles)
+            util_queue_add_job(&bin->queue, w, &w->fence,
+                               worker_execute, NULL, 0);
+      }
+
+      worker_execute(&bin->workers[0], NULL, 0);
+
+      for (i = 1; i < bin->num_workers; i++)
+         util_queue_fence_wait(&bin->workers[i].fence);
+   }
+   else {
+      for (i = 0; i < bin->num_workers; i++)
+         worker_execute(&bin->workers[i], NULL, 0);
+   }
+
+   reset_bins(bin);
+}
+
+
+/**
+ * Write back the worker tile caches so the framebuffer surfaces (and the
+ * context's own tile caches) see the binned rendering.
+ */
+void
+sp_bin_release(struct sp_bin_context *bin)
+{
+   unsigned i, j;
+
+   sp_bin_flush(bin);
+
+   if (!bin->workers_own_fb)
+      return;
+
+   for (i = 0; i < bin->num_workers; i++) {
+      struct sp_bin_worker *w = &bin->workers[i];
+
+      for (j = 0; j < PIPE_MAX_COLOR_BUFS; j++)
+         sp_flush_tile_cache(w->target.cbuf_cache[j]);
+      sp_flush_tile_cache(w->target.zsbuf_cache);
+   }
+
+   bin->workers_own_fb = false;
+}
+
+
+/**
+ * Called before the framebuffer state changes.
+ */
+void
+sp_bin_unbind_surfaces(struct sp_bin_context *bin)
+{
+   unsigned i, j;
+
+   sp_bin_release(bin);
+
+   for (i = 0; i < bin->num_workers; i++) {
+      struct sp_bin_worker *w = &bin->workers[i];
+
+      for (j = 0; j < PIPE_MAX_COLOR_BUFS; j++)
+         sp_tile_cache_set_surface(w->target.cbuf_cache[j], NULL);
+      sp_tile_cache_set_surface(w->target.zsbuf_cache, NULL);
+   }
+}
+
+
+void
+sp_bin_flush_texture_caches(struct sp_bin_context *bin)
+{
+   unsigned i, j;
+
+   for (i = 0; i < bin->num_workers; i++) {
+      struct sp_bin_worker *w = &bin->workers[i];
+
+      for (j = 0; j < ARRAY_SIZE(w->tex_cache); j++) {
+         if (w->tex_cache[j])
+            sp_flush_tex_tile_cache(w->tex_cache[j]);
+      }
+   }
+}
+
+
+/**
+ * Called before a fragment shader variant is deleted.
+ */
+void
+sp_bin_unbind_fs_variant(struct sp_bin_context *bin,
+                         const struct sp_fragment_shader_variant *var)
+{
+   unsigned i;
+
+   for (i = 0; i < bin->num_workers; i++) {
+      struct sp_bin_worker *w = &bin->workers[i];
+
+      if (w->fs_variant == var) {
+         tgsi_exec_machine_bind_shader(w->target.machine,
+                                       NULL, NULL, NULL, NULL);
+         w->fs_variant = NULL;
+      }
+   }
+}
+
+
+static bool
+init_worker(struct sp_bin_context *bin, struct sp_bin_worker *w)
+{
+   struct softpipe_context *sp = bin->softpipe;
+   unsigned i;
+
+   w->bin = bin;
+   util_queue_fence_init(&w->fence);
+
+   for (i = 0; i < PIPE_MAX_COLOR_BUFS; i++) {
+      w->target.cbuf_cache[i] = sp_create_tile_cache(&sp->pipe);
+      if (!w->target.cbuf_cache[i])
+         return false;
+   }
+   w->target.zsbuf_cache = sp_create_tile_cache(&sp->pipe);
+   w->target.machine = tgsi_exec_machine_create(PIPE_SHADER_FRAGMENT);
+   w->sampler = sp_create_tgsi_sampler();
+   if (!w->target.zsbuf_cache || !w->target.machine || !w->sampler)
+      return false;
+
+   w->shade = sp_quad_shade_stage(sp);
+   w->depth_test = sp_quad_depth_test_stage(sp);
+   w->blend = sp_quad_blend_stage(sp);
+   if (!w->shade || !w->depth_test || !w->blend)
+      return false;
+
+   w->shade->target = &w->target;
+   w->depth_test->target = &w->target;
+   w->blend->target = &w->target;
+
+   return true;
+}
+
+
+static void
+destroy_worker(struct sp_bin_worker *w)
+{
+   unsigned i;
+
+   if (w->shade)
+      w->shade->destroy(w->shade);
+   if (w->depth_test)
+      w->depth_test->destroy(w->depth_test);
+   if (w->blend)
+      w->blend->destroy(w->blend);
+
+   for (i = 0; i < PIPE_MAX_COLOR_BUFS; i++)
+      sp_destroy_tile_cache(w->target.cbuf_cache[i]);
+   sp_destroy_tile_cache(w->target.zsbuf_cache);
+
+   for (i = 0; i < ARRAY_SIZE(w->tex_cache); i++) {
+      if (w->tex_cache[i]) {
+         sp_tex_tile_cache_set_sampler_view(w->tex_cache[i], NULL);
+         sp_destroy_tex_tile_cache(w->tex_cache[i]);
+      }
+   }
+
+   if (w->target.machine)
+      tgsi_exec_machine_destroy(w->target.machine);
+
+   FREE(w->sampler);
+   FREE(w->tiles);
+   util_queue_fence_destroy(&w->fence);
+}
+
+
+/**
+ * Create the binning context.
+ * \param num_threads  number of workers, including the calling thread
+ */
+struct sp_bin_context *
+sp_bin_create(struct softpipe_context *sp, unsigned num_threads)
+{
+   struct sp_bin_context *bin = CALLOC_STRUCT(sp_bin_context);
+   unsigned i;
+
+   if (!bin)
+      return NULL;
+
+   bin->softpipe = sp;
+   bin->num_workers = CLAMP(num_threads, 1, SP_BIN_MAX_THREADS);
+
+   for (i = 0; i < bin->num_workers; i++) {
+      if (!init_worker(bin, &bin->workers[i]))
+         goto fail;
+   }
+
+   if (bin->num_workers > 1 &&
+       !util_queue_init(&bin->queue, "sp_bin", bin->num_workers,
+                        bin->num_workers - 1, 0, NULL))
+      goto fail;
+
+   return bin;
+
+fail:
+   sp_bin_destroy(bin);
+   return NULL;
+}
+
+
+void
+sp_bin_destroy(struct sp_bin_context *bin)
+{
+   struct sp_bin_block *block, *next;
+   unsigned i;
+
+   if (util_queue_is_initialized(&bin->queue))
+      util_queue_destroy(&bin->queue);
+
+   for (i = 0; i < bin->num_workers; i++)
+      destroy_worker(&bin->workers[i]);
+
+   for (i = 0; i < bin->max_tiles; i++)
+      FREE(bin->tiles[i].runs);
+   FREE(bin->tiles);
+
+   for (block = bin->blocks; block; block = next) {
+      next = block->next;
+      FREE(block);
+   }
+
+   FREE(bin);
+}
@@ -0,0 +1,96 @@
+/**************************************************************************
+ *
+ * Copyright 2007 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * Tile-binned, multi-threaded fragment processing.
+ *
+ * When enabled (SOFTPIPE_DEBUG=bin), primitive setup records runs of quads
+ * into per-tile bins instead of sending them down the quad pipeline.  The
+ * bins are replayed when the draw module flushes a batch of primitives.
+ * Every framebuffer tile is owned by one worker, which has its own shader
+ * machine, sampler and tile caches, so workers never touch the same pixels
+ * and per-tile primitive order is preserved.
+ */
+
+#ifndef SP_BIN_H
+#define SP_BIN_H
+
+#include "util/compiler.h"
+
+
+struct softpipe_context;
+struct sp_bin_context;
+struct sp_bin_prim;
+struct sp_fragment_shader_variant;
+struct tgsi_interp_coef;
+
+
+/** Max number of binning workers, including the calling thread */
+#define SP_BIN_MAX_THREADS 16
+
+
+struct sp_bin_context *
+sp_bin_create(struct softpipe_context *sp, unsigned num_threads);
+
+void
+sp_bin_destroy(struct sp_bin_context *bin);
+
+bool
+sp_bin_begin(struct sp_bin_context *bin);
+
+const struct sp_bin_prim *
+sp_bin_add_prim(struct sp_bin_context *bin,
+                const struct tgsi_interp_coef *coef,
+                const struct tgsi_interp_coef *posCoef,
+                unsigned layer,
+                unsigned viewport_index,
+                unsigned facing);
+
+void
+sp_bin_add_run(struct sp_bin_context *bin,
+               const struct sp_bin_prim *prim,
+               int x, int y,
+               unsigned mask0, unsigned mask1);
+
+void
+sp_bin_flush(struct sp_bin_context *bin);
+
+void
+sp_bin_release(struct sp_bin_context *bin);
+
+void
+sp_bin_unbind_surfaces(struct sp_bin_context *bin);
+
+void
+sp_bin_flush_texture_caches(struct sp_bin_context *bin);
+
+void
+sp_bin_unbind_fs_variant(struct sp_bin_context *bin,
+                         const struct sp_fragment_shader_variant *var);
+
+
+#endif /* SP_BIN_H */
@@ -35,6 +35,7 @@
 #include "pipe/p_defines.h"
 #include "util/u_pack_color.h"
 #include "util/u_surface.h"
+#include "sp_bin.h"
 #include "sp_clear.h"
 #include "sp_context.h"
 #include "sp_screen.h"
@@ -68,6 +69,10 @@ softpipe_clear(struct pipe_context *pipe, unsigned buffers,
    softpipe_update_derived(softpipe, MESA_PRIM_TRIANGLES); /* not needed?? */
 #endif
 
+   /* The clear goes through the context's tile caches */
+   if (softpipe->bin)
+      sp_bin_release(softpipe->bin);
+
    if (buffers & PIPE_CLEAR_COLOR) {
       for (i = 0; i < softpipe->framebuffer.nr_cbufs; i++) {
          if (buffers & (PIPE_CLEAR_COLOR0 << i))
@@ -20,12 +20,17 @@
  * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
  * USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
+#include "util/u_atomic.h"
 #include "util/u_inlines.h"
 #include "util/u_math.h"
 #include "util/u_memory.h"
+#include "util/u_queue.h"
+#include "util/os_time.h"
 #include "pipe/p_shader_tokens.h"
 #include "draw/draw_context.h"
 #include "draw/draw_vertex.h"
+#include "sp_bin.h"
+#include "sp_compute.h"
 #include "sp_context.h"
 #include "sp_screen.h"
 #include "sp_state.h"
@@ -161,20 +166,336 @@ fill_grid_size(struct pipe_context *context,
    pipe_buffer_unmap(context, transfer);
 }
 
+/**
+ * Create and prepare one exec machine per quad of invocations in a
+ * workgroup.
+ */
+static struct tgsi_exec_machine **
+create_group_machines(struct softpipe_context *softpipe,
+                      const struct sp_compute_shader *cs,
+                      const uint32_t grid_size[3],
+                      void *local_mem, unsigned local_mem_size,
+                      struct tgsi_sampler *sampler,
+                      mtx_t *atomic_mutex)
+{
+   const int bwidth = cs->info.properties[TGSI_PROPERTY_CS_FIXED_BLOCK_WIDTH];
+   const int bheight = cs->info.properties[TGSI_PROPERTY_CS_FIXED_BLOCK_HEIGHT];
+   const int bdepth = cs->info.properties[TGSI_PROPERTY_CS_FIXED_BLOCK_DEPTH];
+   const int num_threads_in_group =
+      DIV_ROUND_UP(bwidth, TGSI_QUAD_SIZE) * bheight * bdepth;
+   struct tgsi_exec_machine **machines;
+   int local_x, local_y, local_z;
+
+   machines = CALLOC(sizeof(struct tgsi_exec_machine *), num_threads_in_group);
+   if (!machines)
+      return NULL;
+
+   /* initialise machines + GRID_SIZE + THREAD_ID  + BLOCK_SIZE */
+   int idx = 0;
+   for (local_z = 0; local_z < bdepth; local_z++) {
+      for (local_y = 0; local_y < bheight; local_y++) {
+         for (local_x = 0; local_x < bwidth; local_x += TGSI_QUAD_SIZE) {
+            machines[idx] = tgsi_exec_machine_create(PIPE_SHADER_COMPUTE);
+
+            machines[idx]->LocalMem = local_mem;
+            machines[idx]->LocalMemSize = local_mem_size;
+            machines[idx]->AtomicMutex = atomic_mutex;
+            machines[idx]->NonHelperMask = (1 << (MIN2(TGSI_QUAD_SIZE, bwidth - local_x))) - 1;
+            cs_prepare(cs, machines[idx],
+                       local_x, local_y, local_z,
+                       grid_size[0], grid_size[1], grid_size[2],
+                       bwidth, bheight, bdepth,
+                       sampler,
+                       (struct tgsi_image *)softpipe->tgsi.image[PIPE_SHADER_COMPUTE],
+                       (struct tgsi_buffer *)softpipe->tgsi.buffer[PIPE_SHADER_COMPUTE]);
+            tgsi_exec_set_constant_buffers(machines[idx], PIPE_MAX_CONSTANT_BUFFERS,
+                                           softpipe->mapped_constants[PIPE_SHADER_COMPUTE]);
+            idx++;
+         }
+      }
+   }
+
+   return machines;
+}
+
+
+static void
+destroy_group_machines(const struct sp_compute_shader *cs,
+                       struct tgsi_exec_machine **machines,
+                       int num_threads_in_group)
+{
+   int i;
+
+   for (i = 0; i < num_threads_in_group; i++) {
+      cs_delete(cs, machines[i]);
+      tgsi_exec_machine_destroy(machines[i]);
+   }
+   FREE(machines);
+}
+
+
+struct sp_cs_worker {
+   struct sp_cs_pool *pool;
+   struct util_queue_fence fence;
+
+   struct sp_tgsi_sampler *sampler;
+   struct softpipe_tex_tile_cache *tex_cache[PIPE_MAX_SHADER_SAMPLER_VIEWS];
+   unsigned num_sampler_views;
+
+   /** Valid during a launch */
+   struct tgsi_exec_machine **machines;
+   void *local_mem;
+};
+
+
+struct sp_cs_pool {
+   struct softpipe_context *softpipe;
+
+   struct util_queue queue;
+   unsigned num_workers;
+   struct sp_cs_worker workers[SP_BIN_MAX_THREADS];
+
+   /** Serializes image and buffer atomics */
+   mtx_t atomic_mutex;
+
+   /** The grid being launched */
+   const struct sp_compute_shader *cs;
+   uint32_t grid_size[3];
+   int num_threads_in_group;
+   uint64_t num_groups;
+   uint64_t next_group;   /**< next unclaimed workgroup, atomic */
+   unsigned chunk;        /**< workgroups claimed at a time */
+};
+
+
+/**
+ * Bind the current compute samplers and views to a worker, using the
+ * worker's private texture tile caches.
+ */
+static void
+update_worker_samplers(struct sp_cs_pool *pool, struct sp_cs_worker *w)
+{
+   struct softpipe_context *sp = pool->softpipe;
+   const struct sp_tgsi_sampler *src = sp->tgsi.sampler[PIPE_SHADER_COMPUTE];
+   const unsigned num_views = sp->num_sampler_views[PIPE_SHADER_COMPUTE];
+   unsigned i;
+
+   memcpy(w->sampler->sp_sampler, src->sp_sampler,
+          sizeof(src->sp_sampler));
+
+   for (i = 0; i < MAX2(num_views, w->num_sampler_views); i++) {
+      struct pipe_sampler_view *view =
+         i < num_views ? sp->sampler_views[PIPE_SHADER_COMPUTE][i] : NULL;
+      struct softpipe_tex_tile_cache *tc = w->tex_cache[i];
+
+      if (view && !tc) {
+         tc = w->tex_cache[i] = sp_create_tex_tile_cache(&sp->pipe);
+         if (!tc)
+            view = NULL;
+      }
+
+      if (tc) {
+         sp_tex_tile_cache_set_sampler_view(tc, view);
+         /* The texture may have been rendered to since the last launch */
+         if (tc->texture)
+            sp_flush_tex_tile_cache(tc);
+      }
+
+      w->sampler->sp_sview[i] = src->sp_sview[i];
+      w->sampler->sp_sview[i].cache = view ? tc : NULL;
+   }
+
+   w->num_sampler_views = num_views;
+}
+
+
+static void
+cs_worker_execute(void *data, void *gdata, int thread_index)
+{
+   struct sp_cs_worker *w = (struct sp_cs_worker *)data;
+   struct sp_cs_pool *pool = w->pool;
+   const uint64_t gw = pool->grid_size[0];
+   const uint64_t gh = pool->grid_size[1];
+
+   for (;;) {
+      uint64_t end = p_atomic_add_return(&pool->next_group, pool->chunk);
+      uint64_t group = end - pool->chunk;
+
+      if (group >= pool->num_groups)
+         break;
+      end = MIN2(end, pool->num_groups);
+
+      for (; group < end; group++) {
+         run_workgroup(pool->cs,
+                       group % gw, (group / gw) % gh, group / (gw * gh),
+                       pool->num_threads_in_group, w->machines);
+      }
+   }
+}
+
+
+/**
+ * Run a grid on all pool workers.  Returns false if out of memory before
+ * anything was run.
+ */
+static bool
+cs_pool_launch(struct sp_cs_pool *pool,
+               const struct sp_compute_shader *cs,
+               const uint32_t grid_size[3],
+               unsigned shared_mem_size)
+{
+   struct softpipe_context *sp = pool->softpipe;
+   const int bwidth = cs->info.properties[TGSI_PROPERTY_CS_FIXED_BLOCK_WIDTH];
+   const int bheight = cs->info.properties[TGSI_PROPERTY_CS_FIXED_BLOCK_HEIGHT];
+   const int bdepth = cs->info.properties[TGSI_PROPERTY_CS_FIXED_BLOCK_DEPTH];
+   unsigned i;
+   bool ok = true;
+
+   pool->cs = cs;
+   pool->grid_size[0] = grid_size[0];
+   pool->grid_size[1] = grid_size[1];
+   pool->grid_size[2] = grid_size[2];
+   pool->num_threads_in_group =
+      DIV_ROUND_UP(bwidth, TGSI_QUAD_SIZE) * bheight * bdepth;
+   pool->num_groups = (uint64_t)grid_size[0] * grid_size[1] * grid_size[2];
+   pool->next_group = 0;
+   /* Small enough chunks to balance uneven workgroups, large enough to
+    * keep the counter from bouncing between cores.
+    */
+   pool->chunk = CLAMP(pool->num_groups / (pool->num_workers * 16), 1, 64);
+
+   for (i = 0; i < pool->num_workers; i++) {
+      struct sp_cs_worker *w = &pool->workers[i];
+
+      update_worker_samplers(pool, w);
+
+      if (shared_mem_size) {
+         w->local_mem = CALLOC(1, shared_mem_size);
+         if (!w->local_mem) {
+            ok = false;
+            break;
+         }
+      }
+
+      w->machines = create_group_machines(sp, cs, grid_size,
+                                          w->local_mem, shared_mem_size,
+                                          (struct tgsi_sampler *)w->sampler,
+                                          &pool->atomic_mutex);
+      if (!w->machines) {
+         ok = false;
+         break;
+      }
+   }
+
+   if (ok) {
+      for (i = 1; i < pool->num_workers; i++) {
+         struct sp_cs_worker *w = &pool->workers[i];
+         util_queue_add_job(&pool->queue, w, &w->fence,
+                            cs_worker_execute, NULL, 0);
+      }
+
+      cs_worker_execute(&pool->workers[0], NULL, 0);
+
+      for (i = 1; i < pool->num_workers; i++)
+         util_queue_fence_wait(&pool->workers[i].fence);
+   }
+
+   for (i = 0; i < pool->num_workers; i++) {
+      struct sp_cs_worker *w = &pool->workers[i];
+
+      if (w->machines)
+         destroy_group_machines(cs, w->machines, pool->num_threads_in_group);
+      FREE(w->local_mem);
+      w->machines = NULL;
+      w->local_mem = NULL;
+   }
+
+   return ok;
+}
+
+
+struct sp_cs_pool *
+sp_cs_pool_create(struct softpipe_context *sp, unsigned num_threads)
+{
+   struct sp_cs_pool *pool = CALLOC_STRUCT(sp_cs_pool);
+   unsigned i;
+
+   if (!pool)
+      return NULL;
+
+   pool->softpipe = sp;
+   pool->num_workers = CLAMP(num_threads, 1, SP_BIN_MAX_THREADS);
+   (void) mtx_init(&pool->atomic_mutex, mtx_plain);
+
+   for (i = 0; i < pool->num_workers; i++) {
+      struct sp_cs_worker *w = &pool->workers[i];
+
+      w->pool = pool;
+      util_queue_fence_init(&w->fence);
+      w->sampler = sp_create_tgsi_sampler();
+      if (!w->sampler)
+         goto fail;
+   }
+
+   if (pool->num_workers > 1 &&
+       !util_queue_init(&pool->queue, "sp_cs", pool->num_workers,
+                        pool->num_workers - 1, 0, NULL))
+      goto fail;
+
+   return pool;
+
+fail:
+   sp_cs_pool_destroy(pool);
+   return NULL;
+}
+
+
+void
+sp_cs_pool_destroy(struct sp_cs_pool *pool)
+{
+   unsigned i, j;
+
+   if (util_queue_is_initialized(&pool->queue))
+      util_queue_destroy(&pool->queue);
+
+   for (i = 0; i < pool->num_workers; i++) {
+      struct sp_cs_worker *w = &pool->workers[i];
+
+      for (j = 0; j < ARRAY_SIZE(w->tex_cache); j++) {
+         if (w->tex_cache[j]) {
+            sp_tex_tile_cache_set_sampler_view(w->tex_cache[j], NULL);
+            sp_destroy_tex_tile_cache(w->tex_cache[j]);
+         }
+      }
+      FREE(w->sampler);
+      util_queue_fence_destroy(&w->fence);
+   }
+
+   mtx_destroy(&pool->atomic_mutex);
+   FREE(pool);
+}
+
+
 void
 softpipe_launch_grid(struct pipe_context *context,
                      const struct pipe_grid_info *info)
 {
    struct softpipe_context *softpipe = softpipe_context(context);
+   struct softpipe_screen *screen = softpipe_screen(context->screen);
    struct sp_compute_shader *cs = softpipe->cs;
    int num_threads_in_group;
    struct tgsi_exec_machine **machines;
    int bwidth, bheight, bdepth;
-   int local_x, local_y, local_z, i;
    int g_w, g_h, g_d;
    uint32_t grid_size[3] = {0};
+   uint64_t num_groups;
+   unsigned num_threads = 1;
+   int64_t start_time = 0;
    void *local_mem = NULL;
 
+   if (unlikely(sp_debug & SP_DBG_CS_TIME))
+      start_time = os_time_get_nano();
+
    softpipe_update_compute_samplers(softpipe);
    bwidth = cs->info.properties[TGSI_PROPERTY_CS_FIXED_BLOCK_WIDTH];
    bheight = cs->info.properties[TGSI_PROPERTY_CS_FIXED_BLOCK_HEIGHT];
@@ -182,48 +503,45 @@ softpipe_launch_grid(struct pipe_context *context,
    num_threads_in_group = DIV_ROUND_UP(bwidth, TGSI_QUAD_SIZE) * bheight * bdepth;
 
    fill_grid_size(context, info, grid_size);
+   num_groups = (uint64_t)grid_size[0] * grid_size[1] * grid_size[2];
 
    uint32_t shared_mem_size = cs->shader.static_shared_mem + info->variable_shared_mem;
-   if (shared_mem_size) {
-      local_mem = CALLOC(1, shared_mem_size);
-   }
 
-   machines = CALLOC(sizeof(struct tgsi_exec_machine *), num_threads_in_group);
-   if (!machines) {
-      FREE(local_mem);
-      return;
+   /* Threads are created on first use, most contexts never run compute. */
+   if (screen->num_cs_threads > 1 && num_groups > 1 &&
+       !softpipe->cs_pool && !softpipe->cs_pool_failed) {
+      softpipe->cs_pool = sp_cs_pool_create(softpipe, screen->num_cs_threads);
+      softpipe->cs_pool_failed = !softpipe->cs_pool;
    }
 
-   /* initialise machines + GRID_SIZE + THREAD_ID  + BLOCK_SIZE */
-   int idx = 0;
-   for (local_z = 0; local_z < bdepth; local_z++) {
-      for (local_y = 0; local_y < bheight; local_y++) {
-         for (local_x = 0; local_x < bwidth; local_x += TGSI_QUAD_SIZE) {
-            machines[idx] = tgsi_exec_machine_create(PIPE_SHADER_COMPUTE);
+   if (softpipe->cs_pool && num_groups > 1 &&
+       cs_pool_launch(softpipe->cs_pool, cs, grid_size, shared_mem_size)) {
+      num_threads = softpipe->cs_pool->num_workers;
+   }
+   else {
+      if (shared_mem_size) {
+         local_mem = CALLOC(1, shared_mem_size);
+      }
 
-            machines[idx]->LocalMem = local_mem;
-            machines[idx]->LocalMemSize = shared_mem_size;
-            machines[idx]->NonHelperMask = (1 << (MIN2(TGSI_QUAD_SIZE, bwidth - local_x))) - 1;
-            cs_prepare(cs, machines[idx],
-                       local_x, local_y, local_z,
-                       grid_size[0], grid_size[1], grid_size[2],
-                       bwidth, bheight, bdepth,
-                       (struct tgsi_sampler *)softpipe->tgsi.sampler[PIPE_SHADER_COMPUTE],
-                       (struct tgsi_image *)softpipe->tgsi.image[PIPE_SHADER_COMPUTE],
-                       (struct tgsi_buffer *)softpipe->tgsi.buffer[PIPE_SHADER_COMPUTE]);
-            tgsi_exec_set_constant_buffers(machines[idx], PIPE_MAX_CONSTANT_BUFFERS,
-                                           softpipe->mapped_constants[PIPE_SHADER_COMPUTE]);
-            idx++;
-         }
+      machines = create_group_machines(softpipe, cs, grid_size,
+                                       local_mem, shared_mem_size,
+                                       (struct tgsi_sampler *)softpipe->tgsi.sampler[PIPE_SHADER_COMPUTE],
+                                       NULL);
+      if (!machines) {
+         FREE(local_mem);
+         return;
       }
-   }
 
-   for (g_d = 0; g_d < grid_size[2]; g_d++) {
-      for (g_h = 0; g_h < grid_size[1]; g_h++) {
-         for (g_w = 0; g_w < grid_size[0]; g_w++) {
-            run_workgroup(cs, g_w, g_h, g_d, num_threads_in_group, machines);
+      for (g_d = 0; g_d < grid_size[2]; g_d++) {
+         for (g_h = 0; g_h < grid_size[1]; g_h++) {
+            for (g_w = 0; g_w < grid_size[0]; g_w++) {
+               run_workgroup(cs, g_w, g_h, g_d, num_threads_in_group, machines);
+            }
          }
       }
+
+      destroy_group_machines(cs, machines, num_threads_in_group);
+      FREE(local_mem);
    }
 
    if (softpipe->active_statistics_queries) {
@@ -231,11 +549,10 @@ softpipe_launch_grid(struct pipe_context *context,
           grid_size[0] * grid_size[1] * grid_size[2];
    }
 
-   for (i = 0; i < num_threads_in_group; i++) {
-      cs_delete(cs, machines[i]);
-      tgsi_exec_machine_destroy(machines[i]);
+   if (unlikely(sp_debug & SP_DBG_CS_TIME)) {
+      debug_printf("softpipe: grid %ux%ux%u of %dx%dx%d on %u thread(s): %.3f ms\n",
+                   grid_size[0], grid_size[1], grid_size[2],
+                   bwidth, bheight, bdepth, num_threads,
+                   (os_time_get_nano() - start_time) / 1000000.0);
    }
-
-   FREE(local_mem);
-   FREE(machines);
 }
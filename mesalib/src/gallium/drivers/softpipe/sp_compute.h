@@ -0,0 +1,47 @@
+/*
+ * Copyright 2016 Red Hat.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * on the rights to use, copy, modify, merge, publish, distribute, sub
+ * license, and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHOR(S) AND/OR THEIR SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Multi-threaded compute dispatch.
+ *
+ * When enabled (SOFTPIPE_DEBUG=cs_threads), the workgroups of a grid are
+ * handed out to a pool of workers.  Each worker has its own exec machines,
+ * shared memory, sampler and texture tile caches; image and buffer atomics
+ * are serialized with a pool-wide mutex.
+ */
+
+#ifndef SP_COMPUTE_H
+#define SP_COMPUTE_H
+
+struct softpipe_context;
+struct sp_cs_pool;
+
+
+struct sp_cs_pool *
+sp_cs_pool_create(struct softpipe_context *sp, unsigned num_threads);
+
+void
+sp_cs_pool_destroy(struct sp_cs_pool *pool);
+
+
+#endif /* SP_COMPUTE_H */
@@ -39,6 +39,8 @@
 #include "util/u_upload_mgr.h"
 #include "util/u_debug_cb.h"
 #include "tgsi/tgsi_exec.h"
+#include "sp_bin.h"
+#include "sp_compute.h"
 #include "sp_buffer.h"
 #include "sp_clear.h"
 #include "sp_context.h"
@@ -69,6 +71,12 @@ softpipe_destroy( struct pipe_context *pipe )
    if (softpipe->draw)
       draw_destroy( softpipe->draw );
 
+   if (softpipe->bin)
+      sp_bin_destroy(softpipe->bin);
+
+   if (softpipe->cs_pool)
+      sp_cs_pool_destroy(softpipe->cs_pool);
+
    if (softpipe->quad.shade)
       softpipe->quad.shade->destroy( softpipe->quad.shade );
 
@@ -251,11 +259,22 @@ softpipe_create_context(struct pipe_screen *screen,
 
    softpipe->fs_machine = tgsi_exec_machine_create(PIPE_SHADER_FRAGMENT);
 
+   softpipe->quad.target.machine = softpipe->fs_machine;
+   for (i = 0; i < PIPE_MAX_COLOR_BUFS; i++)
+      softpipe->quad.target.cbuf_cache[i] = softpipe->cbuf_cache[i];
+   softpipe->quad.target.zsbuf_cache = softpipe->zsbuf_cache;
+
    /* setup quad rendering stages */
    softpipe->quad.shade = sp_quad_shade_stage(softpipe);
    softpipe->quad.depth_test = sp_quad_depth_test_stage(softpipe);
    softpipe->quad.blend = sp_quad_blend_stage(softpipe);
 
+   if (sp_screen->num_threads) {
+      softpipe->bin = sp_bin_create(softpipe, sp_screen->num_threads);
+      if (!softpipe->bin)
+         goto fail;
+   }
+
    softpipe->pipe.stream_uploader = u_upload_create_default(&softpipe->pipe);
    if (!softpipe->pipe.stream_uploader)
       goto fail;
@@ -42,6 +42,8 @@
 #include "tgsi/tgsi_exec.h"
 
 struct softpipe_vbuf_render;
+struct sp_bin_context;
+struct sp_cs_pool;
 struct draw_context;
 struct draw_stage;
 struct softpipe_tile_cache;
@@ -151,8 +153,17 @@ struct softpipe_context {
       struct quad_stage *depth_test;
       struct quad_stage *blend;
       struct quad_stage *first; /**< points to one of the above stages */
+      struct sp_quad_target target;
    } quad;
 
+   /** Tile binning state, NULL unless binned rasterization is enabled */
+   struct sp_bin_context *bin;
+
+   /** Compute workgroup threads, created by the first threaded launch */
+   struct sp_cs_pool *cs_pool;
+   /** Creating cs_pool failed, compute stays on the calling thread */
+   bool cs_pool_failed;
+
    /** TGSI exec things */
    struct {
       struct sp_tgsi_sampler *sampler[PIPE_SHADER_TYPES];
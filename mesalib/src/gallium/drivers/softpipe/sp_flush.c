@@ -33,6 +33,7 @@
 #include "pipe/p_defines.h"
 #include "pipe/p_screen.h"
 #include "draw/draw_context.h"
+#include "sp_bin.h"
 #include "sp_flush.h"
 #include "sp_context.h"
 #include "sp_state.h"
@@ -53,6 +54,12 @@ softpipe_flush( struct pipe_context *pipe,
 
    draw_flush(softpipe->draw);
 
+   if (softpipe->bin) {
+      sp_bin_release(softpipe->bin);
+      if (flags & SP_FLUSH_TEXTURE_CACHE)
+         sp_bin_flush_texture_caches(softpipe->bin);
+   }
+
    if (flags & SP_FLUSH_TEXTURE_CACHE) {
       unsigned sh;
 
@@ -174,6 +181,11 @@ void softpipe_texture_barrier(struct pipe_context *pipe, unsigned flags)
    struct softpipe_context *softpipe = softpipe_context(pipe);
    uint i, sh;
 
+   if (softpipe->bin) {
+      sp_bin_release(softpipe->bin);
+      sp_bin_flush_texture_caches(softpipe->bin);
+   }
+
    for (sh = 0; sh < ARRAY_SIZE(softpipe->tex_cache); sh++) {
       for (i = 0; i < softpipe->num_sampler_views[sh]; i++) {
          sp_flush_tex_tile_cache(softpipe->tex_cache[sh][i]);
@@ -38,6 +38,7 @@
 #include "pipe/p_defines.h"
 #include "util/u_memory.h"
 #include "tgsi/tgsi_exec.h"
+#include "tgsi/tgsi_sse2.h"
 
 
 /**
@@ -46,10 +47,21 @@
 struct sp_exec_fragment_shader
 {
    struct sp_fragment_shader_variant base;
-   /* No other members for now */
+
+   /** Native code for the variant's tokens, compiled on first prepare */
+   struct tgsi_sse2_function *sse2;
+   bool sse2_tried;
 };
 
 
+/** cast wrapper */
+static inline struct sp_exec_fragment_shader *
+sp_exec_fragment_shader(const struct sp_fragment_shader_variant *var)
+{
+   return (struct sp_exec_fragment_shader *) var;
+}
+
+
 static void
 exec_prepare( const struct sp_fragment_shader_variant *var,
               struct tgsi_exec_machine *machine,
@@ -57,12 +69,22 @@ exec_prepare( const struct sp_fragment_shader_variant *var,
               struct tgsi_image *image,
               struct tgsi_buffer *buffer )
 {
+   struct sp_exec_fragment_shader *spefs = sp_exec_fragment_shader(var);
+
    /*
     * Bind tokens/shader to the interpreter's machine state.
     */
    tgsi_exec_machine_bind_shader(machine,
                                  var->tokens,
                                  sampler, image, buffer);
+
+   /* Variants are keyed by shader and state, so is the compiled code. */
+   if (!spefs->sse2_tried) {
+      spefs->sse2 = tgsi_sse2_create(machine);
+      spefs->sse2_tried = true;
+   }
+   if (spefs->sse2)
+      machine->Jit = tgsi_sse2_get_func(spefs->sse2);
 }
 
 
@@ -181,6 +203,7 @@ exec_delete(struct sp_fragment_shader_variant *var,
       tgsi_exec_machine_bind_shader(machine, NULL, NULL, NULL, NULL);
    }
 
+   tgsi_sse2_destroy(sp_exec_fragment_shader(var)->sse2);
    FREE( (void *) var->tokens );
    FREE(var);
 }
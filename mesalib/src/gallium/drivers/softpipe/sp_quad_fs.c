@@ -63,7 +63,7 @@ static inline bool
 shade_quad(struct quad_stage *qs, struct quad_header *quad)
 {
    struct softpipe_context *softpipe = qs->softpipe;
-   struct tgsi_exec_machine *machine = softpipe->fs_machine;
+   struct tgsi_exec_machine *machine = qs->target->machine;
 
    if (softpipe->active_statistics_queries) {
       softpipe->pipeline_statistics.ps_invocations +=
@@ -106,7 +106,7 @@ shade_quads(struct quad_stage *qs,
             unsigned nr)
 {
    struct softpipe_context *softpipe = qs->softpipe;
-   struct tgsi_exec_machine *machine = softpipe->fs_machine;
+   struct tgsi_exec_machine *machine = qs->target->machine;
    unsigned i, nr_quads = 0;
 
    tgsi_exec_set_constant_buffers(machine, PIPE_MAX_CONSTANT_BUFFERS,
@@ -163,6 +163,7 @@ sp_quad_shade_stage( struct softpipe_context *softpipe )
       goto fail;
 
    qss->stage.softpipe = softpipe;
+   qss->stage.target = &softpipe->quad.target;
    qss->stage.begin = shade_begin;
    qss->stage.run = shade_quads;
    qss->stage.destroy = shade_destroy;
@@ -31,9 +31,25 @@
 #ifndef SP_QUAD_PIPE_H
 #define SP_QUAD_PIPE_H
 
+#include "pipe/p_state.h"
+
 
 struct softpipe_context;
 struct quad_header;
+struct softpipe_tile_cache;
+struct tgsi_exec_machine;
+
+
+/**
+ * The per-thread resources a quad pipeline renders with.  The context
+ * owns one for the regular, single-threaded path; each tile binning
+ * worker (see sp_bin.c) owns another so pipelines can run concurrently.
+ */
+struct sp_quad_target {
+   struct tgsi_exec_machine *machine;
+   struct softpipe_tile_cache *cbuf_cache[PIPE_MAX_COLOR_BUFS];
+   struct softpipe_tile_cache *zsbuf_cache;
+};
 
 
 /**
@@ -44,6 +60,9 @@ struct quad_header;
 struct quad_stage {
    struct softpipe_context *softpipe;
 
+   /** Shader machine and tile caches used by this stage */
+   const struct sp_quad_target *target;
+
    struct quad_stage *next;
 
    void (*begin)(struct quad_stage *qs);
@@ -27,6 +27,7 @@
 
 
 #include "compiler/nir/nir.h"
+#include "util/u_cpu_detect.h"
 #include "util/u_helpers.h"
 #include "util/u_memory.h"
 #include "util/format/u_format.h"
@@ -42,6 +43,7 @@
 #include "frontend/sw_winsys.h"
 #include "tgsi/tgsi_exec.h"
 
+#include "sp_bin.h"
 #include "sp_texture.h"
 #include "sp_screen.h"
 #include "sp_context.h"
@@ -55,6 +57,9 @@ static const struct debug_named_value sp_debug_options[] = {
    {"cs",        SP_DBG_CS,         "dump compute shader assembly to stderr"},
    {"no_rast",   SP_DBG_NO_RAST,    "no-ops rasterization, for profiling purposes"},
    {"use_llvm",  SP_DBG_USE_LLVM,   "Use LLVM if available for shaders"},
+   {"bin",       SP_DBG_BIN,        "bin quads per tile and shade tiles in parallel"},
+   {"cs_threads", SP_DBG_CS_THREADS, "run compute workgroups on several threads"},
+   {"cs_time",   SP_DBG_CS_TIME,    "print compute grid launch times to stderr"},
    DEBUG_NAMED_VALUE_END
 };
 
@@ -606,6 +611,17 @@ softpipe_create_screen(struct sw_winsys *winsys)
    screen->base.get_compiler_options = softpipe_get_compiler_options;
    screen->use_llvm = sp_debug & SP_DBG_USE_LLVM;
 
+   if (sp_debug & (SP_DBG_BIN | SP_DBG_CS_THREADS)) {
+      int64_t threads = debug_get_num_option("SOFTPIPE_NUM_THREADS",
+                                             util_get_cpu_caps()->nr_cpus);
+      threads = CLAMP(threads, 1, SP_BIN_MAX_THREADS);
+
+      if (sp_debug & SP_DBG_BIN)
+         screen->num_threads = threads;
+      if (sp_debug & SP_DBG_CS_THREADS)
+         screen->num_cs_threads = threads;
+   }
+
    softpipe_init_screen_texture_funcs(&screen->base);
    softpipe_init_screen_fence_funcs(&screen->base);
 
@@ -47,6 +47,12 @@ struct softpipe_screen {
     */
    unsigned timestamp;
    bool use_llvm;
+
+   /** Number of tile binning threads, 0 if binning is disabled */
+   unsigned num_threads;
+
+   /** Number of compute workgroup threads, 0 if disabled */
+   unsigned num_cs_threads;
 };
 
 static inline struct softpipe_screen *
@@ -64,6 +70,9 @@ enum sp_debug_flag {
    SP_DBG_CS              = BITFIELD_BIT(5),
    SP_DBG_USE_LLVM        = BITFIELD_BIT(6),
    SP_DBG_NO_RAST         = BITFIELD_BIT(7),
+   SP_DBG_BIN             = BITFIELD_BIT(8),
+   SP_DBG_CS_THREADS      = BITFIELD_BIT(9),
+   SP_DBG_CS_TIME         = BITFIELD_BIT(10),
 };
 
 extern int sp_debug;
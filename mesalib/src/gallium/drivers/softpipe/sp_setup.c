@@ -32,6 +32,7 @@
  * \author  Brian Paul
  */
 
+#include "sp_bin.h"
 #include "sp_context.h"
 #include "sp_screen.h"
 #include "sp_quad.h"
@@ -114,6 +115,11 @@ struct setup_context {
 
    unsigned cull_face;		/* which faces cull */
    unsigned nr_vertex_attrs;
+
+   /** Binning context if quads are binned rather than rendered directly */
+   struct sp_bin_context *bin;
+   /** Binned copy of the current primitive, created on first use */
+   const struct sp_bin_prim *bin_prim;
 };
 
 
@@ -154,6 +160,24 @@ quad_clip(struct setup_context *setup, struct quad_header *quad)
 }
 
 
+/**
+ * Return the binned record of the current primitive's interpolants.
+ */
+static inline const struct sp_bin_prim *
+get_bin_prim(struct setup_context *setup, unsigned facing)
+{
+   if (!setup->bin_prim) {
+      setup->bin_prim = sp_bin_add_prim(setup->bin,
+                                        setup->coef,
+                                        &setup->posCoef,
+                                        setup->quad[0].input.layer,
+                                        setup->quad[0].input.viewport_index,
+                                        facing);
+   }
+   return setup->bin_prim;
+}
+
+
 /**
  * Emit a quad (pass to next stage) with clipping.
  */
@@ -169,6 +193,14 @@ clip_emit_quad(struct setup_context *setup, struct quad_header *quad)
       setup->numFragsEmitted += util_bitcount(quad->inout.mask);
 #endif
 
+      if (setup->bin) {
+         sp_bin_add_run(setup->bin,
+                        get_bin_prim(setup, quad->input.facing),
+                        quad->input.x0, quad->input.y0,
+                        quad->inout.mask & 3, quad->inout.mask >> 2);
+         return;
+      }
+
       sp->quad.first->run( sp->quad.first, &quad, 1 );
    }
 }
@@ -230,7 +262,11 @@ flush_spans(struct setup_context *setup)
       unsigned mask0 = ~skipmask_left0 & ~skipmask_right0;
       unsigned mask1 = ~skipmask_left1 & ~skipmask_right1;
 
-      if (mask0 | mask1) {
+      if ((mask0 | mask1) && setup->bin) {
+         sp_bin_add_run(setup->bin, get_bin_prim(setup, setup->facing),
+                        x, setup->span.y, mask0, mask1);
+      }
+      else if (mask0 | mask1) {
          do {
             unsigned quadmask = (mask0 & 3) | ((mask1 & 3) << 2);
             if (quadmask) {
@@ -762,6 +798,8 @@ sp_setup_tri(struct setup_context *setup,
    if (unlikely(sp_debug & SP_DBG_NO_RAST) ||
        setup->softpipe->rasterizer->rasterizer_discard)
       return;
+
+   setup->bin_prim = NULL;
    
    det = calc_det(v0, v1, v2);
    /*
@@ -1019,6 +1057,8 @@ sp_setup_line(struct setup_context *setup,
        setup->softpipe->rasterizer->rasterizer_discard)
       return;
 
+   setup->bin_prim = NULL;
+
    if (dx == 0 && dy == 0)
       return;
 
@@ -1167,6 +1207,8 @@ sp_setup_point(struct setup_context *setup,
        setup->softpipe->rasterizer->rasterizer_discard)
       return;
 
+   setup->bin_prim = NULL;
+
    assert(setup->softpipe->reduced_prim == MESA_PRIM_POINTS);
 
    if (setup->softpipe->layer_slot > 0) {
@@ -1401,6 +1443,8 @@ sp_setup_prepare(struct setup_context *setup)
 
    setup->max_layer = max_layer;
 
+   setup->bin = sp->bin && sp_bin_begin(sp->bin) ? sp->bin : NULL;
+
    sp->quad.first->begin( sp->quad.first );
 
    if (sp->reduced_api_prim == MESA_PRIM_TRIANGLES &&
@@ -1416,6 +1460,18 @@ sp_setup_prepare(struct setup_context *setup)
 }
 
 
+/**
+ * Called after a batch of primitives has been set up.  Renders any quads
+ * that were binned rather than sent down the quad pipeline.
+ */
+void
+sp_setup_flush(struct setup_context *setup)
+{
+   if (setup->bin)
+      sp_bin_flush(setup->bin);
+}
+
+
 void
 sp_setup_destroy_context(struct setup_context *setup)
 {
@@ -25,6 +25,7 @@
  * 
  **************************************************************************/
 
+#include "sp_bin.h"
 #include "sp_context.h"
 #include "sp_screen.h"
 #include "sp_state.h"
@@ -218,6 +219,9 @@ softpipe_delete_fs_state(struct pipe_context *pipe, void *fs)
       draw_delete_fragment_shader(softpipe->draw, var->draw_shader);
 #endif
 
+      if (softpipe->bin)
+         sp_bin_unbind_fs_variant(softpipe->bin, var);
+
       var->delete(var, softpipe->fs_machine);
    }
 
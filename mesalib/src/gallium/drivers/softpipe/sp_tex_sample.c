@@ -39,8 +39,10 @@
 #include "pipe/p_shader_tokens.h"
 #include "util/u_math.h"
 #include "util/format/u_format.h"
+#include "util/format/format_utils.h"
 #include "util/u_memory.h"
 #include "util/u_inlines.h"
+#include "util/u_sse.h"
 #include "sp_quad.h"   /* only for #define QUAD_* tokens */
 #include "sp_tex_sample.h"
 #include "sp_texture.h"
@@ -3176,6 +3178,226 @@ get_filters(const struct sp_sampler_view *sp_sview,
    }
 }
 
+/**
+ * Get a texel from a native unorm8 tile, as packed R,G,B,A bytes.
+ * The coordinates must be inside the texture level.
+ */
+static inline uint32_t
+get_texel_2d_unorm8(const struct sp_sampler_view *sp_sview,
+                    union tex_tile_address addr, int x, int y)
+{
+   const struct softpipe_tex_cached_tile_unorm8 *tile;
+
+   addr.bits.x = x / TEX_TILE_SIZE;
+   addr.bits.y = y / TEX_TILE_SIZE;
+   tile = sp_get_cached_tile_tex_unorm8(sp_sview->cache, addr);
+
+   return tile->color[y % TEX_TILE_SIZE][x % TEX_TILE_SIZE];
+}
+
+
+#if DETECT_ARCH_SSE
+
+/**
+ * Convert four pixels of 16-bit channels (pixels 0,1 in lo, 2,3 in hi)
+ * holding unorm8 values to float and store them channel-major.
+ */
+static inline void
+store_unorm8x16_quad(__m128i lo, __m128i hi,
+                     float rgba[TGSI_NUM_CHANNELS][TGSI_QUAD_SIZE])
+{
+   const __m128i zero = _mm_setzero_si128();
+   const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+   __m128 p0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero));
+   __m128 p1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero));
+   __m128 p2 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero));
+   __m128 p3 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero));
+
+   p0 = _mm_mul_ps(p0, scale);
+   p1 = _mm_mul_ps(p1, scale);
+   p2 = _mm_mul_ps(p2, scale);
+   p3 = _mm_mul_ps(p3, scale);
+
+   _MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+
+   _mm_storeu_ps(rgba[0], p0);
+   _mm_storeu_ps(rgba[1], p1);
+   _mm_storeu_ps(rgba[2], p2);
+   _mm_storeu_ps(rgba[3], p3);
+}
+
+
+/**
+ * (a * (256 - w) + b * w + 128) >> 8 on 16-bit lanes, w in [0, 256].
+ */
+static inline __m128i
+lerp_unorm8x16(__m128i w, __m128i a, __m128i b)
+{
+   const __m128i one = _mm_set1_epi16(256);
+   const __m128i half = _mm_set1_epi16(128);
+   __m128i r;
+
+   r = _mm_add_epi16(_mm_mullo_epi16(a, _mm_sub_epi16(one, w)),
+                     _mm_mullo_epi16(b, w));
+   return _mm_srli_epi16(_mm_add_epi16(r, half), 8);
+}
+
+
+static void
+unorm8_to_float_quad(const uint32_t tx[TGSI_QUAD_SIZE],
+                     float rgba[TGSI_NUM_CHANNELS][TGSI_QUAD_SIZE])
+{
+   const __m128i zero = _mm_setzero_si128();
+   const __m128i t = _mm_loadu_si128((const __m128i *) tx);
+
+   store_unorm8x16_quad(_mm_unpacklo_epi8(t, zero),
+                        _mm_unpackhi_epi8(t, zero), rgba);
+}
+
+
+static void
+lerp_2d_unorm8_quad(const uint32_t tx[4][TGSI_QUAD_SIZE],
+                    const uint16_t xw[TGSI_QUAD_SIZE],
+                    const uint16_t yw[TGSI_QUAD_SIZE],
+                    float rgba[TGSI_NUM_CHANNELS][TGSI_QUAD_SIZE])
+{
+   const __m128i zero = _mm_setzero_si128();
+   const __m128i xw_lo = _mm_set_epi16(xw[1], xw[1], xw[1], xw[1],
+                                       xw[0], xw[0], xw[0], xw[0]);
+   const __m128i xw_hi = _mm_set_epi16(xw[3], xw[3], xw[3], xw[3],
+                                       xw[2], xw[2], xw[2], xw[2]);
+   const __m128i yw_lo = _mm_set_epi16(yw[1], yw[1], yw[1], yw[1],
+                                       yw[0], yw[0], yw[0], yw[0]);
+   const __m128i yw_hi = _mm_set_epi16(yw[3], yw[3], yw[3], yw[3],
+                                       yw[2], yw[2], yw[2], yw[2]);
+   const __m128i t00 = _mm_loadu_si128((const __m128i *) tx[0]);
+   const __m128i t10 = _mm_loadu_si128((const __m128i *) tx[1]);
+   const __m128i t01 = _mm_loadu_si128((const __m128i *) tx[2]);
+   const __m128i t11 = _mm_loadu_si128((const __m128i *) tx[3]);
+   __m128i r0, r1, lo, hi;
+
+   r0 = lerp_unorm8x16(xw_lo, _mm_unpacklo_epi8(t00, zero),
+                       _mm_unpacklo_epi8(t10, zero));
+   r1 = lerp_unorm8x16(xw_lo, _mm_unpacklo_epi8(t01, zero),
+                       _mm_unpacklo_epi8(t11, zero));
+   lo = lerp_unorm8x16(yw_lo, r0, r1);
+
+   r0 = lerp_unorm8x16(xw_hi, _mm_unpackhi_epi8(t00, zero),
+                       _mm_unpackhi_epi8(t10, zero));
+   r1 = lerp_unorm8x16(xw_hi, _mm_unpackhi_epi8(t01, zero),
+                       _mm_unpackhi_epi8(t11, zero));
+   hi = lerp_unorm8x16(yw_hi, r0, r1);
+
+   store_unorm8x16_quad(lo, hi, rgba);
+}
+
+#else /* !DETECT_ARCH_SSE */
+
+static inline unsigned
+lerp_unorm8(unsigned w, unsigned a, unsigned b)
+{
+   return (a * (256 - w) + b * w + 128) >> 8;
+}
+
+
+static void
+unorm8_to_float_quad(const uint32_t tx[TGSI_QUAD_SIZE],
+                     float rgba[TGSI_NUM_CHANNELS][TGSI_QUAD_SIZE])
+{
+   int j, c;
+
+   for (j = 0; j < TGSI_QUAD_SIZE; j++) {
+      for (c = 0; c < TGSI_NUM_CHANNELS; c++)
+         rgba[c][j] = _mesa_unorm_to_float((tx[j] >> (8 * c)) & 0xff, 8);
+   }
+}
+
+
+static void
+lerp_2d_unorm8_quad(const uint32_t tx[4][TGSI_QUAD_SIZE],
+                    const uint16_t xw[TGSI_QUAD_SIZE],
+                    const uint16_t yw[TGSI_QUAD_SIZE],
+                    float rgba[TGSI_NUM_CHANNELS][TGSI_QUAD_SIZE])
+{
+   int j, c;
+
+   for (j = 0; j < TGSI_QUAD_SIZE; j++) {
+      for (c = 0; c < TGSI_NUM_CHANNELS; c++) {
+         const unsigned shift = 8 * c;
+         const unsigned r0 = lerp_unorm8(xw[j],
+                                         (tx[0][j] >> shift) & 0xff,
+                                         (tx[1][j] >> shift) & 0xff);
+         const unsigned r1 = lerp_unorm8(xw[j],
+                                         (tx[2][j] >> shift) & 0xff,
+                                         (tx[3][j] >> shift) & 0xff);
+         rgba[c][j] = _mesa_unorm_to_float(lerp_unorm8(yw[j], r0, r1), 8);
+      }
+   }
+}
+
+#endif /* DETECT_ARCH_SSE */
+
+
+/**
+ * Fast path for 2D RGBA8 textures sampled without mipmapping, with
+ * clamp-to-edge or repeat wrapping and no compare (see sp_sampler::unorm8
+ * and sp_sampler_view::unorm8).  Texels are fetched from the native unorm8
+ * tile cache and filtered in 8-bit fixed point with 8-bit weights, so
+ * bilinear results can differ from the float path by up to 2/255.
+ * The wrap modes never produce coordinates outside the level, so no
+ * border color handling is needed.
+ */
+static void
+sample_2d_unorm8(const struct sp_sampler_view *sp_sview,
+                 const struct sp_sampler *sp_samp,
+                 const float s[TGSI_QUAD_SIZE],
+                 const float t[TGSI_QUAD_SIZE],
+                 float rgba[TGSI_NUM_CHANNELS][TGSI_QUAD_SIZE])
+{
+   const struct pipe_resource *texture = sp_sview->base.texture;
+   const unsigned level = sp_sview->base.u.tex.first_level;
+   const int width = u_minify(texture->width0, level);
+   const int height = u_minify(texture->height0, level);
+   union tex_tile_address addr;
+   uint32_t tx[4][TGSI_QUAD_SIZE];
+   int j;
+
+   addr.value = 0;
+   addr.bits.level = level;
+   addr.bits.z = sp_sview->base.u.tex.first_layer;
+
+   if (sp_samp->min_img_filter == PIPE_TEX_FILTER_NEAREST) {
+      for (j = 0; j < TGSI_QUAD_SIZE; j++) {
+         int x, y;
+
+         sp_samp->nearest_texcoord_s(s[j], width, 0, &x);
+         sp_samp->nearest_texcoord_t(t[j], height, 0, &y);
+         tx[0][j] = get_texel_2d_unorm8(sp_sview, addr, x, y);
+      }
+      unorm8_to_float_quad(tx[0], rgba);
+   }
+   else {
+      uint16_t xw[TGSI_QUAD_SIZE], yw[TGSI_QUAD_SIZE];
+
+      for (j = 0; j < TGSI_QUAD_SIZE; j++) {
+         int x0, y0, x1, y1;
+         float fxw, fyw;
+
+         sp_samp->linear_texcoord_s(s[j], width, 0, &x0, &x1, &fxw);
+         sp_samp->linear_texcoord_t(t[j], height, 0, &y0, &y1, &fyw);
+
+         tx[0][j] = get_texel_2d_unorm8(sp_sview, addr, x0, y0);
+         tx[1][j] = get_texel_2d_unorm8(sp_sview, addr, x1, y0);
+         tx[2][j] = get_texel_2d_unorm8(sp_sview, addr, x0, y1);
+         tx[3][j] = get_texel_2d_unorm8(sp_sview, addr, x1, y1);
+         xw[j] = (uint16_t) util_iround(fxw * 256.0f);
+         yw[j] = (uint16_t) util_iround(fyw * 256.0f);
+      }
+      lerp_2d_unorm8_quad(tx, xw, yw, rgba);
+   }
+}
+
+
 static void
 sample_mip(const struct sp_sampler_view *sp_sview,
            const struct sp_sampler *sp_samp,
@@ -3192,11 +3414,18 @@ sample_mip(const struct sp_sampler_view *sp_sview,
    img_filter_func min_img_filter = NULL;
    img_filter_func mag_img_filter = NULL;
 
-   get_filters(sp_sview, sp_samp, filt_args->control,
-               &funcs, &min_img_filter, &mag_img_filter);
+   if (sp_sview->unorm8 && sp_samp->unorm8 &&
+       filt_args->control != TGSI_SAMPLER_GATHER &&
+       !filt_args->offset[0] && !filt_args->offset[1]) {
+      sample_2d_unorm8(sp_sview, sp_samp, s, t, rgba);
+   }
+   else {
+      get_filters(sp_sview, sp_samp, filt_args->control,
+                  &funcs, &min_img_filter, &mag_img_filter);
 
-   funcs->filter(sp_sview, sp_samp, min_img_filter, mag_img_filter,
-                 s, t, p, gather_comp, lod, filt_args, rgba);
+      funcs->filter(sp_sview, sp_samp, min_img_filter, mag_img_filter,
+                    s, t, p, gather_comp, lod, filt_args, rgba);
+   }
 
    if (sp_samp->base.compare_mode != PIPE_TEX_COMPARE_NONE) {
       sample_compare(sp_sview, sp_samp, c0, filt_args->control, rgba);
@@ -3467,6 +3696,18 @@ sp_get_texels(const struct sp_sampler_view *sp_sview,
 }
 
 
+/**
+ * Can this wrap mode be used by sample_2d_unorm8()?  Unnormalized coords
+ * only support the clamp modes, REPEAT falls back to CLAMP for them.
+ */
+static bool
+unorm8_wrap_ok(unsigned wrap_mode, bool unnormalized_coords)
+{
+   return wrap_mode == PIPE_TEX_WRAP_CLAMP_TO_EDGE ||
+          (wrap_mode == PIPE_TEX_WRAP_REPEAT && !unnormalized_coords);
+}
+
+
 void *
 softpipe_create_sampler_state(struct pipe_context *pipe,
                               const struct pipe_sampler_state *sampler)
@@ -3548,6 +3789,16 @@ softpipe_create_sampler_state(struct pipe_context *pipe,
       samp->min_mag_equal = true;
    }
 
+   /* Single level, no compare, and wrap modes which never reach the
+    * border: RGBA8 textures can use sample_2d_unorm8().
+    */
+   samp->unorm8 = sampler->min_mip_filter == PIPE_TEX_MIPFILTER_NONE &&
+                  sampler->min_img_filter == sampler->mag_img_filter &&
+                  sampler->compare_mode == PIPE_TEX_COMPARE_NONE &&
+                  sampler->max_anisotropy <= 1 &&
+                  unorm8_wrap_ok(sampler->wrap_s, sampler->unnormalized_coords) &&
+                  unorm8_wrap_ok(sampler->wrap_t, sampler->unnormalized_coords);
+
    return (void *)samp;
 }
 
@@ -3636,6 +3887,10 @@ softpipe_create_sampler_view(struct pipe_context *pipe,
                      (view->target == PIPE_TEXTURE_2D ||
                       view->target == PIPE_TEXTURE_RECT);
 
+      sview->unorm8 = sp_tex_tile_format_is_unorm8(view->format) &&
+                      (view->target == PIPE_TEXTURE_2D ||
+                       view->target == PIPE_TEXTURE_RECT);
+
       sview->xpot = util_logbase2( resource->width0 );
       sview->ypot = util_logbase2( resource->height0 );
 
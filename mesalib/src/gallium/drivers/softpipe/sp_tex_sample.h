@@ -116,6 +116,7 @@ struct sp_sampler_view
    bool need_swizzle;
    bool pot2d;
    bool need_cube_convert;
+   bool unorm8;  /**< 2D RGBA8 view, can use the native unorm8 tile cache */
 
    /* these are different per shader type */
    struct softpipe_tex_tile_cache *cache;
@@ -136,6 +137,7 @@ struct sp_sampler {
 
    bool min_mag_equal_repeat_linear;
    bool min_mag_equal;
+   bool unorm8;  /**< simple enough for the unorm8 fast path */
    unsigned min_img_filter;
 
    wrap_nearest_func nearest_texcoord_s;
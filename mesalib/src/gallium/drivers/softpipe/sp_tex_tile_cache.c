@@ -37,6 +37,7 @@
 #include "util/u_tile.h"
 #include "util/format/u_format.h"
 #include "util/u_math.h"
+#include "util/u_endian.h"
 #include "sp_context.h"
 #include "sp_texture.h"
 #include "sp_tex_tile_cache.h"
@@ -57,8 +58,10 @@ sp_create_tex_tile_cache( struct pipe_context *pipe )
       tc->pipe = pipe;
       for (pos = 0; pos < ARRAY_SIZE(tc->entries); pos++) {
          tc->entries[pos].addr.bits.invalid = 1;
+         tc->entries_unorm8[pos].addr.bits.invalid = 1;
       }
       tc->last_tile = &tc->entries[0]; /* any tile */
+      tc->last_tile_unorm8 = &tc->entries_unorm8[0];
    }
    return tc;
 }
@@ -99,6 +102,7 @@ sp_tex_tile_cache_validate_texture(struct softpipe_tex_tile_cache *tc)
 
    for (i = 0; i < ARRAY_SIZE(tc->entries); i++) {
       tc->entries[i].addr.bits.invalid = 1;
+      tc->entries_unorm8[i].addr.bits.invalid = 1;
    }
 }
 
@@ -149,6 +153,7 @@ sp_tex_tile_cache_set_sampler_view(struct softpipe_tex_tile_cache *tc,
       /* XXX we should try to avoid this when the teximage hasn't changed */
       for (i = 0; i < ARRAY_SIZE(tc->entries); i++) {
          tc->entries[i].addr.bits.invalid = 1;
+         tc->entries_unorm8[i].addr.bits.invalid = 1;
       }
 
       tc->tex_z = -1; /* any invalid value here */
@@ -171,6 +176,7 @@ sp_flush_tex_tile_cache(struct softpipe_tex_tile_cache *tc)
       /* caching a texture, mark all entries as empty */
       for (pos = 0; pos < ARRAY_SIZE(tc->entries); pos++) {
          tc->entries[pos].addr.bits.invalid = 1;
+         tc->entries_unorm8[pos].addr.bits.invalid = 1;
       }
       tc->tex_z = -1;
    }
@@ -196,6 +202,48 @@ tex_cache_pos( union tex_tile_address addr )
    return entry % NUM_TEX_TILE_ENTRIES;
 }
 
+/**
+ * Make sure tc->tex_trans maps the texture level and layer of the given
+ * tile address.
+ */
+static void
+sp_tex_tile_cache_map_level(struct softpipe_tex_tile_cache *tc,
+                            union tex_tile_address addr)
+{
+   if (!tc->tex_trans ||
+       tc->tex_level != addr.bits.level ||
+       tc->tex_z != addr.bits.z) {
+      /* get new transfer (view into texture) */
+      unsigned width, height, layer;
+
+      if (tc->tex_trans_map) {
+         tc->pipe->texture_unmap(tc->pipe, tc->tex_trans);
+         tc->tex_trans = NULL;
+         tc->tex_trans_map = NULL;
+      }
+
+      width = u_minify(tc->texture->width0, addr.bits.level);
+      if (tc->texture->target == PIPE_TEXTURE_1D_ARRAY) {
+         height = tc->texture->array_size;
+         layer = 0;
+      }
+      else {
+         height = u_minify(tc->texture->height0, addr.bits.level);
+         layer = addr.bits.z;
+      }
+
+      tc->tex_trans_map =
+         pipe_texture_map(tc->pipe, tc->texture,
+                           addr.bits.level,
+                           layer,
+                           PIPE_MAP_READ | PIPE_MAP_UNSYNCHRONIZED,
+                           0, 0, width, height, &tc->tex_trans);
+
+      tc->tex_level = addr.bits.level;
+      tc->tex_z = addr.bits.z;
+   }
+}
+
 /**
  * Similar to sp_get_cached_tile() but for textures.
  * Tiles are read-only and indexed with more params.
@@ -222,39 +270,7 @@ sp_find_cached_tile_tex(struct softpipe_tex_tile_cache *tc,
                     pos, tile->addr.bits.x, tile->addr.bits.y, tile->z, tile->face, tile->level);
 #endif
 
-      /* check if we need to get a new transfer */
-      if (!tc->tex_trans ||
-          tc->tex_level != addr.bits.level ||
-          tc->tex_z != addr.bits.z) {
-         /* get new transfer (view into texture) */
-         unsigned width, height, layer;
-
-         if (tc->tex_trans_map) {
-            tc->pipe->texture_unmap(tc->pipe, tc->tex_trans);
-            tc->tex_trans = NULL;
-            tc->tex_trans_map = NULL;
-         }
-
-         width = u_minify(tc->texture->width0, addr.bits.level);
-         if (tc->texture->target == PIPE_TEXTURE_1D_ARRAY) {
-            height = tc->texture->array_size;
-            layer = 0;
-         }
-         else {
-            height = u_minify(tc->texture->height0, addr.bits.level);
-            layer = addr.bits.z;
-         }
-
-         tc->tex_trans_map =
-            pipe_texture_map(tc->pipe, tc->texture,
-                              addr.bits.level,
-                              layer,
-                              PIPE_MAP_READ | PIPE_MAP_UNSYNCHRONIZED,
-                              0, 0, width, height, &tc->tex_trans);
-
-         tc->tex_level = addr.bits.level;
-         tc->tex_z = addr.bits.z;
-      }
+      sp_tex_tile_cache_map_level(tc, addr);
 
       /* Get tile from the transfer (view into texture), explicitly passing
        * the image format.
@@ -272,3 +288,101 @@ sp_find_cached_tile_tex(struct softpipe_tex_tile_cache *tc,
    tc->last_tile = tile;
    return tile;
 }
+
+
+/**
+ * Can textures of this format be cached in native unorm8 tiles?
+ */
+bool
+sp_tex_tile_format_is_unorm8(enum pipe_format format)
+{
+#if UTIL_ARCH_LITTLE_ENDIAN
+   switch (format) {
+   case PIPE_FORMAT_R8G8B8A8_UNORM:
+   case PIPE_FORMAT_R8G8B8X8_UNORM:
+   case PIPE_FORMAT_B8G8R8A8_UNORM:
+   case PIPE_FORMAT_B8G8R8X8_UNORM:
+      return true;
+   default:
+      return false;
+   }
+#else
+   return false;
+#endif
+}
+
+
+/**
+ * Copy a tile from the transfer into a native unorm8 tile, reordering
+ * the channels to R,G,B,A bytes.
+ */
+static void
+get_tile_unorm8(struct softpipe_tex_tile_cache *tc,
+                union tex_tile_address addr,
+                struct softpipe_tex_cached_tile_unorm8 *tile)
+{
+   const struct pipe_transfer *pt = tc->tex_trans;
+   const unsigned x = addr.bits.x * TEX_TILE_SIZE;
+   const unsigned y = addr.bits.y * TEX_TILE_SIZE;
+   const unsigned w = MIN2(TEX_TILE_SIZE, pt->box.width - x);
+   const unsigned h = MIN2(TEX_TILE_SIZE, pt->box.height - y);
+   const uint8_t *src = (const uint8_t *) tc->tex_trans_map +
+                        y * pt->stride + x * 4;
+   unsigned i, j;
+
+   for (i = 0; i < h; i++) {
+      const uint32_t *row = (const uint32_t *) src;
+      uint32_t *dst = tile->color[i];
+
+      switch (tc->format) {
+      case PIPE_FORMAT_R8G8B8A8_UNORM:
+         memcpy(dst, row, w * 4);
+         break;
+      case PIPE_FORMAT_R8G8B8X8_UNORM:
+         for (j = 0; j < w; j++)
+            dst[j] = row[j] | 0xff000000;
+         break;
+      case PIPE_FORMAT_B8G8R8A8_UNORM:
+         for (j = 0; j < w; j++) {
+            const uint32_t v = row[j];
+            dst[j] = (v & 0xff00ff00) | ((v & 0xff) << 16) | ((v >> 16) & 0xff);
+         }
+         break;
+      case PIPE_FORMAT_B8G8R8X8_UNORM:
+         for (j = 0; j < w; j++) {
+            const uint32_t v = row[j];
+            dst[j] = 0xff000000 | (v & 0xff00) |
+                     ((v & 0xff) << 16) | ((v >> 16) & 0xff);
+         }
+         break;
+      default:
+         assert(0);
+         break;
+      }
+
+      src += pt->stride;
+   }
+}
+
+
+/**
+ * Like sp_find_cached_tile_tex() but returns a native unorm8 tile.
+ * Only valid if sp_tex_tile_format_is_unorm8() is true for the view format.
+ */
+const struct softpipe_tex_cached_tile_unorm8 *
+sp_find_cached_tile_tex_unorm8(struct softpipe_tex_tile_cache *tc,
+                               union tex_tile_address addr)
+{
+   struct softpipe_tex_cached_tile_unorm8 *tile;
+
+   tile = tc->entries_unorm8 + tex_cache_pos(addr);
+
+   if (addr.value != tile->addr.value) {
+      sp_tex_tile_cache_map_level(tc, addr);
+      get_tile_unorm8(tc, addr, tile);
+      tile->addr = addr;
+   }
+
+   tc->last_tile_unorm8 = tile;
+   return tile;
+}
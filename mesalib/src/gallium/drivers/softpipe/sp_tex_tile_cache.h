@@ -30,6 +30,7 @@
 
 
 #include "util/compiler.h"
+#include "util/format/u_formats.h"
 #include "sp_limits.h"
 
 
@@ -71,6 +72,17 @@ struct softpipe_tex_cached_tile
    } data;
 };
 
+/**
+ * Cached tile of an 8-bit unorm RGBA texture, kept in native format.
+ * Each texel is stored as R,G,B,A bytes (in memory order) whatever the
+ * channel order of the texture, so a tile is 4KB rather than 16KB.
+ */
+struct softpipe_tex_cached_tile_unorm8
+{
+   union tex_tile_address addr;
+   uint32_t color[TEX_TILE_SIZE][TEX_TILE_SIZE];
+};
+
 /*
  * The number of cache entries.
  * Should not be decreased to lower than 16, and even that
@@ -89,6 +101,7 @@ struct softpipe_tex_tile_cache
    unsigned timestamp;
 
    struct softpipe_tex_cached_tile entries[NUM_TEX_TILE_ENTRIES];
+   struct softpipe_tex_cached_tile_unorm8 entries_unorm8[NUM_TEX_TILE_ENTRIES];
 
    struct pipe_transfer *tex_trans;
    void *tex_trans_map;
@@ -101,6 +114,7 @@ struct softpipe_tex_tile_cache
    enum pipe_format format;
 
    struct softpipe_tex_cached_tile *last_tile;  /**< most recently retrieved tile */
+   struct softpipe_tex_cached_tile_unorm8 *last_tile_unorm8;
 };
 
 
@@ -126,6 +140,13 @@ extern const struct softpipe_tex_cached_tile *
 sp_find_cached_tile_tex(struct softpipe_tex_tile_cache *tc, 
                         union tex_tile_address addr );
 
+extern const struct softpipe_tex_cached_tile_unorm8 *
+sp_find_cached_tile_tex_unorm8(struct softpipe_tex_tile_cache *tc,
+                               union tex_tile_address addr);
+
+extern bool
+sp_tex_tile_format_is_unorm8(enum pipe_format format);
+
 static inline union tex_tile_address
 tex_tile_address( unsigned x,
                   unsigned y,
@@ -156,6 +177,18 @@ sp_get_cached_tile_tex(struct softpipe_tex_tile_cache *tc,
    return sp_find_cached_tile_tex( tc, addr );
 }
 
+/* Same as above, for the native unorm8 tiles.
+ */
+static inline const struct softpipe_tex_cached_tile_unorm8 *
+sp_get_cached_tile_tex_unorm8(struct softpipe_tex_tile_cache *tc,
+                              union tex_tile_address addr)
+{
+   if (tc->last_tile_unorm8->addr.value == addr.value)
+      return tc->last_tile_unorm8;
+
+   return sp_find_cached_tile_tex_unorm8(tc, addr);
+}
+
 
 #endif /* SP_TEX_TILE_CACHE_H */
 
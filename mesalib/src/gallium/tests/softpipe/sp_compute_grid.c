@@ -0,0 +1,169 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Compute grid scaling benchmark for softpipe.
+ *
+ * Launches 1D grids of increasing size with a fixed 64-wide block.  Every
+ * invocation runs a chain of MADs seeded with its global id and stores the
+ * result to a shader buffer, which is checked on the CPU afterwards.
+ *
+ * Run it with SOFTPIPE_DEBUG=cs_threads and different SOFTPIPE_NUM_THREADS
+ * values to see how softpipe_launch_grid scales; meson registers one
+ * benchmark per thread count.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "pipe/p_context.h"
+#include "pipe/p_defines.h"
+#include "pipe/p_screen.h"
+#include "pipe/p_state.h"
+#include "softpipe/sp_public.h"
+#include "sw/null/null_sw_winsys.h"
+#include "tgsi/tgsi_text.h"
+#include "util/os_time.h"
+#include "util/u_inlines.h"
+#include "util/u_memory.h"
+
+#define BLOCK_WIDTH 64
+#define NUM_MADS    64
+#define MAX_TOKENS  1024
+
+static const unsigned grid_sizes[] = { 64, 1024, 4096, 16384 };
+
+static void *
+create_shader(struct pipe_context *ctx)
+{
+   static struct tgsi_token tokens[MAX_TOKENS];
+   struct pipe_compute_state cs = {0};
+   char text[4096];
+   int len, i;
+
+   len = snprintf(text, sizeof(text),
+                  "COMP\n"
+                  "PROPERTY CS_FIXED_BLOCK_WIDTH %d\n"
+                  "PROPERTY CS_FIXED_BLOCK_HEIGHT 1\n"
+                  "PROPERTY CS_FIXED_BLOCK_DEPTH 1\n"
+                  "DCL SV[0], THREAD_ID\n"
+                  "DCL SV[1], BLOCK_ID\n"
+                  "DCL BUFFER[0]\n"
+                  "DCL TEMP[0..1]\n"
+                  "IMM[0] UINT32 {%d, 4, 0, 0}\n"
+                  "IMM[1] FLT32 {1.0, 1.0, 0.0, 0.0}\n"
+                  "UMAD TEMP[0].x, SV[1].xxxx, IMM[0].xxxx, SV[0].xxxx\n"
+                  "UMUL TEMP[0].y, TEMP[0].xxxx, IMM[0].yyyy\n"
+                  "U2F TEMP[1].x, TEMP[0].xxxx\n",
+                  BLOCK_WIDTH, BLOCK_WIDTH);
+
+   for (i = 0; i < NUM_MADS; i++)
+      len += snprintf(text + len, sizeof(text) - len,
+                      "MAD TEMP[1].x, TEMP[1].xxxx, IMM[1].xxxx, IMM[1].yyyy\n");
+
+   snprintf(text + len, sizeof(text) - len,
+            "STORE BUFFER[0].x, TEMP[0].yyyy, TEMP[1].xxxx\n"
+            "END\n");
+
+   if (!tgsi_text_translate(text, tokens, ARRAY_SIZE(tokens))) {
+      fprintf(stderr, "failed to translate compute shader\n");
+      return NULL;
+   }
+
+   cs.ir_type = PIPE_SHADER_IR_TGSI;
+   cs.prog = tokens;
+   return ctx->create_compute_state(ctx, &cs);
+}
+
+/* Every invocation stores float(global id) + NUM_MADS, exact below 2^24. */
+static unsigned
+check_results(struct pipe_context *ctx, struct pipe_resource *buf,
+              unsigned count)
+{
+   float *data = MALLOC(count * sizeof(float));
+   unsigned i, bad = 0;
+
+   pipe_buffer_read(ctx, buf, 0, count * sizeof(float), data);
+   for (i = 0; i < count; i++) {
+      if (data[i] != (float)i + NUM_MADS) {
+         if (!bad)
+            fprintf(stderr, "invocation %u: got %f, expected %f\n",
+                    i, data[i], (float)i + NUM_MADS);
+         bad++;
+      }
+   }
+   FREE(data);
+   return bad;
+}
+
+int
+main(int argc, char **argv)
+{
+   struct pipe_screen *screen;
+   struct pipe_context *ctx;
+   void *cso;
+   unsigned i;
+   int ret = 0;
+
+   screen = softpipe_create_screen(null_sw_create());
+   if (!screen) {
+      fprintf(stderr, "failed to create softpipe screen\n");
+      return 1;
+   }
+
+   ctx = screen->context_create(screen, NULL, 0);
+   cso = ctx ? create_shader(ctx) : NULL;
+   if (!cso) {
+      fprintf(stderr, "failed to set up compute\n");
+      if (ctx)
+         ctx->destroy(ctx);
+      screen->destroy(screen);
+      return 1;
+   }
+   ctx->bind_compute_state(ctx, cso);
+
+   for (i = 0; i < ARRAY_SIZE(grid_sizes); i++) {
+      unsigned count = grid_sizes[i] * BLOCK_WIDTH;
+      struct pipe_grid_info info = {0};
+      struct pipe_shader_buffer sb = {0};
+      int64_t start, elapsed;
+      unsigned bad;
+
+      sb.buffer = pipe_buffer_create(screen, PIPE_BIND_SHADER_BUFFER,
+                                     PIPE_USAGE_DEFAULT,
+                                     count * sizeof(float));
+      sb.buffer_size = count * sizeof(float);
+      ctx->set_shader_buffers(ctx, PIPE_SHADER_COMPUTE, 0, 1, &sb, 1);
+
+      info.work_dim = 1;
+      info.block[0] = BLOCK_WIDTH;
+      info.block[1] = 1;
+      info.block[2] = 1;
+      info.grid[0] = grid_sizes[i];
+      info.grid[1] = 1;
+      info.grid[2] = 1;
+
+      start = os_time_get_nano();
+      ctx->launch_grid(ctx, &info);
+      elapsed = os_time_get_nano() - start;
+
+      bad = check_results(ctx, sb.buffer, count);
+      printf("grid %6u x %d: %9.3f ms, %12.0f invocations/s%s\n",
+             grid_sizes[i], BLOCK_WIDTH, elapsed / 1000000.0,
+             count / (elapsed / 1000000000.0),
+             bad ? ", MISMATCH" : "");
+      if (bad)
+         ret = 1;
+
+      ctx->set_shader_buffers(ctx, PIPE_SHADER_COMPUTE, 0, 1, NULL, 0);
+      pipe_resource_reference(&sb.buffer, NULL);
+   }
+
+   ctx->bind_compute_state(ctx, NULL);
+   ctx->delete_compute_state(ctx, cso);
+   ctx->destroy(ctx);
+   screen->destroy(screen);
+   return ret;
+}
@@ -0,0 +1,446 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Checks the SSE2 shader compiler softpipe and draw use for fragment and
+ * vertex shaders against the TGSI interpreter.
+ *
+ * Every shader is bound to two machines, one of which gets the compiled
+ * code, and both are run on the same inputs; outputs and kill masks must
+ * match bit for bit.  The shaders cover each class of natively compiled
+ * opcode with operand modifiers and special values, IF/ELSE with lanes
+ * going both ways and none, texture sampling and kills, and instructions
+ * the compiler hands back to the interpreter.  Shaders it does not
+ * compile at all are checked to fall back to the interpreter.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tgsi/tgsi_exec.h"
+#include "tgsi/tgsi_sse2.h"
+#include "tgsi/tgsi_text.h"
+#include "util/detect.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_debug.h"
+
+#define MAX_TOKENS  1024
+#define NUM_INPUTS  8
+#define NUM_OUTPUTS 8
+#define NUM_ROUNDS  16
+
+struct test_sampler {
+   struct tgsi_sampler base;
+   unsigned calls;
+};
+
+static float consts[2][16][4];
+
+/* Some lanes hold values the float ops treat specially */
+static const float specials[] = {
+   0.0f, -0.0f, 1.0f, -1.0f, 0.5f, INFINITY, -INFINITY, NAN, 1e-40f,
+   -3e38f, 16777217.0f, 0.25f,
+};
+
+static void
+test_get_samples(struct tgsi_sampler *tgsi_sampler,
+                 const unsigned sview_index,
+                 const unsigned sampler_index,
+                 const float s[TGSI_QUAD_SIZE],
+                 const float t[TGSI_QUAD_SIZE],
+                 const float r[TGSI_QUAD_SIZE],
+                 const float c0[TGSI_QUAD_SIZE],
+                 const float c1[TGSI_QUAD_SIZE],
+                 float derivs[3][2][TGSI_QUAD_SIZE],
+                 const int8_t offset[3],
+                 enum tgsi_sampler_control control,
+                 float rgba[TGSI_NUM_CHANNELS][TGSI_QUAD_SIZE])
+{
+   struct test_sampler *sampler = (struct test_sampler *)tgsi_sampler;
+   unsigned c, q;
+
+   sampler->calls++;
+   for (c = 0; c < TGSI_NUM_CHANNELS; c++) {
+      for (q = 0; q < TGSI_QUAD_SIZE; q++)
+         rgba[c][q] = s[q] * (float)(c + 1) - t[q] + 0.125f * sview_index;
+   }
+}
+
+static float
+input_value(unsigned round, unsigned i, unsigned c, unsigned l)
+{
+   unsigned n = round * 131 + i * 37 + c * 11 + l * 5;
+
+   if (round && n % 7 == 0)
+      return specials[n % ARRAY_SIZE(specials)];
+   return (float)(int)(n % 17) - 8.0f + 0.25f * l;
+}
+
+static void
+setup_inputs(struct tgsi_exec_machine *mach, unsigned round,
+             struct tgsi_interp_coef *coefs)
+{
+   unsigned i, c, l;
+
+   for (i = 0; i < NUM_INPUTS; i++) {
+      for (c = 0; c < TGSI_NUM_CHANNELS; c++) {
+         for (l = 0; l < TGSI_QUAD_SIZE; l++)
+            mach->Inputs[i].xyzw[c].f[l] = input_value(round, i, c, l);
+         coefs[i].a0[c] = input_value(round, i, c, 0);
+         coefs[i].dadx[c] = (float)((int)((round + i + c) % 5) - 2);
+         coefs[i].dady[c] = (float)((int)((round * 3 + c) % 7) - 3) * 0.5f;
+      }
+   }
+   mach->InterpCoefs = coefs;
+   for (l = 0; l < TGSI_QUAD_SIZE; l++) {
+      mach->QuadPos.xyzw[0].f[l] = (float)(round % 4 + (l & 1));
+      mach->QuadPos.xyzw[1].f[l] = (float)(round / 4 + (l >> 1));
+   }
+   memset(mach->Outputs, 0, NUM_OUTPUTS * sizeof(struct tgsi_exec_vector));
+   mach->NonHelperMask = 0xf;
+}
+
+static struct tgsi_exec_machine *
+create_machine(enum pipe_shader_type type, const struct tgsi_token *tokens,
+               struct test_sampler *sampler)
+{
+   struct tgsi_exec_machine *mach = tgsi_exec_machine_create(type);
+   struct tgsi_exec_consts_info info[PIPE_MAX_CONSTANT_BUFFERS];
+
+   memset(info, 0, sizeof(info));
+   info[0].ptr = consts[0];
+   info[0].size = sizeof(consts[0]);
+   info[1].ptr = consts[1];
+   info[1].size = sizeof(consts[1]);
+   tgsi_exec_set_constant_buffers(mach, PIPE_MAX_CONSTANT_BUFFERS, info);
+   tgsi_exec_machine_bind_shader(mach, tokens, &sampler->base, NULL, NULL);
+   return mach;
+}
+
+/*
+ * Run text through the interpreter and the compiled code.  Returns the
+ * number of mismatches, or -1 if the compiler doesn't take the shader.
+ */
+static int
+compare(const char *name, const char *text, enum pipe_shader_type type)
+{
+   struct tgsi_token tokens[MAX_TOKENS];
+   struct tgsi_interp_coef coefs_a[NUM_INPUTS], coefs_b[NUM_INPUTS];
+   struct test_sampler sampler_a = {0}, sampler_b = {0};
+   struct tgsi_exec_machine *a, *b;
+   struct tgsi_sse2_function *func;
+   unsigned round, i, c, l;
+   int bad = 0;
+
+   if (!tgsi_text_translate(text, tokens, ARRAY_SIZE(tokens))) {
+      fprintf(stderr, "%s: failed to translate shader\n", name);
+      return 1;
+   }
+
+   sampler_a.base.get_samples = test_get_samples;
+   sampler_b.base.get_samples = test_get_samples;
+   a = create_machine(type, tokens, &sampler_a);
+   b = create_machine(type, tokens, &sampler_b);
+
+   func = tgsi_sse2_create(b);
+   if (!func) {
+      tgsi_exec_machine_destroy(a);
+      tgsi_exec_machine_destroy(b);
+      return -1;
+   }
+
+   for (round = 0; round < NUM_ROUNDS; round++) {
+      unsigned kill_a, kill_b;
+
+      setup_inputs(a, round, coefs_a);
+      setup_inputs(b, round, coefs_b);
+      b->Jit = tgsi_sse2_get_func(func);
+
+      kill_a = tgsi_exec_machine_run(a, 0);
+      kill_b = tgsi_exec_machine_run(b, 0);
+      if (kill_a != kill_b) {
+         fprintf(stderr, "%s round %u: kill mask 0x%x, compiled 0x%x\n",
+                 name, round, kill_a, kill_b);
+         bad++;
+      }
+
+      for (i = 0; i < NUM_OUTPUTS; i++) {
+         for (c = 0; c < TGSI_NUM_CHANNELS; c++) {
+            for (l = 0; l < TGSI_QUAD_SIZE; l++) {
+               if (a->Outputs[i].xyzw[c].u[l] ==
+                   b->Outputs[i].xyzw[c].u[l])
+                  continue;
+               /* MIN/MAX of +0 and -0 may return either zero */
+               if (a->Outputs[i].xyzw[c].f[l] == 0.0f &&
+                   b->Outputs[i].xyzw[c].f[l] == 0.0f)
+                  continue;
+               fprintf(stderr, "%s round %u: OUT[%u].%c lane %u is %g, "
+                       "compiled %g\n", name, round, i, "xyzw"[c], l,
+                       a->Outputs[i].xyzw[c].f[l],
+                       b->Outputs[i].xyzw[c].f[l]);
+               bad++;
+            }
+         }
+      }
+   }
+
+   if (sampler_a.calls != sampler_b.calls) {
+      fprintf(stderr, "%s: %u texture calls, compiled %u\n",
+              name, sampler_a.calls, sampler_b.calls);
+      bad++;
+   }
+
+   tgsi_sse2_destroy(func);
+   tgsi_exec_machine_destroy(a);
+   tgsi_exec_machine_destroy(b);
+   return bad;
+}
+
+#define ALU_SHADER_BODY \
+   "DCL OUT[0..7]\n" \
+   "DCL CONST[0][0..15]\n" \
+   "DCL CONST[1][0..15]\n" \
+   "DCL TEMP[0..3]\n" \
+   "IMM[0] FLT32 { 0.5, -2.0, 3.0, 0.0 }\n" \
+   "  0: MUL TEMP[0], IN[0], CONST[0][1]\n" \
+   "  1: MAD TEMP[0].xy, IN[1].yxzw, -|IN[2]|, TEMP[0].yxzw\n" \
+   "  2: DP4 OUT[0].x, TEMP[0], IN[3]\n" \
+   "  3: DP3_SAT OUT[0].yz, IN[0], -IN[1]\n" \
+   "  4: DP2 OUT[0].w, IN[4].zwxy, CONST[1][3]\n" \
+   "  5: LRP OUT[1], IN[0], IN[1], IN[2]\n" \
+   "  6: MIN OUT[2].xy, IN[3], IN[1].wzyx\n" \
+   "  7: MAX OUT[2].zw, -IN[5], IN[3]\n" \
+   "  8: SLT OUT[3].x, IN[0], IN[1]\n" \
+   "  9: SGE OUT[3].y, IN[3], IN[1]\n" \
+   " 10: SEQ OUT[3].z, IN[6], IN[6].yyyy\n" \
+   " 11: SNE OUT[3].w, IN[7], IN[7]\n" \
+   " 12: CMP OUT[4], IN[2], IMM[0], CONST[0][11].xxyy\n" \
+   " 13: RCP TEMP[1].x, IN[0].zzzz\n" \
+   " 14: RSQ TEMP[1].y, |IN[1].xxxx|\n" \
+   " 15: SQRT TEMP[1].zw, IN[2].yyyy\n" \
+   " 16: ADD_SAT OUT[5], TEMP[1], CONST[0][2].wzyx\n" \
+   " 17: MOV TEMP[2], -|IN[6]|\n" \
+   " 18: MOV TEMP[2].xy, TEMP[2].yxzw\n" \
+   " 19: MUL_SAT OUT[6], TEMP[2], IN[7].wwwx\n" \
+   " 20: ADD OUT[7], OUT[5], OUT[6].zwxy\n" \
+   " 21: END\n"
+
+static const char alu_shader[] =
+   "VERT\n"
+   "DCL IN[0..7]\n"
+   ALU_SHADER_BODY;
+
+/* The same on interpolated fragment inputs */
+static const char alu_frag_shader[] =
+   "FRAG\n"
+   "DCL IN[0..7], GENERIC[0], LINEAR\n"
+   ALU_SHADER_BODY;
+
+static const char branch_shader[] =
+   "VERT\n"
+   "DCL IN[0..3]\n"
+   "DCL OUT[0..3]\n"
+   "DCL TEMP[0..2]\n"
+   "IMM[0] FLT32 { 1.0, 2.0, 3.0, 0.0 }\n"
+   "IMM[1] UINT32 { 0, 1, 0, 0 }\n"
+   "  0: MOV TEMP[0], IMM[0]\n"
+   "  1: SLT TEMP[1].x, IN[0].xxxx, IMM[0].wwww\n"
+   "  2: IF TEMP[1].xxxx :8\n"
+   "  3:   MOV TEMP[0], IN[1]\n"
+   "  4:   SLT TEMP[1].y, IN[2].yyyy, IMM[0].wwww\n"
+   "  5:   IF TEMP[1].yyyy :7\n"
+   "  6:     MUL TEMP[0].xz, TEMP[0], IN[2]\n"
+   "  7:   ENDIF\n"
+   "  8: ELSE :14\n"
+   "  9:   ADD TEMP[0], IN[1], IMM[0]\n"
+   " 10:   IF IMM[0].wwww :12\n"
+   " 11:     MOV TEMP[0], -IN[0]\n"
+   " 12:   ELSE :13\n"
+   " 13:     MAD TEMP[0].yw, TEMP[0], IN[3], IMM[0].zzzz\n"
+   " 14:   ENDIF\n"
+   " 15: ENDIF\n"
+   " 16: MOV OUT[0], TEMP[0]\n"
+   " 17: UIF IMM[1].yyyy :21\n"
+   " 18:   MUL OUT[1], TEMP[0], IN[0]\n"
+   " 19: ELSE :21\n"
+   " 20:   MOV OUT[1], IMM[0]\n"
+   " 21: ENDIF\n"
+   " 22: UIF IMM[1].xxxx :24\n"
+   " 23:   MOV OUT[2], IN[3]\n"
+   " 24: ENDIF\n"
+   " 25: SGE TEMP[2].x, IN[3].xxxx, IMM[0].xxxx\n"
+   " 26: IF TEMP[2].xxxx :28\n"
+   " 27:   DP3 OUT[3].xyz, TEMP[0], IN[3]\n"
+   " 28: ENDIF\n"
+   " 29: END\n";
+
+static const char texture_shader[] =
+   "FRAG\n"
+   "DCL IN[0], GENERIC[0], LINEAR\n"
+   "DCL IN[1], GENERIC[1], LINEAR\n"
+   "DCL OUT[0], COLOR[0]\n"
+   "DCL OUT[1], COLOR[1]\n"
+   "DCL SAMP[0]\n"
+   "DCL SAMP[1]\n"
+   "DCL SVIEW[0], 2D, FLOAT\n"
+   "DCL SVIEW[1], 2D, FLOAT\n"
+   "DCL TEMP[0..2]\n"
+   "IMM[0] FLT32 { 0.5, 0.0, -4.0, 1.0 }\n"
+   "  0: MUL TEMP[0], IN[0], IMM[0].xxxx\n"
+   "  1: TEX TEMP[1], TEMP[0], SAMP[0], 2D\n"
+   "  2: ADD TEMP[2], IN[1].xxxx, IN[0].yyyy\n"
+   "  3: KILL_IF TEMP[2].xxxx\n"
+   "  4: SLT TEMP[2].x, IN[1].yyyy, IMM[0].yyyy\n"
+   "  5: IF TEMP[2].xxxx :8\n"
+   "  6:   TXB TEMP[1], TEMP[0], SAMP[1], 2D\n"
+   "  7:   MUL TEMP[1], TEMP[1], IMM[0].xxxx\n"
+   "  8: ENDIF\n"
+   "  9: MAD OUT[0], TEMP[1], IN[1], TEMP[0]\n"
+   " 10: DP4 OUT[1].x, TEMP[1], TEMP[1]\n"
+   " 11: MOV OUT[1].yzw, TEMP[0].wzyx\n"
+   " 12: END\n";
+
+/* Integer ops, indirect addressing and ARL go through the interpreter */
+static const char helper_shader[] =
+   "VERT\n"
+   "DCL IN[0..3]\n"
+   "DCL OUT[0..2]\n"
+   "DCL TEMP[0..7]\n"
+   "DCL ADDR[0]\n"
+   "IMM[0] FLT32 { 2.0, 1.0, 0.0, 5.0 }\n"
+   "IMM[1] INT32 { 3, -2, 7, 0 }\n"
+   "  0: MOV TEMP[0], IN[0]\n"
+   "  1: MOV TEMP[1], IN[1]\n"
+   "  2: MOV TEMP[2], IN[2]\n"
+   "  3: F2I TEMP[3], |IN[3]|\n"
+   "  4: UADD TEMP[3], TEMP[3], IMM[1]\n"
+   "  5: I2F TEMP[4], TEMP[3]\n"
+   "  6: ARL ADDR[0].x, IMM[0].xxxx\n"
+   "  7: ADD TEMP[5], TEMP[ADDR[0].x], IN[0]\n"
+   "  8: MOV TEMP[ADDR[0].x].yw, TEMP[4]\n"
+   "  9: MAD OUT[0], TEMP[5], TEMP[2], TEMP[4]\n"
+   " 10: FRC OUT[1], IN[1]\n"
+   " 11: EX2 TEMP[6].x, IN[2].xxxx\n"
+   " 12: MUL OUT[2], TEMP[6].xxxx, TEMP[2]\n"
+   " 13: END\n";
+
+/* Loops are not compiled */
+static const char loop_shader[] =
+   "VERT\n"
+   "DCL OUT[0]\n"
+   "DCL TEMP[0..1]\n"
+   "IMM[0] FLT32 { 0.0, 1.0, 3.0, 0.0 }\n"
+   "  0: MOV TEMP[0], IMM[0].xxxx\n"
+   "  1: BGNLOOP :6\n"
+   "  2:   SGE TEMP[1].x, TEMP[0].xxxx, IMM[0].zzzz\n"
+   "  3:   IF TEMP[1].xxxx :5\n"
+   "  4:     BRK\n"
+   "  5:   ENDIF\n"
+   "  6:   ADD TEMP[0], TEMP[0], IMM[0].yyyy\n"
+   "  7: ENDLOOP :1\n"
+   "  8: MOV OUT[0], TEMP[0]\n"
+   "  9: END\n";
+
+static const char compute_shader[] =
+   "COMP\n"
+   "DCL TEMP[0]\n"
+   "IMM[0] FLT32 { 1.0, 1.0, 1.0, 1.0 }\n"
+   "  0: MOV TEMP[0], IMM[0]\n"
+   "  1: END\n";
+
+/* Check a shader the compiler declines still runs in the interpreter */
+static int
+check_fallback(const char *name, const char *text,
+               enum pipe_shader_type type, float expected)
+{
+   struct tgsi_token tokens[MAX_TOKENS];
+   struct test_sampler sampler = {0};
+   struct tgsi_exec_machine *mach;
+   struct tgsi_sse2_function *func;
+   unsigned l;
+   int bad = 0;
+
+   if (!tgsi_text_translate(text, tokens, ARRAY_SIZE(tokens))) {
+      fprintf(stderr, "%s: failed to translate shader\n", name);
+      return 1;
+   }
+
+   sampler.base.get_samples = test_get_samples;
+   mach = create_machine(type, tokens, &sampler);
+   func = tgsi_sse2_create(mach);
+   if (func) {
+      fprintf(stderr, "%s: compiled, expected the interpreter\n", name);
+      tgsi_sse2_destroy(func);
+      bad++;
+   }
+
+   if (type != PIPE_SHADER_COMPUTE) {
+      memset(mach->Outputs, 0, sizeof(struct tgsi_exec_vector));
+      mach->NonHelperMask = 0xf;
+      tgsi_exec_machine_run(mach, 0);
+      for (l = 0; l < TGSI_QUAD_SIZE; l++) {
+         if (mach->Outputs[0].xyzw[0].f[l] != expected) {
+            fprintf(stderr, "%s: lane %u is %g, expected %g\n", name, l,
+                    mach->Outputs[0].xyzw[0].f[l], expected);
+            bad++;
+         }
+      }
+   }
+
+   tgsi_exec_machine_destroy(mach);
+   return bad;
+}
+
+int
+main(int argc, char **argv)
+{
+   static const struct {
+      const char *name;
+      const char *text;
+      enum pipe_shader_type type;
+   } shaders[] = {
+      { "alu", alu_shader, PIPE_SHADER_VERTEX },
+      { "alu-frag", alu_frag_shader, PIPE_SHADER_FRAGMENT },
+      { "branch", branch_shader, PIPE_SHADER_VERTEX },
+      { "texture", texture_shader, PIPE_SHADER_FRAGMENT },
+      { "helper", helper_shader, PIPE_SHADER_VERTEX },
+   };
+   unsigned i, j;
+   int bad = 0;
+
+   for (i = 0; i < ARRAY_SIZE(consts[0]); i++) {
+      for (j = 0; j < 4; j++) {
+         consts[0][i][j] = i * 0.5f - j;
+         consts[1][i][j] = (j & 1) ? -1.5f * i : 0.25f * i + j;
+      }
+   }
+
+#if DETECT_ARCH_X86 || DETECT_ARCH_X86_64
+   if (!util_get_cpu_caps()->has_sse2 || debug_get_bool_option("GALLIUM_NOSSE", false))
+#endif
+   {
+      printf("no SSE2 shader compiler, skipping\n");
+      return 77;
+   }
+
+   for (i = 0; i < ARRAY_SIZE(shaders); i++) {
+      int n = compare(shaders[i].name, shaders[i].text, shaders[i].type);
+
+      if (n < 0) {
+         fprintf(stderr, "%s: not compiled\n", shaders[i].name);
+         n = 1;
+      }
+      printf("%s: %s\n", shaders[i].name, n ? "FAIL" : "ok");
+      bad += n;
+   }
+
+   bad += check_fallback("loop", loop_shader, PIPE_SHADER_VERTEX, 3.0f);
+   bad += check_fallback("compute", compute_shader, PIPE_SHADER_COMPUTE, 0);
+
+   printf("%s\n", bad ? "FAIL" : "PASS");
+   return bad ? 1 : 0;
+}
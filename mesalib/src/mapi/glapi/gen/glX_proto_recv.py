@@ -233,6 +233,20 @@ class PrintGlxDispatchFunctions(glX_proto_common.glx_print_proto):
         return None
 
 
+    def image_param(self, f, name, default):
+        """C expression for an image attribute, which names a parameter
+        or is a constant."""
+
+        if not name:
+            return default
+
+        for param in f.parameterIterator():
+            if param.name == name:
+                return self.fetch_param(param).strip()
+
+        return name
+
+
     def emit_function_call(self, f, retval_assign, indent):
         list = []
         prefix = "gl" if f.is_abi() else ""
@@ -527,7 +541,13 @@ class PrintGlxDispatchFunctions(glX_proto_common.glx_print_proto):
             # swapBytes and lsbFirst are single byte fields, so
             # the must NEVER be byte-swapped.
 
-            if not (img.img_type == "GL_BITMAP" and img.img_format == "GL_COLOR_INDEX"):
+            # Other than for bitmaps, swapBytes is handled by
+            # __glXUnpackSwapPixels once the rest of the unpack state is
+            # set, which may swap the image itself.
+
+            is_bitmap = (img.img_type == "GL_BITMAP" and img.img_format == "GL_COLOR_INDEX")
+            bulk_swap = not is_bitmap and not img.extent
+            if not is_bitmap and not bulk_swap:
                 print('    CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SWAP_BYTES,   hdr->swapBytes) );')
 
             print('    CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_LSB_FIRST,    hdr->lsbFirst) );')
@@ -540,6 +560,15 @@ class PrintGlxDispatchFunctions(glX_proto_common.glx_print_proto):
                 print('    CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_IMAGES,  (GLint) %shdr->skipImages%s) );' % (pre, post))
             print('    CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_PIXELS,  (GLint) %shdr->skipPixels%s) );' % (pre, post))
             print('    CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ALIGNMENT,    (GLint) %shdr->alignment%s) );' % (pre, post))
+            if bulk_swap:
+                print('    __glXUnpackSwapPixels( hdr->swapBytes,')
+                print('        %s,' % (self.image_param(f, img.img_target, "0")))
+                print('        %s,' % (self.image_param(f, img.img_format, None)))
+                print('        %s,' % (self.image_param(f, img.img_type, None)))
+                print('        %s,' % (self.image_param(f, img.width, None)))
+                print('        %s,' % (self.image_param(f, img.height, "1")))
+                print('        %s,' % (self.image_param(f, img.depth, "0")))
+                print('        %s );' % (img.name))
             print('')
 
 
@@ -13,6 +13,8 @@
 #include <assert.h>
 
 #include "dix/registry_priv.h"
+#include "dix/reqstats_priv.h"
+#include "os/osdep.h"
 
 #include "misc.h"
 #include "os.h"
@@ -20,6 +22,7 @@
 #include "extnsionst.h"
 #include "swaprep.h"
 #include <X11/extensions/XResproto.h>
+#include "xresvcxsrv.h"
 #include "pixmapstr.h"
 #include "windowstr.h"
 #include "gcstruct.h"
@@ -30,6 +33,7 @@
 #include "misc.h"
 #include <string.h>
 #include "hashtable.h"
+#include "xace.h"
 #include "picturestr.h"
 
 #ifdef COMPOSITE
@@ -91,6 +95,16 @@ typedef struct {
     xXResResourceSizeValue    *sizeValue;
 } ConstructResourceBytesCtx;
 
+#define REQUEST_STAT_WORDS (bytes_to_int32(sz_xXResRequestStat) + \
+                            REQSTATS_BUCKETS)
+
+/** @brief Holds the response to ProcXResQueryRequestStats while it is
+           built; data is NULL while the entries are only being counted. */
+typedef struct {
+    int           numStats;
+    CARD32       *data;
+} RequestStatsCtx;
+
 /** @brief Allocate and add a sequence of bytes at the end of a fragment list.
            Call DestroyFragments to release the list.
 
@@ -996,6 +1010,242 @@ ProcXResQueryResourceBytes (ClientPtr client)
     return rc;
 }
 
+static void
+AddRequestStat(ClientPtr client, int major, int minor,
+               const ReqStatRec *stat, void *closure)
+{
+    RequestStatsCtx *ctx = closure;
+    xXResRequestStat *entry;
+
+    if (ctx->data) {
+        entry = (xXResRequestStat *)
+            (ctx->data + ctx->numStats * REQUEST_STAT_WORDS);
+        *entry = (xXResRequestStat) {
+            .resource_base = client->clientAsMask,
+            .major = major,
+            .minor = minor,
+            .count = stat->count,
+            .max = stat->max,
+            .total_hi = stat->total >> 32,
+            .total_lo = stat->total & 0xffffffff
+        };
+        memcpy(entry + 1, stat->hist, sizeof(stat->hist));
+    }
+    ctx->numStats++;
+}
+
+static int
+ProcXResQueryRequestStats(ClientPtr client)
+{
+    REQUEST(xXResQueryRequestStatsReq);
+    xXResQueryRequestStatsReply rep;
+    RequestStatsCtx ctx = { 0 };
+    ClientPtr target = NULL;
+    int i, rc, first, last;
+
+    REQUEST_SIZE_MATCH(xXResQueryRequestStatsReq);
+
+    if (stuff->flags & ~(XResRequestStatsEnable | XResRequestStatsDisable |
+                         XResRequestStatsReset) ||
+        (stuff->flags & XResRequestStatsEnable &&
+         stuff->flags & XResRequestStatsDisable)) {
+        client->errorValue = stuff->flags;
+        return BadValue;
+    }
+
+    if (stuff->client != None) {
+        int clientID = CLIENT_ID(stuff->client);
+
+        if ((clientID >= currentMaxClients) || !clients[clientID]) {
+            client->errorValue = stuff->client;
+            return BadValue;
+        }
+        target = clients[clientID];
+    }
+
+    rc = XaceHook(XACE_SERVER_ACCESS, client,
+                  stuff->flags ? DixManageAccess : DixGetAttrAccess);
+    if (rc != Success)
+        return rc;
+
+    first = target ? target->index : 0;
+    last = target ? target->index + 1 : currentMaxClients;
+
+    for (i = first; i < last; i++)
+        if (clients[i])
+            ReqStatsForEach(clients[i], AddRequestStat, &ctx);
+
+    if (ctx.numStats) {
+        ctx.data = xallocarray(ctx.numStats, REQUEST_STAT_WORDS * 4);
+        if (!ctx.data)
+            return BadAlloc;
+        ctx.numStats = 0;
+        for (i = first; i < last; i++)
+            if (clients[i])
+                ReqStatsForEach(clients[i], AddRequestStat, &ctx);
+    }
+
+    rep = (xXResQueryRequestStatsReply) {
+        .type = X_Reply,
+        .enabled = reqStatsEnabled,
+        .sequenceNumber = client->sequence,
+        .length = ctx.numStats * REQUEST_STAT_WORDS,
+        .numStats = ctx.numStats,
+        .numBuckets = REQSTATS_BUCKETS
+    };
+
+    if (client->swapped) {
+        for (i = 0; i < ctx.numStats; i++) {
+            CARD32 *entry = ctx.data + i * REQUEST_STAT_WORDS;
+
+            swapl(&entry[0]);
+            SwapLongs(entry + 2, REQUEST_STAT_WORDS - 2);
+        }
+        swaps(&rep.sequenceNumber);
+        swapl(&rep.length);
+        swapl(&rep.numStats);
+        swapl(&rep.numBuckets);
+    }
+
+    WriteToClient(client, sizeof(rep), &rep);
+    if (ctx.numStats)
+        WriteToClient(client, ctx.numStats * REQUEST_STAT_WORDS * 4, ctx.data);
+    free(ctx.data);
+
+    if (stuff->flags & XResRequestStatsReset)
+        ReqStatsReset(target);
+    if (stuff->flags & XResRequestStatsEnable)
+        ReqStatsEnable(TRUE);
+    if (stuff->flags & XResRequestStatsDisable)
+        ReqStatsEnable(FALSE);
+
+    return Success;
+}
+
+static int
+ProcXResQueryMotionCompression(ClientPtr client)
+{
+    REQUEST(xXResQueryMotionCompressionReq);
+    xXResQueryMotionCompressionReply rep;
+    ClientPtr target = NULL;
+    CARD64 compressed;
+    Bool enabled;
+    int rc;
+
+    REQUEST_SIZE_MATCH(xXResQueryMotionCompressionReq);
+
+    if (stuff->flags & ~(XResRequestStatsEnable | XResRequestStatsDisable |
+                         XResRequestStatsReset) ||
+        (stuff->flags & XResRequestStatsEnable &&
+         stuff->flags & XResRequestStatsDisable)) {
+        client->errorValue = stuff->flags;
+        return BadValue;
+    }
+
+    if (stuff->client != None) {
+        int clientID = CLIENT_ID(stuff->client);
+
+        if ((clientID >= currentMaxClients) || !clients[clientID] ||
+            clients[clientID] == serverClient) {
+            client->errorValue = stuff->client;
+            return BadValue;
+        }
+        target = clients[clientID];
+    }
+
+    rc = XaceHook(XACE_SERVER_ACCESS, client,
+                  stuff->flags ? DixManageAccess : DixGetAttrAccess);
+    if (rc != Success)
+        return rc;
+
+    enabled = GetMotionCompression(target, &compressed,
+                                   stuff->flags & XResRequestStatsReset);
+
+    rep = (xXResQueryMotionCompressionReply) {
+        .type = X_Reply,
+        .enabled = enabled,
+        .sequenceNumber = client->sequence,
+        .length = 0,
+        .compressed_hi = compressed >> 32,
+        .compressed_lo = compressed
+    };
+
+    if (client->swapped) {
+        swaps(&rep.sequenceNumber);
+        swapl(&rep.compressed_hi);
+        swapl(&rep.compressed_lo);
+    }
+
+    WriteToClient(client, sizeof(rep), &rep);
+
+    if (stuff->flags & XResRequestStatsEnable)
+        SetMotionCompression(target, TRUE);
+    if (stuff->flags & XResRequestStatsDisable)
+        SetMotionCompression(target, FALSE);
+
+    return Success;
+}
+
+#ifdef COMPOSITE
+static int
+ProcXResQueryCompositePool(ClientPtr client)
+{
+    REQUEST(xXResQueryCompositePoolReq);
+    xXResQueryCompositePoolReply rep;
+    CompPixmapPoolPtr pool;
+    int rc;
+
+    REQUEST_SIZE_MATCH(xXResQueryCompositePoolReq);
+
+    if (stuff->flags & ~XResRequestStatsReset) {
+        client->errorValue = stuff->flags;
+        return BadValue;
+    }
+
+    if (stuff->screen >= screenInfo.numScreens) {
+        client->errorValue = stuff->screen;
+        return BadValue;
+    }
+
+    rc = XaceHook(XACE_SERVER_ACCESS, client,
+                  stuff->flags ? DixManageAccess : DixGetAttrAccess);
+    if (rc != Success)
+        return rc;
+
+    pool = compPoolLookup(screenInfo.screens[stuff->screen]);
+    if (!pool)
+        return BadMatch;
+
+    rep = (xXResQueryCompositePoolReply) {
+        .type = X_Reply,
+        .disabled = pool->disabled,
+        .sequenceNumber = client->sequence,
+        .length = bytes_to_int32(sz_xXResQueryCompositePoolReply -
+                                 sizeof(xGenericReply)),
+        .numPixmaps = pool->numEntries,
+        .bytes = pool->bytes,
+        .hits = pool->stats.hits,
+        .misses = pool->stats.misses,
+        .recycled = pool->stats.recycled,
+        .expired = pool->stats.expired,
+        .evicted = pool->stats.evicted
+    };
+
+    if (client->swapped) {
+        swaps(&rep.sequenceNumber);
+        swapl(&rep.length);
+        SwapLongs(&rep.numPixmaps, 7);
+    }
+
+    WriteToClient(client, sizeof(rep), &rep);
+
+    if (stuff->flags & XResRequestStatsReset)
+        memset(&pool->stats, 0, sizeof(pool->stats));
+
+    return Success;
+}
+#endif
+
 static int
 ProcResDispatch(ClientPtr client)
 {
@@ -1013,6 +1263,14 @@ ProcResDispatch(ClientPtr client)
         return ProcXResQueryClientIds(client);
     case X_XResQueryResourceBytes:
         return ProcXResQueryResourceBytes(client);
+    case X_XResQueryRequestStats:
+        return ProcXResQueryRequestStats(client);
+    case X_XResQueryMotionCompression:
+        return ProcXResQueryMotionCompression(client);
+#ifdef COMPOSITE
+    case X_XResQueryCompositePool:
+        return ProcXResQueryCompositePool(client);
+#endif
     default: break;
     }
 
@@ -1076,6 +1334,38 @@ SProcXResQueryResourceBytes (ClientPtr client)
     return ProcXResQueryResourceBytes(client);
 }
 
+static int _X_COLD
+SProcXResQueryRequestStats(ClientPtr client)
+{
+    REQUEST(xXResQueryRequestStatsReq);
+    REQUEST_SIZE_MATCH(xXResQueryRequestStatsReq);
+    swapl(&stuff->client);
+    swapl(&stuff->flags);
+    return ProcXResQueryRequestStats(client);
+}
+
+static int _X_COLD
+SProcXResQueryMotionCompression(ClientPtr client)
+{
+    REQUEST(xXResQueryMotionCompressionReq);
+    REQUEST_SIZE_MATCH(xXResQueryMotionCompressionReq);
+    swapl(&stuff->client);
+    swapl(&stuff->flags);
+    return ProcXResQueryMotionCompression(client);
+}
+
+#ifdef COMPOSITE
+static int _X_COLD
+SProcXResQueryCompositePool(ClientPtr client)
+{
+    REQUEST(xXResQueryCompositePoolReq);
+    REQUEST_SIZE_MATCH(xXResQueryCompositePoolReq);
+    swapl(&stuff->screen);
+    swapl(&stuff->flags);
+    return ProcXResQueryCompositePool(client);
+}
+#endif
+
 static int _X_COLD
 SProcResDispatch (ClientPtr client)
 {
@@ -1095,6 +1385,14 @@ SProcResDispatch (ClientPtr client)
         return SProcXResQueryClientIds(client);
     case X_XResQueryResourceBytes:
         return SProcXResQueryResourceBytes(client);
+    case X_XResQueryRequestStats:
+        return SProcXResQueryRequestStats(client);
+    case X_XResQueryMotionCompression:
+        return SProcXResQueryMotionCompression(client);
+#ifdef COMPOSITE
+    case X_XResQueryCompositePool:
+        return SProcXResQueryCompositePool(client);
+#endif
     default: break;
     }
 
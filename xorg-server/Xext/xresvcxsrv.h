@@ -0,0 +1,130 @@
+/* SPDX-License-Identifier: MIT OR X11
+ */
+
+#ifndef _XRESVCXSRV_H_
+#define _XRESVCXSRV_H_
+
+#include <X11/Xmd.h>
+
+/*
+ * VcXsrv additions to the X-Resource extension.
+ *
+ * Minor opcodes 64 to 127 are reserved for requests that only this
+ * server implements; they are well above the ones the protocol defines,
+ * so they cannot collide with future revisions.  Allocate new ones here,
+ * in order, so they cannot collide with each other either.
+ */
+
+#define X_XResVcXsrvFirst 64
+#define X_XResVcXsrvLast  127
+
+/*
+ * QueryRequestStats reports the per-opcode counters collected by
+ * dix/reqstats.c.
+ */
+#define X_XResQueryRequestStats 64
+
+#define XResRequestStatsEnable  0x01
+#define XResRequestStatsDisable 0x02
+#define XResRequestStatsReset   0x04
+
+typedef struct {
+    CARD8   reqType;
+    CARD8   XResReqType;
+    CARD16  length;
+    CARD32  client;     /* any resource of the client, or None for all */
+    CARD32  flags;      /* applied after the counters are reported */
+} xXResQueryRequestStatsReq;
+#define sz_xXResQueryRequestStatsReq 12
+
+typedef struct {
+    CARD8   type;
+    CARD8   enabled;
+    CARD16  sequenceNumber;
+    CARD32  length;
+    CARD32  numStats;
+    CARD32  numBuckets;
+    CARD32  pad1;
+    CARD32  pad2;
+    CARD32  pad3;
+    CARD32  pad4;
+} xXResQueryRequestStatsReply;
+#define sz_xXResQueryRequestStatsReply 32
+
+/* Followed by numBuckets CARD32 histogram counts */
+typedef struct {
+    CARD32  resource_base;
+    CARD8   major;      /* 0 for time spent writing output to the client */
+    CARD8   minor;
+    CARD16  pad;
+    CARD32  count;
+    CARD32  max;        /* microseconds */
+    CARD32  total_hi;   /* microseconds */
+    CARD32  total_lo;
+} xXResRequestStat;
+#define sz_xXResRequestStat 24
+
+/*
+ * QueryMotionCompression reports whether motion
+ * events are compressed for a client that stops reading them, or for all
+ * clients, and how many were dropped.  It takes the same flags as
+ * QueryRequestStats, applied after replying.
+ */
+#define X_XResQueryMotionCompression 65
+
+typedef struct {
+    CARD8   reqType;
+    CARD8   XResReqType;
+    CARD16  length;
+    CARD32  client;     /* any resource of the client, or None for all */
+    CARD32  flags;
+} xXResQueryMotionCompressionReq;
+#define sz_xXResQueryMotionCompressionReq 12
+
+typedef struct {
+    CARD8   type;
+    CARD8   enabled;
+    CARD16  sequenceNumber;
+    CARD32  length;
+    CARD32  compressed_hi;      /* since the server started, for None */
+    CARD32  compressed_lo;
+    CARD32  pad1;
+    CARD32  pad2;
+    CARD32  pad3;
+    CARD32  pad4;
+} xXResQueryMotionCompressionReply;
+#define sz_xXResQueryMotionCompressionReply 32
+
+/*
+ * QueryCompositePool reports the backing pixmap pool of a screen, see
+ * composite/comppool.c.  XResRequestStatsReset clears the counters after
+ * replying; the other flags are not accepted.
+ */
+#define X_XResQueryCompositePool 66
+
+typedef struct {
+    CARD8   reqType;
+    CARD8   XResReqType;
+    CARD16  length;
+    CARD32  screen;
+    CARD32  flags;
+} xXResQueryCompositePoolReq;
+#define sz_xXResQueryCompositePoolReq 12
+
+typedef struct {
+    CARD8   type;
+    CARD8   disabled;
+    CARD16  sequenceNumber;
+    CARD32  length;             /* 2 */
+    CARD32  numPixmaps;
+    CARD32  bytes;
+    CARD32  hits;
+    CARD32  misses;
+    CARD32  recycled;
+    CARD32  expired;
+    CARD32  evicted;
+    CARD32  pad;
+} xXResQueryCompositePoolReply;
+#define sz_xXResQueryCompositePoolReply 40
+
+#endif /* _XRESVCXSRV_H_ */
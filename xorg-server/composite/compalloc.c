@@ -184,6 +184,7 @@ compRedirectWindow(ClientPtr pClient, WindowPtr pWin, int update)
             free(cw);
             return BadAlloc;
         }
+        DamageSetMaxBoxes(cw->damage, damageMaxBoxes);
 
         anyMarked = compMarkWindows(pWin, &pLayerWin);
 
@@ -310,7 +311,7 @@ compFreeClientWindow(WindowPtr pWin, XID id)
 
     if (pPixmap) {
         compRestoreWindow(pWin, pPixmap);
-        (*pScreen->DestroyPixmap) (pPixmap);
+        compPoolPutPixmap(pScreen, pPixmap);
     }
 }
 
@@ -534,8 +535,7 @@ compNewPixmap(WindowPtr pWin, int x, int y, int w, int h)
     WindowPtr pParent = pWin->parent;
     PixmapPtr pPixmap;
 
-    pPixmap = (*pScreen->CreatePixmap) (pScreen, w, h, pWin->drawable.depth,
-                                        CREATE_PIXMAP_USAGE_BACKING_PIXMAP);
+    pPixmap = compPoolGetPixmap(pScreen, w, h, pWin->drawable.depth);
 
     if (!pPixmap)
         return 0;
@@ -257,6 +257,7 @@ ProcCompositeNameWindowPixmap(ClientPtr client)
         return rc;
 
     ++pPixmap->refcnt;
+    compPoolMarkNamed(pPixmap);
 
     if (!AddResource(stuff->pixmap, X11_RESTYPE_PIXMAP, (void *) pPixmap))
         return BadAlloc;
@@ -755,6 +756,7 @@ PanoramiXCompositeNameWindowPixmap(ClientPtr client)
             return BadAlloc;
 
         ++pPixmap->refcnt;
+        compPoolMarkNamed(pPixmap);
     }
 
     if (!AddResource(stuff->pixmap, XRT_PIXMAP, (void *) newPix))
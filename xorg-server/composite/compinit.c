@@ -61,6 +61,8 @@ compCloseScreen(ScreenPtr pScreen)
     free(cs->alternateVisuals);
     free(cs->implicitRedirectExceptions);
 
+    compPoolFini(pScreen, cs);
+
     pScreen->CloseScreen = cs->CloseScreen;
     pScreen->InstallColormap = cs->InstallColormap;
     pScreen->ChangeWindowAttributes = cs->ChangeWindowAttributes;
@@ -357,7 +359,13 @@ compScreenInit(ScreenPtr pScreen)
     cs->numImplicitRedirectExceptions = 0;
     cs->implicitRedirectExceptions = NULL;
 
+    if (!compPoolInit(pScreen, cs)) {
+        free(cs);
+        return FALSE;
+    }
+
     if (!compAddAlternateVisuals(pScreen, cs)) {
+        compPoolFini(pScreen, cs);
         free(cs);
         return FALSE;
     }
@@ -119,6 +119,38 @@ typedef struct _CompOverlayClientRec {
     XID resource;
 } CompOverlayClientRec;
 
+/*
+ * Backing pixmaps released by redirected windows are kept for a while and
+ * handed to the next window that needs one of the same depth and size
+ * bucket, see comppool.c.
+ */
+#define COMP_POOL_BUCKET	64              /* size granularity, pixels */
+#define COMP_POOL_ENTRIES	16
+#define COMP_POOL_MAX_BYTES	(64 << 20)
+#define COMP_POOL_MAX_AGE	3000            /* msec */
+
+typedef struct _CompPoolEntry {
+    PixmapPtr pPixmap;
+    CARD32 time;
+} CompPoolEntryRec;
+
+typedef struct _CompPoolStats {
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long recycled;
+    unsigned long expired;
+    unsigned long evicted;
+} CompPoolStatsRec, *CompPoolStatsPtr;
+
+typedef struct _CompPixmapPool {
+    CompPoolEntryRec entries[COMP_POOL_ENTRIES];        /* oldest first */
+    int numEntries;
+    size_t bytes;
+    Bool disabled;              /* pixmaps can't be resized in place */
+    OsTimerPtr timer;
+    CompPoolStatsRec stats;     /* diagnostics */
+} CompPixmapPoolRec, *CompPixmapPoolPtr;
+
 typedef struct _CompImplicitRedirectException {
     XID parentVisual;
     XID winVisual;
@@ -169,6 +201,8 @@ typedef struct _CompScreen {
     CompOverlayClientPtr pOverlayClients;
 
     SourceValidateProcPtr SourceValidate;
+
+    CompPixmapPoolRec pool;
 } CompScreenRec, *CompScreenPtr;
 
 extern DevPrivateKeyRec CompScreenPrivateKeyRec;
@@ -244,6 +278,28 @@ void compMarkAncestors(WindowPtr pWin);
 Bool
  compScreenInit(ScreenPtr pScreen);
 
+/*
+ * comppool.c
+ */
+
+Bool
+ compPoolInit(ScreenPtr pScreen, CompScreenPtr cs);
+
+void
+ compPoolFini(ScreenPtr pScreen, CompScreenPtr cs);
+
+PixmapPtr
+compPoolGetPixmap(ScreenPtr pScreen, int w, int h, int depth);
+
+void
+ compPoolPutPixmap(ScreenPtr pScreen, PixmapPtr pPixmap);
+
+void
+ compPoolMarkNamed(PixmapPtr pPixmap);
+
+CompPixmapPoolPtr
+compPoolLookup(ScreenPtr pScreen);
+
 /*
  * compoverlay.c
  */
@@ -0,0 +1,288 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include "dix/reqstats_priv.h"
+
+#include "compint.h"
+
+/*
+ * Redirected windows get a new backing pixmap on every map and resize,
+ * so resizing a window under a compositing manager allocates and frees
+ * a window-sized pixmap per ConfigureNotify.  Backing pixmaps are
+ * therefore allocated with their dimensions rounded up to a multiple of
+ * COMP_POOL_BUCKET and their header trimmed to the size asked for.  When
+ * released they are parked in a small per-screen pool, and the next
+ * request for the same depth and rounded size gets one back.
+ *
+ * Pooled pixmaps expire after COMP_POOL_MAX_AGE, and the pool never
+ * holds more than COMP_POOL_MAX_BYTES; the oldest pixmaps go first.
+ *
+ * Only pixmaps nobody else can have seen are recycled: the pool's own,
+ * with no other references, that were never named by a client.  They are
+ * cleared when handed out again, as compNewPixmap only copies the part of
+ * the parent that is visible and a fresh pixmap would be zeroed.  Screens
+ * whose pixmaps have no CPU storage can't have their header trimmed, so
+ * the pool disables itself there on first use.
+ *
+ * The counters are logged on SIGUSR2 and reported by the X-Resource
+ * QueryCompositePool request, see Xext/xres.c.
+ */
+
+#define COMP_PIXMAP_POOLED	(1 << 0)
+#define COMP_PIXMAP_NAMED	(1 << 1)
+
+typedef struct _CompPixmap {
+    unsigned int flags;
+    unsigned short width;       /* as allocated */
+    unsigned short height;
+} CompPixmapRec, *CompPixmapPtr;
+
+static DevPrivateKeyRec CompPixmapPrivateKeyRec;
+
+#define CompPixmapPrivateKey (&CompPixmapPrivateKeyRec)
+
+#define GetCompPixmap(p) ((CompPixmapPtr) \
+    dixGetPrivateAddr(&(p)->devPrivates, CompPixmapPrivateKey))
+
+#define COMP_POOL_ROUND(n) \
+    (((n) + COMP_POOL_BUCKET - 1) & ~(COMP_POOL_BUCKET - 1))
+
+static size_t
+compPoolSize(PixmapPtr pPixmap)
+{
+    return (size_t) pPixmap->devKind * GetCompPixmap(pPixmap)->height;
+}
+
+static void
+compPoolRemove(CompPixmapPoolPtr pool, int i)
+{
+    pool->bytes -= compPoolSize(pool->entries[i].pPixmap);
+    pool->numEntries--;
+    memmove(&pool->entries[i], &pool->entries[i + 1],
+            (pool->numEntries - i) * sizeof(CompPoolEntryRec));
+}
+
+static void
+compPoolDiscardOldest(ScreenPtr pScreen, CompPixmapPoolPtr pool)
+{
+    PixmapPtr pPixmap = pool->entries[0].pPixmap;
+
+    compPoolRemove(pool, 0);
+    (*pScreen->DestroyPixmap) (pPixmap);
+}
+
+static CARD32
+compPoolExpire(OsTimerPtr timer, CARD32 now, void *arg)
+{
+    ScreenPtr pScreen = arg;
+    CompPixmapPoolPtr pool = &GetCompScreen(pScreen)->pool;
+
+    while (pool->numEntries &&
+           (INT32) (now - pool->entries[0].time) >= COMP_POOL_MAX_AGE) {
+        compPoolDiscardOldest(pScreen, pool);
+        pool->stats.expired++;
+    }
+
+    if (!pool->numEntries)
+        return 0;
+    return pool->entries[0].time + COMP_POOL_MAX_AGE - now;
+}
+
+static void
+compPoolDumpStats(CallbackListPtr *pcbl, void *closure, void *data)
+{
+    ScreenPtr pScreen = closure;
+    CompPixmapPoolPtr pool = &GetCompScreen(pScreen)->pool;
+
+    LogMessageVerb(X_NONE, 0,
+                   "composite pixmap pool, screen %d%s: %d pixmaps, "
+                   "%lu KiB; %lu hits, %lu misses, %lu recycled, "
+                   "%lu expired, %lu evicted\n",
+                   pScreen->myNum, pool->disabled ? " (disabled)" : "",
+                   pool->numEntries, (unsigned long) (pool->bytes >> 10),
+                   pool->stats.hits, pool->stats.misses, pool->stats.recycled,
+                   pool->stats.expired, pool->stats.evicted);
+}
+
+Bool
+compPoolInit(ScreenPtr pScreen, CompScreenPtr cs)
+{
+    CompPixmapPoolPtr pool = &cs->pool;
+
+    if (!dixRegisterPrivateKey(&CompPixmapPrivateKeyRec, PRIVATE_PIXMAP,
+                               sizeof(CompPixmapRec)))
+        return FALSE;
+
+    memset(pool, 0, sizeof(*pool));
+    return AddCallback(&ReqStatsDumpCallback, compPoolDumpStats, pScreen);
+}
+
+void
+compPoolFini(ScreenPtr pScreen, CompScreenPtr cs)
+{
+    CompPixmapPoolPtr pool = &cs->pool;
+
+    DeleteCallback(&ReqStatsDumpCallback, compPoolDumpStats, pScreen);
+    TimerFree(pool->timer);
+    pool->timer = NULL;
+    while (pool->numEntries)
+        compPoolDiscardOldest(pScreen, pool);
+}
+
+static void
+compPoolTrim(PixmapPtr pPixmap, int w, int h)
+{
+    ScreenPtr pScreen = pPixmap->drawable.pScreen;
+
+    (*pScreen->ModifyPixmapHeader) (pPixmap, w, h, 0, 0, 0, NULL);
+    pPixmap->drawable.serialNumber = NEXT_SERIAL_NUMBER;
+}
+
+/* Clear a recycled pixmap, FALSE if that could not be done */
+static Bool
+compPoolClear(PixmapPtr pPixmap)
+{
+    ScreenPtr pScreen = pPixmap->drawable.pScreen;
+    GCPtr pGC = GetScratchGC(pPixmap->drawable.depth, pScreen);
+    xRectangle rect = {
+        .width = pPixmap->drawable.width,
+        .height = pPixmap->drawable.height
+    };
+    ChangeGCVal val;
+
+    if (!pGC)
+        return FALSE;
+
+    val.val = 0;
+    ChangeGC(NullClient, pGC, GCForeground, &val);
+    ValidateGC(&pPixmap->drawable, pGC);
+    (*pGC->ops->PolyFillRect) (&pPixmap->drawable, pGC, 1, &rect);
+    FreeScratchGC(pGC);
+    return TRUE;
+}
+
+PixmapPtr
+compPoolGetPixmap(ScreenPtr pScreen, int w, int h, int depth)
+{
+    CompPixmapPoolPtr pool = &GetCompScreen(pScreen)->pool;
+    int bw = COMP_POOL_ROUND(w);
+    int bh = COMP_POOL_ROUND(h);
+    PixmapPtr pPixmap;
+    CompPixmapPtr cp;
+    int i;
+
+    if (pool->disabled || w <= 0 || h <= 0 || bw > MAXSHORT || bh > MAXSHORT)
+        return (*pScreen->CreatePixmap) (pScreen, w, h, depth,
+                                         CREATE_PIXMAP_USAGE_BACKING_PIXMAP);
+
+    /* Newest first, it is the most likely to still be in cache */
+    for (i = pool->numEntries - 1; i >= 0; i--) {
+        pPixmap = pool->entries[i].pPixmap;
+        cp = GetCompPixmap(pPixmap);
+        if (pPixmap->drawable.depth == depth &&
+            cp->width == bw && cp->height == bh) {
+            compPoolRemove(pool, i);
+            compPoolTrim(pPixmap, w, h);
+            if (!compPoolClear(pPixmap)) {
+                (*pScreen->DestroyPixmap) (pPixmap);
+                break;
+            }
+            pool->stats.hits++;
+            return pPixmap;
+        }
+    }
+
+    pool->stats.misses++;
+    pPixmap = (*pScreen->CreatePixmap) (pScreen, bw, bh, depth,
+                                        CREATE_PIXMAP_USAGE_BACKING_PIXMAP);
+    if (pPixmap && !pPixmap->devPrivate.ptr) {
+        (*pScreen->DestroyPixmap) (pPixmap);
+        pool->disabled = TRUE;
+        pPixmap = NULL;
+    }
+    if (!pPixmap)
+        return (*pScreen->CreatePixmap) (pScreen, w, h, depth,
+                                         CREATE_PIXMAP_USAGE_BACKING_PIXMAP);
+
+    cp = GetCompPixmap(pPixmap);
+    cp->flags = COMP_PIXMAP_POOLED;
+    cp->width = bw;
+    cp->height = bh;
+    compPoolTrim(pPixmap, w, h);
+    return pPixmap;
+}
+
+/*
+ * Release a backing pixmap, keeping it for reuse if it is the pool's own
+ * and not referenced by anyone else.
+ */
+void
+compPoolPutPixmap(ScreenPtr pScreen, PixmapPtr pPixmap)
+{
+    CompPixmapPoolPtr pool = &GetCompScreen(pScreen)->pool;
+    CompPixmapPtr cp = GetCompPixmap(pPixmap);
+    size_t size;
+
+    if (cp->flags != COMP_PIXMAP_POOLED || pPixmap->refcnt != 1 ||
+        (size = compPoolSize(pPixmap)) > COMP_POOL_MAX_BYTES) {
+        (*pScreen->DestroyPixmap) (pPixmap);
+        return;
+    }
+
+    while (pool->numEntries == COMP_POOL_ENTRIES ||
+           pool->bytes + size > COMP_POOL_MAX_BYTES) {
+        compPoolDiscardOldest(pScreen, pool);
+        pool->stats.evicted++;
+    }
+
+    pool->entries[pool->numEntries].pPixmap = pPixmap;
+    pool->entries[pool->numEntries].time = GetTimeInMillis();
+    pool->numEntries++;
+    pool->bytes += size;
+    pool->stats.recycled++;
+
+    if (pool->numEntries == 1)
+        pool->timer = TimerSet(pool->timer, 0, COMP_POOL_MAX_AGE,
+                               compPoolExpire, pScreen);
+}
+
+/* A client holds a name for the pixmap, so it must never be recycled */
+void
+compPoolMarkNamed(PixmapPtr pPixmap)
+{
+    GetCompPixmap(pPixmap)->flags |= COMP_PIXMAP_NAMED;
+}
+
+/* The screen's pool, or NULL when composite is not active there */
+CompPixmapPoolPtr
+compPoolLookup(ScreenPtr pScreen)
+{
+    CompScreenPtr cs;
+
+    if (!dixPrivateKeyRegistered(CompScreenPrivateKey))
+        return NULL;
+    cs = GetCompScreen(pScreen);
+    return cs ? &cs->pool : NULL;
+}
@@ -56,88 +56,124 @@ SOFTWARE.
 #include "resource.h"
 #include "dix.h"
 
+/*
+ * Atoms are numbered densely from 1, so the atom -> name direction is a
+ * plain array.  The name -> atom direction is an open-addressed hash table
+ * of atoms with linear probing, kept at most half full; None marks an
+ * empty slot.  Atoms are never freed, so entries are never removed.
+ */
+
 #define InitialTableSize 256
 
-typedef struct _Node {
-    struct _Node *left, *right;
-    Atom a;
-    unsigned int fingerPrint;
+typedef struct _AtomName {
     const char *string;
-} NodeRec, *NodePtr;
+    unsigned int len;
+    unsigned int hash;
+} AtomNameRec, *AtomNamePtr;
 
 static Atom lastAtom = None;
-static NodePtr atomRoot = NULL;
-static unsigned long tableLength;
-static NodePtr *nodeTable;
+static AtomNamePtr atomNames;
+static unsigned long namesLength;
+static Atom *atomHash;
+static unsigned long hashMask;
+
+/* FNV-1a */
+static unsigned int
+AtomHash(const char *string, unsigned len)
+{
+    unsigned int h = 2166136261u;
+    unsigned i;
+
+    for (i = 0; i < len; i++) {
+        h ^= (unsigned char) string[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static unsigned long
+AtomHashSlot(unsigned int hash)
+{
+    unsigned long i = hash & hashMask;
+
+    while (atomHash[i] != None)
+        i = (i + 1) & hashMask;
+    return i;
+}
+
+static Bool
+GrowAtomHash(void)
+{
+    Atom *old = atomHash;
+    Atom a;
+
+    atomHash = calloc((hashMask + 1) * 2, sizeof(Atom));
+    if (!atomHash) {
+        atomHash = old;
+        return FALSE;
+    }
+    hashMask = hashMask * 2 + 1;
+    for (a = 1; a <= lastAtom; a++)
+        atomHash[AtomHashSlot(atomNames[a].hash)] = a;
+    free(old);
+    return TRUE;
+}
 
 Atom
 MakeAtom(const char *string, unsigned len, Bool makeit)
 {
-    NodePtr *np;
-    unsigned i;
-    int comp;
-    unsigned int fp = 0;
+    const char *nul;
+    unsigned int hash;
+    unsigned long i;
+    AtomNamePtr name;
+    Atom a;
 
-    np = &atomRoot;
-    for (i = 0; i < (len + 1) / 2; i++) {
-        fp = fp * 27 + string[i];
-        fp = fp * 27 + string[len - 1 - i];
+    if (!atomHash)
+        return makeit ? BAD_RESOURCE : None;
+
+    /* names end at the first NUL, whatever length the caller passed */
+    if ((nul = memchr(string, 0, len)))
+        len = nul - string;
+
+    hash = AtomHash(string, len);
+    for (i = hash & hashMask; (a = atomHash[i]) != None;
+         i = (i + 1) & hashMask) {
+        name = &atomNames[a];
+        if (name->hash == hash && name->len == len &&
+            memcmp(name->string, string, len) == 0)
+            return a;
     }
-    while (*np != NULL) {
-        if (fp < (*np)->fingerPrint)
-            np = &((*np)->left);
-        else if (fp > (*np)->fingerPrint)
-            np = &((*np)->right);
-        else {                  /* now start testing the strings */
-            comp = strncmp(string, (*np)->string, (int) len);
-            if ((comp < 0) || ((comp == 0) && (len < strlen((*np)->string))))
-                np = &((*np)->left);
-            else if (comp > 0)
-                np = &((*np)->right);
-            else
-                return (*np)->a;
-        }
+    if (!makeit)
+        return None;
+
+    if ((lastAtom + 1) >= namesLength) {
+        AtomNamePtr names;
+
+        names = reallocarray(atomNames, namesLength, 2 * sizeof(AtomNameRec));
+        if (!names)
+            return BAD_RESOURCE;
+        namesLength <<= 1;
+        atomNames = names;
+    }
+    if ((lastAtom + 1) * 2 > hashMask + 1) {
+        if (!GrowAtomHash())
+            return BAD_RESOURCE;
+        i = AtomHashSlot(hash);
     }
-    if (makeit) {
-        NodePtr nd;
 
-        nd = malloc(sizeof(NodeRec));
-        if (!nd)
+    name = &atomNames[lastAtom + 1];
+    if (lastAtom < XA_LAST_PREDEFINED) {
+        name->string = string;
+    }
+    else {
+        name->string = strndup(string, len);
+        if (!name->string)
             return BAD_RESOURCE;
-        if (lastAtom < XA_LAST_PREDEFINED) {
-            nd->string = string;
-        }
-        else {
-            nd->string = strndup(string, len);
-            if (!nd->string) {
-                free(nd);
-                return BAD_RESOURCE;
-            }
-        }
-        if ((lastAtom + 1) >= tableLength) {
-            NodePtr *table;
-
-            table = reallocarray(nodeTable, tableLength, 2 * sizeof(NodePtr));
-            if (!table) {
-                if (nd->string != string) {
-                    /* nd->string has been strdup'ed */
-                    free((char *) nd->string);
-                }
-                free(nd);
-                return BAD_RESOURCE;
-            }
-            tableLength <<= 1;
-            nodeTable = table;
-        }
-        *np = nd;
-        nd->left = nd->right = NULL;
-        nd->fingerPrint = fp;
-        nd->a = ++lastAtom;
-        nodeTable[lastAtom] = nd;
-        return nd->a;
     }
-    else
-        return None;
+    name->len = len;
+    name->hash = hash;
+    atomHash[i] = ++lastAtom;
+    return lastAtom;
 }
 
 Bool
@@ -149,13 +185,9 @@ ValidAtom(Atom atom)
 const char *
 NameForAtom(Atom atom)
 {
-    NodePtr node;
-
-    if (atom > lastAtom)
-        return 0;
-    if ((node = nodeTable[atom]) == NULL)
+    if (atom == None || atom > lastAtom)
         return 0;
-    return node->string;
+    return atomNames[atom].string;
 }
 
 void
@@ -164,32 +196,23 @@ AtomError(void)
     FatalError("initializing atoms");
 }
 
-static void
-FreeAtom(NodePtr patom)
-{
-    if (patom->left)
-        FreeAtom(patom->left);
-    if (patom->right)
-        FreeAtom(patom->right);
-    if (patom->a > XA_LAST_PREDEFINED) {
-        /*
-         * All strings above XA_LAST_PREDEFINED are strdup'ed, so it's safe to
-         * cast here
-         */
-        free((char *) patom->string);
-    }
-    free(patom);
-}
-
 void
 FreeAllAtoms(void)
 {
-    if (atomRoot == NULL)
+    Atom a;
+
+    if (atomNames == NULL)
         return;
-    FreeAtom(atomRoot);
-    atomRoot = NULL;
-    free(nodeTable);
-    nodeTable = NULL;
+    /*
+     * All strings above XA_LAST_PREDEFINED are strdup'ed, so it's safe to
+     * cast here
+     */
+    for (a = XA_LAST_PREDEFINED + 1; a <= lastAtom; a++)
+        free((char *) atomNames[a].string);
+    free(atomNames);
+    atomNames = NULL;
+    free(atomHash);
+    atomHash = NULL;
     lastAtom = None;
 }
 
@@ -197,11 +220,13 @@ void
 InitAtoms(void)
 {
     FreeAllAtoms();
-    tableLength = InitialTableSize;
-    nodeTable = xallocarray(InitialTableSize, sizeof(NodePtr));
-    if (!nodeTable)
+    namesLength = InitialTableSize;
+    atomNames = xallocarray(InitialTableSize, sizeof(AtomNameRec));
+    hashMask = 2 * InitialTableSize - 1;
+    atomHash = calloc(hashMask + 1, sizeof(Atom));
+    if (!atomNames || !atomHash)
         AtomError();
-    nodeTable[None] = NULL;
+    atomNames[None].string = NULL;
     MakePredeclaredAtoms();
     if (lastAtom != XA_LAST_PREDEFINED)
         AtomError();
@@ -112,6 +112,7 @@ Equipment Corporation.
 #include "dix/dix_priv.h"
 #include "dix/gc_priv.h"
 #include "dix/registry_priv.h"
+#include "dix/reqstats_priv.h"
 #include "dix/screenint_priv.h"
 #include "os/auth.h"
 #include "os/ddx_priv.h"
@@ -496,6 +497,9 @@ void DispatchQueuedEvents(Bool wait)
     }
     while (1)
     {
+        if (reqStatsDumpPending)
+            ReqStatsDump();
+
         if (InputCheckPending())
         {
             ProcessInputEvents();
@@ -533,6 +537,7 @@ void DispatchQueuedEvents(Bool wait)
             while (!isItTimeToYield)
             {
                 int result;
+                CARD64 stats_start = 0;
 #ifdef XSERVER_DTRACE
                 CARD8 StartMajorOp;
 #endif
@@ -582,6 +587,8 @@ void DispatchQueuedEvents(Bool wait)
                     result = BadLength;
                 else
                 {
+                    if (reqStatsEnabled)
+                        stats_start = GetTimeInMicros();
                     result = XaceHookDispatch(client, client->majorOp);
                     if (result == Success) {
                         currentClient = client;
@@ -589,6 +596,8 @@ void DispatchQueuedEvents(Bool wait)
                             (*client->requestVector[client->majorOp]) (client);
                         currentClient = NULL;
                     }
+                    if (stats_start)
+                        ReqStatsRecord(client, stats_start);
                 }
                 if (!SmartScheduleSignalEnable)
                     SmartScheduleTime = GetTimeInMillis();
@@ -2219,6 +2228,21 @@ ProcPutImage(ClientPtr client)
     return Success;
 }
 
+/*
+ * Replace a band buffer that was queued for output by WriteToClientNoCopy().
+ * The reply header has already gone out, so if this fails the client has
+ * to be dropped.
+ */
+static void *
+GetImageBuffer(ClientPtr client, int length)
+{
+    void *pBuf = calloc(1, length);
+
+    if (!pBuf)
+        MarkClientException(client);
+    return pBuf;
+}
+
 static int
 DoGetImage(ClientPtr client, int format, Drawable drawable,
            int x, int y, int width, int height,
@@ -2378,8 +2402,11 @@ DoGetImage(ClientPtr client, int format, Drawable drawable,
             ReformatImage(pBuf, (int) (nlines * widthBytesLine),
                           BitsPerPixel(pDraw->depth), ClientOrder(client));
 
-            WriteToClient(client, (int) (nlines * widthBytesLine), pBuf);
+            WriteToClientNoCopy(client, (int) (nlines * widthBytesLine),
+                                (void **) &pBuf);
             linesDone += nlines;
+            if (!pBuf && !(pBuf = GetImageBuffer(client, length)))
+                return Success;
         }
     }
     else {                      /* XYPixmap */
@@ -2406,8 +2433,11 @@ DoGetImage(ClientPtr client, int format, Drawable drawable,
                     ReformatImage(pBuf, (int) (nlines * widthBytesLine),
                                   1, ClientOrder(client));
 
-                    WriteToClient(client, (int)(nlines * widthBytesLine), pBuf);
+                    WriteToClientNoCopy(client, (int)(nlines * widthBytesLine),
+                                        (void **) &pBuf);
                     linesDone += nlines;
+                    if (!pBuf && !(pBuf = GetImageBuffer(client, length)))
+                        return Success;
                 }
             }
         }
@@ -3640,6 +3670,7 @@ CloseDownClient(ClientPtr client)
             nextFreeClientID = client->index;
         clients[client->index] = NullClient;
         SmartLastClient = NullClient;
+        ReqStatsFreeClient(client);
         dixFreeObjectWithPrivates(client, PRIVATE_CLIENT);
 
         while (!clients[currentMaxClients - 1])
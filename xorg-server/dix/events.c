@@ -117,6 +117,7 @@ Equipment Corporation.
 #include "dix/dix_priv.h"
 #include "dix/eventconvert.h"
 #include "dix/exevents_priv.h"
+#include "os/osdep.h"
 #include "xkb/xkbsrv_priv.h"
 
 #include "misc.h"
@@ -6002,6 +6003,26 @@ ProcRecolorCursor(ClientPtr client)
     return Success;
 }
 
+/*
+ * Motion events that a later one for the same window and device makes
+ * obsolete get a key, so they can be compressed while queued for a client
+ * that does not keep up.  Raw events carry deltas and are never dropped.
+ */
+static CARD64
+MotionEventKey(int count, xEvent *events)
+{
+    xXIDeviceEvent *xi = (xXIDeviceEvent *) events;
+
+    if (count != 1)
+        return 0;
+    if (events->u.u.type == MotionNotify)
+        return (CARD64) 1 << 48 | events->u.keyButtonPointer.event;
+    if (events->u.u.type == GenericEvent && xi->extension == IReqCode &&
+        xi->evtype == XI_Motion)
+        return (CARD64) 2 << 48 | (CARD64) xi->deviceid << 32 | xi->event;
+    return 0;
+}
+
 /**
  * Write the given events to a client, swapping the byte order if necessary.
  * To swap the byte ordering, a callback is called that has to be set up for
@@ -6024,6 +6045,7 @@ WriteEventsToClient(ClientPtr pClient, int count, xEvent *events)
 #endif
     xEvent *eventTo, *eventFrom;
     int i, eventlength = sizeof(xEvent);
+    CARD64 key;
 
     if (!pClient || pClient == serverClient || pClient->clientGone)
         return;
@@ -6096,6 +6118,8 @@ WriteEventsToClient(ClientPtr pClient, int count, xEvent *events)
         eventlength += ((xGenericEvent *) events)->length * 4;
     }
 
+    key = MotionEventKey(count, events);
+
     if (pClient->swapped) {
         if (eventlength > swapEventLen) {
             swapEventLen = eventlength;
@@ -6115,14 +6139,14 @@ WriteEventsToClient(ClientPtr pClient, int count, xEvent *events)
             (*EventSwapVector[eventFrom->u.u.type & 0177])
                 (eventFrom, eventTo);
 
-            WriteToClient(pClient, eventlength, eventTo);
+            WriteMotionToClient(pClient, eventlength, eventTo, key);
         }
     }
     else {
         /* only one GenericEvent, remember? that means either count is 1 and
          * eventlength is arbitrary or eventlength is 32 and count doesn't
          * matter. And we're all set. Woohoo. */
-        WriteToClient(pClient, count * eventlength, events);
+        WriteMotionToClient(pClient, count * eventlength, events, key);
     }
 }
 
@@ -116,6 +116,8 @@ TimeStamp currentTime;
 
 int defaultColorVisualClass = -1;
 int monitorResolution = 0;
+int damageMaxBoxes = 64;
+int shadowTileThreads = 0;
 
 const char *display;
 intptr_t displayfd = -1;
@@ -89,6 +89,199 @@ PrintPropertys(WindowPtr pWin)
 }
 #endif
 
+/*
+ * Windows carrying many properties (root windows of busy desktops often
+ * have hundreds) get an open-addressed index from atom to the first
+ * property of that name in userProps, so that lookups no longer walk the
+ * whole list.  The list stays authoritative: the index is built once a
+ * window reaches PROPERTY_INDEX_MIN properties, dropped again when it
+ * falls well below that, and simply discarded if it cannot be grown.
+ *
+ * Security modules may polyinstantiate properties, i.e. keep several
+ * entries of the same name on one window and pick between them by walking
+ * on from the first one.  The index therefore always points at the first
+ * entry of a name in list order.
+ */
+
+#define PROPERTY_INDEX_MIN      32
+
+typedef struct _PropertyIndex {
+    unsigned int shift;         /* 32 - log2(number of slots) */
+    unsigned int used;          /* occupied slots */
+    unsigned int nprops;        /* properties on the window */
+    Bool dups;                  /* some name is on the list twice */
+    PropertyPtr slots[];
+} PropertyIndexRec, *PropertyIndexPtr;
+
+#define PropertyIndexSize(index)        (1u << (32 - (index)->shift))
+
+static inline unsigned int
+PropertyIndexHash(PropertyIndexPtr index, Atom name)
+{
+    return ((uint32_t) name * 0x9E3779B1u) >> index->shift;
+}
+
+static unsigned int
+PropertyIndexSlot(PropertyIndexPtr index, Atom name)
+{
+    unsigned int mask = PropertyIndexSize(index) - 1;
+    unsigned int i = PropertyIndexHash(index, name);
+
+    while (index->slots[i] && index->slots[i]->propertyName != name)
+        i = (i + 1) & mask;
+    return i;
+}
+
+/* Index every property on the list, keeping the first of each name. */
+static PropertyIndexPtr
+PropertyIndexBuild(PropertyPtr list, unsigned int nprops)
+{
+    PropertyIndexPtr index;
+    PropertyPtr pProp;
+    unsigned int shift = 31, i;
+
+    while ((1u << (32 - shift)) < nprops * 2)
+        shift--;
+    index = calloc(1, sizeof(PropertyIndexRec) +
+                   (sizeof(PropertyPtr) << (32 - shift)));
+    if (!index)
+        return NULL;
+    index->shift = shift;
+
+    for (pProp = list; pProp; pProp = pProp->next) {
+        i = PropertyIndexSlot(index, pProp->propertyName);
+        if (index->slots[i])
+            index->dups = TRUE;
+        else {
+            index->slots[i] = pProp;
+            index->used++;
+        }
+        index->nprops++;
+    }
+    return index;
+}
+
+static void
+PropertyIndexDestroy(WindowPtr pWin)
+{
+    free(pWin->optional->userPropIndex);
+    pWin->optional->userPropIndex = NULL;
+}
+
+/* Account for pProp, which has just been put at the head of the list. */
+static void
+PropertyIndexAdd(WindowPtr pWin, PropertyPtr pProp)
+{
+    PropertyIndexPtr index = pWin->optional->userPropIndex;
+    unsigned int i, nprops;
+
+    if (!index) {
+        PropertyPtr p = pProp;
+
+        for (i = 0; p && i < PROPERTY_INDEX_MIN; i++)
+            p = p->next;
+        if (i < PROPERTY_INDEX_MIN)
+            return;
+        for (; p; p = p->next)
+            i++;
+        pWin->optional->userPropIndex = PropertyIndexBuild(pProp, i);
+        return;
+    }
+
+    i = PropertyIndexSlot(index, pProp->propertyName);
+    if (index->slots[i]) {
+        index->slots[i] = pProp;
+        index->dups = TRUE;
+        index->nprops++;
+        return;
+    }
+
+    if ((index->used + 1) * 2 > PropertyIndexSize(index)) {
+        nprops = index->nprops + 1;
+        PropertyIndexDestroy(pWin);
+        pWin->optional->userPropIndex = PropertyIndexBuild(pProp, nprops);
+        return;
+    }
+    index->slots[i] = pProp;
+    index->used++;
+    index->nprops++;
+}
+
+/*
+ * Account for pProp, which has just been unlinked.  Its next pointer
+ * still leads to the rest of the list.
+ */
+static void
+PropertyIndexRemove(WindowPtr pWin, PropertyPtr pProp)
+{
+    PropertyIndexPtr index = pWin->optional->userPropIndex;
+    PropertyPtr pDup;
+    unsigned int mask, i, j, k;
+
+    if (!index)
+        return;
+    if (--index->nprops < PROPERTY_INDEX_MIN / 2) {
+        PropertyIndexDestroy(pWin);
+        return;
+    }
+
+    i = PropertyIndexSlot(index, pProp->propertyName);
+    if (index->slots[i] != pProp)
+        return;                 /* a later duplicate */
+
+    if (index->dups) {
+        for (pDup = pProp->next; pDup; pDup = pDup->next)
+            if (pDup->propertyName == pProp->propertyName) {
+                index->slots[i] = pDup;
+                return;
+            }
+    }
+
+    /* Backward-shift deletion, so that no probe sequence is broken */
+    mask = PropertyIndexSize(index) - 1;
+    index->used--;
+    for (j = i;;) {
+        index->slots[i] = NULL;
+        for (;;) {
+            j = (j + 1) & mask;
+            if (!index->slots[j])
+                return;
+            k = PropertyIndexHash(index, index->slots[j]->propertyName);
+            /* entries whose home slot lies in (i, j] stay where they are */
+            if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+                continue;
+            break;
+        }
+        index->slots[i] = index->slots[j];
+        i = j;
+    }
+}
+
+/* Take pProp off the window's list, dropping the optional record if idle. */
+static void
+UnlinkProperty(WindowPtr pWin, PropertyPtr pProp)
+{
+    PropertyPtr prevProp;
+
+    if (pWin->optional->userProps == pProp) {
+        /* Takes care of head */
+        pWin->optional->userProps = pProp->next;
+    }
+    else {
+        /* Need to traverse to find the previous element */
+        prevProp = pWin->optional->userProps;
+        while (prevProp->next != pProp)
+            prevProp = prevProp->next;
+        prevProp->next = pProp->next;
+    }
+    PropertyIndexRemove(pWin, pProp);
+
+    if (!pWin->optional->userProps) {
+        PropertyIndexDestroy(pWin);
+        CheckWindowOptionalNeed(pWin);
+    }
+}
+
 int
 dixLookupProperty(PropertyPtr *result, WindowPtr pWin, Atom propertyName,
                   ClientPtr client, Mask access_mode)
@@ -98,9 +291,16 @@ dixLookupProperty(PropertyPtr *result, WindowPtr pWin, Atom propertyName,
 
     client->errorValue = propertyName;
 
-    for (pProp = wUserProps(pWin); pProp; pProp = pProp->next)
-        if (pProp->propertyName == propertyName)
-            break;
+    if (pWin->optional && pWin->optional->userPropIndex) {
+        PropertyIndexPtr index = pWin->optional->userPropIndex;
+
+        pProp = index->slots[PropertyIndexSlot(index, propertyName)];
+    }
+    else {
+        for (pProp = wUserProps(pWin); pProp; pProp = pProp->next)
+            if (pProp->propertyName == propertyName)
+                break;
+    }
 
     if (pProp)
         rc = XaceHookPropertyAccess(client, pWin, &pProp, access_mode);
@@ -299,6 +499,7 @@ dixChangeWindowProperty(ClientPtr pClient, WindowPtr pWin, Atom property,
         }
         pProp->next = pWin->optional->userProps;
         pWin->optional->userProps = pProp;
+        PropertyIndexAdd(pWin, pProp);
     }
     else if (rc == Success) {
         /* To append or prepend to a property the request format and type
@@ -372,7 +573,7 @@ dixChangeWindowProperty(ClientPtr pClient, WindowPtr pWin, Atom property,
 int
 DeleteProperty(ClientPtr client, WindowPtr pWin, Atom propName)
 {
-    PropertyPtr pProp, prevProp;
+    PropertyPtr pProp;
     int rc;
 
     rc = dixLookupProperty(&pProp, pWin, propName, client, DixDestroyAccess);
@@ -380,18 +581,7 @@ DeleteProperty(ClientPtr client, WindowPtr pWin, Atom propName)
         return Success;         /* Succeed if property does not exist */
 
     if (rc == Success) {
-        if (pWin->optional->userProps == pProp) {
-            /* Takes care of head */
-            if (!(pWin->optional->userProps = pProp->next))
-                CheckWindowOptionalNeed(pWin);
-        }
-        else {
-            /* Need to traverse to find the previous element */
-            prevProp = pWin->optional->userProps;
-            while (prevProp->next != pProp)
-                prevProp = prevProp->next;
-            prevProp->next = pProp->next;
-        }
+        UnlinkProperty(pWin, pProp);
 
         deliverPropertyNotifyEvent(pWin, PropertyDelete, pProp);
         free(pProp->data);
@@ -414,8 +604,10 @@ DeleteAllWindowProperties(WindowPtr pWin)
         pProp = pNextProp;
     }
 
-    if (pWin->optional)
+    if (pWin->optional) {
         pWin->optional->userProps = NULL;
+        PropertyIndexDestroy(pWin);
+    }
 }
 
 static int
@@ -446,7 +638,7 @@ NullPropertyReply(ClientPtr client, ATOM propertyType, int format)
 int
 ProcGetProperty(ClientPtr client)
 {
-    PropertyPtr pProp, prevProp;
+    PropertyPtr pProp;
     unsigned long n, len, ind;
     int rc;
     WindowPtr pWin;
@@ -547,18 +739,7 @@ ProcGetProperty(ClientPtr client)
 
     if (stuff->delete && (reply.bytesAfter == 0)) {
         /* Delete the Property */
-        if (pWin->optional->userProps == pProp) {
-            /* Takes care of head */
-            if (!(pWin->optional->userProps = pProp->next))
-                CheckWindowOptionalNeed(pWin);
-        }
-        else {
-            /* Need to traverse to find the previous element */
-            prevProp = pWin->optional->userProps;
-            while (prevProp->next != pProp)
-                prevProp = prevProp->next;
-            prevProp->next = pProp->next;
-        }
+        UnlinkProperty(pWin, pProp);
 
         free(pProp->data);
         dixFreeObjectWithPrivates(pProp, PRIVATE_PROPERTY);
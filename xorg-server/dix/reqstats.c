@@ -0,0 +1,249 @@
+/* SPDX-License-Identifier: MIT OR X11
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "dix/registry_priv.h"
+#include "dix/reqstats_priv.h"
+
+#include "misc.h"
+#include "os.h"
+#include "dixstruct.h"
+
+/*
+ * Counters are only allocated for clients that issue requests while
+ * statistics are enabled.  Core requests are a fixed array indexed by
+ * major opcode; each extension gets an array indexed by minor opcode,
+ * grown as higher minors show up.
+ */
+
+#define NUM_EXT_MAJORS (256 - EXTENSION_BASE)
+
+typedef struct _ReqStats {
+    ReqStatRec flush;
+    ReqStatRec core[EXTENSION_BASE];
+    ReqStatPtr ext[NUM_EXT_MAJORS];
+    unsigned short numMinors[NUM_EXT_MAJORS];
+} ReqStatsRec, *ReqStatsPtr;
+
+Bool reqStatsEnabled = FALSE;
+volatile sig_atomic_t reqStatsDumpPending = 0;
+#ifdef SIGUSR2
+int reqStatsDumpSignal = SIGUSR2;
+#else
+int reqStatsDumpSignal = 0;
+#endif
+CallbackListPtr ReqStatsDumpCallback;
+
+void
+ReqStatsEnable(Bool enable)
+{
+    reqStatsEnabled = enable;
+}
+
+static ReqStatsPtr
+ClientReqStats(ClientPtr client)
+{
+    if (!client->reqStats)
+        client->reqStats = calloc(1, sizeof(ReqStatsRec));
+    return client->reqStats;
+}
+
+static ReqStatPtr
+ExtensionReqStat(ReqStatsPtr stats, int major, int minor)
+{
+    int i = major - EXTENSION_BASE;
+
+    if (minor >= stats->numMinors[i]) {
+        int n = max(minor + 1, 8);
+        ReqStatPtr ext;
+
+        while (n < minor + 1)
+            n <<= 1;
+        n = min(n, 256);
+        ext = reallocarray(stats->ext[i], n, sizeof(ReqStatRec));
+        if (!ext)
+            return NULL;
+        memset(ext + stats->numMinors[i], 0,
+               (n - stats->numMinors[i]) * sizeof(ReqStatRec));
+        stats->ext[i] = ext;
+        stats->numMinors[i] = n;
+    }
+    return &stats->ext[i][minor];
+}
+
+void
+ReqStatsAddSample(ReqStatPtr stat, CARD64 start)
+{
+    CARD64 now = GetTimeInMicros();
+    CARD32 us = now > start ? (CARD32) min(now - start, 0xffffffff) : 0;
+    CARD32 v = us;
+    int bucket = 0;
+
+    while (v && bucket < REQSTATS_BUCKETS - 1) {
+        v >>= 1;
+        bucket++;
+    }
+
+    stat->count++;
+    stat->total += us;
+    if (us > stat->max)
+        stat->max = us;
+    stat->hist[bucket]++;
+}
+
+/*
+ * Account the request the client is currently dispatching, which started
+ * at start (from GetTimeInMicros).
+ */
+void
+ReqStatsRecord(ClientPtr client, CARD64 start)
+{
+    ReqStatsPtr stats = ClientReqStats(client);
+    ReqStatPtr stat;
+
+    if (!stats)
+        return;
+
+    if (client->majorOp < EXTENSION_BASE)
+        stat = &stats->core[client->majorOp];
+    else
+        stat = ExtensionReqStat(stats, client->majorOp, client->minorOp);
+
+    if (stat)
+        ReqStatsAddSample(stat, start);
+}
+
+void
+ReqStatsRecordFlush(ClientPtr client, CARD64 start)
+{
+    ReqStatsPtr stats = ClientReqStats(client);
+
+    if (stats)
+        ReqStatsAddSample(&stats->flush, start);
+}
+
+void
+ReqStatsFreeClient(ClientPtr client)
+{
+    ReqStatsPtr stats = client->reqStats;
+    int i;
+
+    if (!stats)
+        return;
+
+    for (i = 0; i < NUM_EXT_MAJORS; i++)
+        free(stats->ext[i]);
+    free(stats);
+    client->reqStats = NULL;
+}
+
+void
+ReqStatsReset(ClientPtr client)
+{
+    int i;
+
+    if (client) {
+        ReqStatsFreeClient(client);
+        return;
+    }
+
+    for (i = 0; i < currentMaxClients; i++)
+        if (clients[i])
+            ReqStatsFreeClient(clients[i]);
+}
+
+void
+ReqStatsForEach(ClientPtr client, ReqStatsProcPtr proc, void *closure)
+{
+    ReqStatsPtr stats = client->reqStats;
+    int i, j;
+
+    if (!stats)
+        return;
+
+    if (stats->flush.count)
+        (*proc) (client, 0, 0, &stats->flush, closure);
+
+    for (i = 1; i < EXTENSION_BASE; i++)
+        if (stats->core[i].count)
+            (*proc) (client, i, 0, &stats->core[i], closure);
+
+    for (i = 0; i < NUM_EXT_MAJORS; i++)
+        for (j = 0; j < stats->numMinors[i]; j++)
+            if (stats->ext[i][j].count)
+                (*proc) (client, i + EXTENSION_BASE, j, &stats->ext[i][j],
+                         closure);
+}
+
+void
+ReqStatsLogStat(const char *name, const ReqStatRec *stat)
+{
+    char hist[REQSTATS_BUCKETS * 11 + 1];
+    int i, last, len = 0;
+
+    for (last = REQSTATS_BUCKETS - 1; last > 0 && !stat->hist[last]; last--)
+        ;
+    for (i = 0; i <= last; i++)
+        len += snprintf(hist + len, sizeof(hist) - len, " %u",
+                        (unsigned int) stat->hist[i]);
+
+    LogMessageVerb(X_NONE, 0,
+                   "  %-40s %10u %10llu %10u  hist:%s\n", name,
+                   (unsigned int) stat->count,
+                   (unsigned long long) (stat->count ?
+                                         stat->total / stat->count : 0),
+                   (unsigned int) stat->max, hist);
+}
+
+static void
+DumpReqStat(ClientPtr client, int major, int minor,
+            const ReqStatRec *stat, void *closure)
+{
+#ifdef X_REGISTRY_REQUEST
+    ReqStatsLogStat(major ? LookupRequestName(major, minor) : "(flush)",
+                    stat);
+#else
+    char name[24];
+
+    if (major)
+        snprintf(name, sizeof(name), "request %d.%d", major, minor);
+    else
+        strcpy(name, "(flush)");
+    ReqStatsLogStat(name, stat);
+#endif
+}
+
+void
+ReqStatsDump(void)
+{
+    int i;
+
+    reqStatsDumpPending = 0;
+
+    LogMessage(X_INFO, "Request statistics (%s), latencies in microseconds\n",
+               reqStatsEnabled ? "enabled" : "disabled");
+
+    for (i = 0; i < currentMaxClients; i++) {
+        if (!clients[i] || !clients[i]->reqStats)
+            continue;
+        LogMessageVerb(X_NONE, 0, "client %d (0x%lx):\n"
+                       "  %-40s %10s %10s %10s\n", i,
+                       (unsigned long) clients[i]->clientAsMask,
+                       "request", "count", "mean", "max");
+        ReqStatsForEach(clients[i], DumpReqStat, NULL);
+    }
+
+    CallCallbacks(&ReqStatsDumpCallback, NULL);
+}
+
+void
+ReqStatsSignal(int sig)
+{
+    reqStatsDumpPending = 1;
+}
@@ -0,0 +1,71 @@
+/* SPDX-License-Identifier: MIT OR X11
+ */
+#ifndef _XSERVER_DIX_REQSTATS_PRIV_H
+#define _XSERVER_DIX_REQSTATS_PRIV_H
+
+#include <signal.h>
+#include <X11/Xmd.h>
+
+#include "include/callback.h"
+#include "include/dixstruct.h"
+
+/*
+ * Optional per-client, per-request dispatch statistics.  When enabled
+ * (-requeststats, or through the X-Resource extension), every request is
+ * timed and counted under its major/minor opcode, and time spent writing
+ * output to the client is counted under the pseudo opcode 0/0.
+ *
+ * Latencies are kept in microseconds.  Histogram bucket 0 counts
+ * requests that took less than a microsecond, bucket n counts those that
+ * took [2^(n-1), 2^n) microseconds and the last bucket is open-ended.
+ */
+
+#define REQSTATS_BUCKETS 20
+
+typedef struct _ReqStat {
+    CARD32 count;
+    CARD32 max;
+    CARD64 total;
+    CARD32 hist[REQSTATS_BUCKETS];
+} ReqStatRec, *ReqStatPtr;
+
+typedef void (*ReqStatsProcPtr) (ClientPtr client, int major, int minor,
+                                 const ReqStatRec *stat, void *closure);
+
+extern Bool reqStatsEnabled;
+extern volatile sig_atomic_t reqStatsDumpPending;
+
+/*
+ * Signal that requests a dump to the log, SIGUSR2 by default where it
+ * exists.  Set with -requeststatssignal; 0 installs no handler.  A DDX
+ * that needs the signal for itself clears this before taking it over.
+ */
+extern int reqStatsDumpSignal;
+
+void ReqStatsEnable(Bool enable);
+void ReqStatsRecord(ClientPtr client, CARD64 start);
+void ReqStatsRecordFlush(ClientPtr client, CARD64 start);
+
+/* Account one sample that started at start (from GetTimeInMicros) */
+void ReqStatsAddSample(ReqStatPtr stat, CARD64 start);
+
+/* Reset one client's counters, or every client's if client is NULL */
+void ReqStatsReset(ClientPtr client);
+void ReqStatsFreeClient(ClientPtr client);
+
+/* Call proc for every opcode the client has counters for */
+void ReqStatsForEach(ClientPtr client, ReqStatsProcPtr proc, void *closure);
+
+/* Write every client's counters to the log */
+void ReqStatsDump(void);
+
+/* Write one line of counters to the log, in the format of ReqStatsDump */
+void ReqStatsLogStat(const char *name, const ReqStatRec *stat);
+
+/* Called at the end of every dump, so others can log their own counters */
+extern CallbackListPtr ReqStatsDumpCallback;
+
+/* Signal handler; the dump itself is done by the dispatch loop */
+void ReqStatsSignal(int sig);
+
+#endif /* _XSERVER_DIX_REQSTATS_PRIV_H */
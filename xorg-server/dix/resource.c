@@ -105,8 +105,7 @@ Equipment Corporation.
  *      A resource ID is a 32 bit quantity, the upper 2 bits of which are
  *	off-limits for client-visible resources.  The next 8 bits are
  *      used as client ID, and the low 22 bits come from the client.
- *	A resource ID is "hashed" by extracting and xoring subfields
- *      (varying with the size of the hash table).
+ *	Each client's resources are kept in a hash table keyed by ID.
  *
  *      It is sometimes necessary for the server to create an ID that looks
  *      like it belongs to a client.  This ID, however,  must not be one
@@ -152,14 +151,25 @@ Equipment Corporation.
 #define TypeNameString(t) LookupResourceName(t)
 #endif
 
-static void RebuildTable(int    /*client */
-    );
-
 #define SERVER_MINID 32
 
-#define INITBUCKETS 64
-#define INITHASHSIZE 6
-#define MAXHASHSIZE 16
+/*
+ * Each client's resources live in an open-addressed hash table with
+ * linear probing, keyed by XID.  A slot holds the id inline, so probing
+ * does not chase pointers, and the newest resource with that id; older
+ * resources sharing the id hang off its next pointer.  Freed slots
+ * become tombstones so that slot positions never move under a walk.
+ *
+ * When a table gets more than half full, a new one is allocated and the
+ * old one is drained into it a few slots at a time by AddResource and
+ * FreeResource, instead of all at once.  Until it is empty, lookups look
+ * in both; every id lives in exactly one of them.  Draining pauses while
+ * a walk over the client's resources is in progress.
+ */
+
+#define INITSLOTS 128
+#define MIGRATE_SLOTS 64
+#define DEAD_ID (~(XID) 0)      /* never a valid resource id */
 
 typedef struct _Resource {
     struct _Resource *next;
@@ -168,11 +178,25 @@ typedef struct _Resource {
     void *value;
 } ResourceRec, *ResourcePtr;
 
+typedef struct _ResourceSlot {
+    XID id;                     /* DEAD_ID for a tombstone */
+    ResourcePtr res;            /* NULL for an empty slot or a tombstone */
+} ResourceSlotRec, *ResourceSlotPtr;
+
+typedef struct _ResourceTable {
+    ResourceSlotPtr slots;
+    unsigned int shift;         /* 32 - log2(number of slots) */
+    unsigned int used;          /* slots holding resources */
+    unsigned int dead;          /* tombstones */
+} ResourceTableRec, *ResourceTablePtr;
+
 typedef struct _ClientResource {
-    ResourcePtr *resources;
+    ResourceTableRec table;     /* NULL slots when the client is not in use */
+    ResourceTableRec old;       /* being drained into table, if slots set */
+    unsigned int migrate;       /* next slot of old to move */
+    int walking;                /* walks in progress, slots must not move */
+    unsigned int generation;    /* bumped when slots move under a walk */
     int elements;
-    int buckets;
-    int hashsize;               /* log(2)(buckets) */
     XID fakeID;
     XID endFakeID;
 } ClientResourceRec;
@@ -603,6 +627,8 @@ CreateNewResourceClass(void)
 
 static ClientResourceRec clientTable[MAXCLIENTS];
 
+#define TableSize(t) (1u << (32 - (t)->shift))
+
 static unsigned int
 ilog2(int val)
 {
@@ -634,6 +660,22 @@ ResourceClientBits(void)
     return cache_ilog2;
 }
 
+static Bool
+AllocResourceTable(ResourceTablePtr t, unsigned int size)
+{
+    unsigned int shift = 32;
+
+    while ((1u << (32 - shift)) < size)
+        shift--;
+    t->slots = calloc(1u << (32 - shift), sizeof(ResourceSlotRec));
+    if (!t->slots)
+        return FALSE;
+    t->shift = shift;
+    t->used = 0;
+    t->dead = 0;
+    return TRUE;
+}
+
 /*****************
  * InitClientResources
  *    When a new client is created, call this to allocate space
@@ -643,7 +685,7 @@ ResourceClientBits(void)
 Bool
 InitClientResources(ClientPtr client)
 {
-    int i, j;
+    int i;
 
     if (client == serverClient) {
         lastResourceType = X11_RESTYPE_LASTPREDEF;
@@ -655,13 +697,12 @@ InitClientResources(ClientPtr client)
             return FALSE;
         memcpy(resourceTypes, predefTypes, sizeof(predefTypes));
     }
-    clientTable[i = client->index].resources =
-        malloc(INITBUCKETS * sizeof(ResourcePtr));
-    if (!clientTable[i].resources)
+    if (!AllocResourceTable(&clientTable[i = client->index].table, INITSLOTS))
         return FALSE;
-    clientTable[i].buckets = INITBUCKETS;
+    clientTable[i].old.slots = NULL;
+    clientTable[i].migrate = 0;
+    clientTable[i].walking = 0;
     clientTable[i].elements = 0;
-    clientTable[i].hashsize = INITHASHSIZE;
     /* Many IDs allocated from the server client are visible to clients,
      * so we don't use the SERVER_BIT for them, but we have to start
      * past the magic value constants used in the protocol.  For normal
@@ -670,9 +711,6 @@ InitClientResources(ClientPtr client)
     clientTable[i].fakeID = client->clientAsMask |
         (client->index ? SERVER_BIT : SERVER_MINID);
     clientTable[i].endFakeID = (clientTable[i].fakeID | RESOURCE_ID_MASK) + 1;
-    for (j = 0; j < INITBUCKETS; j++) {
-        clientTable[i].resources[j] = NULL;
-    }
     return TRUE;
 }
 
@@ -689,18 +727,182 @@ HashResourceID(XID id, unsigned int numBits)
     return (id ^ (id >> numBits)) & ~((~0) << numBits);
 }
 
+static inline unsigned int
+SlotHash(const ResourceTableRec *t, XID id)
+{
+    /* Clients mostly hand out ids in sequence.  Runs of eight ids stay
+     * together for locality, and the runs are scattered over the table. */
+    return ((((uint32_t) (id >> 3) * 0x9E3779B1u) >> (t->shift + 3)) << 3) |
+        (id & 7);
+}
+
+static inline ResourceSlotPtr
+FindSlot(const ResourceTableRec *t, XID id)
+{
+    unsigned int mask = TableSize(t) - 1;
+    unsigned int i = SlotHash(t, id);
+    ResourceSlotPtr slot;
+
+    for (;; i = (i + 1) & mask) {
+        slot = &t->slots[i];
+        if (slot->res) {
+            if (slot->id == id)
+                return slot;
+        }
+        else if (slot->id != DEAD_ID)
+            return NULL;
+    }
+}
+
+static inline ResourceSlotPtr
+LookupSlot(const ClientResourceRec *rrec, XID id)
+{
+    ResourceSlotPtr slot = FindSlot(&rrec->table, id);
+
+    if (!slot && rrec->old.slots)
+        slot = FindSlot(&rrec->old, id);
+    return slot;
+}
+
+/* Put id into a free slot of t, which must not hold it already */
+static void
+InsertSlot(ResourceTablePtr t, XID id, ResourcePtr res)
+{
+    unsigned int mask = TableSize(t) - 1;
+    unsigned int i = SlotHash(t, id);
+    ResourceSlotPtr slot;
+
+    while ((slot = &t->slots[i])->res)
+        i = (i + 1) & mask;
+    if (slot->id == DEAD_ID)
+        t->dead--;
+    slot->id = id;
+    slot->res = res;
+    t->used++;
+}
+
+/* Turn a slot whose last resource went away into a tombstone */
+static void
+KillSlot(ClientResourceRec *rrec, ResourceSlotPtr slot)
+{
+    ResourceTablePtr t = &rrec->table;
+
+    if (slot < t->slots || slot >= t->slots + TableSize(t))
+        t = &rrec->old;
+    slot->id = DEAD_ID;
+    slot->res = NULL;
+    t->used--;
+    t->dead++;
+}
+
+/* Move up to count slots of the table being drained into the current one */
+static void
+MoveOldSlots(ClientResourceRec *rrec, unsigned int count)
+{
+    ResourceTablePtr old = &rrec->old;
+    unsigned int size = TableSize(old);
+    ResourceSlotPtr slot;
+
+    for (; count && rrec->migrate < size; count--, rrec->migrate++) {
+        slot = &old->slots[rrec->migrate];
+        if (slot->res) {
+            InsertSlot(&rrec->table, slot->id, slot->res);
+            KillSlot(rrec, slot);
+        }
+    }
+    if (rrec->migrate == size) {
+        free(old->slots);
+        old->slots = NULL;
+    }
+}
+
+static inline void
+DrainOldTable(ClientResourceRec *rrec)
+{
+    if (rrec->old.slots && !rrec->walking)
+        MoveOldSlots(rrec, MIGRATE_SLOTS);
+}
+
+/*
+ * Make sure the current table has room for one more id.  Normally this
+ * only swaps in a bigger table and leaves the draining to later calls;
+ * while the client's resources are being walked the table is allowed to
+ * fill up further, and is only rebuilt in one go if it must be.
+ */
+static Bool
+ReserveSlot(ClientResourceRec *rrec)
+{
+    ResourceTablePtr t = &rrec->table;
+    ResourceTableRec grown;
+    unsigned int size = TableSize(t);
+    unsigned int want;
+
+    if ((t->used + t->dead + 1) * 2 <= size)
+        return TRUE;
+    if (rrec->walking && (t->used + t->dead + 1) * 4 <= size * 3)
+        return TRUE;
+
+    if (rrec->old.slots) {
+        MoveOldSlots(rrec, ~0u);
+        rrec->generation++;
+        if ((t->used + t->dead + 1) * 2 <= size)
+            return TRUE;
+    }
+
+    for (want = INITSLOTS; want < (t->used + 1) * 3; want <<= 1)
+        ;
+    if (!AllocResourceTable(&grown, want))
+        return (t->used + t->dead + 1) < size;
+
+    rrec->old = *t;
+    *t = grown;
+    rrec->migrate = 0;
+    if (rrec->walking) {
+        MoveOldSlots(rrec, ~0u);
+        rrec->generation++;
+    }
+    return TRUE;
+}
+
+/* Take res off the chain of slot, where *prev points at it */
+static void
+UnlinkResource(ClientResourceRec *rrec, ResourceSlotPtr slot,
+               ResourcePtr *prev, ResourcePtr res)
+{
+#ifdef XSERVER_DTRACE
+    XSERVER_RESOURCE_FREE(res->id, res->type,
+                          res->value, TypeNameString(res->type));
+#endif
+    *prev = res->next;
+    if (!slot->res)
+        KillSlot(rrec, slot);
+    rrec->elements--;
+}
+
+/*
+ * Slot pos of a walk over all of a client's slots: the current table
+ * first, then the one being drained.  NULL past the end.
+ */
+static ResourceSlotPtr
+WalkSlot(const ClientResourceRec *rrec, unsigned int pos)
+{
+    if (!rrec->table.slots)
+        return NULL;
+    if (pos < TableSize(&rrec->table))
+        return &rrec->table.slots[pos];
+    pos -= TableSize(&rrec->table);
+    if (rrec->old.slots && pos < TableSize(&rrec->old))
+        return &rrec->old.slots[pos];
+    return NULL;
+}
+
 static XID
 AvailableID(int client, XID id, XID maxid, XID goodid)
 {
-    ResourcePtr res;
-
     if ((goodid >= id) && (goodid <= maxid))
         return goodid;
     for (; id <= maxid; id++) {
-        res = clientTable[client].resources[HashResourceID(id, clientTable[client].hashsize)];
-        while (res && (res->id != id))
-            res = res->next;
-        if (!res)
+        if (!LookupSlot(&clientTable[client], id))
             return id;
     }
     return 0;
@@ -710,28 +912,27 @@ void
 GetXIDRange(int client, Bool server, XID *minp, XID *maxp)
 {
     XID id, maxid;
-    ResourcePtr *resp;
-    ResourcePtr res;
-    int i;
-    XID goodid;
+    ResourceSlotPtr slot;
+    unsigned int pos;
+    XID goodid, rid;
 
     id = (Mask) client << CLIENTOFFSET;
     if (server)
         id |= client ? SERVER_BIT : SERVER_MINID;
     maxid = id | RESOURCE_ID_MASK;
     goodid = 0;
-    for (resp = clientTable[client].resources, i = clientTable[client].buckets;
-         --i >= 0;) {
-        for (res = *resp++; res; res = res->next) {
-            if ((res->id < id) || (res->id > maxid))
-                continue;
-            if (((res->id - id) >= (maxid - res->id)) ?
-                (goodid = AvailableID(client, id, res->id - 1, goodid)) :
-                !(goodid = AvailableID(client, res->id + 1, maxid, goodid)))
-                maxid = res->id - 1;
-            else
-                id = res->id + 1;
-        }
+    for (pos = 0; (slot = WalkSlot(&clientTable[client], pos)); pos++) {
+        if (!slot->res)
+            continue;
+        rid = slot->id;
+        if ((rid < id) || (rid > maxid))
+            continue;
+        if (((rid - id) >= (maxid - rid)) ?
+            (goodid = AvailableID(client, id, rid - 1, goodid)) :
+            !(goodid = AvailableID(client, rid + 1, maxid, goodid)))
+            maxid = rid - 1;
+        else
+            id = rid + 1;
     }
     if (id > maxid)
         id = maxid = 0;
@@ -809,77 +1010,47 @@ AddResource(XID id, RESTYPE type, void *value)
 {
     int client;
     ClientResourceRec *rrec;
-    ResourcePtr res, *head;
+    ResourceSlotPtr slot;
+    ResourcePtr res;
 
 #ifdef XSERVER_DTRACE
     XSERVER_RESOURCE_ALLOC(id, type, value, TypeNameString(type));
 #endif
     client = CLIENT_ID(id);
     rrec = &clientTable[client];
-    if (!rrec->buckets) {
+    if (!rrec->table.slots) {
         ErrorF("[dix] AddResource(%lx, %x, %lx), client=%d \n",
                (unsigned long) id, type, (unsigned long)(uintptr_t) value, client);
         FatalError("client not in use\n");
     }
-    if ((rrec->elements >= 4 * rrec->buckets) && (rrec->hashsize < MAXHASHSIZE))
-        RebuildTable(client);
-    head = &rrec->resources[HashResourceID(id, clientTable[client].hashsize)];
+    DrainOldTable(rrec);
     res = malloc(sizeof(ResourceRec));
     if (!res) {
         (*resourceTypes[type & TypeMask].deleteFunc) (value, id);
         return FALSE;
     }
-    res->next = *head;
     res->id = id;
     res->type = type;
     res->value = value;
-    *head = res;
-    rrec->elements++;
-    CallResourceStateCallback(ResourceStateAdding, res);
-    return TRUE;
-}
-
-static void
-RebuildTable(int client)
-{
-    int j;
-    ResourcePtr res, next;
-    ResourcePtr **tails, *resources;
-    ResourcePtr **tptr, *rptr;
-
-    /*
-     * For now, preserve insertion order, since some ddx layers depend
-     * on resources being free in the opposite order they are added.
-     */
-
-    j = 2 * clientTable[client].buckets;
-    tails =  xallocarray(j, sizeof(ResourcePtr *));
-    if (!tails)
-        return;
-    resources =  xallocarray(j, sizeof(ResourcePtr));
-    if (!resources) {
-        free(tails);
-        return;
+    if ((slot = LookupSlot(rrec, id))) {
+        /* Newest first, since some ddx layers depend on resources
+         * with the same id being freed in the opposite order they are
+         * added. */
+        res->next = slot->res;
+        slot->res = res;
     }
-    for (rptr = resources, tptr = tails; --j >= 0; rptr++, tptr++) {
-        *rptr = NULL;
-        *tptr = rptr;
+    else if (ReserveSlot(rrec)) {
+        res->next = NULL;
+        InsertSlot(&rrec->table, id, res);
     }
-    clientTable[client].hashsize++;
-    for (j = clientTable[client].buckets,
-         rptr = clientTable[client].resources; --j >= 0; rptr++) {
-        for (res = *rptr; res; res = next) {
-            next = res->next;
-            res->next = NULL;
-            tptr = &tails[HashResourceID(res->id, clientTable[client].hashsize)];
-            **tptr = res;
-            *tptr = &res->next;
-        }
+    else {
+        free(res);
+        (*resourceTypes[type & TypeMask].deleteFunc) (value, id);
+        return FALSE;
     }
-    free(tails);
-    clientTable[client].buckets *= 2;
-    free(clientTable[client].resources);
-    clientTable[client].resources = resources;
+    rrec->elements++;
+    CallResourceStateCallback(ResourceStateAdding, res);
+    return TRUE;
 }
 
 static void
@@ -897,34 +1068,20 @@ void
 FreeResource(XID id, RESTYPE skipDeleteFuncType)
 {
     int cid;
+    ClientResourceRec *rrec;
+    ResourceSlotPtr slot;
     ResourcePtr res;
-    ResourcePtr *prev, *head;
-    int *eltptr;
-    int elements;
-
-    if (((cid = CLIENT_ID(id)) < LimitClients) && clientTable[cid].buckets) {
-        head = &clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
-        eltptr = &clientTable[cid].elements;
 
-        prev = head;
-        while ((res = *prev)) {
-            if (res->id == id) {
-                RESTYPE rtype = res->type;
+    if (((cid = CLIENT_ID(id)) < LimitClients) && clientTable[cid].table.slots) {
+        rrec = &clientTable[cid];
+        DrainOldTable(rrec);
 
-#ifdef XSERVER_DTRACE
-                XSERVER_RESOURCE_FREE(res->id, res->type,
-                                      res->value, TypeNameString(res->type));
-#endif
-                *prev = res->next;
-                elements = --*eltptr;
-
-                doFreeResource(res, rtype == skipDeleteFuncType);
-
-                if (*eltptr != elements)
-                    prev = head;        /* prev may no longer be valid */
-            }
-            else
-                prev = &res->next;
+        /* The slot is looked up again after every deleteFunc, which may
+           have added or freed other resources of this client. */
+        while (rrec->table.slots && (slot = LookupSlot(rrec, id))) {
+            res = slot->res;
+            UnlinkResource(rrec, slot, &slot->res, res);
+            doFreeResource(res, res->type == skipDeleteFuncType);
         }
     }
 }
@@ -933,24 +1090,22 @@ void
 FreeResourceByType(XID id, RESTYPE type, Bool skipFree)
 {
     int cid;
+    ClientResourceRec *rrec;
+    ResourceSlotPtr slot;
     ResourcePtr res;
-    ResourcePtr *prev, *head;
+    ResourcePtr *prev;
 
-    if (((cid = CLIENT_ID(id)) < LimitClients) && clientTable[cid].buckets) {
-        head = &clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
+    if (((cid = CLIENT_ID(id)) < LimitClients) && clientTable[cid].table.slots) {
+        rrec = &clientTable[cid];
+        DrainOldTable(rrec);
 
-        prev = head;
+        if (!(slot = LookupSlot(rrec, id)))
+            return;
+        prev = &slot->res;
         while ((res = *prev)) {
-            if (res->id == id && res->type == type) {
-#ifdef XSERVER_DTRACE
-                XSERVER_RESOURCE_FREE(res->id, res->type,
-                                      res->value, TypeNameString(res->type));
-#endif
-                *prev = res->next;
-                clientTable[cid].elements--;
-
+            if (res->type == type) {
+                UnlinkResource(rrec, slot, prev, res);
                 doFreeResource(res, skipFree);
-
                 break;
             }
             else
@@ -969,13 +1124,13 @@ Bool
 ChangeResourceValue(XID id, RESTYPE rtype, void *value)
 {
     int cid;
+    ResourceSlotPtr slot;
     ResourcePtr res;
 
-    if (((cid = CLIENT_ID(id)) < LimitClients) && clientTable[cid].buckets) {
-        res = clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
-
-        for (; res; res = res->next)
-            if ((res->id == id) && (res->type == rtype)) {
+    if (((cid = CLIENT_ID(id)) < LimitClients) && clientTable[cid].table.slots &&
+        (slot = LookupSlot(&clientTable[cid], id))) {
+        for (res = slot->res; res; res = res->next)
+            if (res->type == rtype) {
                 res->value = value;
                 return TRUE;
             }
@@ -993,27 +1148,33 @@ void
 FindClientResourcesByType(ClientPtr client,
                           RESTYPE type, FindResType func, void *cdata)
 {
-    ResourcePtr *resources;
+    ClientResourceRec *rrec;
+    ResourceSlotPtr slot;
     ResourcePtr this, next;
-    int i, elements;
-    int *eltptr;
+    unsigned int pos, generation;
+    int elements;
 
     if (!client)
         client = serverClient;
 
-    resources = clientTable[client->index].resources;
-    eltptr = &clientTable[client->index].elements;
-    for (i = 0; i < clientTable[client->index].buckets; i++) {
-        for (this = resources[i]; this; this = next) {
+    rrec = &clientTable[client->index];
+    rrec->walking++;
+ restart:
+    generation = rrec->generation;
+    for (pos = 0; (slot = WalkSlot(rrec, pos)); pos++) {
+        for (this = slot->res; this; this = next) {
             next = this->next;
             if (!type || this->type == type) {
-                elements = *eltptr;
+                elements = rrec->elements;
                 (*func) (this->value, this->id, cdata);
-                if (*eltptr != elements)
-                    next = resources[i];        /* start over */
+                if (rrec->generation != generation)
+                    goto restart;
+                if (rrec->elements != elements)
+                    next = slot->res;   /* start over */
             }
         }
     }
+    rrec->walking--;
 }
 
 void FindSubResources(void *resource,
@@ -1028,25 +1189,31 @@ void FindSubResources(void *resource,
 void
 FindAllClientResources(ClientPtr client, FindAllRes func, void *cdata)
 {
-    ResourcePtr *resources;
+    ClientResourceRec *rrec;
+    ResourceSlotPtr slot;
     ResourcePtr this, next;
-    int i, elements;
-    int *eltptr;
+    unsigned int pos, generation;
+    int elements;
 
     if (!client)
         client = serverClient;
 
-    resources = clientTable[client->index].resources;
-    eltptr = &clientTable[client->index].elements;
-    for (i = 0; i < clientTable[client->index].buckets; i++) {
-        for (this = resources[i]; this; this = next) {
+    rrec = &clientTable[client->index];
+    rrec->walking++;
+ restart:
+    generation = rrec->generation;
+    for (pos = 0; (slot = WalkSlot(rrec, pos)); pos++) {
+        for (this = slot->res; this; this = next) {
             next = this->next;
-            elements = *eltptr;
+            elements = rrec->elements;
             (*func) (this->value, this->id, this->type, cdata);
-            if (*eltptr != elements)
-                next = resources[i];    /* start over */
+            if (rrec->generation != generation)
+                goto restart;
+            if (rrec->elements != elements)
+                next = slot->res;       /* start over */
         }
     }
+    rrec->walking--;
 }
 
 void *
@@ -1054,74 +1221,85 @@ LookupClientResourceComplex(ClientPtr client,
                             RESTYPE type,
                             FindComplexResType func, void *cdata)
 {
-    ResourcePtr *resources;
+    ClientResourceRec *rrec;
+    ResourceSlotPtr slot;
     ResourcePtr this, next;
+    unsigned int pos, generation;
     void *value;
-    int i;
 
     if (!client)
         client = serverClient;
 
-    resources = clientTable[client->index].resources;
-    for (i = 0; i < clientTable[client->index].buckets; i++) {
-        for (this = resources[i]; this; this = next) {
+    rrec = &clientTable[client->index];
+    rrec->walking++;
+ restart:
+    generation = rrec->generation;
+    for (pos = 0; (slot = WalkSlot(rrec, pos)); pos++) {
+        for (this = slot->res; this; this = next) {
             next = this->next;
             if (!type || this->type == type) {
                 /* workaround func freeing the type as DRI1 does */
                 value = this->value;
-                if ((*func) (value, this->id, cdata))
+                if ((*func) (value, this->id, cdata)) {
+                    rrec->walking--;
                     return value;
+                }
+                if (rrec->generation != generation)
+                    goto restart;
             }
         }
     }
+    rrec->walking--;
     return NULL;
 }
 
 void
 FreeClientNeverRetainResources(ClientPtr client)
 {
-    ResourcePtr *resources;
+    ClientResourceRec *rrec;
+    ResourceSlotPtr slot;
     ResourcePtr this;
     ResourcePtr *prev;
-    int j, elements;
-    int *eltptr;
+    unsigned int pos, generation;
+    int elements;
 
     if (!client)
         return;
 
-    resources = clientTable[client->index].resources;
-    eltptr = &clientTable[client->index].elements;
-    for (j = 0; j < clientTable[client->index].buckets; j++) {
-        prev = &resources[j];
+    rrec = &clientTable[client->index];
+    rrec->walking++;
+ restart:
+    generation = rrec->generation;
+    for (pos = 0; (slot = WalkSlot(rrec, pos)); pos++) {
+        prev = &slot->res;
         while ((this = *prev)) {
             RESTYPE rtype = this->type;
 
             if (rtype & RC_NEVERRETAIN) {
-#ifdef XSERVER_DTRACE
-                XSERVER_RESOURCE_FREE(this->id, this->type,
-                                      this->value, TypeNameString(this->type));
-#endif
-                *prev = this->next;
-                clientTable[client->index].elements--;
-                elements = *eltptr;
+                UnlinkResource(rrec, slot, prev, this);
+                elements = rrec->elements;
 
                 doFreeResource(this, FALSE);
 
-                if (*eltptr != elements)
-                    prev = &resources[j];       /* prev may no longer be valid */
+                if (rrec->generation != generation)
+                    goto restart;
+                if (rrec->elements != elements)
+                    prev = &slot->res;  /* prev may no longer be valid */
             }
             else
                 prev = &this->next;
         }
     }
+    rrec->walking--;
 }
 
 void
 FreeClientResources(ClientPtr client)
 {
-    ResourcePtr *resources;
+    ClientResourceRec *rrec;
+    ResourceSlotPtr slot;
     ResourcePtr this;
-    int j;
+    unsigned int pos, generation;
 
     /* This routine shouldn't be called with a null client, but just in
        case ... */
@@ -1131,35 +1309,35 @@ FreeClientResources(ClientPtr client)
 
     HandleSaveSet(client);
 
-    resources = clientTable[client->index].resources;
-    for (j = 0; j < clientTable[client->index].buckets; j++) {
-        /* It may seem silly to update the head of this resource list as
-           we delete the members, since the entire list will be deleted any way,
-           but there are some resource deletion functions "FreeClientPixels" for
-           one which do a LookupID on another resource id (a Colormap id in this
-           case), so the resource list must be kept valid up to the point that
-           it is deleted, so every time we delete a resource, we must update the
-           head, just like in FreeResource. I hope that this doesn't slow down
-           mass deletion appreciably. PRH */
-
-        ResourcePtr *head;
-
-        head = &resources[j];
-
-        for (this = *head; this; this = *head) {
-#ifdef XSERVER_DTRACE
-            XSERVER_RESOURCE_FREE(this->id, this->type,
-                                  this->value, TypeNameString(this->type));
-#endif
-            *head = this->next;
-            clientTable[client->index].elements--;
+    rrec = &clientTable[client->index];
+    rrec->walking++;
+ restart:
+    generation = rrec->generation;
+    for (pos = 0; (slot = WalkSlot(rrec, pos)); pos++) {
+        /* It may seem silly to update the slot as we delete the members,
+           since the entire table will be deleted any way, but there are
+           some resource deletion functions "FreeClientPixels" for one
+           which do a LookupID on another resource id (a Colormap id in
+           this case), so the table must be kept valid up to the point
+           that it is deleted, so every time we delete a resource, we must
+           update the slot, just like in FreeResource. I hope that this
+           doesn't slow down mass deletion appreciably. PRH */
+
+        while ((this = slot->res)) {
+            UnlinkResource(rrec, slot, &slot->res, this);
 
             doFreeResource(this, FALSE);
+
+            if (rrec->generation != generation)
+                goto restart;
         }
     }
-    free(clientTable[client->index].resources);
-    clientTable[client->index].resources = NULL;
-    clientTable[client->index].buckets = 0;
+    rrec->walking--;
+    free(rrec->table.slots);
+    free(rrec->old.slots);
+    rrec->table.slots = NULL;
+    rrec->old.slots = NULL;
+    rrec->generation++;
 }
 
 void
@@ -1168,7 +1346,7 @@ FreeAllResources(void)
     int i;
 
     for (i = currentMaxClients; --i >= 0;) {
-        if (clientTable[i].buckets)
+        if (clientTable[i].table.slots)
             FreeClientResources(clients[i]);
     }
 }
@@ -1203,17 +1381,17 @@ dixLookupResourceByType(void **result, XID id, RESTYPE rtype,
                         ClientPtr client, Mask mode)
 {
     int cid = CLIENT_ID(id);
+    ResourceSlotPtr slot;
     ResourcePtr res = NULL;
 
     *result = NULL;
     if ((rtype & TypeMask) > lastResourceType)
         return BadImplementation;
 
-    if ((cid < LimitClients) && clientTable[cid].buckets) {
-        res = clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
-
-        for (; res; res = res->next)
-            if (res->id == id && res->type == rtype)
+    if ((cid < LimitClients) && clientTable[cid].table.slots &&
+        (slot = LookupSlot(&clientTable[cid], id))) {
+        for (res = slot->res; res; res = res->next)
+            if (res->type == rtype)
                 break;
     }
     if (client) {
@@ -1240,15 +1418,15 @@ dixLookupResourceByClass(void **result, XID id, RESTYPE rclass,
                          ClientPtr client, Mask mode)
 {
     int cid = CLIENT_ID(id);
+    ResourceSlotPtr slot;
     ResourcePtr res = NULL;
 
     *result = NULL;
 
-    if ((cid < LimitClients) && clientTable[cid].buckets) {
-        res = clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
-
-        for (; res; res = res->next)
-            if (res->id == id && (res->type & rclass))
+    if ((cid < LimitClients) && clientTable[cid].table.slots &&
+        (slot = LookupSlot(&clientTable[cid], id))) {
+        for (res = slot->res; res; res = res->next)
+            if (res->type & rclass)
                 break;
     }
     if (client) {
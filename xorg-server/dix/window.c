@@ -127,6 +127,7 @@ Equipment Corporation.
 #include "dixevents.h"
 #include "globals.h"
 #include "mi.h"                 /* miPaintWindow */
+#include "mi/mi_priv.h"         /* miWindowIndexUpdate */
 #ifdef COMPOSITE
 #include "compint.h"
 #endif
@@ -598,6 +599,7 @@ CreateRootWindow(ScreenPtr pScreen)
     pWin->optional->otherClients = NULL;
     pWin->optional->passiveGrabs = NULL;
     pWin->optional->userProps = NULL;
+    pWin->optional->userPropIndex = NULL;
     pWin->optional->backingBitPlanes = ~0L;
     pWin->optional->backingPixel = 0;
     pWin->optional->boundingShape = NULL;
@@ -2417,6 +2419,10 @@ ConfigureWindow(WindowPtr pWin, Mask mask, XID *vlist, ClientPtr client)
         (*pWin->drawable.pScreen->ResizeWindow) (pWin, x, y, w, h, pSib);
     else if (mask & CWStackMode)
         ReflectStackChange(pWin, pSib, VTOther);
+    if (mask & CWStackMode)
+        miWindowIndexInvalidate(pWin);
+    else
+        miWindowIndexUpdate(pWin);
 
     if (action != RESTACK_WIN)
         CheckCursorConfinement(pWin);
@@ -2484,6 +2490,7 @@ CirculateWindow(WindowPtr pParent, int direction, ClientPtr client)
     ReflectStackChange(pWin,
                        (direction == RaiseLowest) ? pFirst : NullWindow,
                        VTStack);
+    miWindowIndexInvalidate(pWin);
 
     return Success;
 }
@@ -2541,6 +2548,7 @@ ReparentWindow(WindowPtr pWin, WindowPtr pParent,
 
     /* take out of sibling chain */
 
+    miWindowIndexInvalidate(pWin);
     pPriorParent = pPrev = pWin->parent;
     if (pPrev->firstChild == pWin)
         pPrev->firstChild = pWin->nextSib;
@@ -2578,6 +2586,7 @@ ReparentWindow(WindowPtr pWin, WindowPtr pParent,
     pWin->origin.y = y + bw;
     pWin->drawable.x = x + bw + pParent->drawable.x;
     pWin->drawable.y = y + bw + pParent->drawable.y;
+    miWindowIndexInvalidate(pWin);
 
     /* clip to parent */
     SetWinSize(pWin);
@@ -2680,6 +2689,7 @@ MapWindow(WindowPtr pWin, ClientPtr client)
                 return Success;
 
         pWin->mapped = TRUE;
+        miWindowIndexUpdate(pWin);
         if (SubStrSend(pWin, pParent))
             DeliverMapNotify(pWin);
 
@@ -2748,6 +2758,7 @@ MapSubwindows(WindowPtr pParent, ClientPtr client)
                     continue;
 
             pWin->mapped = TRUE;
+            miWindowIndexUpdate(pWin);
             if (parentNotify || StrSend(pWin))
                 DeliverMapNotify(pWin);
 
@@ -2864,6 +2875,7 @@ UnmapWindow(WindowPtr pWin, Bool fromConfigure)
         (*pScreen->MarkWindow) (pLayerWin->parent);
     }
     pWin->mapped = FALSE;
+    miWindowIndexUpdate(pWin);
     if (wasRealized)
         UnrealizeTree(pWin, fromConfigure);
     if (wasViewable && !fromConfigure) {
@@ -2913,6 +2925,7 @@ UnmapSubwindows(WindowPtr pWin)
                 anyMarked = TRUE;
             }
             pChild->mapped = FALSE;
+            miWindowIndexUpdate(pChild);
             if (pChild->realized)
                 UnrealizeTree(pChild, FALSE);
         }
@@ -3408,6 +3421,7 @@ MakeWindowOptional(WindowPtr pWin)
     optional->otherClients = NULL;
     optional->passiveGrabs = NULL;
     optional->userProps = NULL;
+    optional->userPropIndex = NULL;
     optional->backingBitPlanes = ~0L;
     optional->backingPixel = 0;
     optional->boundingShape = NULL;
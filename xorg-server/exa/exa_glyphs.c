@@ -252,7 +252,7 @@ exaGlyphCacheHashLookup(ExaGlyphCachePtr cache, GlyphPtr pGlyph)
 {
     int slot;
 
-    slot = (*(CARD32 *) pGlyph->sha1) % cache->hashSize;
+    slot = ((CARD32) pGlyph->hash[0]) % cache->hashSize;
 
     while (TRUE) {              /* hash table can never be full */
         int entryPos = cache->hashEntries[slot];
@@ -260,11 +260,9 @@ exaGlyphCacheHashLookup(ExaGlyphCachePtr cache, GlyphPtr pGlyph)
         if (entryPos == -1)
             return -1;
 
-        if (memcmp
-            (pGlyph->sha1, cache->glyphs[entryPos].sha1,
-             sizeof(pGlyph->sha1)) == 0) {
+        /* The hash only picks the slot, it can be made to collide */
+        if (cache->glyphs[entryPos].glyph == pGlyph)
             return entryPos;
-        }
 
         slot--;
         if (slot < 0)
@@ -277,9 +275,10 @@ exaGlyphCacheHashInsert(ExaGlyphCachePtr cache, GlyphPtr pGlyph, int pos)
 {
     int slot;
 
-    memcpy(cache->glyphs[pos].sha1, pGlyph->sha1, sizeof(pGlyph->sha1));
+    cache->glyphs[pos].glyph = pGlyph;
+    memcpy(cache->glyphs[pos].hash, pGlyph->hash, sizeof(pGlyph->hash));
 
-    slot = (*(CARD32 *) pGlyph->sha1) % cache->hashSize;
+    slot = ((CARD32) pGlyph->hash[0]) % cache->hashSize;
 
     while (TRUE) {              /* hash table can never be full */
         if (cache->hashEntries[slot] == -1) {
@@ -299,7 +298,7 @@ exaGlyphCacheHashRemove(ExaGlyphCachePtr cache, int pos)
     int slot;
     int emptiedSlot = -1;
 
-    slot = (*(CARD32 *) cache->glyphs[pos].sha1) % cache->hashSize;
+    slot = ((CARD32) cache->glyphs[pos].hash[0]) % cache->hashSize;
 
     while (TRUE) {              /* hash table can never be full */
         int entryPos = cache->hashEntries[slot];
@@ -329,7 +328,7 @@ exaGlyphCacheHashRemove(ExaGlyphCachePtr cache, int pos)
              */
 
             int entrySlot =
-                (*(CARD32 *) cache->glyphs[entryPos].sha1) % cache->hashSize;
+                ((CARD32) cache->glyphs[entryPos].hash[0]) % cache->hashSize;
 
             if (!((entrySlot >= slot && entrySlot < emptiedSlot) ||
                   (emptiedSlot < slot &&
@@ -346,6 +345,35 @@ exaGlyphCacheHashRemove(ExaGlyphCachePtr cache, int pos)
     }
 }
 
+/*
+ * Entries are keyed by GlyphPtr, so drop the glyph's before its memory
+ * can be reused for another glyph.
+ */
+void
+exaUnrealizeGlyph(ScreenPtr pScreen, GlyphPtr pGlyph)
+{
+    ExaScreenPriv(pScreen);
+    PictureScreenPtr ps = GetPictureScreen(pScreen);
+    int i, pos;
+
+    for (i = 0; i < EXA_NUM_GLYPH_CACHES; i++) {
+        ExaGlyphCachePtr cache = &pExaScr->glyphCaches[i];
+
+        if (!cache->hashEntries)
+            continue;
+
+        pos = exaGlyphCacheHashLookup(cache, pGlyph);
+        if (pos != -1) {
+            exaGlyphCacheHashRemove(cache, pos);
+            cache->glyphs[pos].glyph = NULL;
+        }
+    }
+
+    unwrap(pExaScr, ps, UnrealizeGlyph);
+    (*ps->UnrealizeGlyph) (pScreen, pGlyph);
+    wrap(pExaScr, ps, UnrealizeGlyph, exaUnrealizeGlyph);
+}
+
 #define CACHE_X(pos) (((pos) % cache->columns) * cache->glyphWidth)
 #define CACHE_Y(pos) (cache->yOffset + ((pos) / cache->columns) * cache->glyphHeight)
 
@@ -448,7 +476,7 @@ exaGlyphCacheBufferGlyph(ScreenPtr pScreen,
     DBG_GLYPH_CACHE(("(%d,%d,%s): buffering glyph %lx\n",
                      cache->glyphWidth, cache->glyphHeight,
                      cache->format == PICT_a8 ? "A" : "ARGB",
-                     (long) *(CARD32 *) pGlyph->sha1));
+                     (long) (CARD32) pGlyph->hash[0]));
 
     pos = exaGlyphCacheHashLookup(cache, pGlyph);
     if (pos != -1) {
@@ -105,7 +105,8 @@ enum ExaMigrationHeuristic {
 };
 
 typedef struct {
-    unsigned char sha1[20];
+    GlyphPtr glyph;             /* identical glyphs are shared by glyph.c */
+    CARD64 hash[2];
 } ExaCachedGlyphRec, *ExaCachedGlyphPtr;
 
 typedef struct {
@@ -116,7 +117,7 @@ typedef struct {
 
     int size;                   /* Size of cache; eventually this should be dynamically determined */
 
-    /* Hash table mapping from glyph sha1 to position in the glyph; we use
+    /* Hash table mapping from glyph hash to position in the glyph; we use
      * open addressing with a hash table size determined based on size and large
      * enough so that we always have a good amount of free space, so we can
      * use linear probing. (Linear probing is preferable to double hashing
@@ -168,6 +169,7 @@ typedef struct {
     CompositeProcPtr SavedComposite;
     TrianglesProcPtr SavedTriangles;
     GlyphsProcPtr SavedGlyphs;
+    UnrealizeGlyphProcPtr SavedUnrealizeGlyph;
     TrapezoidsProcPtr SavedTrapezoids;
     AddTrapsProcPtr SavedAddTraps;
     void (*do_migration) (ExaMigrationPtr pixmaps, int npixmaps,
@@ -693,6 +695,9 @@ void
 void
  exaGlyphsFini(ScreenPtr pScreen);
 
+void
+ exaUnrealizeGlyph(ScreenPtr pScreen, GlyphPtr pGlyph);
+
 void
 
 exaGlyphs(CARD8 op,
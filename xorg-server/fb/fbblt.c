@@ -25,6 +25,7 @@
 #endif
 
 #include <string.h>
+#include <stdint.h>
 #include "fb.h"
 
 #define InitializeShifts(sx,dx,ls,rs) { \
@@ -39,6 +40,250 @@
     } \
 }
 
+/*
+ * Plain copies at 8, 16 and 32bpp, which is what scrolling and CopyArea
+ * come down to whenever pixman_blt() declines (it won't do overlapping
+ * copies), move whole pixels and so need no shifting.  They are done a
+ * row at a time by SSE2 or AVX2 kernels picked on first use from what the
+ * CPU supports.  Each kernel copies whole pixels until the destination is
+ * aligned for vector stores, then uses unaligned loads from the source,
+ * which may sit at any pixel offset.  Rows that overlap themselves
+ * (horizontal scrolling) are copied from the end when the destination is
+ * past the source; rows are walked bottom-up for upsidedown copies.
+ *
+ * Loads always run ahead of the stores that could clobber them, so the
+ * kernels are safe for any overlap in the direction they're chosen for.
+ */
+#ifndef FB_ACCESS_WRAPPER
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FB_BLT_SIMD
+#define FB_BLT_TARGET(isa) __attribute__((target(isa)))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define FB_BLT_SIMD
+#define FB_BLT_TARGET(isa)
+#endif
+#endif
+
+#ifdef FB_BLT_SIMD
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/* Strides are in bytes and negative for upsidedown copies */
+typedef void (*FbBltRowsProcPtr) (CARD8 *dst, FbStride dstStride,
+                                  const CARD8 *src, FbStride srcStride,
+                                  int width, int height);
+
+typedef struct {
+    FbBltRowsProcPtr forward;
+    FbBltRowsProcPtr backward;
+} FbBltKernelRec;
+
+#define FB_BLT_SSE2_LOAD(p)     _mm_loadu_si128((const __m128i *) (p))
+#define FB_BLT_SSE2_STORE(p, v) _mm_store_si128((__m128i *) (p), v)
+#define FB_BLT_AVX2_LOAD(p)     _mm256_loadu_si256((const __m256i *) (p))
+#define FB_BLT_AVX2_STORE(p, v) _mm256_store_si256((__m256i *) (p), v)
+
+/*
+ * width is in bytes.  Vectors are VS bytes wide and the main loop moves
+ * four of them; VS is a multiple of every pixel size, so whole pixels
+ * always reach vector alignment.
+ */
+#define FB_BLT_KERNEL(name, isa, Pixel, Vec, VS, LOAD, STORE)            \
+static void FB_BLT_TARGET(isa)                                          \
+name##Forward(CARD8 *dst, FbStride dstStride,                           \
+              const CARD8 *src, FbStride srcStride,                     \
+              int width, int height)                                    \
+{                                                                       \
+    while (height--) {                                                  \
+        CARD8 *d = dst;                                                 \
+        const CARD8 *s = src;                                           \
+        int n = width;                                                  \
+                                                                        \
+        while (n && ((uintptr_t) d & (VS - 1))) {                       \
+            *(Pixel *) d = *(const Pixel *) s;                          \
+            d += sizeof(Pixel);                                         \
+            s += sizeof(Pixel);                                         \
+            n -= sizeof(Pixel);                                         \
+        }                                                               \
+        for (; n >= 4 * VS; n -= 4 * VS, d += 4 * VS, s += 4 * VS) {    \
+            Vec v0 = LOAD(s);                                           \
+            Vec v1 = LOAD(s + VS);                                      \
+            Vec v2 = LOAD(s + 2 * VS);                                  \
+            Vec v3 = LOAD(s + 3 * VS);                                  \
+            STORE(d, v0);                                               \
+            STORE(d + VS, v1);                                          \
+            STORE(d + 2 * VS, v2);                                      \
+            STORE(d + 3 * VS, v3);                                      \
+        }                                                               \
+        for (; n >= VS; n -= VS, d += VS, s += VS)                      \
+            STORE(d, LOAD(s));                                          \
+        for (; n; n -= sizeof(Pixel), d += sizeof(Pixel),               \
+             s += sizeof(Pixel))                                        \
+            *(Pixel *) d = *(const Pixel *) s;                          \
+        dst += dstStride;                                               \
+        src += srcStride;                                               \
+    }                                                                   \
+}                                                                       \
+                                                                        \
+static void FB_BLT_TARGET(isa)                                          \
+name##Backward(CARD8 *dst, FbStride dstStride,                          \
+               const CARD8 *src, FbStride srcStride,                    \
+               int width, int height)                                   \
+{                                                                       \
+    while (height--) {                                                  \
+        CARD8 *d = dst + width;                                         \
+        const CARD8 *s = src + width;                                   \
+        int n = width;                                                  \
+                                                                        \
+        while (n && ((uintptr_t) d & (VS - 1))) {                       \
+            d -= sizeof(Pixel);                                         \
+            s -= sizeof(Pixel);                                         \
+            n -= sizeof(Pixel);                                         \
+            *(Pixel *) d = *(const Pixel *) s;                          \
+        }                                                               \
+        while (n >= 4 * VS) {                                           \
+            Vec v0, v1, v2, v3;                                         \
+                                                                        \
+            d -= 4 * VS;                                                \
+            s -= 4 * VS;                                                \
+            n -= 4 * VS;                                                \
+            v3 = LOAD(s + 3 * VS);                                      \
+            v2 = LOAD(s + 2 * VS);                                      \
+            v1 = LOAD(s + VS);                                          \
+            v0 = LOAD(s);                                               \
+            STORE(d + 3 * VS, v3);                                      \
+            STORE(d + 2 * VS, v2);                                      \
+            STORE(d + VS, v1);                                          \
+            STORE(d, v0);                                               \
+        }                                                               \
+        while (n >= VS) {                                               \
+            d -= VS;                                                    \
+            s -= VS;                                                    \
+            n -= VS;                                                    \
+            STORE(d, LOAD(s));                                          \
+        }                                                               \
+        while (n) {                                                     \
+            d -= sizeof(Pixel);                                         \
+            s -= sizeof(Pixel);                                         \
+            n -= sizeof(Pixel);                                         \
+            *(Pixel *) d = *(const Pixel *) s;                          \
+        }                                                               \
+        dst += dstStride;                                               \
+        src += srcStride;                                               \
+    }                                                                   \
+}
+
+FB_BLT_KERNEL(fbBlt8Sse2, "sse2", CARD8, __m128i, 16,
+              FB_BLT_SSE2_LOAD, FB_BLT_SSE2_STORE)
+FB_BLT_KERNEL(fbBlt16Sse2, "sse2", CARD16, __m128i, 16,
+              FB_BLT_SSE2_LOAD, FB_BLT_SSE2_STORE)
+FB_BLT_KERNEL(fbBlt32Sse2, "sse2", CARD32, __m128i, 16,
+              FB_BLT_SSE2_LOAD, FB_BLT_SSE2_STORE)
+FB_BLT_KERNEL(fbBlt8Avx2, "avx2", CARD8, __m256i, 32,
+              FB_BLT_AVX2_LOAD, FB_BLT_AVX2_STORE)
+FB_BLT_KERNEL(fbBlt16Avx2, "avx2", CARD16, __m256i, 32,
+              FB_BLT_AVX2_LOAD, FB_BLT_AVX2_STORE)
+FB_BLT_KERNEL(fbBlt32Avx2, "avx2", CARD32, __m256i, 32,
+              FB_BLT_AVX2_LOAD, FB_BLT_AVX2_STORE)
+
+/* Indexed by bpp >> 4 */
+static const FbBltKernelRec fbBltKernelsSse2[3] = {
+    {fbBlt8Sse2Forward, fbBlt8Sse2Backward},
+    {fbBlt16Sse2Forward, fbBlt16Sse2Backward},
+    {fbBlt32Sse2Forward, fbBlt32Sse2Backward},
+};
+
+static const FbBltKernelRec fbBltKernelsAvx2[3] = {
+    {fbBlt8Avx2Forward, fbBlt8Avx2Backward},
+    {fbBlt16Avx2Forward, fbBlt16Avx2Backward},
+    {fbBlt32Avx2Forward, fbBlt32Avx2Backward},
+};
+
+static const FbBltKernelRec *
+fbBltSelectKernels(void)
+{
+#ifdef _MSC_VER
+    int info[4];
+    Bool sse2, avx2 = FALSE;
+
+    __cpuid(info, 0);
+    if (info[0] < 1)
+        return NULL;
+    __cpuid(info, 1);
+    sse2 = (info[3] & (1 << 26)) != 0;
+    /* AVX needs the OS to save the ymm registers (OSXSAVE, XCR0) */
+    if ((info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6) {
+        __cpuid(info, 0);
+        if (info[0] >= 7) {
+            __cpuidex(info, 7, 0);
+            avx2 = (info[1] & (1 << 5)) != 0;
+        }
+    }
+#else
+    Bool sse2, avx2;
+
+    __builtin_cpu_init();
+    sse2 = __builtin_cpu_supports("sse2");
+    avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+    if (avx2)
+        return fbBltKernelsAvx2;
+    if (sse2)
+        return fbBltKernelsSse2;
+    return NULL;
+}
+
+static Bool fbBltKernelsChecked;
+static const FbBltKernelRec *fbBltKernels;
+
+/*
+ * Copy width bits of height rows with GXcopy at 8, 16 or 32bpp.  The
+ * coordinates must be byte aligned.  Returns FALSE when there is no
+ * kernel for this CPU.
+ */
+static Bool
+fbBltSimd(FbBits * srcLine, FbStride srcStride, int srcX,
+          FbBits * dstLine, FbStride dstStride, int dstX,
+          int width, int height, int bpp, Bool upsidedown)
+{
+    CARD8 *src = (CARD8 *) srcLine + (srcX >> 3);
+    CARD8 *dst = (CARD8 *) dstLine + (dstX >> 3);
+    FbStride srcByteStride = srcStride << (FB_SHIFT - 3);
+    FbStride dstByteStride = dstStride << (FB_SHIFT - 3);
+    const FbBltKernelRec *kernel;
+
+    if (!fbBltKernelsChecked) {
+        fbBltKernels = fbBltSelectKernels();
+        fbBltKernelsChecked = TRUE;
+    }
+    if (!fbBltKernels)
+        return FALSE;
+
+    kernel = &fbBltKernels[bpp >> 4];
+    if (upsidedown) {
+        src += (height - 1) * srcByteStride;
+        dst += (height - 1) * dstByteStride;
+        srcByteStride = -srcByteStride;
+        dstByteStride = -dstByteStride;
+    }
+    /*
+     * Only a row overlapping itself cares which way it is copied; rows
+     * that overlap others are taken care of by upsidedown.  Forward
+     * copies are a little faster, so they are used everywhere else.
+     */
+    if (dst > src && dst < src + (width >> 3))
+        (*kernel->backward) (dst, dstByteStride, src, srcByteStride,
+                             width >> 3, height);
+    else
+        (*kernel->forward) (dst, dstByteStride, src, srcByteStride,
+                            width >> 3, height);
+    return TRUE;
+}
+#endif                          /* FB_BLT_SIMD */
+
 void
 fbBlt(FbBits * srcLine,
       FbStride srcStride,
@@ -59,6 +304,15 @@ fbBlt(FbBits * srcLine,
 
     FbDeclareMergeRop();
 
+#ifdef FB_BLT_SIMD
+    if (alu == GXcopy && pm == FB_ALLONES &&
+        (bpp == 8 || bpp == 16 || bpp == 32) &&
+        !((srcX | dstX | width) & (bpp - 1)) &&
+        fbBltSimd(srcLine, srcStride, srcX, dstLine, dstStride, dstX,
+                  width, height, bpp, upsidedown))
+        return;
+#endif
+
     if (alu == GXcopy && pm == FB_ALLONES &&
         !(srcX & 7) && !(dstX & 7) && !(width & 7))
     {
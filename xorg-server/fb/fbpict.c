@@ -29,6 +29,7 @@
 
 #include <string.h>
 
+#include "list.h"
 #include "fb.h"
 #include "glyphstr_priv.h"
 #include "picturestr.h"
@@ -72,9 +73,244 @@ fbComposite(CARD8 op,
 
 static pixman_glyph_cache_t *glyphCache;
 
+/*
+ * Text repainted unchanged (terminals, editors scrolling) comes back as
+ * the same glyphs at the same positions relative to the start of the run.
+ * When such a run is drawn with a mask format for the second time, the
+ * mask pixman builds for it is kept, keyed by the mask format and the
+ * glyphs with their relative positions, and later requests for the run
+ * are composited through it with a single pixman_image_composite32().
+ *
+ * Runs are dropped as soon as one of their glyphs is unrealized; every
+ * glyph keeps the runs it appears in on a list in its privates, so that
+ * costs nothing for glyphs that are in no run.  The least recently used
+ * runs go first once their masks take more than GLYPH_RUN_CACHE_BYTES.
+ */
+
+#define GLYPH_RUN_BUCKETS	256
+#define GLYPH_RUN_SEEN		256
+#define GLYPH_RUN_MAX_GLYPHS	256
+#define GLYPH_RUN_MAX_BYTES	(256 << 10)     /* for a single run */
+#define GLYPH_RUN_CACHE_BYTES	(4 << 20)
+
+typedef struct {
+    GlyphPtr glyph;
+    int x, y;
+} GlyphRunGlyphRec, *GlyphRunGlyphPtr;
+
+typedef struct {
+    struct xorg_list entry;     /* in the glyph's list of runs */
+    struct _GlyphRun *run;
+} GlyphRunLinkRec, *GlyphRunLinkPtr;
+
+typedef struct _GlyphRun {
+    struct xorg_list lru;
+    struct _GlyphRun *next;     /* in its hash bucket */
+    CARD64 hash;
+    pixman_format_code_t format;
+    int nglyphs;
+    GlyphRunGlyphPtr glyphs;
+    GlyphRunLinkPtr links;      /* one per glyph */
+    pixman_box32_t extents;     /* relative to the start of the run */
+    size_t bytes;
+    pixman_image_t *mask;
+} GlyphRunRec, *GlyphRunPtr;
+
+static struct {
+    Bool initialized;
+    GlyphRunPtr buckets[GLYPH_RUN_BUCKETS];
+    struct xorg_list lru;       /* most recently used first */
+    CARD64 seen[GLYPH_RUN_SEEN];        /* hashes of runs drawn once */
+    size_t bytes;
+    pixman_image_t *white;
+} glyphRuns;
+
+static DevPrivateKeyRec glyphRunPrivateKeyRec;
+
+/* The runs a glyph appears in, zeroed until the first one is added */
+#define GlyphRunsOf(glyph) ((struct xorg_list *) \
+    dixGetPrivateAddr(&(glyph)->devPrivates, &glyphRunPrivateKeyRec))
+
+/*
+ * Lay out the glyphs of a request relative to the start of the run and
+ * hash them with the mask format.  Returns 0 if the run is too long to be
+ * cached.
+ */
+static CARD64
+GlyphRunLayout(pixman_format_code_t format, int nlist, GlyphListPtr list,
+               GlyphPtr *glyphs, GlyphRunGlyphPtr layout, int *nglyphs)
+{
+    CARD64 hash = 0xcbf29ce484222325ULL ^ format;
+    GlyphListPtr first = list;
+    int x = 0, y = 0;
+    int i = 0, n;
+
+    while (nlist--) {
+        /* The first list's offset is where the run starts */
+        if (list != first) {
+            x += list->xOff;
+            y += list->yOff;
+        }
+        if (i + list->len > GLYPH_RUN_MAX_GLYPHS)
+            return 0;
+        for (n = list->len; n--; i++) {
+            GlyphPtr glyph = *glyphs++;
+
+            layout[i].glyph = glyph;
+            layout[i].x = x;
+            layout[i].y = y;
+            hash = (hash ^ (uintptr_t) glyph) * 0x100000001b3ULL;
+            hash = (hash ^ (((CARD64) (CARD32) x << 32) | (CARD32) y)) *
+                0x100000001b3ULL;
+            x += glyph->info.xOff;
+            y += glyph->info.yOff;
+        }
+        list++;
+    }
+    *nglyphs = i;
+    hash ^= hash >> 29;
+    return hash ? hash : 1;
+}
+
+static void
+GlyphRunRemove(GlyphRunPtr run)
+{
+    GlyphRunPtr *prev = &glyphRuns.buckets[run->hash % GLYPH_RUN_BUCKETS];
+    int i;
+
+    while (*prev != run)
+        prev = &(*prev)->next;
+    *prev = run->next;
+    xorg_list_del(&run->lru);
+    for (i = 0; i < run->nglyphs; i++)
+        xorg_list_del(&run->links[i].entry);
+    glyphRuns.bytes -= run->bytes;
+    pixman_image_unref(run->mask);
+    free(run);
+}
+
+static GlyphRunPtr
+GlyphRunLookup(CARD64 hash, pixman_format_code_t format,
+               GlyphRunGlyphPtr layout, int nglyphs)
+{
+    GlyphRunPtr run;
+
+    if (!glyphRuns.initialized)
+        return NULL;
+
+    for (run = glyphRuns.buckets[hash % GLYPH_RUN_BUCKETS]; run;
+         run = run->next) {
+        if (run->hash == hash && run->format == format &&
+            run->nglyphs == nglyphs &&
+            !memcmp(run->glyphs, layout, nglyphs * sizeof(*layout))) {
+            xorg_list_del(&run->lru);
+            xorg_list_add(&run->lru, &glyphRuns.lru);
+            return run;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Build the mask for a run exactly as pixman_composite_glyphs() would,
+ * adding the glyphs to it through a white source, and keep it.
+ */
+static GlyphRunPtr
+GlyphRunInsert(CARD64 hash, pixman_format_code_t format,
+               GlyphRunGlyphPtr layout, int nglyphs,
+               const pixman_box32_t *extents, int xDst, int yDst,
+               int nPixmanGlyphs, const pixman_glyph_t *pglyphs)
+{
+    static const pixman_color_t white = { 0xffff, 0xffff, 0xffff, 0xffff };
+    int width = extents->x2 - extents->x1;
+    int height = extents->y2 - extents->y1;
+    size_t bytes = (size_t) PIXMAN_FORMAT_BPP(format) * width / 8 * height;
+    GlyphRunPtr run;
+
+    if (width <= 0 || height <= 0 || bytes > GLYPH_RUN_MAX_BYTES)
+        return NULL;
+
+    if (!glyphRuns.initialized) {
+        xorg_list_init(&glyphRuns.lru);
+        glyphRuns.initialized = TRUE;
+    }
+    if (!glyphRuns.white &&
+        !(glyphRuns.white = pixman_image_create_solid_fill(&white)))
+        return NULL;
+
+    while (glyphRuns.bytes + bytes > GLYPH_RUN_CACHE_BYTES)
+        GlyphRunRemove(xorg_list_last_entry(&glyphRuns.lru, GlyphRunRec,
+                                            lru));
+
+    run = malloc(sizeof(GlyphRunRec) + nglyphs *
+                 (sizeof(GlyphRunGlyphRec) + sizeof(GlyphRunLinkRec)));
+    if (!run)
+        return NULL;
+    run->mask = pixman_image_create_bits(format, width, height, NULL, -1);
+    if (!run->mask) {
+        free(run);
+        return NULL;
+    }
+    if (PIXMAN_FORMAT_A(format) != 0 && PIXMAN_FORMAT_RGB(format) != 0)
+        pixman_image_set_component_alpha(run->mask, TRUE);
+    pixman_composite_glyphs(PIXMAN_OP_ADD, glyphRuns.white, run->mask, format,
+                            0, 0, extents->x1, extents->y1, 0, 0,
+                            width, height, glyphCache, nPixmanGlyphs, pglyphs);
+
+    run->hash = hash;
+    run->format = format;
+    run->nglyphs = nglyphs;
+    run->glyphs = (GlyphRunGlyphPtr) (run + 1);
+    run->links = (GlyphRunLinkPtr) (run->glyphs + nglyphs);
+    memcpy(run->glyphs, layout, nglyphs * sizeof(*layout));
+    while (nglyphs--) {
+        struct xorg_list *runs = GlyphRunsOf(layout[nglyphs].glyph);
+
+        if (!runs->next)
+            xorg_list_init(runs);
+        run->links[nglyphs].run = run;
+        xorg_list_add(&run->links[nglyphs].entry, runs);
+    }
+    run->extents.x1 = extents->x1 - xDst;
+    run->extents.y1 = extents->y1 - yDst;
+    run->extents.x2 = extents->x2 - xDst;
+    run->extents.y2 = extents->y2 - yDst;
+    run->bytes = bytes;
+
+    run->next = glyphRuns.buckets[hash % GLYPH_RUN_BUCKETS];
+    glyphRuns.buckets[hash % GLYPH_RUN_BUCKETS] = run;
+    xorg_list_add(&run->lru, &glyphRuns.lru);
+    glyphRuns.bytes += bytes;
+    return run;
+}
+
+static void
+GlyphRunComposite(CARD8 op, pixman_image_t *srcImage,
+                  pixman_image_t *dstImage, GlyphRunPtr run,
+                  int xSrc, int ySrc, int xDst, int yDst)
+{
+    pixman_image_composite32(op, srcImage, run->mask, dstImage,
+                             xSrc + run->extents.x1, ySrc + run->extents.y1,
+                             0, 0,
+                             xDst + run->extents.x1, yDst + run->extents.y1,
+                             run->extents.x2 - run->extents.x1,
+                             run->extents.y2 - run->extents.y1);
+}
+
 void
 fbDestroyGlyphCache(void)
 {
+    if (glyphRuns.initialized) {
+        while (!xorg_list_is_empty(&glyphRuns.lru))
+            GlyphRunRemove(xorg_list_first_entry(&glyphRuns.lru,
+                                                 GlyphRunRec, lru));
+        memset(glyphRuns.seen, 0, sizeof(glyphRuns.seen));
+    }
+    if (glyphRuns.white) {
+        pixman_image_unref(glyphRuns.white);
+        glyphRuns.white = NULL;
+    }
+
     if (glyphCache)
     {
 	pixman_glyph_cache_destroy (glyphCache);
@@ -86,6 +322,17 @@ static void
 fbUnrealizeGlyph(ScreenPtr pScreen,
 		 GlyphPtr pGlyph)
 {
+    if (glyphRuns.initialized) {
+        struct xorg_list *runs = GlyphRunsOf(pGlyph);
+        GlyphRunLinkPtr link;
+
+        /* A run may hold the glyph more than once, so start over each time */
+        while (runs->next && !xorg_list_is_empty(runs)) {
+            link = xorg_list_first_entry(runs, GlyphRunLinkRec, entry);
+            GlyphRunRemove(link->run);
+        }
+    }
+
     if (glyphCache)
 	pixman_glyph_cache_remove (glyphCache, pGlyph, NULL);
 }
@@ -111,9 +358,33 @@ fbGlyphs(CARD8 op,
     int x, y;
     int i, n;
     int xDst = list->xOff, yDst = list->yOff;
+    GlyphRunGlyphRec layout[GLYPH_RUN_MAX_GLYPHS];
+    pixman_format_code_t format = 0;
+    CARD64 runHash = 0;
+    int runGlyphs = 0;
+    GlyphRunPtr run;
 
     miCompositeSourceValidate(pSrc);
 
+    if (maskFormat) {
+	format = maskFormat->format | (maskFormat->depth << 24);
+	runHash = GlyphRunLayout(format, nlist, list, glyphs,
+				 layout, &runGlyphs);
+	if (runHash &&
+	    (run = GlyphRunLookup(runHash, format, layout, runGlyphs))) {
+	    if ((srcImage = image_from_pict(pSrc, FALSE, &srcXoff, &srcYoff))) {
+		if ((dstImage = image_from_pict(pDst, TRUE, &dstXoff, &dstYoff))) {
+		    GlyphRunComposite(op, srcImage, dstImage, run,
+				      xSrc + srcXoff, ySrc + srcYoff,
+				      xDst + dstXoff, yDst + dstYoff);
+		    free_pixman_pict(pDst, dstImage);
+		}
+		free_pixman_pict(pSrc, srcImage);
+	    }
+	    return;
+	}
+    }
+
     n_glyphs = 0;
     for (i = 0; i < nlist; ++i)
 	n_glyphs += list[i].len;
@@ -183,20 +454,33 @@ fbGlyphs(CARD8 op,
 	goto out_free_src;
 
     if (maskFormat) {
-	pixman_format_code_t format;
 	pixman_box32_t extents;
-
-	format = maskFormat->format | (maskFormat->depth << 24);
+	CARD64 *seen = &glyphRuns.seen[runHash % GLYPH_RUN_SEEN];
 
 	pixman_glyph_get_extents(glyphCache, n_glyphs, pglyphs, &extents);
 
-	pixman_composite_glyphs(op, srcImage, dstImage, format,
-				xSrc + srcXoff + extents.x1 - xDst, ySrc + srcYoff + extents.y1 - yDst,
-				extents.x1, extents.y1,
-				extents.x1 + dstXoff, extents.y1 + dstYoff,
-				extents.x2 - extents.x1,
-				extents.y2 - extents.y1,
-				glyphCache, n_glyphs, pglyphs);
+	/* Keep the mask of runs drawn a second time */
+	run = NULL;
+	if (runHash && *seen == runHash)
+	    run = GlyphRunInsert(runHash, format, layout, runGlyphs,
+				 &extents, xDst, yDst, n_glyphs, pglyphs);
+	else if (runHash)
+	    *seen = runHash;
+
+	if (run) {
+	    GlyphRunComposite(op, srcImage, dstImage, run,
+			      xSrc + srcXoff, ySrc + srcYoff,
+			      xDst + dstXoff, yDst + dstYoff);
+	}
+	else {
+	    pixman_composite_glyphs(op, srcImage, dstImage, format,
+				    xSrc + srcXoff + extents.x1 - xDst, ySrc + srcYoff + extents.y1 - yDst,
+				    extents.x1, extents.y1,
+				    extents.x1 + dstXoff, extents.y1 + dstYoff,
+				    extents.x2 - extents.x1,
+				    extents.y2 - extents.y1,
+				    glyphCache, n_glyphs, pglyphs);
+	}
     }
     else {
 	pixman_composite_glyphs_no_mask(op, srcImage, dstImage,
@@ -492,6 +776,9 @@ fbPictureInit(ScreenPtr pScreen, PictFormatPtr formats, int nformats)
 
     if (!miPictureInit(pScreen, formats, nformats))
         return FALSE;
+    if (!dixRegisterPrivateKey(&glyphRunPrivateKeyRec, PRIVATE_GLYPH,
+                               sizeof(struct xorg_list)))
+        return FALSE;
     ps = GetPictureScreen(pScreen);
     ps->Composite = fbComposite;
     ps->Glyphs = fbGlyphs;
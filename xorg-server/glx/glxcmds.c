@@ -2075,45 +2075,69 @@ ResetLargeCommandStatus(__GLXcontext *cx)
 }
 
 /*
-** Execute all the drawing commands in a request.
+** Render commands are looked up in a table indexed by opcode, flattened
+** from the dispatch tree the first time it is needed.  Entries are -1 for
+** opcodes without a decoder or size information.
 */
-int
-__glXDisp_Render(__GLXclientState * cl, GLbyte * pc)
+static int_fast16_t *renderCommandIndex;
+
+static Bool
+InitRenderCommandIndex(void)
 {
-    xGLXRenderReq *req;
-    ClientPtr client = cl->client;
-    int left, cmdlen, error;
-    int commandsDone;
-    CARD16 opcode;
-    __GLXrenderHeader *hdr;
-    __GLXcontext *glxc;
+    int i, n = 1 << Render_dispatch_info.bits;
 
-    __GLX_DECLARE_SWAP_VARIABLES;
+    renderCommandIndex = calloc(n, sizeof(int_fast16_t));
+    if (!renderCommandIndex)
+        return FALSE;
 
-    REQUEST_AT_LEAST_SIZE(xGLXRenderReq);
+    for (i = 0; i < n; i++) {
+        int index = __glXGetProtocolDecodeIndex(&Render_dispatch_info, i);
 
-    req = (xGLXRenderReq *) pc;
-    if (client->swapped) {
-        __GLX_SWAP_SHORT(&req->length);
-        __GLX_SWAP_INT(&req->contextTag);
+        if (index >= 0 && Render_dispatch_info.size_table[index][0] == 0)
+            index = -1;
+        renderCommandIndex[i] = index;
     }
+    return TRUE;
+}
 
-    glxc = __glXForceCurrent(cl, req->contextTag, &error);
-    if (!glxc) {
-        return error;
-    }
+static int
+RenderCommandIndex(CARD16 opcode)
+{
+    if (opcode >= (1U << Render_dispatch_info.bits))
+        return -1;
+    return renderCommandIndex[opcode];
+}
 
-    commandsDone = 0;
-    pc += sz_xGLXRenderReq;
-    left = (req->length << 2) - sz_xGLXRenderReq;
+static __GLXdispatchRenderProcPtr
+RenderCommandProc(int index, Bool swapped)
+{
+    return (__GLXdispatchRenderProcPtr)
+        Render_dispatch_info.dispatch_functions[index][swapped];
+}
+
+/*
+** Check every command in a Render request before any is executed, swapping
+** their headers if needed.  Returns how many commands at the start of the
+** request are valid, with the error for the one following them, if any,
+** in *error.
+*/
+static int
+ValidateRenderCommands(ClientPtr client, GLbyte * pc, int left, int *error)
+{
+    __GLXrenderHeader *hdr;
+    int commandsDone = 0;
+
+    __GLX_DECLARE_SWAP_VARIABLES;
+
+    *error = Success;
     while (left > 0) {
-        __GLXrenderSizeData entry;
-        int extra = 0;
-        __GLXdispatchRenderProcPtr proc;
-        int err;
+        int cmdlen, index, bytes, varsize, extra = 0;
+        CARD16 opcode;
 
-        if (left < sizeof(__GLXrenderHeader))
-            return BadLength;
+        if (left < sizeof(__GLXrenderHeader)) {
+            *error = BadLength;
+            break;
+        }
 
         /*
          ** Verify that the header length and the overall length agree.
@@ -2127,53 +2151,304 @@ __glXDisp_Render(__GLXclientState * cl, GLbyte * pc)
         cmdlen = hdr->length;
         opcode = hdr->opcode;
 
-        if (left < cmdlen)
-            return BadLength;
+        if (left < cmdlen) {
+            *error = BadLength;
+            break;
+        }
 
         /*
          ** Check for core opcodes and grab entry data.
          */
-        err = __glXGetProtocolSizeData(&Render_dispatch_info, opcode, &entry);
-        proc = (__GLXdispatchRenderProcPtr)
-            __glXGetProtocolDecodeFunction(&Render_dispatch_info,
-                                           opcode, client->swapped);
-
-        if ((err < 0) || (proc == NULL)) {
+        index = RenderCommandIndex(opcode);
+        if (index < 0 || RenderCommandProc(index, client->swapped) == NULL) {
             client->errorValue = commandsDone;
-            return __glXError(GLXBadRenderRequest);
+            *error = __glXError(GLXBadRenderRequest);
+            break;
         }
 
-        if (cmdlen < entry.bytes) {
-            return BadLength;
+        bytes = Render_dispatch_info.size_table[index][0];
+        varsize = Render_dispatch_info.size_table[index][1];
+
+        if (cmdlen < bytes) {
+            *error = BadLength;
+            break;
         }
 
-        if (entry.varsize) {
+        if (varsize != ~0) {
             /* variable size command */
-            extra = (*entry.varsize) (pc + __GLX_RENDER_HDR_SIZE,
-                                      client->swapped,
-                                      left - __GLX_RENDER_HDR_SIZE);
+            extra = (*Render_dispatch_info.size_func_table[varsize])
+                (pc + __GLX_RENDER_HDR_SIZE, client->swapped,
+                 left - __GLX_RENDER_HDR_SIZE);
             if (extra < 0) {
-                return BadLength;
+                *error = BadLength;
+                break;
             }
         }
 
-        if (cmdlen != safe_pad(safe_add(entry.bytes, extra))) {
-            return BadLength;
+        if (cmdlen != safe_pad(safe_add(bytes, extra))) {
+            *error = BadLength;
+            break;
         }
 
-        /*
-         ** Skip over the header and execute the command.  We allow the
-         ** caller to trash the command memory.  This is useful especially
-         ** for things that require double alignment - they can just shift
-         ** the data towards lower memory (trashing the header) by 4 bytes
-         ** and achieve the required alignment.
-         */
-        (*proc) (pc + __GLX_RENDER_HDR_SIZE);
         pc += cmdlen;
         left -= cmdlen;
         commandsDone++;
     }
-    return Success;
+    return commandsDone;
+}
+
+/*
+** Skip over the header and execute the command.  We allow the caller to
+** trash the command memory.  This is useful especially for things that
+** require double alignment - they can just shift the data towards lower
+** memory (trashing the header) by 4 bytes and achieve the required
+** alignment.
+*/
+static void
+ExecuteRenderCommand(ClientPtr client, GLbyte * pc)
+{
+    __GLXrenderHeader *hdr = (__GLXrenderHeader *) pc;
+    int index = RenderCommandIndex(hdr->opcode);
+
+    (*RenderCommandProc(index, client->swapped)) (pc + __GLX_RENDER_HDR_SIZE);
+}
+
+/*
+** Clients using immediate mode send a command per vertex and attribute.
+** A run of them between Begin and End is drawn with a single DrawArrays
+** instead, provided it has at least RENDER_BATCH_MIN_VERTICES vertices,
+** contains nothing but float vertices, colors, normals and texture
+** coordinates, always uses the same command for each of them and sets
+** every attribute it uses before its first vertex, so that no current
+** value has to be read back.  Byte-swapped clients are not batched.
+*/
+#define RENDER_BATCH_MIN_VERTICES 8
+
+enum {
+    RENDER_BATCH_VERTEX,
+    RENDER_BATCH_COLOR,
+    RENDER_BATCH_NORMAL,
+    RENDER_BATCH_TEXCOORD,
+    RENDER_BATCH_ATTRIBS
+};
+
+typedef struct {
+    GLfloat attrib[RENDER_BATCH_ATTRIBS][4];
+} RenderBatchVertex;
+
+typedef struct {
+    int attrib;
+    GLint size;
+    GLenum type;
+} RenderBatchCommand;
+
+static RenderBatchVertex *renderBatch;
+static int renderBatchSize;
+
+static Bool
+RenderBatchCommandInfo(CARD16 opcode, RenderBatchCommand * cmd)
+{
+    static const struct {
+        CARD16 opcode;
+        RenderBatchCommand cmd;
+    } commands[] = {
+        {X_GLrop_Vertex2fv, {RENDER_BATCH_VERTEX, 2, GL_FLOAT}},
+        {X_GLrop_Vertex3fv, {RENDER_BATCH_VERTEX, 3, GL_FLOAT}},
+        {X_GLrop_Vertex4fv, {RENDER_BATCH_VERTEX, 4, GL_FLOAT}},
+        {X_GLrop_Color3fv, {RENDER_BATCH_COLOR, 3, GL_FLOAT}},
+        {X_GLrop_Color4fv, {RENDER_BATCH_COLOR, 4, GL_FLOAT}},
+        {X_GLrop_Color3ubv, {RENDER_BATCH_COLOR, 3, GL_UNSIGNED_BYTE}},
+        {X_GLrop_Color4ubv, {RENDER_BATCH_COLOR, 4, GL_UNSIGNED_BYTE}},
+        {X_GLrop_Normal3fv, {RENDER_BATCH_NORMAL, 3, GL_FLOAT}},
+        {X_GLrop_TexCoord1fv, {RENDER_BATCH_TEXCOORD, 1, GL_FLOAT}},
+        {X_GLrop_TexCoord2fv, {RENDER_BATCH_TEXCOORD, 2, GL_FLOAT}},
+        {X_GLrop_TexCoord3fv, {RENDER_BATCH_TEXCOORD, 3, GL_FLOAT}},
+        {X_GLrop_TexCoord4fv, {RENDER_BATCH_TEXCOORD, 4, GL_FLOAT}},
+    };
+    int i;
+
+    for (i = 0; i < ARRAY_SIZE(commands); i++) {
+        if (commands[i].opcode == opcode) {
+            *cmd = commands[i].cmd;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/*
+** Try to draw the run starting with the Begin at *ppc, the first of count
+** validated commands.  Returns the number of commands drawn, up to and
+** including the End, and moves *ppc past them; or 0 if the commands must
+** be executed one by one.
+*/
+static int
+RenderBatchVertices(ClientPtr client, GLbyte ** ppc, int count)
+{
+    GLbyte *pc = *ppc;
+    CARD16 opcodes[RENDER_BATCH_ATTRIBS] = { 0 };
+    RenderBatchCommand info[RENDER_BATCH_ATTRIBS];
+    GLbyte *last[RENDER_BATCH_ATTRIBS] = { NULL };
+    GLfloat current[RENDER_BATCH_ATTRIBS][4] = { { 0 } };
+    GLenum mode = *(GLenum *) (pc + __GLX_RENDER_HDR_SIZE);
+    GLbyte *end;
+    RenderBatchCommand cmd;
+    int i, commands = 1, vertices = 0;
+
+    if (client->swapped || mode > GL_POLYGON)
+        return 0;
+
+    /* Check the run can be batched and count its vertices */
+    for (end = pc;;) {
+        CARD16 opcode;
+
+        if (commands++ == count)
+            return 0;
+        end += ((__GLXrenderHeader *) end)->length;
+        opcode = ((__GLXrenderHeader *) end)->opcode;
+
+        if (opcode == X_GLrop_End)
+            break;
+        if (!RenderBatchCommandInfo(opcode, &cmd))
+            return 0;
+
+        if (!opcodes[cmd.attrib]) {
+            if (vertices)
+                return 0;
+            opcodes[cmd.attrib] = opcode;
+            info[cmd.attrib] = cmd;
+        }
+        else if (opcodes[cmd.attrib] != opcode)
+            return 0;
+
+        if (cmd.attrib == RENDER_BATCH_VERTEX)
+            vertices++;
+    }
+
+    if (vertices < RENDER_BATCH_MIN_VERTICES)
+        return 0;
+
+    if (vertices > renderBatchSize) {
+        int size = max(renderBatchSize, 256);
+        RenderBatchVertex *batch;
+
+        while (size < vertices)
+            size <<= 1;
+        batch = reallocarray(renderBatch, size, sizeof(RenderBatchVertex));
+        if (!batch)
+            return 0;
+        renderBatch = batch;
+        renderBatchSize = size;
+    }
+
+    /* Gather the vertices, with the attributes current for each */
+    vertices = 0;
+    for (pc += ((__GLXrenderHeader *) pc)->length; pc != end;
+         pc += ((__GLXrenderHeader *) pc)->length) {
+        RenderBatchCommandInfo(((__GLXrenderHeader *) pc)->opcode, &cmd);
+        memcpy(current[cmd.attrib], pc + __GLX_RENDER_HDR_SIZE,
+               cmd.size * (cmd.type == GL_FLOAT ? sizeof(GLfloat) : 1));
+        last[cmd.attrib] = pc;
+
+        if (cmd.attrib == RENDER_BATCH_VERTEX)
+            memcpy(&renderBatch[vertices++], current,
+                   sizeof(RenderBatchVertex));
+    }
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(info[RENDER_BATCH_VERTEX].size, GL_FLOAT,
+                    sizeof(RenderBatchVertex),
+                    renderBatch->attrib[RENDER_BATCH_VERTEX]);
+    if (opcodes[RENDER_BATCH_COLOR]) {
+        glEnableClientState(GL_COLOR_ARRAY);
+        glColorPointer(info[RENDER_BATCH_COLOR].size,
+                       info[RENDER_BATCH_COLOR].type,
+                       sizeof(RenderBatchVertex),
+                       renderBatch->attrib[RENDER_BATCH_COLOR]);
+    }
+    if (opcodes[RENDER_BATCH_NORMAL]) {
+        glEnableClientState(GL_NORMAL_ARRAY);
+        glNormalPointer(GL_FLOAT, sizeof(RenderBatchVertex),
+                        renderBatch->attrib[RENDER_BATCH_NORMAL]);
+    }
+    if (opcodes[RENDER_BATCH_TEXCOORD]) {
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glTexCoordPointer(info[RENDER_BATCH_TEXCOORD].size, GL_FLOAT,
+                          sizeof(RenderBatchVertex),
+                          renderBatch->attrib[RENDER_BATCH_TEXCOORD]);
+    }
+
+    glDrawArrays(mode, 0, vertices);
+
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+
+    /*
+     ** Drawing arrays leaves the current values of their attributes
+     ** undefined, so set them to those of the last commands.
+     */
+    for (i = RENDER_BATCH_COLOR; i < RENDER_BATCH_ATTRIBS; i++)
+        if (last[i])
+            ExecuteRenderCommand(client, last[i]);
+
+    *ppc = end + ((__GLXrenderHeader *) end)->length;
+    return commands;
+}
+
+/*
+** Execute all the drawing commands in a request.
+*/
+int
+__glXDisp_Render(__GLXclientState * cl, GLbyte * pc)
+{
+    xGLXRenderReq *req;
+    ClientPtr client = cl->client;
+    int left, commands, error, batched;
+    __GLXcontext *glxc;
+
+    __GLX_DECLARE_SWAP_VARIABLES;
+
+    REQUEST_AT_LEAST_SIZE(xGLXRenderReq);
+
+    req = (xGLXRenderReq *) pc;
+    if (client->swapped) {
+        __GLX_SWAP_SHORT(&req->length);
+        __GLX_SWAP_INT(&req->contextTag);
+    }
+
+    glxc = __glXForceCurrent(cl, req->contextTag, &error);
+    if (!glxc) {
+        return error;
+    }
+
+    if (!renderCommandIndex && !InitRenderCommandIndex())
+        return BadAlloc;
+
+    pc += sz_xGLXRenderReq;
+    left = (req->length << 2) - sz_xGLXRenderReq;
+
+    /*
+     ** Commands up to the first invalid one are still executed, as if
+     ** they had been checked one at a time.
+     */
+    commands = ValidateRenderCommands(client, pc, left, &error);
+
+    while (commands > 0) {
+        int cmdlen = ((__GLXrenderHeader *) pc)->length;
+
+        if (((__GLXrenderHeader *) pc)->opcode == X_GLrop_Begin &&
+            (batched = RenderBatchVertices(client, &pc, commands))) {
+            commands -= batched;
+            continue;
+        }
+
+        ExecuteRenderCommand(client, pc);
+        pc += cmdlen;
+        commands--;
+    }
+    return error;
 }
 
 /*
@@ -125,6 +125,23 @@ struct __GLXclientStateRec {
     char *GLClientextensions;
 };
 
+/* Make room for size bytes in the client's returnBuf */
+extern GLbyte *__glXReserveReturnBuffer(__GLXclientState * cl, size_t size);
+
+/*
+** Pixel data packed for clients that asked for it byte-swapped is packed
+** unswapped by GL and then swapped by __glXSwapPixelData, in elements of
+** __glXPixelSwapSize bytes.  That is 0 for types GL must swap itself.
+** Images in render commands are swapped the same way before GL unpacks
+** them, by __glXUnpackSwapPixels.
+*/
+extern unsigned __glXPixelSwapSize(GLenum type);
+extern void __glXSwapPixelData(void *data, size_t size, unsigned swapSize);
+extern void __glXUnpackSwapPixels(GLboolean swapBytes, GLenum target,
+                                  GLenum format, GLenum type,
+                                  GLsizei w, GLsizei h, GLsizei d,
+                                  const GLvoid * pixels);
+
 /************************************************************************/
 
 /*
@@ -1121,12 +1121,19 @@ void __glXDisp_TexImage1D(GLbyte * pc)
     const GLvoid * const pixels = (const GLvoid *) (pc + 52);
     __GLXpixelHeader * const hdr = (__GLXpixelHeader *)(pc);
 
-    CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SWAP_BYTES,   hdr->swapBytes) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_LSB_FIRST,    hdr->lsbFirst) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ROW_LENGTH,   (GLint) hdr->rowLength) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_ROWS,    (GLint) hdr->skipRows) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_PIXELS,  (GLint) hdr->skipPixels) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ALIGNMENT,    (GLint) hdr->alignment) );
+    __glXUnpackSwapPixels( hdr->swapBytes,
+        *(GLenum   *)(pc + 20),
+        *(GLenum   *)(pc + 44),
+        *(GLenum   *)(pc + 48),
+        *(GLsizei  *)(pc + 32),
+        1,
+        0,
+        pixels );
 
     CALL_TexImage1D( GET_DISPATCH(), (
         *(GLenum   *)(pc + 20),
@@ -1145,12 +1152,19 @@ void __glXDisp_TexImage2D(GLbyte * pc)
     const GLvoid * const pixels = (const GLvoid *) (pc + 52);
     __GLXpixelHeader * const hdr = (__GLXpixelHeader *)(pc);
 
-    CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SWAP_BYTES,   hdr->swapBytes) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_LSB_FIRST,    hdr->lsbFirst) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ROW_LENGTH,   (GLint) hdr->rowLength) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_ROWS,    (GLint) hdr->skipRows) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_PIXELS,  (GLint) hdr->skipPixels) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ALIGNMENT,    (GLint) hdr->alignment) );
+    __glXUnpackSwapPixels( hdr->swapBytes,
+        *(GLenum   *)(pc + 20),
+        *(GLenum   *)(pc + 44),
+        *(GLenum   *)(pc + 48),
+        *(GLsizei  *)(pc + 32),
+        *(GLsizei  *)(pc + 36),
+        0,
+        pixels );
 
     CALL_TexImage2D( GET_DISPATCH(), (
         *(GLenum   *)(pc + 20),
@@ -1751,12 +1765,19 @@ void __glXDisp_DrawPixels(GLbyte * pc)
     const GLvoid * const pixels = (const GLvoid *) (pc + 36);
     __GLXpixelHeader * const hdr = (__GLXpixelHeader *)(pc);
 
-    CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SWAP_BYTES,   hdr->swapBytes) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_LSB_FIRST,    hdr->lsbFirst) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ROW_LENGTH,   (GLint) hdr->rowLength) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_ROWS,    (GLint) hdr->skipRows) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_PIXELS,  (GLint) hdr->skipPixels) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ALIGNMENT,    (GLint) hdr->alignment) );
+    __glXUnpackSwapPixels( hdr->swapBytes,
+        0,
+        *(GLenum   *)(pc + 28),
+        *(GLenum   *)(pc + 32),
+        *(GLsizei  *)(pc + 20),
+        *(GLsizei  *)(pc + 24),
+        0,
+        pixels );
 
     CALL_DrawPixels( GET_DISPATCH(), (
         *(GLsizei  *)(pc + 20),
@@ -3001,12 +3022,19 @@ void __glXDisp_TexSubImage1D(GLbyte * pc)
     const GLvoid * const pixels = (const GLvoid *) (pc + 56);
     __GLXpixelHeader * const hdr = (__GLXpixelHeader *)(pc);
 
-    CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SWAP_BYTES,   hdr->swapBytes) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_LSB_FIRST,    hdr->lsbFirst) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ROW_LENGTH,   (GLint) hdr->rowLength) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_ROWS,    (GLint) hdr->skipRows) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_PIXELS,  (GLint) hdr->skipPixels) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ALIGNMENT,    (GLint) hdr->alignment) );
+    __glXUnpackSwapPixels( hdr->swapBytes,
+        *(GLenum   *)(pc + 20),
+        *(GLenum   *)(pc + 44),
+        *(GLenum   *)(pc + 48),
+        *(GLsizei  *)(pc + 36),
+        1,
+        0,
+        pixels );
 
     CALL_TexSubImage1D( GET_DISPATCH(), (
         *(GLenum   *)(pc + 20),
@@ -3024,12 +3052,19 @@ void __glXDisp_TexSubImage2D(GLbyte * pc)
     const GLvoid * const pixels = (const GLvoid *) (pc + 56);
     __GLXpixelHeader * const hdr = (__GLXpixelHeader *)(pc);
 
-    CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SWAP_BYTES,   hdr->swapBytes) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_LSB_FIRST,    hdr->lsbFirst) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ROW_LENGTH,   (GLint) hdr->rowLength) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_ROWS,    (GLint) hdr->skipRows) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_PIXELS,  (GLint) hdr->skipPixels) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ALIGNMENT,    (GLint) hdr->alignment) );
+    __glXUnpackSwapPixels( hdr->swapBytes,
+        *(GLenum   *)(pc + 20),
+        *(GLenum   *)(pc + 44),
+        *(GLenum   *)(pc + 48),
+        *(GLsizei  *)(pc + 36),
+        *(GLsizei  *)(pc + 40),
+        0,
+        pixels );
 
     CALL_TexSubImage2D( GET_DISPATCH(), (
         *(GLenum   *)(pc + 20),
@@ -3066,12 +3101,19 @@ void __glXDisp_ColorTable(GLbyte * pc)
     const GLvoid * const table = (const GLvoid *) (pc + 40);
     __GLXpixelHeader * const hdr = (__GLXpixelHeader *)(pc);
 
-    CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SWAP_BYTES,   hdr->swapBytes) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_LSB_FIRST,    hdr->lsbFirst) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ROW_LENGTH,   (GLint) hdr->rowLength) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_ROWS,    (GLint) hdr->skipRows) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_PIXELS,  (GLint) hdr->skipPixels) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ALIGNMENT,    (GLint) hdr->alignment) );
+    __glXUnpackSwapPixels( hdr->swapBytes,
+        *(GLenum   *)(pc + 20),
+        *(GLenum   *)(pc + 32),
+        *(GLenum   *)(pc + 36),
+        *(GLsizei  *)(pc + 28),
+        1,
+        0,
+        table );
 
     CALL_ColorTable( GET_DISPATCH(), (
         *(GLenum   *)(pc + 20),
@@ -3185,12 +3227,19 @@ void __glXDisp_ColorSubTable(GLbyte * pc)
     const GLvoid * const data = (const GLvoid *) (pc + 40);
     __GLXpixelHeader * const hdr = (__GLXpixelHeader *)(pc);
 
-    CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SWAP_BYTES,   hdr->swapBytes) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_LSB_FIRST,    hdr->lsbFirst) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ROW_LENGTH,   (GLint) hdr->rowLength) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_ROWS,    (GLint) hdr->skipRows) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_PIXELS,  (GLint) hdr->skipPixels) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ALIGNMENT,    (GLint) hdr->alignment) );
+    __glXUnpackSwapPixels( hdr->swapBytes,
+        *(GLenum   *)(pc + 20),
+        *(GLenum   *)(pc + 32),
+        *(GLenum   *)(pc + 36),
+        *(GLsizei  *)(pc + 28),
+        1,
+        0,
+        data );
 
     CALL_ColorSubTable( GET_DISPATCH(), (
         *(GLenum   *)(pc + 20),
@@ -3218,12 +3267,19 @@ void __glXDisp_ConvolutionFilter1D(GLbyte * pc)
     const GLvoid * const image = (const GLvoid *) (pc + 44);
     __GLXpixelHeader * const hdr = (__GLXpixelHeader *)(pc);
 
-    CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SWAP_BYTES,   hdr->swapBytes) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_LSB_FIRST,    hdr->lsbFirst) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ROW_LENGTH,   (GLint) hdr->rowLength) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_ROWS,    (GLint) hdr->skipRows) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_PIXELS,  (GLint) hdr->skipPixels) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ALIGNMENT,    (GLint) hdr->alignment) );
+    __glXUnpackSwapPixels( hdr->swapBytes,
+        *(GLenum   *)(pc + 20),
+        *(GLenum   *)(pc + 36),
+        *(GLenum   *)(pc + 40),
+        *(GLsizei  *)(pc + 28),
+        1,
+        0,
+        image );
 
     CALL_ConvolutionFilter1D( GET_DISPATCH(), (
         *(GLenum   *)(pc + 20),
@@ -3240,12 +3296,19 @@ void __glXDisp_ConvolutionFilter2D(GLbyte * pc)
     const GLvoid * const image = (const GLvoid *) (pc + 44);
     __GLXpixelHeader * const hdr = (__GLXpixelHeader *)(pc);
 
-    CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SWAP_BYTES,   hdr->swapBytes) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_LSB_FIRST,    hdr->lsbFirst) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ROW_LENGTH,   (GLint) hdr->rowLength) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_ROWS,    (GLint) hdr->skipRows) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_PIXELS,  (GLint) hdr->skipPixels) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ALIGNMENT,    (GLint) hdr->alignment) );
+    __glXUnpackSwapPixels( hdr->swapBytes,
+        *(GLenum   *)(pc + 20),
+        *(GLenum   *)(pc + 36),
+        *(GLenum   *)(pc + 40),
+        *(GLsizei  *)(pc + 28),
+        *(GLsizei  *)(pc + 32),
+        0,
+        image );
 
     CALL_ConvolutionFilter2D( GET_DISPATCH(), (
         *(GLenum   *)(pc + 20),
@@ -3540,7 +3603,6 @@ void __glXDisp_TexImage3D(GLbyte * pc)
     const GLvoid * const pixels = (const GLvoid *) ((ptr_is_null != 0) ? NULL : (pc + 80));
     __GLXpixel3DHeader * const hdr = (__GLXpixel3DHeader *)(pc);
 
-    CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SWAP_BYTES,   hdr->swapBytes) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_LSB_FIRST,    hdr->lsbFirst) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ROW_LENGTH,   (GLint) hdr->rowLength) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_IMAGE_HEIGHT, (GLint) hdr->imageHeight) );
@@ -3548,6 +3610,14 @@ void __glXDisp_TexImage3D(GLbyte * pc)
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_IMAGES,  (GLint) hdr->skipImages) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_PIXELS,  (GLint) hdr->skipPixels) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ALIGNMENT,    (GLint) hdr->alignment) );
+    __glXUnpackSwapPixels( hdr->swapBytes,
+        *(GLenum   *)(pc + 36),
+        *(GLenum   *)(pc + 68),
+        *(GLenum   *)(pc + 72),
+        *(GLsizei  *)(pc + 48),
+        *(GLsizei  *)(pc + 52),
+        *(GLsizei  *)(pc + 56),
+        pixels );
 
     CALL_TexImage3D( GET_DISPATCH(), (
         *(GLenum   *)(pc + 36),
@@ -3568,7 +3638,6 @@ void __glXDisp_TexSubImage3D(GLbyte * pc)
     const GLvoid * const pixels = (const GLvoid *) (pc + 88);
     __GLXpixel3DHeader * const hdr = (__GLXpixel3DHeader *)(pc);
 
-    CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SWAP_BYTES,   hdr->swapBytes) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_LSB_FIRST,    hdr->lsbFirst) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ROW_LENGTH,   (GLint) hdr->rowLength) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_IMAGE_HEIGHT, (GLint) hdr->imageHeight) );
@@ -3576,6 +3645,14 @@ void __glXDisp_TexSubImage3D(GLbyte * pc)
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_IMAGES,  (GLint) hdr->skipImages) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_PIXELS,  (GLint) hdr->skipPixels) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ALIGNMENT,    (GLint) hdr->alignment) );
+    __glXUnpackSwapPixels( hdr->swapBytes,
+        *(GLenum   *)(pc + 36),
+        *(GLenum   *)(pc + 76),
+        *(GLenum   *)(pc + 80),
+        *(GLsizei  *)(pc + 60),
+        *(GLsizei  *)(pc + 64),
+        *(GLsizei  *)(pc + 68),
+        pixels );
 
     CALL_TexSubImage3D( GET_DISPATCH(), (
         *(GLenum   *)(pc + 36),
@@ -1234,12 +1234,19 @@ void __glXDispSwap_TexImage1D(GLbyte * pc)
     const GLvoid * const pixels = (const GLvoid *) (pc + 52);
     __GLXpixelHeader * const hdr = (__GLXpixelHeader *)(pc);
 
-    CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SWAP_BYTES,   hdr->swapBytes) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_LSB_FIRST,    hdr->lsbFirst) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ROW_LENGTH,   (GLint) bswap_CARD32( & hdr->rowLength )) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_ROWS,    (GLint) bswap_CARD32( & hdr->skipRows )) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_PIXELS,  (GLint) bswap_CARD32( & hdr->skipPixels )) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ALIGNMENT,    (GLint) bswap_CARD32( & hdr->alignment )) );
+    __glXUnpackSwapPixels( hdr->swapBytes,
+        (GLenum  )bswap_ENUM   ( pc + 20 ),
+        (GLenum  )bswap_ENUM   ( pc + 44 ),
+        (GLenum  )bswap_ENUM   ( pc + 48 ),
+        (GLsizei )bswap_CARD32 ( pc + 32 ),
+        1,
+        0,
+        pixels );
 
     CALL_TexImage1D( GET_DISPATCH(), (
          (GLenum  )bswap_ENUM   ( pc + 20 ),
@@ -1258,12 +1265,19 @@ void __glXDispSwap_TexImage2D(GLbyte * pc)
     const GLvoid * const pixels = (const GLvoid *) (pc + 52);
     __GLXpixelHeader * const hdr = (__GLXpixelHeader *)(pc);
 
-    CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SWAP_BYTES,   hdr->swapBytes) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_LSB_FIRST,    hdr->lsbFirst) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ROW_LENGTH,   (GLint) bswap_CARD32( & hdr->rowLength )) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_ROWS,    (GLint) bswap_CARD32( & hdr->skipRows )) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_PIXELS,  (GLint) bswap_CARD32( & hdr->skipPixels )) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ALIGNMENT,    (GLint) bswap_CARD32( & hdr->alignment )) );
+    __glXUnpackSwapPixels( hdr->swapBytes,
+        (GLenum  )bswap_ENUM   ( pc + 20 ),
+        (GLenum  )bswap_ENUM   ( pc + 44 ),
+        (GLenum  )bswap_ENUM   ( pc + 48 ),
+        (GLsizei )bswap_CARD32 ( pc + 32 ),
+        (GLsizei )bswap_CARD32 ( pc + 36 ),
+        0,
+        pixels );
 
     CALL_TexImage2D( GET_DISPATCH(), (
          (GLenum  )bswap_ENUM   ( pc + 20 ),
@@ -1864,12 +1878,19 @@ void __glXDispSwap_DrawPixels(GLbyte * pc)
     const GLvoid * const pixels = (const GLvoid *) (pc + 36);
     __GLXpixelHeader * const hdr = (__GLXpixelHeader *)(pc);
 
-    CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SWAP_BYTES,   hdr->swapBytes) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_LSB_FIRST,    hdr->lsbFirst) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ROW_LENGTH,   (GLint) bswap_CARD32( & hdr->rowLength )) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_ROWS,    (GLint) bswap_CARD32( & hdr->skipRows )) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_PIXELS,  (GLint) bswap_CARD32( & hdr->skipPixels )) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ALIGNMENT,    (GLint) bswap_CARD32( & hdr->alignment )) );
+    __glXUnpackSwapPixels( hdr->swapBytes,
+        0,
+        (GLenum  )bswap_ENUM   ( pc + 28 ),
+        (GLenum  )bswap_ENUM   ( pc + 32 ),
+        (GLsizei )bswap_CARD32 ( pc + 20 ),
+        (GLsizei )bswap_CARD32 ( pc + 24 ),
+        0,
+        pixels );
 
     CALL_DrawPixels( GET_DISPATCH(), (
          (GLsizei )bswap_CARD32 ( pc + 20 ),
@@ -3139,12 +3160,19 @@ void __glXDispSwap_TexSubImage1D(GLbyte * pc)
     const GLvoid * const pixels = (const GLvoid *) (pc + 56);
     __GLXpixelHeader * const hdr = (__GLXpixelHeader *)(pc);
 
-    CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SWAP_BYTES,   hdr->swapBytes) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_LSB_FIRST,    hdr->lsbFirst) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ROW_LENGTH,   (GLint) bswap_CARD32( & hdr->rowLength )) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_ROWS,    (GLint) bswap_CARD32( & hdr->skipRows )) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_PIXELS,  (GLint) bswap_CARD32( & hdr->skipPixels )) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ALIGNMENT,    (GLint) bswap_CARD32( & hdr->alignment )) );
+    __glXUnpackSwapPixels( hdr->swapBytes,
+        (GLenum  )bswap_ENUM   ( pc + 20 ),
+        (GLenum  )bswap_ENUM   ( pc + 44 ),
+        (GLenum  )bswap_ENUM   ( pc + 48 ),
+        (GLsizei )bswap_CARD32 ( pc + 36 ),
+        1,
+        0,
+        pixels );
 
     CALL_TexSubImage1D( GET_DISPATCH(), (
          (GLenum  )bswap_ENUM   ( pc + 20 ),
@@ -3162,12 +3190,19 @@ void __glXDispSwap_TexSubImage2D(GLbyte * pc)
     const GLvoid * const pixels = (const GLvoid *) (pc + 56);
     __GLXpixelHeader * const hdr = (__GLXpixelHeader *)(pc);
 
-    CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SWAP_BYTES,   hdr->swapBytes) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_LSB_FIRST,    hdr->lsbFirst) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ROW_LENGTH,   (GLint) bswap_CARD32( & hdr->rowLength )) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_ROWS,    (GLint) bswap_CARD32( & hdr->skipRows )) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_PIXELS,  (GLint) bswap_CARD32( & hdr->skipPixels )) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ALIGNMENT,    (GLint) bswap_CARD32( & hdr->alignment )) );
+    __glXUnpackSwapPixels( hdr->swapBytes,
+        (GLenum  )bswap_ENUM   ( pc + 20 ),
+        (GLenum  )bswap_ENUM   ( pc + 44 ),
+        (GLenum  )bswap_ENUM   ( pc + 48 ),
+        (GLsizei )bswap_CARD32 ( pc + 36 ),
+        (GLsizei )bswap_CARD32 ( pc + 40 ),
+        0,
+        pixels );
 
     CALL_TexSubImage2D( GET_DISPATCH(), (
          (GLenum  )bswap_ENUM   ( pc + 20 ),
@@ -3204,12 +3239,19 @@ void __glXDispSwap_ColorTable(GLbyte * pc)
     const GLvoid * const table = (const GLvoid *) (pc + 40);
     __GLXpixelHeader * const hdr = (__GLXpixelHeader *)(pc);
 
-    CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SWAP_BYTES,   hdr->swapBytes) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_LSB_FIRST,    hdr->lsbFirst) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ROW_LENGTH,   (GLint) bswap_CARD32( & hdr->rowLength )) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_ROWS,    (GLint) bswap_CARD32( & hdr->skipRows )) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_PIXELS,  (GLint) bswap_CARD32( & hdr->skipPixels )) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ALIGNMENT,    (GLint) bswap_CARD32( & hdr->alignment )) );
+    __glXUnpackSwapPixels( hdr->swapBytes,
+        (GLenum  )bswap_ENUM   ( pc + 20 ),
+        (GLenum  )bswap_ENUM   ( pc + 32 ),
+        (GLenum  )bswap_ENUM   ( pc + 36 ),
+        (GLsizei )bswap_CARD32 ( pc + 28 ),
+        1,
+        0,
+        table );
 
     CALL_ColorTable( GET_DISPATCH(), (
          (GLenum  )bswap_ENUM   ( pc + 20 ),
@@ -3325,12 +3367,19 @@ void __glXDispSwap_ColorSubTable(GLbyte * pc)
     const GLvoid * const data = (const GLvoid *) (pc + 40);
     __GLXpixelHeader * const hdr = (__GLXpixelHeader *)(pc);
 
-    CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SWAP_BYTES,   hdr->swapBytes) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_LSB_FIRST,    hdr->lsbFirst) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ROW_LENGTH,   (GLint) bswap_CARD32( & hdr->rowLength )) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_ROWS,    (GLint) bswap_CARD32( & hdr->skipRows )) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_PIXELS,  (GLint) bswap_CARD32( & hdr->skipPixels )) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ALIGNMENT,    (GLint) bswap_CARD32( & hdr->alignment )) );
+    __glXUnpackSwapPixels( hdr->swapBytes,
+        (GLenum  )bswap_ENUM   ( pc + 20 ),
+        (GLenum  )bswap_ENUM   ( pc + 32 ),
+        (GLenum  )bswap_ENUM   ( pc + 36 ),
+        (GLsizei )bswap_CARD32 ( pc + 28 ),
+        1,
+        0,
+        data );
 
     CALL_ColorSubTable( GET_DISPATCH(), (
          (GLenum  )bswap_ENUM   ( pc + 20 ),
@@ -3358,12 +3407,19 @@ void __glXDispSwap_ConvolutionFilter1D(GLbyte * pc)
     const GLvoid * const image = (const GLvoid *) (pc + 44);
     __GLXpixelHeader * const hdr = (__GLXpixelHeader *)(pc);
 
-    CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SWAP_BYTES,   hdr->swapBytes) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_LSB_FIRST,    hdr->lsbFirst) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ROW_LENGTH,   (GLint) bswap_CARD32( & hdr->rowLength )) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_ROWS,    (GLint) bswap_CARD32( & hdr->skipRows )) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_PIXELS,  (GLint) bswap_CARD32( & hdr->skipPixels )) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ALIGNMENT,    (GLint) bswap_CARD32( & hdr->alignment )) );
+    __glXUnpackSwapPixels( hdr->swapBytes,
+        (GLenum  )bswap_ENUM   ( pc + 20 ),
+        (GLenum  )bswap_ENUM   ( pc + 36 ),
+        (GLenum  )bswap_ENUM   ( pc + 40 ),
+        (GLsizei )bswap_CARD32 ( pc + 28 ),
+        1,
+        0,
+        image );
 
     CALL_ConvolutionFilter1D( GET_DISPATCH(), (
          (GLenum  )bswap_ENUM   ( pc + 20 ),
@@ -3380,12 +3436,19 @@ void __glXDispSwap_ConvolutionFilter2D(GLbyte * pc)
     const GLvoid * const image = (const GLvoid *) (pc + 44);
     __GLXpixelHeader * const hdr = (__GLXpixelHeader *)(pc);
 
-    CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SWAP_BYTES,   hdr->swapBytes) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_LSB_FIRST,    hdr->lsbFirst) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ROW_LENGTH,   (GLint) bswap_CARD32( & hdr->rowLength )) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_ROWS,    (GLint) bswap_CARD32( & hdr->skipRows )) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_PIXELS,  (GLint) bswap_CARD32( & hdr->skipPixels )) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ALIGNMENT,    (GLint) bswap_CARD32( & hdr->alignment )) );
+    __glXUnpackSwapPixels( hdr->swapBytes,
+        (GLenum  )bswap_ENUM   ( pc + 20 ),
+        (GLenum  )bswap_ENUM   ( pc + 36 ),
+        (GLenum  )bswap_ENUM   ( pc + 40 ),
+        (GLsizei )bswap_CARD32 ( pc + 28 ),
+        (GLsizei )bswap_CARD32 ( pc + 32 ),
+        0,
+        image );
 
     CALL_ConvolutionFilter2D( GET_DISPATCH(), (
          (GLenum  )bswap_ENUM   ( pc + 20 ),
@@ -3686,7 +3749,6 @@ void __glXDispSwap_TexImage3D(GLbyte * pc)
     const GLvoid * const pixels = (const GLvoid *) ((ptr_is_null != 0) ? NULL : (pc + 80));
     __GLXpixel3DHeader * const hdr = (__GLXpixel3DHeader *)(pc);
 
-    CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SWAP_BYTES,   hdr->swapBytes) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_LSB_FIRST,    hdr->lsbFirst) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ROW_LENGTH,   (GLint) bswap_CARD32( & hdr->rowLength )) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_IMAGE_HEIGHT, (GLint) bswap_CARD32( & hdr->imageHeight )) );
@@ -3694,6 +3756,14 @@ void __glXDispSwap_TexImage3D(GLbyte * pc)
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_IMAGES,  (GLint) bswap_CARD32( & hdr->skipImages )) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_PIXELS,  (GLint) bswap_CARD32( & hdr->skipPixels )) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ALIGNMENT,    (GLint) bswap_CARD32( & hdr->alignment )) );
+    __glXUnpackSwapPixels( hdr->swapBytes,
+        (GLenum  )bswap_ENUM   ( pc + 36 ),
+        (GLenum  )bswap_ENUM   ( pc + 68 ),
+        (GLenum  )bswap_ENUM   ( pc + 72 ),
+        (GLsizei )bswap_CARD32 ( pc + 48 ),
+        (GLsizei )bswap_CARD32 ( pc + 52 ),
+        (GLsizei )bswap_CARD32 ( pc + 56 ),
+        pixels );
 
     CALL_TexImage3D( GET_DISPATCH(), (
          (GLenum  )bswap_ENUM   ( pc + 36 ),
@@ -3714,7 +3784,6 @@ void __glXDispSwap_TexSubImage3D(GLbyte * pc)
     const GLvoid * const pixels = (const GLvoid *) (pc + 88);
     __GLXpixel3DHeader * const hdr = (__GLXpixel3DHeader *)(pc);
 
-    CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SWAP_BYTES,   hdr->swapBytes) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_LSB_FIRST,    hdr->lsbFirst) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ROW_LENGTH,   (GLint) bswap_CARD32( & hdr->rowLength )) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_IMAGE_HEIGHT, (GLint) bswap_CARD32( & hdr->imageHeight )) );
@@ -3722,6 +3791,14 @@ void __glXDispSwap_TexSubImage3D(GLbyte * pc)
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_IMAGES,  (GLint) bswap_CARD32( & hdr->skipImages )) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_SKIP_PIXELS,  (GLint) bswap_CARD32( & hdr->skipPixels )) );
     CALL_PixelStorei( GET_DISPATCH(), (GL_UNPACK_ALIGNMENT,    (GLint) bswap_CARD32( & hdr->alignment )) );
+    __glXUnpackSwapPixels( hdr->swapBytes,
+        (GLenum  )bswap_ENUM   ( pc + 36 ),
+        (GLenum  )bswap_ENUM   ( pc + 76 ),
+        (GLenum  )bswap_ENUM   ( pc + 80 ),
+        (GLsizei )bswap_CARD32 ( pc + 60 ),
+        (GLsizei )bswap_CARD32 ( pc + 64 ),
+        (GLsizei )bswap_CARD32 ( pc + 68 ),
+        pixels );
 
     CALL_TexSubImage3D( GET_DISPATCH(), (
          (GLenum  )bswap_ENUM   ( pc + 36 ),
@@ -62,6 +62,191 @@ __glGetBooleanv_variable_size(GLenum e)
     }
 }
 
+/**
+ * Make sure the client's reply buffer has room for \c size bytes.
+ *
+ * The buffer is shared by every reply too large for the stack.  It only
+ * grows, to a power of two of at least a page so that readbacks of slowly
+ * growing sizes don't reallocate each time, and its contents are not kept.
+ */
+GLbyte *
+__glXReserveReturnBuffer(__GLXclientState * cl, size_t size)
+{
+    size_t alloc_size = 4096;
+
+    if (size <= (size_t) cl->returnBufSize)
+        return cl->returnBuf;
+
+    if (size > INT_MAX)
+        return NULL;
+
+    while (alloc_size < size)
+        alloc_size <<= 1;
+    if (alloc_size > INT_MAX)
+        alloc_size = size;
+
+    free(cl->returnBuf);
+    cl->returnBuf = malloc(alloc_size);
+    cl->returnBufSize = cl->returnBuf ? alloc_size : 0;
+    return cl->returnBuf;
+}
+
+/**
+ * Size of the elements whose bytes \c GL_PACK_SWAP_BYTES reverses for
+ * pixels of \c type, or 0 if the swapping must be left to GL.
+ */
+unsigned
+__glXPixelSwapSize(GLenum type)
+{
+    switch (type) {
+    case GL_UNSIGNED_BYTE:
+    case GL_BYTE:
+    case GL_UNSIGNED_BYTE_3_3_2:
+    case GL_UNSIGNED_BYTE_2_3_3_REV:
+        return 1;
+    case GL_UNSIGNED_SHORT:
+    case GL_SHORT:
+    case GL_HALF_FLOAT:
+    case GL_UNSIGNED_SHORT_5_6_5:
+    case GL_UNSIGNED_SHORT_5_6_5_REV:
+    case GL_UNSIGNED_SHORT_4_4_4_4:
+    case GL_UNSIGNED_SHORT_4_4_4_4_REV:
+    case GL_UNSIGNED_SHORT_5_5_5_1:
+    case GL_UNSIGNED_SHORT_1_5_5_5_REV:
+        return 2;
+    case GL_UNSIGNED_INT:
+    case GL_INT:
+    case GL_FLOAT:
+    case GL_UNSIGNED_INT_8_8_8_8:
+    case GL_UNSIGNED_INT_8_8_8_8_REV:
+    case GL_UNSIGNED_INT_10_10_10_2:
+    case GL_UNSIGNED_INT_2_10_10_10_REV:
+    case GL_UNSIGNED_INT_24_8:
+    case GL_UNSIGNED_INT_10F_11F_11F_REV:
+    case GL_UNSIGNED_INT_5_9_9_9_REV:
+    case GL_FLOAT_32_UNSIGNED_INT_24_8_REV:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+
+static inline __m128i
+swap_16x8(__m128i v)
+{
+    return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+static inline __m128i
+swap_32x4(__m128i v)
+{
+    v = swap_16x8(v);
+    v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+}
+
+#define SWAP_PIXELS_SSE2(swap)                                  \
+    for (; i + 64 <= size; i += 64) {                           \
+        __m128i *q = (__m128i *) (p + i);                       \
+        __m128i v0 = _mm_loadu_si128(q + 0);                    \
+        __m128i v1 = _mm_loadu_si128(q + 1);                    \
+        __m128i v2 = _mm_loadu_si128(q + 2);                    \
+        __m128i v3 = _mm_loadu_si128(q + 3);                    \
+        _mm_storeu_si128(q + 0, swap(v0));                      \
+        _mm_storeu_si128(q + 1, swap(v1));                      \
+        _mm_storeu_si128(q + 2, swap(v2));                      \
+        _mm_storeu_si128(q + 3, swap(v3));                      \
+    }                                                           \
+    for (; i + 16 <= size; i += 16) {                           \
+        __m128i *q = (__m128i *) (p + i);                       \
+        _mm_storeu_si128(q, swap(_mm_loadu_si128(q)));          \
+    }
+#else
+#define SWAP_PIXELS_SSE2(swap)
+#endif
+
+/**
+ * Reverse the bytes of each \c swapSize (2 or 4) byte element in the
+ * \c size bytes at \c data, which need not be aligned.  A partial element
+ * at the end is left alone.
+ */
+void
+__glXSwapPixelData(void *data, size_t size, unsigned swapSize)
+{
+    GLubyte *p = data;
+    size_t i = 0;
+
+    if (swapSize == 2) {
+        SWAP_PIXELS_SSE2(swap_16x8);
+        for (; i + 2 <= size; i += 2) {
+            uint16_t v;
+
+            memcpy(&v, p + i, 2);
+            v = bswap_16(v);
+            memcpy(p + i, &v, 2);
+        }
+    }
+    else if (swapSize == 4) {
+        SWAP_PIXELS_SSE2(swap_32x4);
+        for (; i + 4 <= size; i += 4) {
+            uint32_t v;
+
+            memcpy(&v, p + i, 4);
+            v = bswap_32(v);
+            memcpy(p + i, &v, 4);
+        }
+    }
+}
+
+/**
+ * Set \c GL_UNPACK_SWAP_BYTES for the image at \c pixels in a render
+ * command, after the rest of the unpack state.
+ *
+ * Pixels GL unpacks byte-swapped take Mesa off its direct texture upload
+ * paths.  If the client asked for swapping and the type is one
+ * __glXSwapPixelData handles, the image is swapped in the request instead
+ * and GL unpacks it as it is.  \c d is 0 for images that aren't 3D.
+ */
+void
+__glXUnpackSwapPixels(GLboolean swapBytes, GLenum target, GLenum format,
+                      GLenum type, GLsizei w, GLsizei h, GLsizei d,
+                      const GLvoid * pixels)
+{
+    GLint rowLength, skipPixels, skipRows, alignment;
+    GLint imageHeight = 0, skipImages = 0;
+    unsigned swapSize = swapBytes ? __glXPixelSwapSize(type) : 0;
+    int size;
+
+    if (swapSize > 1 && pixels != NULL) {
+        glGetIntegerv(GL_UNPACK_ROW_LENGTH, &rowLength);
+        glGetIntegerv(GL_UNPACK_SKIP_PIXELS, &skipPixels);
+        glGetIntegerv(GL_UNPACK_SKIP_ROWS, &skipRows);
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+        if (d > 0) {
+            glGetIntegerv(GL_UNPACK_IMAGE_HEIGHT, &imageHeight);
+            glGetIntegerv(GL_UNPACK_SKIP_IMAGES, &skipImages);
+        }
+
+        /* The request was checked to hold size bytes, which doesn't
+         * include skipped pixels past the end of the last row.
+         */
+        size = __glXImageSize(format, type, target, w, h, d > 0 ? d : 1,
+                              imageHeight, rowLength, skipImages, skipRows,
+                              alignment);
+        if (size > 0 && skipPixels >= 0 &&
+            skipPixels <= (rowLength > 0 ? rowLength : w) - w)
+            __glXSwapPixelData((GLvoid *) pixels, size, swapSize);
+        else
+            swapSize = 0;
+    }
+
+    glPixelStorei(GL_UNPACK_SWAP_BYTES, swapBytes && !swapSize);
+}
+
 /**
  * Get a properly aligned buffer to hold reply data.
  *
@@ -85,15 +270,8 @@ __glXGetAnswerBuffer(__GLXclientState * cl, size_t required_size,
         else
             return NULL;
 
-        if (cl->returnBufSize < worst_case_size) {
-            void *temp = realloc(cl->returnBuf, worst_case_size);
-
-            if (temp == NULL) {
-                return NULL;
-            }
-
-            cl->returnBuf = temp;
-            cl->returnBufSize = worst_case_size;
+        if (__glXReserveReturnBuffer(cl, worst_case_size) == NULL) {
+            return NULL;
         }
 
         temp_buf = (intptr_t) cl->returnBuf;
@@ -260,6 +438,13 @@ get_decode_index(const struct __glXDispatchInfo *dispatch_info, unsigned opcode)
     return -1;
 }
 
+int
+__glXGetProtocolDecodeIndex(const struct __glXDispatchInfo *dispatch_info,
+                            int opcode)
+{
+    return get_decode_index(dispatch_info, opcode);
+}
+
 void *
 __glXGetProtocolDecodeFunction(const struct __glXDispatchInfo *dispatch_info,
                                int opcode, int swapped_version)
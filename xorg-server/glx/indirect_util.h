@@ -42,6 +42,13 @@ extern void __glXSendReplySwap(ClientPtr client, const void *data,
 
 struct __glXDispatchInfo;
 
+/**
+ * Index of \c opcode in the \c dispatch_functions and \c size_table of
+ * \c dispatch_info, or -1 if the opcode is not supported.
+ */
+extern int __glXGetProtocolDecodeIndex(const struct __glXDispatchInfo
+                                       *dispatch_info, int opcode);
+
 extern void *__glXGetProtocolDecodeFunction(const struct __glXDispatchInfo
                                             *dispatch_info, int opcode,
                                             int swapped_version);
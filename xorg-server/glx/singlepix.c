@@ -49,6 +49,7 @@ __glXDisp_ReadPixels(__GLXclientState * cl, GLbyte * pc)
     GLenum format, type;
     GLboolean swapBytes, lsbFirst;
     GLint compsize;
+    unsigned swapSize;
     __GLXcontext *cx;
     ClientPtr client = cl->client;
     int error;
@@ -73,7 +74,8 @@ __glXDisp_ReadPixels(__GLXclientState * cl, GLbyte * pc)
     if (compsize < 0)
         return BadLength;
 
-    glPixelStorei(GL_PACK_SWAP_BYTES, swapBytes);
+    swapSize = swapBytes ? __glXPixelSwapSize(type) : 0;
+    glPixelStorei(GL_PACK_SWAP_BYTES, swapBytes && !swapSize);
     glPixelStorei(GL_PACK_LSB_FIRST, lsbFirst);
     __GLX_GET_ANSWER_BUFFER(answer, cl, compsize, 1);
     __glXClearErrorOccured();
@@ -86,6 +88,8 @@ __glXDisp_ReadPixels(__GLXclientState * cl, GLbyte * pc)
         __GLX_SEND_HEADER();
     }
     else {
+        if (swapSize > 1)
+            __glXSwapPixelData(answer, compsize, swapSize);
         __GLX_BEGIN_REPLY(compsize);
         __GLX_SEND_HEADER();
         __GLX_SEND_VOID_ARRAY(compsize);
@@ -99,6 +103,7 @@ __glXDisp_GetTexImage(__GLXclientState * cl, GLbyte * pc)
     GLint level, compsize;
     GLenum format, type, target;
     GLboolean swapBytes;
+    unsigned swapSize;
     __GLXcontext *cx;
     ClientPtr client = cl->client;
     int error;
@@ -134,7 +139,8 @@ __glXDisp_GetTexImage(__GLXclientState * cl, GLbyte * pc)
     if (compsize < 0)
         return BadLength;
 
-    glPixelStorei(GL_PACK_SWAP_BYTES, swapBytes);
+    swapSize = swapBytes ? __glXPixelSwapSize(type) : 0;
+    glPixelStorei(GL_PACK_SWAP_BYTES, swapBytes && !swapSize);
     __GLX_GET_ANSWER_BUFFER(answer, cl, compsize, 1);
     __glXClearErrorOccured();
     glGetTexImage(*(GLenum *) (pc + 0), *(GLint *) (pc + 4),
@@ -145,6 +151,8 @@ __glXDisp_GetTexImage(__GLXclientState * cl, GLbyte * pc)
         __GLX_SEND_HEADER();
     }
     else {
+        if (swapSize > 1)
+            __glXSwapPixelData(answer, compsize, swapSize);
         __GLX_BEGIN_REPLY(compsize);
         ((xGLXGetTexImageReply *) &reply)->width = width;
         ((xGLXGetTexImageReply *) &reply)->height = height;
@@ -49,6 +49,7 @@ __glXDispSwap_ReadPixels(__GLXclientState * cl, GLbyte * pc)
     GLenum format, type;
     GLboolean swapBytes, lsbFirst;
     GLint compsize;
+    unsigned swapSize;
 
     __GLX_DECLARE_SWAP_VARIABLES;
     __GLXcontext *cx;
@@ -83,7 +84,8 @@ __glXDispSwap_ReadPixels(__GLXclientState * cl, GLbyte * pc)
     if (compsize < 0)
         return BadLength;
 
-    glPixelStorei(GL_PACK_SWAP_BYTES, !swapBytes);
+    swapSize = !swapBytes ? __glXPixelSwapSize(type) : 0;
+    glPixelStorei(GL_PACK_SWAP_BYTES, !swapBytes && !swapSize);
     glPixelStorei(GL_PACK_LSB_FIRST, lsbFirst);
     __GLX_GET_ANSWER_BUFFER(answer, cl, compsize, 1);
     __glXClearErrorOccured();
@@ -97,6 +99,8 @@ __glXDispSwap_ReadPixels(__GLXclientState * cl, GLbyte * pc)
         __GLX_SEND_HEADER();
     }
     else {
+        if (swapSize > 1)
+            __glXSwapPixelData(answer, compsize, swapSize);
         __GLX_BEGIN_REPLY(compsize);
         __GLX_SWAP_REPLY_HEADER();
         __GLX_SEND_HEADER();
@@ -111,6 +115,7 @@ __glXDispSwap_GetTexImage(__GLXclientState * cl, GLbyte * pc)
     GLint level, compsize;
     GLenum format, type, target;
     GLboolean swapBytes;
+    unsigned swapSize;
 
     __GLX_DECLARE_SWAP_VARIABLES;
     __GLXcontext *cx;
@@ -154,7 +159,8 @@ __glXDispSwap_GetTexImage(__GLXclientState * cl, GLbyte * pc)
     if (compsize < 0)
         return BadLength;
 
-    glPixelStorei(GL_PACK_SWAP_BYTES, !swapBytes);
+    swapSize = !swapBytes ? __glXPixelSwapSize(type) : 0;
+    glPixelStorei(GL_PACK_SWAP_BYTES, !swapBytes && !swapSize);
     __GLX_GET_ANSWER_BUFFER(answer, cl, compsize, 1);
     __glXClearErrorOccured();
     glGetTexImage(*(GLenum *) (pc + 0), *(GLint *) (pc + 4),
@@ -166,6 +172,8 @@ __glXDispSwap_GetTexImage(__GLXclientState * cl, GLbyte * pc)
         __GLX_SEND_HEADER();
     }
     else {
+        if (swapSize > 1)
+            __glXSwapPixelData(answer, compsize, swapSize);
         __GLX_BEGIN_REPLY(compsize);
         __GLX_SWAP_REPLY_HEADER();
         __GLX_SWAP_INT(&width);
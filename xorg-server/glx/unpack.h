@@ -79,13 +79,8 @@
     if (size < 0) return BadLength;                                      \
     else if ((size) > sizeof(answerBuffer)) {				 \
 	int bump;							 \
-	if ((cl)->returnBufSize < (size)+(align)) {			 \
-	    (cl)->returnBuf = (GLbyte*)realloc((cl)->returnBuf,	 	 \
-						(size)+(align));         \
-	    if (!(cl)->returnBuf) {					 \
-		return BadAlloc;					 \
-	    }								 \
-	    (cl)->returnBufSize = (size)+(align);			 \
+	if (!__glXReserveReturnBuffer(cl, (size)+(align))) {		 \
+	    return BadAlloc;						 \
 	}								 \
 	res = (char*)cl->returnBuf;					 \
 	bump = (long)(uintptr_t)(res) % (align);					 \
@@ -73,6 +73,11 @@ from The Open Group.
 #include "miline.h"
 #include "glx_extinit.h"
 #include "randrstr.h"
+#if defined(HAVE_MMAP) && defined(HAVE_MEMFD_CREATE)
+#define VFB_MEMFD
+#include "damage.h"
+#include "vfbring.h"
+#endif
 
 #define VFB_DEFAULT_WIDTH      1280
 #define VFB_DEFAULT_HEIGHT     1024
@@ -81,6 +86,7 @@ from The Open Group.
 #define VFB_DEFAULT_BLACKPIXEL    0
 #define VFB_DEFAULT_LINEBIAS      0
 #define XWD_WINDOW_NAME_LEN      60
+#define VFB_RING_RECTS         4096
 
 typedef struct {
     int width;
@@ -107,6 +113,15 @@ typedef struct {
 #ifdef MITSHM
     int shmid;
 #endif
+
+#ifdef VFB_MEMFD
+    int memfd;
+    size_t memfdSize;
+    VfbRingHeader *ring;
+    DamagePtr pDamage;
+    CreateScreenResourcesProcPtr createScreenResources;
+    ScreenBlockHandlerProcPtr blockHandler;
+#endif
 } vfbScreenInfo, *vfbScreenInfoPtr;
 
 static int vfbNumScreens;
@@ -126,7 +141,8 @@ static Bool vfbPixmapDepths[33];
 #ifdef HAVE_MMAP
 static char *pfbdir = NULL;
 #endif
-typedef enum { NORMAL_MEMORY_FB, SHARED_MEMORY_FB, MMAPPED_FILE_FB } fbMemType;
+typedef enum { NORMAL_MEMORY_FB, SHARED_MEMORY_FB, MMAPPED_FILE_FB,
+    MEMFD_FB } fbMemType;
 static fbMemType fbmemtype = NORMAL_MEMORY_FB;
 static char needswap = 0;
 static Bool Render = TRUE;
@@ -191,6 +207,18 @@ freeScreenInfo(vfbScreenInfoPtr pvfb)
         break;
 #endif                          /* MITSHM */
 
+#ifdef VFB_MEMFD
+    case MEMFD_FB:
+        if (pvfb->ring) {
+            munmap(pvfb->ring, pvfb->memfdSize);
+            close(pvfb->memfd);
+        }
+        break;
+#else
+    case MEMFD_FB:
+        break;
+#endif
+
     case NORMAL_MEMORY_FB:
         free(pvfb->pXWDHeader);
         break;
@@ -261,6 +289,10 @@ ddxUseMsg(void)
 #ifdef MITSHM
     ErrorF("-shmem                 put framebuffers in shared memory\n");
 #endif
+
+#ifdef VFB_MEMFD
+    ErrorF("-memfd                 put framebuffers and a damage ring in memfds\n");
+#endif
 }
 
 int
@@ -381,6 +413,13 @@ ddxProcessArgument(int argc, char *argv[], int i)
     }
 #endif
 
+#ifdef VFB_MEMFD
+    if (strcmp(argv[i], "-memfd") == 0) {       /* -memfd */
+        fbmemtype = MEMFD_FB;
+        return 1;
+    }
+#endif
+
     return 0;
 }
 
@@ -571,6 +610,152 @@ vfbAllocateSharedMemoryFramebuffer(vfbScreenInfoPtr pvfb)
 }
 #endif                          /* MITSHM */
 
+#ifdef VFB_MEMFD
+/*
+ * The memfd holds the damage ring described in vfbring.h followed by the
+ * framebuffer, page aligned.
+ */
+static void
+vfbAllocateMemfdFramebuffer(vfbScreenInfoPtr pvfb)
+{
+    int screen = (int) (pvfb - vfbScreens);
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t ringSize;
+    char name[64];
+    char *map;
+
+    ringSize = sizeof(VfbRingHeader) + VFB_RING_RECTS * sizeof(VfbRingRect);
+    ringSize = (ringSize + page - 1) & ~(page - 1);
+    pvfb->memfdSize = ringSize + pvfb->sizeInBytes;
+
+    snprintf(name, sizeof(name), "Xvfb:%s.%d", display, screen);
+    pvfb->memfd = memfd_create(name, MFD_CLOEXEC);
+    if (pvfb->memfd == -1) {
+        ErrorF("memfd_create failed, %s\n", strerror(errno));
+        return;
+    }
+    if (ftruncate(pvfb->memfd, pvfb->memfdSize) == -1) {
+        ErrorF("ftruncate memfd failed, %s\n", strerror(errno));
+        close(pvfb->memfd);
+        return;
+    }
+
+    map = mmap(NULL, pvfb->memfdSize, PROT_READ | PROT_WRITE, MAP_SHARED,
+               pvfb->memfd, 0);
+    if (map == MAP_FAILED) {
+        ErrorF("mmap memfd failed, %s\n", strerror(errno));
+        close(pvfb->memfd);
+        return;
+    }
+
+    pvfb->ring = (VfbRingHeader *) map;
+    pvfb->ring->magic = VFB_RING_MAGIC;
+    pvfb->ring->version = VFB_RING_VERSION;
+    pvfb->ring->rects_offset = sizeof(VfbRingHeader);
+    pvfb->ring->num_rects = VFB_RING_RECTS;
+    pvfb->ring->fb_offset = ringSize;
+    pvfb->ring->fb_size = pvfb->sizeInBytes;
+    pvfb->pXWDHeader = (XWDFileHeader *) (map + ringSize);
+
+    ErrorF("screen %d memfd /proc/%ld/fd/%d\n", screen, (long) getpid(),
+           pvfb->memfd);
+}
+
+/* Append what was drawn since the last time to the ring */
+static void
+vfbRingUpdate(ScreenPtr pScreen)
+{
+    vfbScreenInfoPtr pvfb = &vfbScreens[pScreen->myNum];
+    VfbRingHeader *ring = pvfb->ring;
+    VfbRingRect *rects = (VfbRingRect *) ((char *) ring + ring->rects_offset);
+    RegionPtr pRegion = DamageRegion(pvfb->pDamage);
+    uint64_t seq = ring->seq;
+    BoxPtr pbox;
+    int nbox;
+
+    if (!RegionNotEmpty(pRegion))
+        return;
+
+    nbox = RegionNumRects(pRegion);
+    pbox = RegionRects(pRegion);
+    /* The consumer would have to copy everything anyway */
+    if (nbox > ring->num_rects) {
+        nbox = 1;
+        pbox = RegionExtents(pRegion);
+    }
+
+    ring->width = pScreen->width;
+    ring->height = pScreen->height;
+    for (; nbox--; pbox++, seq++) {
+        VfbRingRect *rect = &rects[seq & (ring->num_rects - 1)];
+
+        /* Invalidate the entry while it is rewritten */
+        __atomic_store_n(&rect->seq, 0, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        rect->x = pbox->x1;
+        rect->y = pbox->y1;
+        rect->width = pbox->x2 - pbox->x1;
+        rect->height = pbox->y2 - pbox->y1;
+        __atomic_store_n(&rect->seq, seq + 1, __ATOMIC_RELEASE);
+    }
+    ring->frames++;
+    __atomic_store_n(&ring->seq, seq, __ATOMIC_RELEASE);
+
+    DamageEmpty(pvfb->pDamage);
+}
+
+static void
+vfbRingBlockHandler(ScreenPtr pScreen, void *timeout)
+{
+    vfbScreenInfoPtr pvfb = &vfbScreens[pScreen->myNum];
+
+    pScreen->BlockHandler = pvfb->blockHandler;
+    (*pScreen->BlockHandler) (pScreen, timeout);
+    pScreen->BlockHandler = vfbRingBlockHandler;
+
+    vfbRingUpdate(pScreen);
+}
+
+/*
+ * Replies are written as soon as a client's requests run out, which can be
+ * long before the server sleeps; update the ring first so that a client
+ * never hears back before the ring holds what it drew.
+ */
+static void
+vfbRingFlushCallback(CallbackListPtr *pcbl, void *closure, void *data)
+{
+    vfbRingUpdate(closure);
+}
+
+static Bool
+vfbCreateScreenResources(ScreenPtr pScreen)
+{
+    vfbScreenInfoPtr pvfb = &vfbScreens[pScreen->myNum];
+    Bool ret;
+
+    pScreen->CreateScreenResources = pvfb->createScreenResources;
+    ret = (*pScreen->CreateScreenResources) (pScreen);
+    pScreen->CreateScreenResources = vfbCreateScreenResources;
+    if (!ret)
+        return FALSE;
+
+    pvfb->pDamage = DamageCreate(NULL, NULL, DamageReportNone, TRUE,
+                                 pScreen, pScreen);
+    if (!pvfb->pDamage)
+        return FALSE;
+    DamageSetMaxBoxes(pvfb->pDamage, damageMaxBoxes);
+    DamageRegister(&(*pScreen->GetScreenPixmap) (pScreen)->drawable,
+                   pvfb->pDamage);
+
+    if (!AddCallback(&FlushCallback, vfbRingFlushCallback, pScreen))
+        return FALSE;
+
+    pvfb->blockHandler = pScreen->BlockHandler;
+    pScreen->BlockHandler = vfbRingBlockHandler;
+    return TRUE;
+}
+#endif                          /* VFB_MEMFD */
+
 static char *
 vfbAllocateFramebufferMemory(vfbScreenInfoPtr pvfb)
 {
@@ -621,6 +806,15 @@ vfbAllocateFramebufferMemory(vfbScreenInfoPtr pvfb)
         break;
 #endif
 
+#ifdef VFB_MEMFD
+    case MEMFD_FB:
+        vfbAllocateMemfdFramebuffer(pvfb);
+        break;
+#else
+    case MEMFD_FB:
+        break;
+#endif
+
     case NORMAL_MEMORY_FB:
         pvfb->pXWDHeader = (XWDFileHeader *) malloc(pvfb->sizeInBytes);
         break;
@@ -726,6 +920,15 @@ vfbCloseScreen(ScreenPtr pScreen)
 
     pScreen->CloseScreen = pvfb->closeScreen;
 
+#ifdef VFB_MEMFD
+    if (pvfb->pDamage) {
+        pScreen->BlockHandler = pvfb->blockHandler;
+        DeleteCallback(&FlushCallback, vfbRingFlushCallback, pScreen);
+        DamageDestroy(pvfb->pDamage);
+        pvfb->pDamage = NULL;
+    }
+#endif
+
     /*
      * fb overwrites miCloseScreen, so do this here
      */
@@ -962,6 +1165,25 @@ vfbScreenInit(ScreenPtr pScreen, int argc, char **argv)
     pvfb->closeScreen = pScreen->CloseScreen;
     pScreen->CloseScreen = vfbCloseScreen;
 
+#ifdef VFB_MEMFD
+    if (pvfb->ring) {
+        VfbRingHeader *ring = pvfb->ring;
+
+        if (!DamageSetup(pScreen))
+            return FALSE;
+
+        ring->pixels_offset = pvfb->pfbMemory - (char *) pvfb->pXWDHeader;
+        ring->stride = pvfb->paddedBytesWidth;
+        ring->width = pvfb->width;
+        ring->height = pvfb->height;
+        ring->depth = pvfb->depth;
+        ring->bits_per_pixel = pvfb->bitsPerPixel;
+
+        pvfb->createScreenResources = pScreen->CreateScreenResources;
+        pScreen->CreateScreenResources = vfbCreateScreenResources;
+    }
+#endif
+
     return ret;
 
 }                               /* end vfbScreenInit */
@@ -0,0 +1,79 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef VFBRING_H
+#define VFBRING_H
+
+#include <stdint.h>
+
+/*
+ * Layout of the memfd Xvfb -memfd puts each screen in, for use by
+ * programs that read the framebuffer directly.  The file is named
+ * "Xvfb:<display>.<screen>" and can be opened by other processes of the
+ * same user through /proc/<pid>/fd/<fd>, which the server prints.
+ *
+ * The file starts with a VfbRingHeader followed by a ring of rects damaged
+ * on the screen, padded to fb_offset where the framebuffer follows in xwd
+ * format, exactly as with -fbdir.
+ *
+ * Every time the server writes to a client or is about to sleep it appends
+ * the rects drawn since it last did so, so what a request drew is in the
+ * ring by the time its reply arrives: entry n goes in rects[n % num_rects],
+ * its seq is set to n + 1 and finally the header's seq is set to the number
+ * of rects ever appended, with release semantics.  A consumer that has
+ * copied the rects up to last reads seq with acquire semantics, then copies
+ * the pixels of rects [last, seq).  If seq - last exceeds num_rects, or an
+ * entry's seq does not match after its rect was read, the ring has wrapped
+ * under the consumer and it must copy the whole screen instead.
+ *
+ * width and height are the current screen size, which RandR can shrink
+ * below the size of the framebuffer; stride does not change.
+ */
+
+#define VFB_RING_MAGIC          0x58766652      /* "XvfR" */
+#define VFB_RING_VERSION        1
+
+typedef struct {
+    uint64_t seq;
+    int16_t x;
+    int16_t y;
+    uint16_t width;
+    uint16_t height;
+} VfbRingRect;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t rects_offset;
+    uint32_t num_rects;         /* a power of two */
+    uint64_t fb_offset;         /* of the xwd header */
+    uint64_t fb_size;
+    uint32_t pixels_offset;     /* from fb_offset */
+    uint32_t stride;
+    uint32_t width;
+    uint32_t height;
+    uint32_t depth;
+    uint32_t bits_per_pixel;
+    uint64_t frames;            /* updates published */
+    uint64_t seq;               /* rects published */
+} VfbRingHeader;
+
+#endif                          /* VFBRING_H */
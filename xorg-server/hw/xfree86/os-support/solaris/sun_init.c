@@ -39,6 +39,7 @@
 #include <sys/kd.h>
 #endif
 
+#include "dix/reqstats_priv.h"
 #include "os/osdep.h"
 
 /*
@@ -214,6 +215,10 @@ xf86OpenConsole(void)
             if (ioctl(xf86Info.consoleFd, VT_GETMODE, &VT) < 0)
                 FatalError("xf86OpenConsole: VT_GETMODE failed\n");
 
+            /* SIGUSR2 releases the VT from here on, not a stats dump */
+            if (reqStatsDumpSignal == SIGUSR2 || reqStatsDumpSignal == SIGUSR1)
+                reqStatsDumpSignal = 0;
+
             OsSignal(SIGUSR1, xf86VTAcquire);
             OsSignal(SIGUSR2, xf86VTRelease);
 
@@ -111,6 +111,7 @@ typedef struct _Client {
     DeviceIntPtr clientPtr;
     ClientIdPtr clientIds;
     int req_fds;
+    struct _ReqStats *reqStats;  /* see dix/reqstats_priv.h */
 } ClientRec;
 
 typedef struct _WorkQueue {
@@ -23,6 +23,8 @@ extern _X_EXPORT Bool screenSaverSuspended;
 extern _X_EXPORT const char *defaultFontPath;
 extern _X_EXPORT int monitorResolution;
 extern _X_EXPORT int defaultColorVisualClass;
+extern _X_EXPORT int damageMaxBoxes;
+extern _X_EXPORT int shadowTileThreads;
 
 extern _X_EXPORT int GrabInProgress;
 extern _X_EXPORT Bool noTestExtensions;
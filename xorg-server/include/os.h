@@ -109,6 +109,9 @@ extern _X_EXPORT void SetCriticalOutputPending(void);
 extern _X_EXPORT int WriteToClient(ClientPtr /*who */ , int /*count */ ,
                                    const void * /*buf */ );
 
+extern _X_EXPORT int WriteToClientNoCopy(ClientPtr /*who */ , int /*count */ ,
+                                         void ** /*buf */ );
+
 extern _X_EXPORT void ResetOsBuffers(void);
 
 extern _X_EXPORT int TransIsListening(char *protocol);
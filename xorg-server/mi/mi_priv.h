@@ -6,7 +6,18 @@
 #define _XSERVER_MI_PRIV_H
 
 #include "screenint.h"
+#include "window.h"
 
 void miScreenClose(ScreenPtr pScreen);
 
+/* miwinindex.c */
+
+typedef Bool (*miWindowHitProcPtr) (WindowPtr pWin, int x, int y);
+
+void miWindowIndexInit(void);
+void miWindowIndexInvalidate(WindowPtr pWin);
+void miWindowIndexUpdate(WindowPtr pWin);
+Bool miWindowIndexLookup(ScreenPtr pScreen, int x, int y,
+                         miWindowHitProcPtr hit, WindowPtr *ppWin);
+
 #endif /* _XSERVER_MI_PRIV_H */
@@ -749,14 +749,53 @@ tailX(double K,
     return xs[0];
 }
 
+/*
+ * The span outline of a wide arc only depends on its size and the line
+ * width, and clients tend to draw the same few shapes every frame, so the
+ * last ARC_CACHE_SIZE outlines computed are kept.  Outlines are lent to
+ * the caller until its next call to miComputeWideEllipse(), which may
+ * reuse their slot, and must not be freed.  Outlines of more than
+ * ARC_CACHE_MAX_SPANS spans aren't cached but still lent the same way.
+ */
+
+#define ARC_CACHE_SIZE		16
+#define ARC_CACHE_MAX_SPANS	1024
+
+typedef struct {
+    unsigned short width, height;
+    int lw;
+    unsigned int used;
+    miArcSpanData *spdata;
+} miArcCacheEntry;
+
+static miArcCacheEntry arcCache[ARC_CACHE_SIZE];
+static unsigned int arcCacheClock;
+static miArcSpanData *arcUncached;
+
 static miArcSpanData *
 miComputeWideEllipse(int lw, xArc * parc)
 {
+    miArcCacheEntry *entry, *lru;
     miArcSpanData *spdata = NULL;
-    int k;
+    int k, i;
 
     if (!lw)
         lw = 1;
+
+    free(arcUncached);
+    arcUncached = NULL;
+    lru = &arcCache[0];
+    for (i = 0; i < ARC_CACHE_SIZE; i++) {
+        entry = &arcCache[i];
+        if (entry->spdata && entry->width == parc->width &&
+            entry->height == parc->height && entry->lw == lw) {
+            entry->used = ++arcCacheClock;
+            return entry->spdata;
+        }
+        if (!entry->spdata || (lru->spdata && entry->used < lru->used))
+            lru = entry;
+    }
+
     k = (parc->height >> 1) + ((lw - 1) >> 1);
     spdata = malloc(sizeof(miArcSpanData) + sizeof(miArcSpan) * (k + 2));
     if (!spdata)
@@ -769,32 +808,42 @@ miComputeWideEllipse(int lw, xArc * parc)
         miComputeCircleSpans(lw, parc, spdata);
     else
         miComputeEllipseSpans(lw, parc, spdata);
+
+    if (k + 2 > ARC_CACHE_MAX_SPANS) {
+        arcUncached = spdata;
+        return spdata;
+    }
+    free(lru->spdata);
+    lru->width = parc->width;
+    lru->height = parc->height;
+    lru->lw = lw;
+    lru->used = ++arcCacheClock;
+    lru->spdata = spdata;
     return spdata;
 }
 
-static void
-miFillWideEllipse(DrawablePtr pDraw, GCPtr pGC, xArc * parc)
+/* At most this many spans for one ellipse */
+#define WIDE_ELLIPSE_SPANS(pGC, parc) \
+    (2 * ((int) (parc)->height + (int) (pGC)->lineWidth))
+
+/*
+ * Store the spans of a full wide ellipse in points and widths, which must
+ * have room for WIDE_ELLIPSE_SPANS of them, and return how many there are.
+ */
+static int
+miWideEllipseSpans(DrawablePtr pDraw, GCPtr pGC, xArc * parc,
+                   DDXPointPtr points, int *widths)
 {
-    DDXPointPtr points;
     DDXPointPtr pts;
-    int *widths;
     int *wids;
     miArcSpanData *spdata;
     miArcSpan *span;
     int xorg, yorgu, yorgl;
     int n;
 
-    yorgu = parc->height + pGC->lineWidth;
-    n = (sizeof(int) * 2) * yorgu;
-    widths = malloc(n + (sizeof(DDXPointRec) * 2) * yorgu);
-    if (!widths)
-        return;
-    points = (DDXPointPtr) ((char *) widths + n);
     spdata = miComputeWideEllipse((int) pGC->lineWidth, parc);
-    if (!spdata) {
-        free(widths);
-        return;
-    }
+    if (!spdata)
+        return 0;
     pts = points;
     wids = widths;
     span = spdata->spans;
@@ -873,9 +922,49 @@ miFillWideEllipse(DrawablePtr pDraw, GCPtr pGC, xArc * parc)
             wids += 2;
         }
     }
-    free(spdata);
-    (*pGC->ops->FillSpans) (pDraw, pGC, pts - points, points, widths, FALSE);
+    return pts - points;
+}
 
+/*
+ * Fill a run of full wide ellipses, handing their spans to FillSpans in
+ * batches of about ELLIPSE_SPAN_BATCH rather than one call per ellipse.
+ * FillSpans draws every span it is given in turn, so this is the same as
+ * drawing the ellipses one at a time, whatever the rop.
+ */
+
+#define ELLIPSE_SPAN_BATCH	8192
+
+static void
+miFillWideEllipses(DrawablePtr pDraw, GCPtr pGC, int narcs, xArc * parcs)
+{
+    DDXPointPtr points;
+    int *widths;
+    int size = ELLIPSE_SPAN_BATCH;
+    int i, n;
+
+    for (i = 0; i < narcs; i++)
+        size = max(size, WIDE_ELLIPSE_SPANS(pGC, &parcs[i]));
+    points = xallocarray(size, sizeof(DDXPointRec));
+    widths = xallocarray(size, sizeof(int));
+    if (!points || !widths) {
+        free(points);
+        free(widths);
+        return;
+    }
+
+    n = 0;
+    for (i = 0; i < narcs; i++) {
+        if (n + WIDE_ELLIPSE_SPANS(pGC, &parcs[i]) > size) {
+            (*pGC->ops->FillSpans) (pDraw, pGC, n, points, widths, FALSE);
+            n = 0;
+        }
+        n += miWideEllipseSpans(pDraw, pGC, &parcs[i],
+                                points + n, widths + n);
+    }
+    if (n)
+        (*pGC->ops->FillSpans) (pDraw, pGC, n, points, widths, FALSE);
+
+    free(points);
     free(widths);
 }
 
@@ -911,23 +1000,23 @@ miWideArc(DrawablePtr pDraw, GCPtr pGC, int narcs, xArc * parcs)
     int halfWidth;
 
     if (width == 0 && pGC->lineStyle == LineSolid) {
-        for (i = narcs, parc = parcs; --i >= 0; parc++) {
-            miArcSpanData *spdata;
-            spdata = miArcSegment(pDraw, pGC, *parc, NULL, NULL, NULL);
-            free(spdata);
-        }
+        for (i = narcs, parc = parcs; --i >= 0; parc++)
+            miArcSegment(pDraw, pGC, *parc, NULL, NULL, NULL);
         fillSpans(pDraw, pGC);
         return;
     }
 
     if ((pGC->lineStyle == LineSolid) && narcs) {
-        while (parcs->width && parcs->height &&
-               (parcs->angle2 >= FULLCIRCLE || parcs->angle2 <= -FULLCIRCLE)) {
-            miFillWideEllipse(pDraw, pGC, parcs);
-            if (!--narcs)
-                return;
-            parcs++;
-        }
+        for (i = 0; i < narcs; i++)
+            if (!parcs[i].width || !parcs[i].height ||
+                (parcs[i].angle2 < FULLCIRCLE &&
+                 parcs[i].angle2 > -FULLCIRCLE))
+                break;
+        if (i)
+            miFillWideEllipses(pDraw, pGC, i, parcs);
+        if (!(narcs -= i))
+            return;
+        parcs += i;
     }
 
     /* Set up pDrawTo and pGCTo based on the rasterop */
@@ -1045,17 +1134,20 @@ miWideArc(DrawablePtr pDraw, GCPtr pGC, int narcs, xArc * parcs)
             arcData = &polyArcs[iphase].arcs[i];
             if (spdata) {
                 if (lastArc.width != arcData->arc.width ||
-                    lastArc.height != arcData->arc.height) {
-                    free(spdata);
+                    lastArc.height != arcData->arc.height)
                     spdata = NULL;
-                }
             }
             memcpy(&lastArc, &arcData->arc, sizeof(xArc));
             spdata = miArcSegment(pDrawTo, pGCTo, arcData->arc,
                                   &arcData->bounds[RIGHT_END],
                                   &arcData->bounds[LEFT_END], spdata);
+            /*
+             * The spans of the arcs, caps and joins are merged as they are
+             * drawn.  With a rop that involves the destination each
+             * rendered arc is pushed through the scratch bitmap on its own;
+             * otherwise the whole phase goes to FillSpans in one go.
+             */
             if (polyArcs[iphase].arcs[i].render) {
-                fillSpans(pDrawTo, pGCTo);
                 /* don't cap self-joining arcs */
                 if (polyArcs[iphase].arcs[i].selfJoin &&
                     cap[iphase] < polyArcs[iphase].arcs[i].cap)
@@ -1101,6 +1193,7 @@ miWideArc(DrawablePtr pDraw, GCPtr pGC, int narcs, xArc * parcs)
                     ++join[iphase];
                 }
                 if (fTricky) {
+                    fillSpans(pDrawTo, pGCTo);
                     if (pGC->serialNumber != pDraw->serialNumber)
                         ValidateGC(pDraw, pGC);
                     (*pGC->ops->PushPixels) (pGC, (PixmapPtr) pDrawTo,
@@ -1110,8 +1203,8 @@ miWideArc(DrawablePtr pDraw, GCPtr pGC, int narcs, xArc * parcs)
                 }
             }
         }
-        free(spdata);
-        spdata = NULL;
+        if (!fTricky)
+            fillSpans(pDrawTo, pGCTo);
     }
     miFreeArcs(polyArcs, pGC);
 
@@ -1161,6 +1254,9 @@ GetFPolyYBounds(SppPointPtr pts, int n, double yFtrans, int *by, int *ty)
  *	to traverse each edge is digital differencing analyzer
  *	line algorithm with y as the major axis. There's some funny linear
  *	interpolation involved because of the subpixel postioning.
+ *
+ *	The spans are added to the arc spans being collected, so caps and
+ *	joins go to FillSpans together with the arcs they belong to.
  */
 static void
 miFillSppPoly(DrawablePtr dst, GCPtr pgc, int count,    /* number of points */
@@ -1182,11 +1278,9 @@ miFillSppPoly(DrawablePtr dst, GCPtr pgc, int count,    /* number of points */
     int y,                      /* current scanline */
      j, imin,                   /* index of vertex with smallest y */
      ymin,                      /* y-extents of polygon */
-     ymax, *width, *FirstWidth, /* output buffer */
-    *Marked;                    /* set if this vertex has been used */
+     ymax, *Marked;             /* set if this vertex has been used */
     int left, right,            /* indices to first endpoints */
      nextleft, nextright;       /* indices to second endpoints */
-    DDXPointPtr ptsOut, FirstPoint;     /* output buffer */
 
     if (pgc->miTranslate) {
         xTrans += dst->x;
@@ -1198,16 +1292,9 @@ miFillSppPoly(DrawablePtr dst, GCPtr pgc, int count,    /* number of points */
     y = ymax - ymin + 1;
     if ((count < 3) || (y <= 0))
         return;
-    ptsOut = FirstPoint = xallocarray(y, sizeof(DDXPointRec));
-    width = FirstWidth = xallocarray(y, sizeof(int));
     Marked = xallocarray(count, sizeof(int));
-
-    if (!ptsOut || !width || !Marked) {
-        free(Marked);
-        free(width);
-        free(ptsOut);
+    if (!Marked)
         return;
-    }
 
     for (j = 0; j < count; j++)
         Marked[j] = 0;
@@ -1282,19 +1369,13 @@ miFillSppPoly(DrawablePtr dst, GCPtr pgc, int count,    /* number of points */
         while (j > 0) {
             int cxl, cxr;
 
-            ptsOut->y = (y) + yTrans;
-
             cxl = ICEIL(xl);
             cxr = ICEIL(xr);
             /* reverse the edges if necessary */
-            if (xl < xr) {
-                *(width++) = cxr - cxl;
-                (ptsOut++)->x = cxl + xTrans;
-            }
-            else {
-                *(width++) = cxl - cxr;
-                (ptsOut++)->x = cxr + xTrans;
-            }
+            if (xl < xr)
+                newFinalSpan(y + yTrans, cxl + xTrans, cxr + xTrans);
+            else
+                newFinalSpan(y + yTrans, cxr + xTrans, cxl + xTrans);
             y++;
 
             /* increment down the edges */
@@ -1304,12 +1385,7 @@ miFillSppPoly(DrawablePtr dst, GCPtr pgc, int count,    /* number of points */
         }
     } while (y <= ymax);
 
-    /* Finally, fill the spans we've collected */
-    (*pgc->ops->FillSpans) (dst, pgc,
-                            ptsOut - FirstPoint, FirstPoint, FirstWidth, 1);
     free(Marked);
-    free(FirstWidth);
-    free(FirstPoint);
 }
 static double
 angleBetween(SppPointRec center, SppPointRec point1, SppPointRec point2)
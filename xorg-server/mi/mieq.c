@@ -53,6 +53,7 @@ in this Software without prior written authorization from The Open Group.
 #include   "extinit.h"
 #include   "exglobals.h"
 #include   "eventstr.h"
+#include   "dix/reqstats_priv.h"
 
 #ifdef DPMSExtension
 #include "dpmsproc.h"
@@ -65,6 +66,7 @@ in this Software without prior written authorization from The Open Group.
 #define QUEUE_MAXIMUM_SIZE                4096
 #define QUEUE_DROP_BACKTRACE_FREQUENCY     100
 #define QUEUE_DROP_BACKTRACE_MAX            10
+#define QUEUE_RING_SIZE                    256  /* a power of two */
 
 #define EnqueueScreen(dev) dev->spriteInfo->sprite->pEnqueueScreen
 #define DequeueScreen(dev) dev->spriteInfo->sprite->pDequeueScreen
@@ -73,16 +75,52 @@ typedef struct _Event {
     InternalEvent *events;
     ScreenPtr pScreen;
     DeviceIntPtr pDev;          /* device this event _originated_ from */
+    CARD32 seq;                 /* enqueue order across queue and ring */
+    CARD64 enqueued;            /* GetTimeInMicros(), 0 if not timed */
 } EventRec, *EventPtr;
 
+#if INPUTTHREAD
+/*
+ * Events enqueued by the input thread go through a fixed-size ring with
+ * that thread as its only producer and the main thread as its only
+ * consumer, so that dispatch can take them without waiting for input_lock
+ * while the input thread holds it to read devices.  Each index is only
+ * written by one side: a slot is published by a release store of tail and
+ * handed back by a release store of head.
+ *
+ * Events enqueued by the main thread, and by the input thread when the
+ * ring is full, still go through the locked queue.  Every event gets a
+ * sequence number under input_lock and the consumer takes the lower of
+ * the two queue heads.  Motion events in the ring are not compressed.
+ */
+typedef struct _EventRing {
+    CARD32 tail;                /* written by the input thread */
+    size_t overflowed;          /* events that went to the queue instead */
+    char pad[64];
+    CARD32 head;                /* written by the main thread */
+    EventRec events[QUEUE_RING_SIZE];
+} EventRingRec, *EventRingPtr;
+
+/* The queue's head and tail are also peeked at without input_lock */
+#define QUEUE_SET_INDEX(i, v) __atomic_store_n(&(i), (v), __ATOMIC_RELAXED)
+#else
+#define QUEUE_SET_INDEX(i, v) ((i) = (v))
+#endif
+
 typedef struct _EventQueue {
-    HWEventQueueType head, tail;        /* long for SetInputCheck */
+    HWEventQueueType head, tail;
+    HWEventQueueType enqueued, dequeued;        /* int for SetInputCheck */
     CARD32 lastEventTime;       /* to avoid time running backwards */
     int lastMotion;             /* device ID if last event motion? */
     EventRec *events;           /* our queue as an array */
     size_t nevents;             /* the number of buckets in our queue */
     size_t dropped;             /* counter for number of consecutive dropped events */
     mieqHandler handlers[128];  /* custom event handler */
+#if INPUTTHREAD
+    EventRingPtr ring;
+    CARD32 generation;          /* odd while mieqGrowQueue moves head/tail */
+#endif
+    ReqStatRec latency;         /* from enqueue to delivery */
 } EventQueueRec, *EventQueuePtr;
 
 static EventQueueRec miEventQueue;
@@ -152,8 +190,17 @@ mieqGrowQueue(EventQueuePtr eventQueue, size_t new_nevents)
     }
 
     /* And update our record */
-    eventQueue->tail = n_enqueued;
-    eventQueue->head = 0;
+#if INPUTTHREAD
+    __atomic_store_n(&eventQueue->generation, eventQueue->generation + 1,
+                     __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+#endif
+    QUEUE_SET_INDEX(eventQueue->tail, n_enqueued);
+    QUEUE_SET_INDEX(eventQueue->head, 0);
+#if INPUTTHREAD
+    __atomic_store_n(&eventQueue->generation, eventQueue->generation + 1,
+                     __ATOMIC_RELEASE);
+#endif
     eventQueue->nevents = new_nevents;
     free(eventQueue->events);
     eventQueue->events = new_events;
@@ -161,6 +208,51 @@ mieqGrowQueue(EventQueuePtr eventQueue, size_t new_nevents)
     return TRUE;
 }
 
+#if INPUTTHREAD
+static void
+mieqFreeRing(EventRingPtr ring)
+{
+    int i;
+
+    for (i = 0; i < QUEUE_RING_SIZE; i++)
+        if (ring->events[i].events)
+            FreeEventList(ring->events[i].events, 1);
+    free(ring);
+}
+
+static EventRingPtr
+mieqAllocRing(void)
+{
+    EventRingPtr ring = calloc(1, sizeof(EventRingRec));
+    int i;
+
+    if (!ring)
+        return NULL;
+
+    for (i = 0; i < QUEUE_RING_SIZE; i++) {
+        ring->events[i].events = InitEventList(1);
+        if (!ring->events[i].events) {
+            mieqFreeRing(ring);
+            return NULL;
+        }
+    }
+    return ring;
+}
+#endif
+
+static void
+mieqDumpStats(CallbackListPtr *pcbl, void *closure, void *data)
+{
+    LogMessageVerb(X_NONE, 0, "input events:\n");
+    ReqStatsLogStat("(enqueue to delivery)", &miEventQueue.latency);
+#if INPUTTHREAD
+    if (miEventQueue.ring)
+        LogMessageVerb(X_NONE, 0, "  %lu events overflowed the input "
+                       "thread ring\n",
+                       (unsigned long) miEventQueue.ring->overflowed);
+#endif
+}
+
 Bool
 mieqInit(void)
 {
@@ -172,7 +264,13 @@ mieqInit(void)
         FatalError("Could not allocate event queue.\n");
     input_unlock();
 
-    SetInputCheck(&miEventQueue.head, &miEventQueue.tail);
+#if INPUTTHREAD
+    /* Without it, the input thread just uses the queue */
+    miEventQueue.ring = mieqAllocRing();
+#endif
+
+    AddCallback(&ReqStatsDumpCallback, mieqDumpStats, NULL);
+    SetInputCheck(&miEventQueue.enqueued, &miEventQueue.dequeued);
     return TRUE;
 }
 
@@ -181,6 +279,8 @@ mieqFini(void)
 {
     int i;
 
+    DeleteCallback(&ReqStatsDumpCallback, mieqDumpStats, NULL);
+
     for (i = 0; i < miEventQueue.nevents; i++) {
         if (miEventQueue.events[i].events != NULL) {
             FreeEventList(miEventQueue.events[i].events, 1);
@@ -188,8 +288,73 @@ mieqFini(void)
         }
     }
     free(miEventQueue.events);
+
+#if INPUTTHREAD
+    if (miEventQueue.ring) {
+        mieqFreeRing(miEventQueue.ring);
+        miEventQueue.ring = NULL;
+    }
+#endif
+}
+
+/* Fill in everything but the sequence number.  Called with input_lock held */
+static void
+mieqStoreEvent(EventPtr slot, DeviceIntPtr pDev, InternalEvent *e)
+{
+    InternalEvent *evt = slot->events;
+    Time time;
+
+    memcpy(evt, e, e->any.length);
+
+    time = e->any.time;
+    /* Make sure that event times don't go backwards - this
+     * is "unnecessary", but very useful. */
+    if (time < miEventQueue.lastEventTime &&
+        miEventQueue.lastEventTime - time < 10000)
+        e->any.time = miEventQueue.lastEventTime;
+
+    miEventQueue.lastEventTime = evt->any.time;
+    slot->pScreen = pDev ? EnqueueScreen(pDev) : NULL;
+    slot->pDev = pDev;
+    slot->enqueued = reqStatsEnabled ? GetTimeInMicros() : 0;
 }
 
+static CARD32
+mieqNextSeq(void)
+{
+    CARD32 seq = miEventQueue.enqueued;
+
+    miEventQueue.enqueued = seq + 1;
+    return seq;
+}
+
+#if INPUTTHREAD
+/* Called on the input thread with input_lock held */
+static Bool
+mieqRingEnqueue(DeviceIntPtr pDev, InternalEvent *e)
+{
+    EventRingPtr ring = miEventQueue.ring;
+    CARD32 tail = ring->tail;
+    EventPtr slot;
+
+    if (tail - __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) ==
+        QUEUE_RING_SIZE) {
+        ring->overflowed++;
+        return FALSE;
+    }
+
+    slot = &ring->events[tail & (QUEUE_RING_SIZE - 1)];
+    mieqStoreEvent(slot, pDev, e);
+    slot->seq = mieqNextSeq();
+
+    /* The next motion in the queue must not be merged past this one */
+    miEventQueue.lastMotion = 0;
+
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+    return TRUE;
+}
+#endif
+
 /*
  * Must be reentrant with ProcessInputEvents.  Assumption: mieqEnqueue
  * will never be interrupted. Must be called with input_lock held
@@ -199,14 +364,17 @@ void
 mieqEnqueue(DeviceIntPtr pDev, InternalEvent *e)
 {
     unsigned int oldtail = miEventQueue.tail;
-    InternalEvent *evt;
     int isMotion = 0;
-    int evlen;
-    Time time;
+    Bool merged = FALSE;
     size_t n_enqueued;
 
     verify_internal_event(e);
 
+#if INPUTTHREAD
+    if (miEventQueue.ring && in_input_thread() && mieqRingEnqueue(pDev, e))
+        return;
+#endif
+
     n_enqueued = mieqNumEnqueued(&miEventQueue);
 
     /* avoid merging events from different devices */
@@ -216,6 +384,7 @@ mieqEnqueue(DeviceIntPtr pDev, InternalEvent *e)
     if (isMotion && isMotion == miEventQueue.lastMotion &&
         oldtail != miEventQueue.head) {
         oldtail = (oldtail - 1) % miEventQueue.nevents;
+        merged = TRUE;
     }
     else if (n_enqueued + 1 == miEventQueue.nevents) {
         if (!mieqGrowQueue(&miEventQueue, miEventQueue.nevents << 1)) {
@@ -248,23 +417,13 @@ mieqEnqueue(DeviceIntPtr pDev, InternalEvent *e)
         oldtail = miEventQueue.tail;
     }
 
-    evlen = e->any.length;
-    evt = miEventQueue.events[oldtail].events;
-    memcpy(evt, e, evlen);
-
-    time = e->any.time;
-    /* Make sure that event times don't go backwards - this
-     * is "unnecessary", but very useful. */
-    if (time < miEventQueue.lastEventTime &&
-        miEventQueue.lastEventTime - time < 10000)
-        e->any.time = miEventQueue.lastEventTime;
-
-    miEventQueue.lastEventTime = evt->any.time;
-    miEventQueue.events[oldtail].pScreen = pDev ? EnqueueScreen(pDev) : NULL;
-    miEventQueue.events[oldtail].pDev = pDev;
+    /* A merged motion keeps the place, and sequence number, of the old one */
+    mieqStoreEvent(&miEventQueue.events[oldtail], pDev, e);
+    if (!merged)
+        miEventQueue.events[oldtail].seq = mieqNextSeq();
 
     miEventQueue.lastMotion = isMotion;
-    miEventQueue.tail = (oldtail + 1) % miEventQueue.nevents;
+    QUEUE_SET_INDEX(miEventQueue.tail, (oldtail + 1) % miEventQueue.nevents);
 }
 
 /**
@@ -509,14 +668,113 @@ mieqProcessDeviceEvent(DeviceIntPtr dev, InternalEvent *event, ScreenPtr screen)
     }
 }
 
+static void
+mieqTakeEvent(EventPtr e, InternalEvent *event, DeviceIntPtr *dev,
+              ScreenPtr *screen, CARD64 *enqueued)
+{
+    *event = *e->events;
+    *dev = e->pDev;
+    *screen = e->pScreen;
+    *enqueued = e->enqueued;
+    miEventQueue.dequeued = (CARD32) miEventQueue.dequeued + 1;
+}
+
+#if INPUTTHREAD
+static EventPtr
+mieqRingHead(EventRingPtr ring)
+{
+    if (!ring || ring->head == __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE))
+        return NULL;
+    return &ring->events[ring->head & (QUEUE_RING_SIZE - 1)];
+}
+
+static void
+mieqRingRelease(EventRingPtr ring)
+{
+    __atomic_store_n(&ring->head, ring->head + 1, __ATOMIC_RELEASE);
+}
+
+/*
+ * Is the queue empty, judging without input_lock?  head and tail are two
+ * loads, so if mieqGrowQueue moved them in between the answer is no.
+ */
+static Bool
+mieqQueueLooksEmpty(EventQueuePtr eventQueue)
+{
+    CARD32 generation = __atomic_load_n(&eventQueue->generation,
+                                        __ATOMIC_ACQUIRE);
+    Bool empty;
+
+    if (generation & 1)
+        return FALSE;
+    empty = __atomic_load_n(&eventQueue->head, __ATOMIC_RELAXED) ==
+        __atomic_load_n(&eventQueue->tail, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return empty && __atomic_load_n(&eventQueue->generation,
+                                    __ATOMIC_RELAXED) == generation;
+}
+#endif
+
+/*
+ * Take the oldest event off the queue or the ring, return FALSE if both
+ * are empty.
+ */
+static Bool
+mieqDequeue(InternalEvent *event, DeviceIntPtr *dev, ScreenPtr *screen,
+            CARD64 *enqueued)
+{
+    EventPtr e = NULL;
+#if INPUTTHREAD
+    EventRingPtr ring = miEventQueue.ring;
+    EventPtr r = mieqRingHead(ring);
+
+    /*
+     * Anything the input thread put in the queue before r was published
+     * along with r, so if the queue looks empty now r is the oldest event
+     * and can be taken without the lock.  Otherwise, or if the queue was
+     * being grown, look again under the lock.
+     */
+    if (r && mieqQueueLooksEmpty(&miEventQueue)) {
+        mieqTakeEvent(r, event, dev, screen, enqueued);
+        mieqRingRelease(ring);
+        return TRUE;
+    }
+#endif
+
+    input_lock();
+
+    if (miEventQueue.head != miEventQueue.tail)
+        e = &miEventQueue.events[miEventQueue.head];
+
+#if INPUTTHREAD
+    /* The input thread can't be enqueueing now, so look again */
+    r = mieqRingHead(ring);
+    if (r && (!e || (INT32) (r->seq - e->seq) < 0)) {
+        input_unlock();
+        mieqTakeEvent(r, event, dev, screen, enqueued);
+        mieqRingRelease(ring);
+        return TRUE;
+    }
+#endif
+
+    if (e) {
+        mieqTakeEvent(e, event, dev, screen, enqueued);
+        QUEUE_SET_INDEX(miEventQueue.head,
+                        (miEventQueue.head + 1) % miEventQueue.nevents);
+    }
+
+    input_unlock();
+    return e != NULL;
+}
+
 /* Call this from ProcessInputEvents(). */
 void
 mieqProcessInputEvents(void)
 {
-    EventRec *e = NULL;
     ScreenPtr screen;
     InternalEvent event;
     DeviceIntPtr dev = NULL, master = NULL;
+    CARD64 enqueued;
     static Bool inProcessInputEvents = FALSE;
 
     input_lock();
@@ -537,17 +795,9 @@ mieqProcessInputEvents(void)
         miEventQueue.dropped = 0;
     }
 
-    while (miEventQueue.head != miEventQueue.tail) {
-        e = &miEventQueue.events[miEventQueue.head];
-
-        event = *e->events;
-        dev = e->pDev;
-        screen = e->pScreen;
-
-        miEventQueue.head = (miEventQueue.head + 1) % miEventQueue.nevents;
-
-        input_unlock();
+    input_unlock();
 
+    while (mieqDequeue(&event, &dev, &screen, &enqueued)) {
         master = (dev) ? GetMaster(dev, MASTER_ATTACHED) : NULL;
 
         if (screenIsSaved == SCREEN_SAVER_ON)
@@ -570,9 +820,12 @@ mieqProcessInputEvents(void)
               event.device_event.flags & TOUCH_POINTER_EMULATED)))
             miPointerUpdateSprite(dev);
 
-        input_lock();
+        if (enqueued)
+            ReqStatsAddSample(&miEventQueue.latency, enqueued);
     }
 
+    input_lock();
+
     inProcessInputEvents = FALSE;
 
     CallCallbacks(&miCallbacksWhenDrained, NULL);
@@ -295,6 +295,7 @@ miScreenInit(ScreenPtr pScreen, void *pbits,  /* pointer to screen bits */
     pScreen->SetShape = miSetShape;
     pScreen->MarkUnrealizedWindow = miMarkUnrealizedWindow;
     pScreen->XYToWindow = miXYToWindow;
+    miWindowIndexInit();
 
     miSetZeroLineBias(pScreen, DEFAULTZEROLINEBIAS);
 
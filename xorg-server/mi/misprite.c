@@ -301,6 +301,9 @@ miSpriteInitialize(ScreenPtr pScreen, miPointerScreenFuncPtr screenFuncs)
                                         NULL,
                                         DamageReportRawRegion,
                                         TRUE, pScreen, pScreen);
+    /* Only the raw reports are looked at, never the accumulated region */
+    if (pScreenPriv->pDamage && damageMaxBoxes)
+        DamageSetMaxBoxes(pScreenPriv->pDamage, 1);
 
     if (!miPointerInitialize(pScreen, &miSpritePointerFuncs, screenFuncs, TRUE)) {
         free(pScreenPriv);
@@ -600,6 +600,159 @@ AppendSpanGroup(GCPtr pGC, unsigned long pixel, Spans * spanPtr,
     miAppendSpans(group, othergroup, spanPtr);
 }
 
+/*
+ * With rops that give the same result however many times a pixel is
+ * drawn, the pieces of a wide line (segments, joins, caps and dashes) are
+ * drawn as they come rather than made disjoint first.  Handing each piece
+ * to FillSpans or PolyFillRect on its own costs a trip through the GC
+ * wrappers, damage and the clip code per piece, so their spans and rects
+ * are collected in a batch instead.  The batch is drawn with the spans
+ * sorted by y when the line is done, when a piece of another pixel value
+ * comes along and when it is full.  It never covers more rows than it can
+ * hold spans, which bounds the sort.
+ */
+
+#define SPAN_BATCH_SIZE	4096
+#define RECT_BATCH_SIZE	256
+
+typedef struct _SpanBatch {
+    unsigned long pixel;
+    int count;
+    int ymin, ymax;
+    int nrects;
+    DDXPointRec points[SPAN_BATCH_SIZE];
+    int widths[SPAN_BATCH_SIZE];
+    DDXPointRec sortedPoints[SPAN_BATCH_SIZE];
+    int sortedWidths[SPAN_BATCH_SIZE];
+    int rows[SPAN_BATCH_SIZE + 1];
+    xRectangle rects[RECT_BATCH_SIZE];
+} SpanBatchRec;
+
+static SpanBatchRec spanBatch;
+
+static void
+FlushSpanBatch(DrawablePtr pDrawable, GCPtr pGC)
+{
+    SpanBatchRec *batch = &spanBatch;
+    ChangeGCVal oldPixel, tmpPixel;
+    int i, j, nrows;
+
+    if (!batch->count && !batch->nrects)
+        return;
+
+    oldPixel.val = pGC->fgPixel;
+    if (batch->pixel != oldPixel.val) {
+        tmpPixel.val = (XID) batch->pixel;
+        ChangeGC(NullClient, pGC, GCForeground, &tmpPixel);
+        ValidateGC(pDrawable, pGC);
+    }
+
+    if (batch->count) {
+        /* Counting sort on y */
+        nrows = batch->ymax - batch->ymin + 1;
+        memset(batch->rows, 0, (nrows + 1) * sizeof(int));
+        for (i = 0; i < batch->count; i++)
+            batch->rows[batch->points[i].y - batch->ymin + 1]++;
+        for (i = 0; i < nrows; i++)
+            batch->rows[i + 1] += batch->rows[i];
+        for (i = 0; i < batch->count; i++) {
+            j = batch->rows[batch->points[i].y - batch->ymin]++;
+            batch->sortedPoints[j] = batch->points[i];
+            batch->sortedWidths[j] = batch->widths[i];
+        }
+        (*pGC->ops->FillSpans) (pDrawable, pGC, batch->count,
+                                batch->sortedPoints, batch->sortedWidths,
+                                TRUE);
+    }
+    if (batch->nrects)
+        (*pGC->ops->PolyFillRect) (pDrawable, pGC, batch->nrects,
+                                   batch->rects);
+
+    if (batch->pixel != oldPixel.val) {
+        ChangeGC(NullClient, pGC, GCForeground, &oldPixel);
+        ValidateGC(pDrawable, pGC);
+    }
+    batch->count = 0;
+    batch->nrects = 0;
+}
+
+/*
+ * Make room in the batch for pixel, flushing it first if it holds another
+ * pixel value or hasn't room for count more spans over rows ymin to ymax.
+ */
+static void
+ReserveSpanBatch(DrawablePtr pDrawable, GCPtr pGC, unsigned long pixel,
+                 int count, int ymin, int ymax)
+{
+    SpanBatchRec *batch = &spanBatch;
+
+    if ((batch->count || batch->nrects) &&
+        (batch->pixel != pixel ||
+         batch->count + count > SPAN_BATCH_SIZE ||
+         (batch->count && count &&
+          max(ymax, batch->ymax) - min(ymin, batch->ymin) >=
+          SPAN_BATCH_SIZE)))
+        FlushSpanBatch(pDrawable, pGC);
+    batch->pixel = pixel;
+    if (!count)
+        return;
+    if (!batch->count) {
+        batch->ymin = ymin;
+        batch->ymax = ymax;
+    }
+    else {
+        batch->ymin = min(batch->ymin, ymin);
+        batch->ymax = max(batch->ymax, ymax);
+    }
+}
+
+/* Returns FALSE if the spans are too many to ever fit in the batch */
+static Bool
+BatchSpans(DrawablePtr pDrawable, GCPtr pGC, unsigned long pixel,
+           Spans * spans)
+{
+    SpanBatchRec *batch = &spanBatch;
+    int ymin, ymax, i;
+
+    if (!spans->count)
+        return TRUE;
+
+    ymin = ymax = spans->points[0].y;
+    for (i = 1; i < spans->count; i++) {
+        ymin = min(ymin, spans->points[i].y);
+        ymax = max(ymax, spans->points[i].y);
+    }
+    if (spans->count > SPAN_BATCH_SIZE || ymax - ymin >= SPAN_BATCH_SIZE) {
+        FlushSpanBatch(pDrawable, pGC);
+        return FALSE;
+    }
+
+    ReserveSpanBatch(pDrawable, pGC, pixel, spans->count, ymin, ymax);
+    memcpy(batch->points + batch->count, spans->points,
+           spans->count * sizeof(DDXPointRec));
+    memcpy(batch->widths + batch->count, spans->widths,
+           spans->count * sizeof(int));
+    batch->count += spans->count;
+    return TRUE;
+}
+
+static void
+BatchRect(DrawablePtr pDrawable, GCPtr pGC, unsigned long pixel,
+          int x, int y, int w, int h)
+{
+    SpanBatchRec *batch = &spanBatch;
+    xRectangle *rect;
+
+    if (batch->nrects == RECT_BATCH_SIZE)
+        FlushSpanBatch(pDrawable, pGC);
+    ReserveSpanBatch(pDrawable, pGC, pixel, 0, 0, 0);
+    rect = &batch->rects[batch->nrects++];
+    rect->x = x;
+    rect->y = y;
+    rect->width = w;
+    rect->height = h;
+}
+
 static void miLineArc(DrawablePtr pDraw, GCPtr pGC,
                       unsigned long pixel, SpanDataPtr spanData,
                       LineFacePtr leftFace,
@@ -614,7 +767,11 @@ static void
 fillSpans(DrawablePtr pDrawable, GCPtr pGC, unsigned long pixel, Spans * spans,
           SpanDataPtr spanData)
 {
-    if (!spanData) {
+    if (!spanData && BatchSpans(pDrawable, pGC, pixel, spans)) {
+        free(spans->widths);
+        free(spans->points);
+    }
+    else if (!spanData) {
         ChangeGCVal oldPixel, tmpPixel;
 
         oldPixel.val = pGC->fgPixel;
@@ -738,26 +895,10 @@ miFillRectPolyHelper(DrawablePtr pDrawable,
 {
     DDXPointPtr ppt;
     int *pwidth;
-    ChangeGCVal oldPixel, tmpPixel;
     Spans spanRec;
-    xRectangle rect;
 
     if (!spanData) {
-        rect.x = x;
-        rect.y = y;
-        rect.width = w;
-        rect.height = h;
-        oldPixel.val = pGC->fgPixel;
-        if (pixel != oldPixel.val) {
-            tmpPixel.val = (XID) pixel;
-            ChangeGC(NullClient, pGC, GCForeground, &tmpPixel);
-            ValidateGC(pDrawable, pGC);
-        }
-        (*pGC->ops->PolyFillRect) (pDrawable, pGC, 1, &rect);
-        if (pixel != oldPixel.val) {
-            ChangeGC(NullClient, pGC, GCForeground, &oldPixel);
-            ValidateGC(pDrawable, pGC);
-        }
+        BatchRect(pDrawable, pGC, pixel, x, y, w, h);
     }
     else {
         if (!InitSpans(&spanRec, h))
@@ -943,6 +1084,8 @@ miLineOnePoint(DrawablePtr pDrawable,
     int wid;
     unsigned long oldPixel;
 
+    if (spanBatch.pixel != pixel)
+        FlushSpanBatch(pDrawable, pGC);
     MILINESETPIXEL(pDrawable, pGC, pixel, oldPixel);
     if (pGC->fillStyle == FillSolid) {
         pt.x = x;
@@ -2000,6 +2143,8 @@ miWideLine(DrawablePtr pDrawable, GCPtr pGC,
     }
     if (spanData)
         miCleanupSpanData(pDrawable, pGC, spanData);
+    else
+        FlushSpanBatch(pDrawable, pGC);
 }
 
 #define V_TOP	    0
@@ -2486,6 +2631,8 @@ miWideDash(DrawablePtr pDrawable, GCPtr pGC,
     }
     if (spanData)
         miCleanupSpanData(pDrawable, pGC, spanData);
+    else
+        FlushSpanBatch(pDrawable, pGC);
 }
 
 void
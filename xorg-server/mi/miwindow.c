@@ -58,6 +58,7 @@ SOFTWARE.
 #include "pixmapstr.h"
 #include "mivalidate.h"
 #include "inputstr.h"
+#include "mi/mi_priv.h"
 
 void
 miClearToBackground(WindowPtr pWin,
@@ -746,42 +747,55 @@ miMarkUnrealizedWindow(WindowPtr pChild, WindowPtr pWin, Bool fromConfigure)
     }
 }
 
+static Bool
+miSpriteHit(WindowPtr pWin, int x, int y)
+{
+    BoxRec box;
+
+    return (pWin->mapped) &&
+        (x >= pWin->drawable.x - wBorderWidth(pWin)) &&
+        (x < pWin->drawable.x + (int) pWin->drawable.width +
+         wBorderWidth(pWin)) &&
+        (y >= pWin->drawable.y - wBorderWidth(pWin)) &&
+        (y < pWin->drawable.y + (int) pWin->drawable.height +
+         wBorderWidth(pWin))
+        /* When a window is shaped, a further check
+         * is made to see if the point is inside
+         * borderSize
+         */
+        && (!wBoundingShape(pWin) || PointInBorderSize(pWin, x, y))
+        && (!wInputShape(pWin) ||
+            RegionContainsPoint(wInputShape(pWin),
+                                x - pWin->drawable.x,
+                                y - pWin->drawable.y, &box))
+        /* In rootless mode windows may be offscreen, even when
+         * they're in X's stack. (E.g. if the native window system
+         * implements some form of virtual desktop system).
+         */
+        && !pWin->unhittable;
+}
+
+static void
+miSpriteTracePush(SpritePtr pSprite, WindowPtr pWin)
+{
+    if (pSprite->spriteTraceGood >= pSprite->spriteTraceSize) {
+        pSprite->spriteTraceSize += 10;
+        pSprite->spriteTrace = reallocarray(pSprite->spriteTrace,
+                                            pSprite->spriteTraceSize,
+                                            sizeof(WindowPtr));
+    }
+    pSprite->spriteTrace[pSprite->spriteTraceGood++] = pWin;
+}
+
 WindowPtr
 miSpriteTrace(SpritePtr pSprite, int x, int y)
 {
     WindowPtr pWin;
-    BoxRec box;
 
     pWin = DeepestSpriteWin(pSprite)->firstChild;
     while (pWin) {
-        if ((pWin->mapped) &&
-            (x >= pWin->drawable.x - wBorderWidth(pWin)) &&
-            (x < pWin->drawable.x + (int) pWin->drawable.width +
-             wBorderWidth(pWin)) &&
-            (y >= pWin->drawable.y - wBorderWidth(pWin)) &&
-            (y < pWin->drawable.y + (int) pWin->drawable.height +
-             wBorderWidth(pWin))
-            /* When a window is shaped, a further check
-             * is made to see if the point is inside
-             * borderSize
-             */
-            && (!wBoundingShape(pWin) || PointInBorderSize(pWin, x, y))
-            && (!wInputShape(pWin) ||
-                RegionContainsPoint(wInputShape(pWin),
-                                    x - pWin->drawable.x,
-                                    y - pWin->drawable.y, &box))
-            /* In rootless mode windows may be offscreen, even when
-             * they're in X's stack. (E.g. if the native window system
-             * implements some form of virtual desktop system).
-             */
-            && !pWin->unhittable) {
-            if (pSprite->spriteTraceGood >= pSprite->spriteTraceSize) {
-                pSprite->spriteTraceSize += 10;
-                pSprite->spriteTrace = reallocarray(pSprite->spriteTrace,
-                                                    pSprite->spriteTraceSize,
-                                                    sizeof(WindowPtr));
-            }
-            pSprite->spriteTrace[pSprite->spriteTraceGood++] = pWin;
+        if (miSpriteHit(pWin, x, y)) {
+            miSpriteTracePush(pSprite, pWin);
             pWin = pWin->firstChild;
         }
         else
@@ -804,6 +818,16 @@ miSpriteTrace(SpritePtr pSprite, int x, int y)
 WindowPtr
 miXYToWindow(ScreenPtr pScreen, SpritePtr pSprite, int x, int y)
 {
+    WindowPtr pWin;
+
     pSprite->spriteTraceGood = 1;       /* root window still there */
+
+    /* Look the top-level window up in the screen's grid if it has one */
+    if (pSprite->spriteTrace[0] == pScreen->root &&
+        miWindowIndexLookup(pScreen, x, y, miSpriteHit, &pWin)) {
+        if (!pWin)
+            return pScreen->root;
+        miSpriteTracePush(pSprite, pWin);
+    }
     return miSpriteTrace(pSprite, x, y);
 }
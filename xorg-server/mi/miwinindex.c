@@ -0,0 +1,457 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mi/mi_priv.h"
+
+#include "misc.h"
+#include "privates.h"
+#include "windowstr.h"
+#include "scrnintstr.h"
+
+/*
+ * Finding the top-level window under the pointer walks every child of the
+ * root in stacking order, which shows up on every motion event once
+ * clients create thousands of override-redirect windows.  Screens with at
+ * least MI_WINDOW_INDEX_MIN mapped top-level windows therefore keep a grid
+ * over their bounding box, where each cell lists the windows whose border
+ * box overlaps it, topmost first.  Windows that would cover more than
+ * MI_WINDOW_INDEX_LARGE cells go on a separate list instead, merged with
+ * the cell's by stacking order during lookups.
+ *
+ * Mapping, unmapping, moving or resizing a top-level window takes it out
+ * of its cells and puts it in the new ones.  Entries are ordered by a
+ * rank each window keeps in a private: the rebuild numbers all children
+ * of the root MI_WINDOW_INDEX_RANK_GAP apart, and a window created since
+ * gets a rank between those of its nearest ranked siblings.  Restacking,
+ * reparenting, a window leaving the grid's bounds or running out of ranks
+ * invalidates the grid instead, and the next lookup rebuilds it.  The grid
+ * only narrows down the candidates: each is still tested with the same
+ * hit procedure the walk uses, so shapes, input shapes and unhittable
+ * windows need not update it.
+ */
+
+#define MI_WINDOW_INDEX_GRID	32      /* cells on each side */
+#define MI_WINDOW_INDEX_CELLS	(MI_WINDOW_INDEX_GRID * MI_WINDOW_INDEX_GRID)
+#define MI_WINDOW_INDEX_MIN	64
+#define MI_WINDOW_INDEX_LARGE	64
+#define MI_WINDOW_INDEX_RANK_GAP	1024
+#define MI_WINDOW_INDEX_RANK_WALK	64      /* siblings to look through */
+
+typedef struct {
+    WindowPtr pWin;
+    int rank;                   /* in stacking order, topmost lowest */
+} miWindowIndexEntryRec, *miWindowIndexEntryPtr;
+
+typedef struct {
+    miWindowIndexEntryPtr entries;      /* ordered by rank */
+    unsigned int num, size;
+} miWindowIndexListRec, *miWindowIndexListPtr;
+
+typedef struct {
+    unsigned long generation;
+    unsigned int stamp;         /* of the last rebuild */
+    Bool valid;                 /* matches the window tree */
+    Bool used;                  /* enough windows to be worth it */
+    BoxRec bounds;
+    int cellWidth, cellHeight;
+    miWindowIndexListRec cells[MI_WINDOW_INDEX_CELLS];
+    miWindowIndexListRec large;
+} miWindowIndexRec, *miWindowIndexPtr;
+
+/* Window private, only meaningful if stamp is the grid's */
+typedef struct {
+    unsigned int stamp;
+    int rank;
+    Bool indexed;               /* in the grid, under box */
+    BoxRec box;
+} miWindowIndexWinRec, *miWindowIndexWinPtr;
+
+static miWindowIndexRec miWindowIndex[MAXSCREENS];
+
+static DevPrivateKeyRec miWindowIndexWinKeyRec;
+
+#define miWindowIndexWinKey (&miWindowIndexWinKeyRec)
+#define miGetWindowIndexWin(w) ((miWindowIndexWinPtr) \
+    dixLookupPrivate(&(w)->devPrivates, miWindowIndexWinKey))
+
+/*
+ * Called by miScreenInit, before any window exists.  Without the private
+ * the grid is still used, but rebuilt after every change.
+ */
+void
+miWindowIndexInit(void)
+{
+    (void) dixRegisterPrivateKey(&miWindowIndexWinKeyRec, PRIVATE_WINDOW,
+                                 sizeof(miWindowIndexWinRec));
+}
+
+/* Mark the grid of pWin's screen stale if pWin is a root or top-level */
+void
+miWindowIndexInvalidate(WindowPtr pWin)
+{
+    if (pWin->parent && pWin->parent->parent)
+        return;
+    miWindowIndex[pWin->drawable.pScreen->myNum].valid = FALSE;
+}
+
+/* The box the walk tests the pointer against, borders included */
+static void
+miWindowIndexBox(WindowPtr pWin, BoxPtr box)
+{
+    int bw = wBorderWidth(pWin);
+
+    box->x1 = pWin->drawable.x - bw;
+    box->y1 = pWin->drawable.y - bw;
+    box->x2 = pWin->drawable.x + (int) pWin->drawable.width + bw;
+    box->y2 = pWin->drawable.y + (int) pWin->drawable.height + bw;
+}
+
+static Bool
+miWindowIndexReserve(miWindowIndexListPtr list, unsigned int n)
+{
+    miWindowIndexEntryPtr grown;
+    unsigned int size;
+
+    if (n <= list->size)
+        return TRUE;
+    size = max(n, list->size * 2);
+    grown = reallocarray(list->entries, size, sizeof(miWindowIndexEntryRec));
+    if (!grown)
+        return FALSE;
+    list->entries = grown;
+    list->size = size;
+    return TRUE;
+}
+
+/* Put entry in list, before the first entry ranked below it */
+static Bool
+miWindowIndexInsert(miWindowIndexListPtr list, miWindowIndexEntryRec entry)
+{
+    unsigned int lo = 0, hi = list->num, mid;
+
+    if (!miWindowIndexReserve(list, list->num + 1))
+        return FALSE;
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (list->entries[mid].rank < entry.rank)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    memmove(list->entries + lo + 1, list->entries + lo,
+            (list->num - lo) * sizeof(miWindowIndexEntryRec));
+    list->entries[lo] = entry;
+    list->num++;
+    return TRUE;
+}
+
+static void
+miWindowIndexDelete(miWindowIndexListPtr list, WindowPtr pWin)
+{
+    unsigned int i;
+
+    for (i = 0; i < list->num; i++) {
+        if (list->entries[i].pWin == pWin) {
+            list->num--;
+            memmove(list->entries + i, list->entries + i + 1,
+                    (list->num - i) * sizeof(miWindowIndexEntryRec));
+            return;
+        }
+    }
+}
+
+/* Which cells box covers; FALSE if it is large */
+static Bool
+miWindowIndexCells(miWindowIndexPtr index, const BoxRec *box,
+                   int *cx1, int *cy1, int *cx2, int *cy2)
+{
+    *cx1 = (box->x1 - index->bounds.x1) / index->cellWidth;
+    *cy1 = (box->y1 - index->bounds.y1) / index->cellHeight;
+    *cx2 = (box->x2 - 1 - index->bounds.x1) / index->cellWidth;
+    *cy2 = (box->y2 - 1 - index->bounds.y1) / index->cellHeight;
+    return (*cx2 - *cx1 + 1) * (*cy2 - *cy1 + 1) <= MI_WINDOW_INDEX_LARGE;
+}
+
+/* Add pWin to the grid under rank; FALSE if it can't be */
+static Bool
+miWindowIndexAdd(miWindowIndexPtr index, WindowPtr pWin, int rank,
+                 miWindowIndexWinPtr priv)
+{
+    miWindowIndexEntryRec entry = { pWin, rank };
+    BoxRec box;
+    int cx1, cy1, cx2, cy2, cx, cy;
+
+    miWindowIndexBox(pWin, &box);
+    if (box.x1 >= box.x2 || box.y1 >= box.y2)
+        return TRUE;
+    if (box.x1 < index->bounds.x1 || box.y1 < index->bounds.y1 ||
+        box.x2 > index->bounds.x2 || box.y2 > index->bounds.y2)
+        return FALSE;
+
+    if (!miWindowIndexCells(index, &box, &cx1, &cy1, &cx2, &cy2)) {
+        if (!miWindowIndexInsert(&index->large, entry))
+            return FALSE;
+    }
+    else {
+        for (cy = cy1; cy <= cy2; cy++)
+            for (cx = cx1; cx <= cx2; cx++)
+                if (!miWindowIndexInsert(&index->cells[cy *
+                                                       MI_WINDOW_INDEX_GRID +
+                                                       cx], entry))
+                    return FALSE;
+    }
+    if (priv) {
+        priv->indexed = TRUE;
+        priv->box = box;
+    }
+    return TRUE;
+}
+
+static void
+miWindowIndexRemove(miWindowIndexPtr index, WindowPtr pWin,
+                    miWindowIndexWinPtr priv)
+{
+    int cx1, cy1, cx2, cy2, cx, cy;
+
+    if (!priv->indexed)
+        return;
+    priv->indexed = FALSE;
+    if (!miWindowIndexCells(index, &priv->box, &cx1, &cy1, &cx2, &cy2)) {
+        miWindowIndexDelete(&index->large, pWin);
+        return;
+    }
+    for (cy = cy1; cy <= cy2; cy++)
+        for (cx = cx1; cx <= cx2; cx++)
+            miWindowIndexDelete(&index->cells[cy * MI_WINDOW_INDEX_GRID + cx],
+                                pWin);
+}
+
+static miWindowIndexWinPtr
+miWindowIndexRanked(miWindowIndexPtr index, WindowPtr pWin)
+{
+    miWindowIndexWinPtr priv = miGetWindowIndexWin(pWin);
+
+    return priv->stamp == index->stamp ? priv : NULL;
+}
+
+/*
+ * Rank a window created since the last rebuild between its nearest ranked
+ * siblings.  FALSE if they are too far away or have no rank left between
+ * them.
+ */
+static Bool
+miWindowIndexRank(miWindowIndexPtr index, WindowPtr pWin,
+                  miWindowIndexWinPtr priv)
+{
+    miWindowIndexWinPtr above = NULL, below = NULL;
+    WindowPtr pSib;
+    int64_t rank;
+    int steps = 0;
+
+    for (pSib = pWin->prevSib; pSib; pSib = pSib->prevSib) {
+        if ((above = miWindowIndexRanked(index, pSib)) ||
+            ++steps == MI_WINDOW_INDEX_RANK_WALK)
+            break;
+    }
+    for (pSib = pWin->nextSib; pSib; pSib = pSib->nextSib) {
+        if ((below = miWindowIndexRanked(index, pSib)) ||
+            ++steps == MI_WINDOW_INDEX_RANK_WALK)
+            break;
+    }
+    if (steps >= MI_WINDOW_INDEX_RANK_WALK)
+        return FALSE;
+
+    if (above && below)
+        rank = ((int64_t) above->rank + below->rank) / 2;
+    else if (above)
+        rank = (int64_t) above->rank + MI_WINDOW_INDEX_RANK_GAP;
+    else if (below)
+        rank = (int64_t) below->rank - MI_WINDOW_INDEX_RANK_GAP;
+    else
+        rank = 0;
+    if (rank < INT_MIN || rank > INT_MAX ||
+        (above && rank == above->rank) || (below && rank == below->rank))
+        return FALSE;
+    priv->rank = rank;
+    priv->stamp = index->stamp;
+    priv->indexed = FALSE;
+    return TRUE;
+}
+
+/*
+ * Move a top-level window to the cells matching its mapping and geometry.
+ * Called after it is mapped, unmapped, moved or resized, but not
+ * restacked.
+ */
+void
+miWindowIndexUpdate(WindowPtr pWin)
+{
+    miWindowIndexPtr index;
+    miWindowIndexWinPtr priv;
+
+    if (!pWin->parent) {
+        miWindowIndexInvalidate(pWin);
+        return;
+    }
+    if (pWin->parent->parent)
+        return;
+    index = &miWindowIndex[pWin->drawable.pScreen->myNum];
+    if (!index->valid || index->generation != serverGeneration)
+        return;
+    if (!index->used || !dixPrivateKeyRegistered(miWindowIndexWinKey)) {
+        /* Unmapping can't bring the windows up to MI_WINDOW_INDEX_MIN */
+        if (pWin->mapped || index->used)
+            index->valid = FALSE;
+        return;
+    }
+
+    priv = miGetWindowIndexWin(pWin);
+    if (priv->stamp != index->stamp) {
+        if (!pWin->mapped)
+            return;
+        if (!miWindowIndexRank(index, pWin, priv)) {
+            index->valid = FALSE;
+            return;
+        }
+    }
+    miWindowIndexRemove(index, pWin, priv);
+    if (pWin->mapped && !miWindowIndexAdd(index, pWin, priv->rank, priv))
+        index->valid = FALSE;
+}
+
+static void
+miWindowIndexBuild(ScreenPtr pScreen, miWindowIndexPtr index)
+{
+    Bool ranks = dixPrivateKeyRegistered(miWindowIndexWinKey);
+    WindowPtr pWin;
+    BoxRec box;
+    unsigned int n = 0, children = 0, i;
+    int rank, gap;
+
+    index->valid = TRUE;
+    index->used = FALSE;
+
+    for (pWin = pScreen->root->firstChild; pWin; pWin = pWin->nextSib) {
+        children++;
+        if (!pWin->mapped)
+            continue;
+        miWindowIndexBox(pWin, &box);
+        if (box.x1 >= box.x2 || box.y1 >= box.y2)
+            continue;
+        if (!n++)
+            index->bounds = box;
+        else {
+            index->bounds.x1 = min(index->bounds.x1, box.x1);
+            index->bounds.y1 = min(index->bounds.y1, box.y1);
+            index->bounds.x2 = max(index->bounds.x2, box.x2);
+            index->bounds.y2 = max(index->bounds.y2, box.y2);
+        }
+    }
+    if (n < MI_WINDOW_INDEX_MIN)
+        return;
+
+    index->cellWidth = (index->bounds.x2 - index->bounds.x1 +
+                        MI_WINDOW_INDEX_GRID - 1) / MI_WINDOW_INDEX_GRID;
+    index->cellHeight = (index->bounds.y2 - index->bounds.y1 +
+                         MI_WINDOW_INDEX_GRID - 1) / MI_WINDOW_INDEX_GRID;
+
+    for (i = 0; i < MI_WINDOW_INDEX_CELLS; i++)
+        index->cells[i].num = 0;
+    index->large.num = 0;
+
+    /* Windows go in topmost first, so appending keeps the lists ordered */
+    if (++index->stamp == 0)
+        index->stamp = 1;
+    gap = min(MI_WINDOW_INDEX_RANK_GAP, INT_MAX / children);
+    rank = 0;
+    for (pWin = pScreen->root->firstChild; pWin; pWin = pWin->nextSib) {
+        miWindowIndexWinPtr priv = NULL;
+
+        if (ranks) {
+            priv = miGetWindowIndexWin(pWin);
+            priv->stamp = index->stamp;
+            priv->rank = rank;
+            priv->indexed = FALSE;
+        }
+        if (pWin->mapped && !miWindowIndexAdd(index, pWin, rank, priv))
+            return;
+        rank += gap;
+    }
+    index->used = TRUE;
+}
+
+/*
+ * Find the topmost child of the root at x/y for which hit returns TRUE,
+ * or NullWindow if there is none.  Returns FALSE if the screen has no
+ * grid, in which case the caller has to walk the windows itself.
+ */
+Bool
+miWindowIndexLookup(ScreenPtr pScreen, int x, int y,
+                    miWindowHitProcPtr hit, WindowPtr *ppWin)
+{
+    miWindowIndexPtr index = &miWindowIndex[pScreen->myNum];
+    miWindowIndexListPtr list;
+    miWindowIndexEntryPtr e, end, l, lend, next;
+    int cell;
+
+    if (index->generation != serverGeneration) {
+        index->generation = serverGeneration;
+        index->valid = FALSE;
+    }
+    if (!index->valid)
+        miWindowIndexBuild(pScreen, index);
+    if (!index->used)
+        return FALSE;
+
+    *ppWin = NullWindow;
+    if (x < index->bounds.x1 || x >= index->bounds.x2 ||
+        y < index->bounds.y1 || y >= index->bounds.y2)
+        return TRUE;
+
+    cell = ((y - index->bounds.y1) / index->cellHeight) *
+        MI_WINDOW_INDEX_GRID + (x - index->bounds.x1) / index->cellWidth;
+    list = &index->cells[cell];
+    e = list->entries;
+    end = list->entries + list->num;
+    l = index->large.entries;
+    lend = index->large.entries + index->large.num;
+
+    while (e < end || l < lend) {
+        if (l == lend || (e < end && e->rank < l->rank))
+            next = e++;
+        else
+            next = l++;
+        if ((*hit) (next->pWin, x, y)) {
+            *ppWin = next->pWin;
+            break;
+        }
+    }
+    return TRUE;
+}
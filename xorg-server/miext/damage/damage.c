@@ -124,6 +124,68 @@ getDrawableDamageRef(DrawablePtr pDrawable)
     DamagePtr	*pPrev = (DamagePtr *) \
 	dixLookupPrivateAddr(&(pWindow)->devPrivates, damageWinPrivateKey)
 
+/*
+ * Coalescing snaps boxes outwards to a grid of DAMAGE_TILE_SIZE pixel
+ * tiles, doubling the tile size until the region has at most half of its
+ * budget left, so the next few operations don't push it straight back
+ * over.  The result is clipped to the old extents, so damage only grows
+ * inside its bounding box.
+ */
+#define DAMAGE_TILE_SIZE 16
+
+static void
+damageRegionBound(DamagePtr pDamage)
+{
+    RegionPtr pRegion = &pDamage->damage;
+    int nbox = RegionNumRects(pRegion);
+    int target = pDamage->maxBoxes / 2;
+    BoxRec extents;
+    BoxPtr boxes;
+    int tile, i;
+
+    if (!pDamage->maxBoxes || nbox <= pDamage->maxBoxes)
+        return;
+
+    extents = *RegionExtents(pRegion);
+    boxes = target > 1 ? xallocarray(nbox, sizeof(BoxRec)) : NULL;
+    if (!boxes) {
+        RegionReset(pRegion, &extents);
+        return;
+    }
+
+    /* Grids nest, so each round can snap the previous round's result */
+    for (tile = DAMAGE_TILE_SIZE; nbox > target; tile <<= 1) {
+        int mask = tile - 1;
+
+        if (tile > MAXSHORT) {
+            RegionReset(pRegion, &extents);
+            break;
+        }
+
+        memcpy(boxes, RegionRects(pRegion), nbox * sizeof(BoxRec));
+        for (i = 0; i < nbox; i++) {
+            boxes[i].x1 = max(boxes[i].x1 & ~mask, extents.x1);
+            boxes[i].y1 = max(boxes[i].y1 & ~mask, extents.y1);
+            boxes[i].x2 = min((boxes[i].x2 + mask) & ~mask, extents.x2);
+            boxes[i].y2 = min((boxes[i].y2 + mask) & ~mask, extents.y2);
+        }
+        RegionUninit(pRegion);
+        if (!RegionInitBoxes(pRegion, boxes, nbox)) {
+            RegionInit(pRegion, &extents, 1);
+            break;
+        }
+        nbox = RegionNumRects(pRegion);
+    }
+    free(boxes);
+}
+
+static void
+damageAccumulate(DamagePtr pDamage, RegionPtr pRegion)
+{
+    RegionUnion(&pDamage->damage, &pDamage->damage, pRegion);
+    damageRegionBound(pDamage);
+}
+
 #if DAMAGE_DEBUG_ENABLE
 static void
 _damageRegionAppend(DrawablePtr pDrawable, RegionPtr pRegion, Bool clip,
@@ -268,7 +330,7 @@ damageRegionAppend(DrawablePtr pDrawable, RegionPtr pRegion, Bool clip,
             if (pDamage->damageReport)
                 DamageReportDamage(pDamage, pDamageRegion);
             else
-                RegionUnion(&pDamage->damage, &pDamage->damage, pDamageRegion);
+                damageAccumulate(pDamage, pDamageRegion);
         }
 
         /*
@@ -296,8 +358,7 @@ damageRegionProcessPending(DrawablePtr pDrawable)
             if (pDamage->damageReport)
                 DamageReportDamage(pDamage, &pDamage->pendingDamage);
             else
-                RegionUnion(&pDamage->damage, &pDamage->damage,
-                            &pDamage->pendingDamage);
+                damageAccumulate(pDamage, &pDamage->pendingDamage);
         }
 
         if (pDamage->reportAfter)
@@ -1781,6 +1842,7 @@ DamageCreate(DamageReportFunc damageReport,
     pDamage->isWindow = FALSE;
     pDamage->pDrawable = 0;
     pDamage->reportAfter = FALSE;
+    pDamage->maxBoxes = 0;
 
     pDamage->damageReport = damageReport;
     pDamage->damageDestroy = damageDestroy;
@@ -1974,6 +2036,20 @@ DamageSetReportAfterOp(DamagePtr pDamage, Bool reportAfter)
     pDamage->reportAfter = reportAfter;
 }
 
+/*
+ * Bound the accumulated damage region to maxBoxes boxes, or leave it
+ * exact with 0.  Delta reporting needs the exact region to compute what
+ * is new, so the budget is ignored for DamageReportDeltaRegion.
+ */
+void
+DamageSetMaxBoxes(DamagePtr pDamage, int maxBoxes)
+{
+    if (pDamage->damageLevel == DamageReportDeltaRegion)
+        maxBoxes = 0;
+    pDamage->maxBoxes = maxBoxes;
+    damageRegionBound(pDamage);
+}
+
 DamageScreenFuncsPtr
 DamageGetScreenFuncs(ScreenPtr pScreen)
 {
@@ -1990,7 +2066,7 @@ DamageReportDamage(DamagePtr pDamage, RegionPtr pDamageRegion)
 
     switch (pDamage->damageLevel) {
     case DamageReportRawRegion:
-        RegionUnion(&pDamage->damage, &pDamage->damage, pDamageRegion);
+        damageAccumulate(pDamage, pDamageRegion);
         (*pDamage->damageReport) (pDamage, pDamageRegion, pDamage->closure);
         break;
     case DamageReportDeltaRegion:
@@ -2004,7 +2080,7 @@ DamageReportDamage(DamagePtr pDamage, RegionPtr pDamageRegion)
         break;
     case DamageReportBoundingBox:
         tmpBox = *RegionExtents(&pDamage->damage);
-        RegionUnion(&pDamage->damage, &pDamage->damage, pDamageRegion);
+        damageAccumulate(pDamage, pDamageRegion);
         if (!BOX_SAME(&tmpBox, RegionExtents(&pDamage->damage))) {
             (*pDamage->damageReport) (pDamage, &pDamage->damage,
                                       pDamage->closure);
@@ -2012,14 +2088,14 @@ DamageReportDamage(DamagePtr pDamage, RegionPtr pDamageRegion)
         break;
     case DamageReportNonEmpty:
         was_empty = !RegionNotEmpty(&pDamage->damage);
-        RegionUnion(&pDamage->damage, &pDamage->damage, pDamageRegion);
+        damageAccumulate(pDamage, pDamageRegion);
         if (was_empty && RegionNotEmpty(&pDamage->damage)) {
             (*pDamage->damageReport) (pDamage, &pDamage->damage,
                                       pDamage->closure);
         }
         break;
     case DamageReportNone:
-        RegionUnion(&pDamage->damage, &pDamage->damage, pDamageRegion);
+        damageAccumulate(pDamage, pDamageRegion);
         break;
     }
 }
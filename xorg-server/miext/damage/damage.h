@@ -110,6 +110,10 @@ extern _X_EXPORT void
 extern _X_EXPORT void
  DamageSetReportAfterOp(DamagePtr pDamage, Bool reportAfter);
 
+/* Coalesce the accumulated region into at most maxBoxes boxes, 0 = never. */
+extern _X_EXPORT void
+ DamageSetMaxBoxes(DamagePtr pDamage, int maxBoxes);
+
 extern _X_EXPORT DamageScreenFuncsPtr DamageGetScreenFuncs(ScreenPtr);
 
 #endif                          /* _DAMAGE_H_ */
@@ -49,6 +49,7 @@ typedef struct _damage {
     Bool reportAfter;
     RegionRec pendingDamage;    /* will be flushed post submission at the latest */
     ScreenPtr pScreen;
+    int maxBoxes;               /* coalesce damage beyond this, 0 = never */
 } DamageRec;
 
 typedef struct _damageScrPriv {
@@ -25,6 +25,10 @@
 #endif
 
 #include <stdlib.h>
+#ifdef SHADOW_THREADS
+#include <pthread.h>
+#include <signal.h>
+#endif
 
 #include    <X11/X.h>
 #include    "scrnintstr.h"
@@ -35,6 +39,7 @@
 #include    "globals.h"
 #include    "gcstruct.h"
 #include    "shadow.h"
+#include    "fb.h"
 
 static DevPrivateKeyRec shadowScrPrivateKeyRec;
 #define shadowScrPrivateKey (&shadowScrPrivateKeyRec)
@@ -52,6 +57,321 @@ static DevPrivateKeyRec shadowScrPrivateKeyRec;
     real->mem = priv->mem; \
 }
 
+/*
+ * Tiled updates.  The damage is cut into SHADOW_TILE_SIZE squares and each
+ * damaged square is hashed; squares hashing the same as when they were last
+ * pushed to the screen are dropped from the damage, which catches clients
+ * repainting identical pixels.  When the update proc is one of the copy or
+ * rotate procs from this directory, whose writes for separate bands of
+ * shadow rows never overlap, what remains is split into bands of tile rows
+ * pushed in parallel by worker threads.
+ *
+ * The hashes assume the screen keeps what was pushed to it.  They are
+ * forgotten when the shadow pixmap is replaced or changes storage, and
+ * while rendering to the screen is off (the root clip is empty, as when
+ * xf86 has switched VT away).  A DDX that loses the screen contents in
+ * other ways must call shadowInvalidateTiles before damaging the screen
+ * to have it repainted.
+ */
+
+#define SHADOW_TILE_SIZE	64
+#define SHADOW_MAX_THREADS	16
+
+typedef struct _shadowTiles *shadowTilesPtr;
+
+typedef struct _shadowWorker {
+    shadowTilesPtr tiles;
+    int row1, row2;             /* tile rows of this band */
+    DamageRec damage;           /* hands the band to the update proc */
+#ifdef SHADOW_THREADS
+    pthread_t thread;
+#endif
+} shadowWorkerRec, *shadowWorkerPtr;
+
+typedef struct _shadowTiles {
+    ScreenPtr pScreen;
+    shadowBufPtr pBuf;
+    int width, height;          /* of the pixmap the hashes describe */
+    int tilesX, tilesY;
+    CARD64 *hashes;             /* 0 when unknown */
+    int numWorkers;
+    shadowWorkerRec workers[SHADOW_MAX_THREADS];
+#ifdef SHADOW_THREADS
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    unsigned int generation;
+    int pending;
+    Bool quit;
+#endif
+} shadowTilesRec;
+
+static Bool
+shadowTilesThreadSafe(ShadowUpdateProc update)
+{
+    static const ShadowUpdateProc procs[] = {
+        shadowUpdatePacked,
+        shadowUpdate32to24,
+        shadowUpdateRotate8,
+        shadowUpdateRotate16,
+        shadowUpdateRotate32,
+        shadowUpdateRotate8_90,
+        shadowUpdateRotate16_90,
+        shadowUpdateRotate16_90YX,
+        shadowUpdateRotate32_90,
+        shadowUpdateRotate8_180,
+        shadowUpdateRotate16_180,
+        shadowUpdateRotate32_180,
+        shadowUpdateRotate8_270,
+        shadowUpdateRotate16_270,
+        shadowUpdateRotate16_270YX,
+        shadowUpdateRotate32_270,
+    };
+    int i;
+
+    for (i = 0; i < ARRAY_SIZE(procs); i++)
+        if (update == procs[i])
+            return TRUE;
+    return FALSE;
+}
+
+static CARD64
+shadowHashTile(FbBits *base, FbStride stride, int bpp, const BoxRec *box)
+{
+    int x1 = (box->x1 * bpp) >> FB_SHIFT;
+    int w = ((box->x2 * bpp + FB_MASK) >> FB_SHIFT) - x1;
+    CARD64 hash = 0xcbf29ce484222325ULL;
+    int x, y;
+
+    for (y = box->y1; y < box->y2; y++) {
+        const FbBits *bits = base + y * stride + x1;
+
+        for (x = 0; x < w; x++) {
+            hash = (hash ^ bits[x]) * 0x9e3779b97f4a7c15ULL;
+            hash ^= hash >> 29;
+        }
+    }
+    return hash | 1;
+}
+
+/* Drop the unchanged tiles in rows [row1, row2) from region */
+static void
+shadowTilesSkip(shadowTilesPtr tiles, RegionPtr region, int row1, int row2)
+{
+    PixmapPtr pShadow = tiles->pBuf->pPixmap;
+    BoxPtr extents = RegionExtents(region);
+    FbBits *base;
+    FbStride stride;
+    int bpp;
+    _X_UNUSED int xoff, yoff;
+    int tx, tx1, tx2, ty;
+
+    if (!RegionNotEmpty(region))
+        return;
+
+    fbGetDrawable(&pShadow->drawable, base, stride, bpp, xoff, yoff);
+    tx1 = extents->x1 / SHADOW_TILE_SIZE;
+    tx2 = min((extents->x2 + SHADOW_TILE_SIZE - 1) / SHADOW_TILE_SIZE,
+              tiles->tilesX);
+    row1 = max(row1, extents->y1 / SHADOW_TILE_SIZE);
+    row2 = min(row2, (extents->y2 + SHADOW_TILE_SIZE - 1) / SHADOW_TILE_SIZE);
+
+    for (ty = row1; ty < row2; ty++) {
+        BoxRec run = { 0, 0, 0, 0 };
+
+        for (tx = tx1; tx < tx2; tx++) {
+            CARD64 *hash = &tiles->hashes[ty * tiles->tilesX + tx];
+            BoxRec tile;
+            CARD64 h;
+
+            tile.x1 = tx * SHADOW_TILE_SIZE;
+            tile.y1 = ty * SHADOW_TILE_SIZE;
+            tile.x2 = min(tile.x1 + SHADOW_TILE_SIZE, tiles->width);
+            tile.y2 = min(tile.y1 + SHADOW_TILE_SIZE, tiles->height);
+            if (RegionContainsRect(region, &tile) == rgnOUT)
+                continue;
+
+            h = shadowHashTile(base, stride, bpp, &tile);
+            if (h != *hash) {
+                *hash = h;
+                continue;
+            }
+            /* Collect runs of unchanged tiles, one subtraction per run */
+            if (run.x2 == tile.x1 && run.x2 > run.x1)
+                run.x2 = tile.x2;
+            else {
+                if (run.x2 > run.x1) {
+                    RegionRec skip;
+
+                    RegionInit(&skip, &run, 1);
+                    RegionSubtract(region, region, &skip);
+                }
+                run = tile;
+            }
+        }
+        if (run.x2 > run.x1) {
+            RegionRec skip;
+
+            RegionInit(&skip, &run, 1);
+            RegionSubtract(region, region, &skip);
+        }
+    }
+}
+
+static void
+shadowWorkerUpdate(shadowWorkerPtr worker)
+{
+    shadowTilesPtr tiles = worker->tiles;
+    shadowBufRec buf = *tiles->pBuf;
+    RegionPtr region = &worker->damage.damage;
+    BoxRec band;
+
+    if (worker->row1 >= worker->row2)
+        return;
+
+    band.x1 = 0;
+    band.y1 = worker->row1 * SHADOW_TILE_SIZE;
+    band.x2 = tiles->width;
+    band.y2 = min(worker->row2 * SHADOW_TILE_SIZE, tiles->height);
+    RegionInit(region, &band, 1);
+    RegionIntersect(region, region, DamageRegion(tiles->pBuf->pDamage));
+    shadowTilesSkip(tiles, region, worker->row1, worker->row2);
+    if (RegionNotEmpty(region)) {
+        buf.pDamage = &worker->damage;
+        (*buf.update) (tiles->pScreen, &buf);
+    }
+    RegionUninit(region);
+}
+
+#ifdef SHADOW_THREADS
+static void *
+shadowWorkerThread(void *arg)
+{
+    shadowWorkerPtr worker = arg;
+    shadowTilesPtr tiles = worker->tiles;
+    unsigned int generation = 0;
+#ifndef WIN32
+    sigset_t set;
+
+    /* Signals are for the main thread */
+    sigfillset(&set);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+#endif
+
+    pthread_mutex_lock(&tiles->lock);
+    for (;;) {
+        while (tiles->generation == generation && !tiles->quit)
+            pthread_cond_wait(&tiles->start, &tiles->lock);
+        if (tiles->quit)
+            break;
+        generation = tiles->generation;
+        pthread_mutex_unlock(&tiles->lock);
+
+        shadowWorkerUpdate(worker);
+
+        pthread_mutex_lock(&tiles->lock);
+        if (--tiles->pending == 0)
+            pthread_cond_signal(&tiles->done);
+    }
+    pthread_mutex_unlock(&tiles->lock);
+    return NULL;
+}
+#endif
+
+static Bool
+shadowTilesResize(shadowTilesPtr tiles)
+{
+    PixmapPtr pShadow = tiles->pBuf->pPixmap;
+    int width = pShadow->drawable.width;
+    int height = pShadow->drawable.height;
+
+    if (tiles->hashes && tiles->width == width && tiles->height == height)
+        return TRUE;
+
+    free(tiles->hashes);
+    tiles->width = width;
+    tiles->height = height;
+    tiles->tilesX = (width + SHADOW_TILE_SIZE - 1) / SHADOW_TILE_SIZE;
+    tiles->tilesY = (height + SHADOW_TILE_SIZE - 1) / SHADOW_TILE_SIZE;
+    tiles->hashes = calloc(tiles->tilesX * tiles->tilesY, sizeof(CARD64));
+    return tiles->hashes != NULL;
+}
+
+static void
+shadowTilesUpdate(ScreenPtr pScreen, shadowBufPtr pBuf)
+{
+    shadowTilesPtr tiles = pBuf->tiles;
+    RegionPtr pRegion = DamageRegion(pBuf->pDamage);
+    BoxPtr extents;
+    int row1, rows, n, i;
+
+    if (!pBuf->pPixmap->devPrivate.ptr || !shadowTilesResize(tiles)) {
+        (*pBuf->update) (pScreen, pBuf);
+        return;
+    }
+
+    extents = RegionExtents(pRegion);
+    row1 = extents->y1 / SHADOW_TILE_SIZE;
+    rows = (extents->y2 + SHADOW_TILE_SIZE - 1) / SHADOW_TILE_SIZE - row1;
+    n = min(tiles->numWorkers, rows);
+
+    if (n <= 1 || !shadowTilesThreadSafe(pBuf->update)) {
+        shadowTilesSkip(tiles, pRegion, 0, tiles->tilesY);
+        if (RegionNotEmpty(pRegion))
+            (*pBuf->update) (pScreen, pBuf);
+        return;
+    }
+
+    for (i = 0; i < tiles->numWorkers; i++) {
+        shadowWorkerPtr worker = &tiles->workers[i];
+
+        worker->row1 = i < n ? row1 + rows * i / n : 0;
+        worker->row2 = i < n ? row1 + rows * (i + 1) / n : 0;
+    }
+
+#ifdef SHADOW_THREADS
+    pthread_mutex_lock(&tiles->lock);
+    tiles->pending = tiles->numWorkers - 1;
+    tiles->generation++;
+    pthread_cond_broadcast(&tiles->start);
+    pthread_mutex_unlock(&tiles->lock);
+#endif
+
+    shadowWorkerUpdate(&tiles->workers[0]);
+
+#ifdef SHADOW_THREADS
+    pthread_mutex_lock(&tiles->lock);
+    while (tiles->pending)
+        pthread_cond_wait(&tiles->done, &tiles->lock);
+    pthread_mutex_unlock(&tiles->lock);
+#endif
+}
+
+static void
+shadowTilesFree(shadowBufPtr pBuf)
+{
+    shadowTilesPtr tiles = pBuf->tiles;
+
+    if (!tiles)
+        return;
+
+#ifdef SHADOW_THREADS
+    pthread_mutex_lock(&tiles->lock);
+    tiles->quit = TRUE;
+    pthread_cond_broadcast(&tiles->start);
+    pthread_mutex_unlock(&tiles->lock);
+    while (--tiles->numWorkers > 0)
+        pthread_join(tiles->workers[tiles->numWorkers].thread, NULL);
+    pthread_cond_destroy(&tiles->done);
+    pthread_cond_destroy(&tiles->start);
+    pthread_mutex_destroy(&tiles->lock);
+#endif
+
+    free(tiles->hashes);
+    free(tiles);
+    pBuf->tiles = NULL;
+}
+
 static void
 shadowRedisplay(ScreenPtr pScreen)
 {
@@ -60,9 +380,16 @@ shadowRedisplay(ScreenPtr pScreen)
 
     if (!pBuf || !pBuf->pDamage || !pBuf->update)
         return;
+    /* Whatever the screen shows while we can't draw to it isn't ours */
+    if (pBuf->tiles && pScreen->root &&
+        !RegionNotEmpty(&pScreen->root->borderClip))
+        shadowInvalidateTiles(pScreen);
     pRegion = DamageRegion(pBuf->pDamage);
     if (RegionNotEmpty(pRegion)) {
-        (*pBuf->update) (pScreen, pBuf);
+        if (pBuf->tiles)
+            shadowTilesUpdate(pScreen, pBuf);
+        else
+            (*pBuf->update) (pScreen, pBuf);
         DamageEmpty(pBuf->pDamage);
     }
 }
@@ -95,6 +422,37 @@ shadowGetImage(DrawablePtr pDrawable, int sx, int sy, int w, int h,
     wrap(pBuf, pScreen, GetImage);
 }
 
+static Bool
+shadowModifyPixmapHeader(PixmapPtr pPixmap, int width, int height, int depth,
+                         int bitsPerPixel, int devKind, void *pPixData)
+{
+    ScreenPtr pScreen = pPixmap->drawable.pScreen;
+    Bool ret;
+
+    shadowBuf(pScreen);
+
+    if (pPixmap == pBuf->pPixmap)
+        shadowInvalidateTiles(pScreen);
+    unwrap(pBuf, pScreen, ModifyPixmapHeader);
+    ret = pScreen->ModifyPixmapHeader(pPixmap, width, height, depth,
+                                      bitsPerPixel, devKind, pPixData);
+    wrap(pBuf, pScreen, ModifyPixmapHeader);
+    return ret;
+}
+
+static void
+shadowSetScreenPixmap(PixmapPtr pPixmap)
+{
+    ScreenPtr pScreen = pPixmap->drawable.pScreen;
+
+    shadowBuf(pScreen);
+
+    shadowInvalidateTiles(pScreen);
+    unwrap(pBuf, pScreen, SetScreenPixmap);
+    pScreen->SetScreenPixmap(pPixmap);
+    wrap(pBuf, pScreen, SetScreenPixmap);
+}
+
 static Bool
 shadowCloseScreen(ScreenPtr pScreen)
 {
@@ -103,7 +461,10 @@ shadowCloseScreen(ScreenPtr pScreen)
     unwrap(pBuf, pScreen, GetImage);
     unwrap(pBuf, pScreen, CloseScreen);
     unwrap(pBuf, pScreen, BlockHandler);
+    unwrap(pBuf, pScreen, ModifyPixmapHeader);
+    unwrap(pBuf, pScreen, SetScreenPixmap);
     shadowRemove(pScreen, pBuf->pPixmap);
+    shadowTilesFree(pBuf);
     DamageDestroy(pBuf->pDamage);
     if (pBuf->pPixmap)
         pScreen->DestroyPixmap(pBuf->pPixmap);
@@ -132,17 +493,24 @@ shadowSetup(ScreenPtr pScreen)
         free(pBuf);
         return FALSE;
     }
+    DamageSetMaxBoxes(pBuf->pDamage, damageMaxBoxes);
 
     wrap(pBuf, pScreen, CloseScreen);
     wrap(pBuf, pScreen, GetImage);
     wrap(pBuf, pScreen, BlockHandler);
+    wrap(pBuf, pScreen, ModifyPixmapHeader);
+    wrap(pBuf, pScreen, SetScreenPixmap);
     pBuf->update = 0;
     pBuf->window = 0;
     pBuf->pPixmap = 0;
     pBuf->closure = 0;
     pBuf->randr = 0;
+    pBuf->tiles = NULL;
 
     dixSetPrivate(&pScreen->devPrivates, shadowScrPrivateKey, pBuf);
+
+    if (shadowTileThreads)
+        shadowSetTiles(pScreen, shadowTileThreads);
     return TRUE;
 }
 
@@ -176,6 +544,7 @@ shadowAdd(ScreenPtr pScreen, PixmapPtr pPixmap, ShadowUpdateProc update,
     pBuf->closure = closure;
     pBuf->pPixmap = pPixmap;
     DamageRegister(&pPixmap->drawable, pBuf->pDamage);
+    shadowInvalidateTiles(pScreen);
     return TRUE;
 }
 
@@ -193,3 +562,56 @@ shadowRemove(ScreenPtr pScreen, PixmapPtr pPixmap)
         pBuf->pPixmap = 0;
     }
 }
+
+/*
+ * Push updates in tiles, skipping the unchanged ones, using up to threads
+ * threads.  0 turns tiled updates off.
+ */
+Bool
+shadowSetTiles(ScreenPtr pScreen, int threads)
+{
+    shadowBuf(pScreen);
+    shadowTilesPtr tiles;
+    int i;
+
+    shadowTilesFree(pBuf);
+    if (threads <= 0)
+        return TRUE;
+
+    tiles = calloc(1, sizeof(shadowTilesRec));
+    if (!tiles)
+        return FALSE;
+    tiles->pScreen = pScreen;
+    tiles->pBuf = pBuf;
+    for (i = 0; i < SHADOW_MAX_THREADS; i++)
+        tiles->workers[i].tiles = tiles;
+    tiles->numWorkers = 1;
+
+#ifdef SHADOW_THREADS
+    pthread_mutex_init(&tiles->lock, NULL);
+    pthread_cond_init(&tiles->start, NULL);
+    pthread_cond_init(&tiles->done, NULL);
+    for (i = 1; i < min(threads, SHADOW_MAX_THREADS); i++) {
+        if (pthread_create(&tiles->workers[i].thread, NULL,
+                           shadowWorkerThread, &tiles->workers[i]) != 0) {
+            LogMessage(X_WARNING, "shadow: cannot create update thread\n");
+            break;
+        }
+        tiles->numWorkers++;
+    }
+#endif
+
+    pBuf->tiles = tiles;
+    return TRUE;
+}
+
+/* Forget what the screen shows, the next update pushes every damaged tile */
+void
+shadowInvalidateTiles(ScreenPtr pScreen)
+{
+    shadowBuf(pScreen);
+
+    if (pBuf->tiles && pBuf->tiles->hashes)
+        memset(pBuf->tiles->hashes, 0,
+               pBuf->tiles->tilesX * pBuf->tiles->tilesY * sizeof(CARD64));
+}
@@ -55,6 +55,11 @@ typedef struct _shadowBuf {
     GetImageProcPtr GetImage;
     CloseScreenProcPtr CloseScreen;
     ScreenBlockHandlerProcPtr BlockHandler;
+    ModifyPixmapHeaderProcPtr ModifyPixmapHeader;
+    SetScreenPixmapProcPtr SetScreenPixmap;
+
+    /* tiled updates, see shadowSetTiles */
+    struct _shadowTiles *tiles;
 } shadowBufRec;
 
 /* Match defines from randr extension */
@@ -81,6 +86,12 @@ shadowAdd(ScreenPtr pScreen,
 extern _X_EXPORT void
  shadowRemove(ScreenPtr pScreen, PixmapPtr pPixmap);
 
+extern _X_EXPORT Bool
+ shadowSetTiles(ScreenPtr pScreen, int threads);
+
+extern _X_EXPORT void
+ shadowInvalidateTiles(ScreenPtr pScreen);
+
 extern _X_EXPORT void
  shadowUpdateAfb4(ScreenPtr pScreen, shadowBufPtr pBuf);
 
@@ -100,6 +100,7 @@ SOFTWARE.
 #endif                          /* WIN32 */
 
 #include "dix/dix_priv.h"
+#include "dix/reqstats_priv.h"
 #include "os/audit.h"
 #include "os/auth.h"
 #include "os/osdep.h"
@@ -327,6 +328,8 @@ CreateWellKnownSockets(void)
 #if !defined(WIN32)
     OsSignal(SIGPIPE, SIG_IGN);
     OsSignal(SIGHUP, AutoResetServer);
+    if (reqStatsDumpSignal)
+        OsSignal(reqStatsDumpSignal, ReqStatsSignal);
 #endif
     OsSignal(SIGINT, GiveUp);
     OsSignal(SIGTERM, GiveUp);
@@ -658,6 +661,7 @@ AllocNewConnection(XtransConnInfo trans_conn, int fd, CARD32 conn_time)
     oc->auth_id = None;
     oc->conn_time = conn_time;
     oc->flags = 0;
+    oc->motion_compressed = 0;
     if (!(client = NextAvailableClient((void *) oc))) {
         free(oc);
         return NullClient;
@@ -76,6 +76,7 @@ SOFTWARE.
 #include <X11/Xproto.h>
 
 #include "dix/dix_priv.h"
+#include "dix/reqstats_priv.h"
 
 #include "os.h"
 #include "osdep.h"
@@ -96,21 +97,69 @@ typedef struct _connectionInput {
     unsigned int ignoreBytes;   /* bytes to ignore before the next request */
 } ConnectionInput;
 
+/*
+ * Output that could not be written right away and did not fit in the
+ * connection's output buffer.  Large payloads handed over with
+ * WriteToClientNoCopy() are queued by reference; everything else is
+ * copied into the chunk.  Chunks are sent after the output buffer, in
+ * order.
+ */
+typedef struct _outputChunk {
+    struct _outputChunk *next;
+    char *data;                 /* start of unwritten data */
+    long count;                 /* bytes of unwritten data */
+    long pad;                   /* padding bytes to send after data */
+    long room;                  /* free space after data, copies only */
+    void *owned;                /* caller buffer to free once written */
+} OutputChunk, *OutputChunkPtr;
+
+/*
+ * Motion events for a client that stopped reading can be compressed: an
+ * event written with a key replaces the queued event with the same key,
+ * as long as nothing but other keyed events was queued after it.  Those
+ * trailing events are tracked while they sit in the last buffer output is
+ * copied into, and forgotten whenever output is written or something else
+ * is queued.
+ */
+#define OUTPUT_RUN_KEYS 16
+
+typedef struct _outputRunEntry {
+    CARD64 key;
+    long offset;                /* in the buffer the run is in */
+    long count;
+} OutputRunEntry;
+
 typedef struct _connectionOutput {
     struct _connectionOutput *next;
     unsigned char *buf;
     int size;
     int count;
+    OutputChunkPtr chunks;      /* queued after buf */
+    OutputChunkPtr last_chunk;
+    Bool blocked;               /* the client stopped reading */
+    OutputChunkPtr run_chunk;   /* the run is in this chunk, or in buf */
+    int run_len;
+    OutputRunEntry run[OUTPUT_RUN_KEYS];
 } ConnectionOutput;
 
 static ConnectionInputPtr AllocateInputBuffer(void);
 static ConnectionOutputPtr AllocateOutputBuffer(void);
+static int FlushOutput(ClientPtr who, OsCommPtr oc, const char *extraBuf,
+                       int extraCount, void **owned);
+static void CoalesceOutput(ClientPtr who, ConnectionOutputPtr oco,
+                           CARD64 key);
+static void RecordOutput(ConnectionOutputPtr oco, CARD64 key, long count);
+static Bool QueueOutput(ConnectionOutputPtr oco, const char *buf, long count,
+                        long pad, void **owned);
+static void FreeOutputChunks(ConnectionOutputPtr oco);
 
 static Bool CriticalOutputPending;
 static int timesThisConnection = 0;
 static ConnectionInputPtr FreeInputs = (ConnectionInputPtr) NULL;
 static ConnectionOutputPtr FreeOutputs = (ConnectionOutputPtr) NULL;
 static OsCommPtr AvailableInput = (OsCommPtr) NULL;
+static Bool CompressAllMotion = FALSE;
+static CARD64 MotionCompressed;
 
 #define get_req_len(req,cli) ((cli)->swapped ? \
 			      bswap_16((req)->length) : (req)->length)
@@ -123,6 +172,7 @@ static OsCommPtr AvailableInput = (OsCommPtr) NULL;
 
 #define BUFSIZE 16384
 #define BUFWATERMARK 32768
+#define OUTPUT_IOVECS 16
 
 /*
  *   A lot of the code in this file manipulates a ConnectionInputPtr:
@@ -682,13 +732,15 @@ AbortClient(ClientPtr client)
  *    this routine as int.
  *****************/
 
-int
-WriteToClient(ClientPtr who, int count, const void *__buf)
+static int
+WriteOutput(ClientPtr who, int count, const void *__buf, void **owned,
+            CARD64 key)
 {
     OsCommPtr oc;
     ConnectionOutputPtr oco;
     int padBytes;
     const char *buf = __buf;
+    Bool record;
 
     BUG_RETURN_VAL_MSG(in_input_thread(), 0,
                        "******** %s called from input thread *********\n", __FUNCTION__);
@@ -795,6 +847,29 @@ WriteToClient(ClientPtr who, int count, const void *__buf)
         }
     }
 #endif
+    record = key && oco->blocked &&
+        (CompressAllMotion || oc->flags & OS_COMM_COMPRESS_MOTION);
+    if (record)
+        CoalesceOutput(who, oco, key);
+    else
+        oco->run_len = 0;
+
+    if (oco->chunks) {
+        /* Already backed up, the socket will tell us when to continue */
+        if (!QueueOutput(oco, buf, count, padBytes, owned)) {
+            AbortClient(who);
+            MarkClientException(who);
+            FreeOutputChunks(oco);
+            oco->count = 0;
+            return -1;
+        }
+        if (record)
+            RecordOutput(oco, key, count + padBytes);
+        NewOutputPending = TRUE;
+        output_pending_mark(who);
+        return count;
+    }
+
     if ((oco->count == 0 && who->local) || oco->count + count + padBytes > oco->size) {
         output_pending_clear(who);
         if (!any_output_pending()) {
@@ -802,7 +877,7 @@ WriteToClient(ClientPtr who, int count, const void *__buf)
             NewOutputPending = FALSE;
         }
 
-        return FlushClient(who, oc, buf, count);
+        return FlushOutput(who, oc, buf, count, owned);
     }
 
     NewOutputPending = TRUE;
@@ -813,9 +888,93 @@ WriteToClient(ClientPtr who, int count, const void *__buf)
         memset(oco->buf + oco->count, '\0', padBytes);
         oco->count += padBytes;
     }
+    if (record)
+        RecordOutput(oco, key, count + padBytes);
     return count;
 }
 
+int
+WriteToClient(ClientPtr who, int count, const void *buf)
+{
+    return WriteOutput(who, count, buf, NULL, 0);
+}
+
+/*****************
+ * WriteMotionToClient
+ *    Like WriteToClient, for a motion event that makes any earlier one
+ *    with the same non-zero key obsolete.  When motion compression is
+ *    enabled for the client and it is not reading its output, such an
+ *    earlier event still queued is dropped.
+ *****************/
+
+int
+WriteMotionToClient(ClientPtr who, int count, const void *buf, CARD64 key)
+{
+    return WriteOutput(who, count, buf, NULL, key);
+}
+
+/* Enable or disable motion compression for one client, or for all */
+void
+SetMotionCompression(ClientPtr client, Bool enable)
+{
+    OsCommPtr oc;
+
+    if (!client) {
+        CompressAllMotion = enable;
+        return;
+    }
+
+    oc = client->osPrivate;
+    if (!oc)
+        return;
+    if (enable)
+        oc->flags |= OS_COMM_COMPRESS_MOTION;
+    else
+        oc->flags &= ~OS_COMM_COMPRESS_MOTION;
+}
+
+/*
+ * Whether motion is compressed for the client, or for all clients, and
+ * the number of events dropped for it, or for all clients, since the
+ * counter was last reset.
+ */
+Bool
+GetMotionCompression(ClientPtr client, CARD64 *compressed, Bool reset)
+{
+    OsCommPtr oc;
+
+    if (!client) {
+        *compressed = MotionCompressed;
+        if (reset)
+            MotionCompressed = 0;
+        return CompressAllMotion;
+    }
+
+    oc = client->osPrivate;
+    if (!oc) {
+        *compressed = 0;
+        return CompressAllMotion;
+    }
+    *compressed = oc->motion_compressed;
+    if (reset)
+        oc->motion_compressed = 0;
+    return CompressAllMotion || oc->flags & OS_COMM_COMPRESS_MOTION;
+}
+
+/*****************
+ * WriteToClientNoCopy
+ *    Like WriteToClient, but *buf must be a malloc'd buffer.  If the
+ *    client is not keeping up and the data is large, the buffer itself is
+ *    queued instead of a copy: *buf is set to NULL and the buffer is freed
+ *    once it has been written.  Otherwise the caller still owns *buf.
+ *****************/
+
+int
+WriteToClientNoCopy(ClientPtr who, int count, void **buf)
+{
+    return WriteOutput(who, count, *buf, buf, 0);
+}
+
  /********************
  * FlushClient()
  *    If the client isn't keeping up with us, then we try to continue
@@ -827,119 +986,287 @@ WriteToClient(ClientPtr who, int count, const void *__buf)
  **********************/
 
 int
-FlushClient(ClientPtr who, OsCommPtr oc, const void *__extraBuf, int extraCount)
+FlushClient(ClientPtr who, OsCommPtr oc, const void *extraBuf, int extraCount)
+{
+    return FlushOutput(who, oc, extraBuf, extraCount, NULL);
+}
+
+static void
+FreeOutputChunks(ConnectionOutputPtr oco)
+{
+    OutputChunkPtr chunk;
+
+    while ((chunk = oco->chunks)) {
+        oco->chunks = chunk->next;
+        free(chunk->owned);
+        free(chunk);
+    }
+    oco->last_chunk = NULL;
+    oco->run_len = 0;
+}
+
+/* The buffer output is copied into last, and how much it holds */
+static char *
+OutputTail(ConnectionOutputPtr oco, OutputChunkPtr *chunk, long *count)
+{
+    if ((*chunk = oco->last_chunk)) {
+        *count = (*chunk)->count;
+        return (*chunk)->data;
+    }
+    *count = oco->count;
+    return (char *) oco->buf;
+}
+
+/*
+ * Drop the queued output with the given key, if it is part of the run of
+ * keyed output at the end of the queue.
+ */
+static void
+CoalesceOutput(ClientPtr who, ConnectionOutputPtr oco, CARD64 key)
+{
+    OutputChunkPtr chunk;
+    long count, offset, len;
+    char *data = OutputTail(oco, &chunk, &count);
+    int i;
+
+    if (chunk != oco->run_chunk) {
+        oco->run_len = 0;
+        return;
+    }
+
+    for (i = 0; i < oco->run_len; i++)
+        if (oco->run[i].key == key)
+            break;
+    if (i == oco->run_len)
+        return;
+
+    offset = oco->run[i].offset;
+    len = oco->run[i].count;
+    memmove(data + offset, data + offset + len, count - offset - len);
+    if (chunk) {
+        chunk->count -= len;
+        chunk->room += len;
+    }
+    else
+        oco->count -= len;
+
+    for (oco->run_len--; i < oco->run_len; i++) {
+        oco->run[i] = oco->run[i + 1];
+        oco->run[i].offset -= len;
+    }
+
+    ((OsCommPtr) who->osPrivate)->motion_compressed++;
+    MotionCompressed++;
+}
+
+/* Remember where the keyed output that was just queued went */
+static void
+RecordOutput(ConnectionOutputPtr oco, CARD64 key, long len)
+{
+    OutputChunkPtr chunk;
+    long count;
+
+    OutputTail(oco, &chunk, &count);
+    if (chunk != oco->run_chunk || (chunk && chunk->owned)) {
+        oco->run_chunk = chunk;
+        oco->run_len = 0;
+    }
+    if (oco->run_len == OUTPUT_RUN_KEYS || (chunk && chunk->owned))
+        return;
+
+    oco->run[oco->run_len].key = key;
+    oco->run[oco->run_len].offset = count - len;
+    oco->run[oco->run_len].count = len;
+    oco->run_len++;
+}
+
+/*
+ * Queue output behind what is already pending.  If owned is set and the
+ * data is large, the caller's buffer is queued by reference and *owned is
+ * cleared; otherwise the data is copied.
+ */
+static Bool
+QueueOutput(ConnectionOutputPtr oco, const char *buf, long count, long pad,
+            void **owned)
+{
+    OutputChunkPtr chunk = NULL, last = oco->last_chunk;
+
+    if (owned && *owned && count >= BUFSIZE) {
+        chunk = malloc(sizeof(OutputChunk));
+        if (!chunk)
+            return FALSE;
+        chunk->data = (char *) buf;
+        chunk->count = count;
+        chunk->pad = pad;
+        chunk->room = 0;
+        chunk->owned = *owned;
+        *owned = NULL;
+    }
+    else {
+        char *dst;
+
+        if (!oco->chunks && oco->count + count + pad <= oco->size) {
+            dst = (char *) oco->buf + oco->count;
+            oco->count += count + pad;
+        }
+        else if (last && last->room >= count + pad) {
+            dst = last->data + last->count;
+            last->count += count + pad;
+            last->room -= count + pad;
+        }
+        else {
+            long size = max(count + pad, BUFSIZE);
+
+            chunk = malloc(sizeof(OutputChunk) + size);
+            if (!chunk)
+                return FALSE;
+            chunk->data = (char *) (chunk + 1);
+            chunk->count = count + pad;
+            chunk->pad = 0;
+            chunk->room = size - chunk->count;
+            chunk->owned = NULL;
+            dst = chunk->data;
+        }
+
+        if (count)
+            memcpy(dst, buf, count);
+        memset(dst + count, '\0', pad);
+
+        if (!chunk)
+            return TRUE;
+    }
+
+    chunk->next = NULL;
+    if (last)
+        last->next = chunk;
+    else
+        oco->chunks = chunk;
+    oco->last_chunk = chunk;
+    return TRUE;
+}
+
+static inline void
+AddIOV(struct iovec *iov, int *i, long *remain, const void *base, long len)
+{
+    /* Once something was cut short, nothing after it may go out */
+    if (len <= 0 || *remain <= 0 || *i >= OUTPUT_IOVECS)
+        return;
+    if (len > *remain)
+        len = *remain;
+    iov[*i].iov_base = (void *) base;
+    iov[*i].iov_len = len;
+    (*i)++;
+    *remain -= len;
+}
+
+static inline long
+Consume(long *count, long len)
+{
+    long n = min(*count, len);
+
+    *count -= n;
+    return len - n;
+}
+
+static int
+FlushOutputBuffers(ClientPtr who, OsCommPtr oc, const char *extraBuf,
+                   int extraCount, void **owned)
 {
     ConnectionOutputPtr oco = oc->output;
     XtransConnInfo trans_conn = oc->trans_conn;
-    struct iovec iov[3];
+    struct iovec iov[OUTPUT_IOVECS];
     static char padBuffer[3];
-    const char *extraBuf = __extraBuf;
-    long written;
+    OutputChunkPtr chunk;
+    long extraLeft = extraCount;
     long padsize;
-    long notWritten;
     long todo;
+    long len;
 
     if (!oco)
 	return 0;
-    written = 0;
+    /* Whatever gets written, the run of keyed output moves */
+    oco->run_len = 0;
     padsize = padding_for_int32(extraCount);
-    notWritten = oco->count + extraCount + padsize;
-    if (!notWritten)
+    if (!oco->count && !oco->chunks && !extraCount)
         return 0;
 
     if (FlushCallback)
         CallCallbacks(&FlushCallback, who);
 
-    todo = notWritten;
-    while (notWritten) {
-        long before = written;  /* amount of whole thing written */
-        long remain = todo;     /* amount to try this time, <= notWritten */
+    todo = LONG_MAX;
+    for (;;) {
+        long remain = todo;
+        long attempted;
         int i = 0;
-        long len;
-
-        /* You could be very general here and have "in" and "out" iovecs
-         * and write a loop without using a macro, but what the heck.  This
-         * translates to:
-         *
-         *     how much of this piece is new?
-         *     if more new then we are trying this time, clamp
-         *     if nothing new
-         *         then bump down amount already written, for next piece
-         *         else put new stuff in iovec, will need all of next piece
-         *
-         * Note that todo had better be at least 1 or else we'll end up
-         * writing 0 iovecs.
-         */
-#define InsertIOV(pointer, length) \
-	len = (length) - before; \
-	if (len > remain) \
-	    len = remain; \
-	if (len <= 0) { \
-	    before = (-len); \
-	} else { \
-	    iov[i].iov_len = len; \
-	    iov[i].iov_base = (pointer) + before;	\
-	    i++; \
-	    remain -= len; \
-	    before = 0; \
-	}
-
-        InsertIOV((char *) oco->buf, oco->count)
-            InsertIOV((char *) extraBuf, extraCount)
-            InsertIOV(padBuffer, padsize)
-
-            errno = 0;
+
+        AddIOV(iov, &i, &remain, oco->buf, oco->count);
+        for (chunk = oco->chunks; chunk; chunk = chunk->next) {
+            AddIOV(iov, &i, &remain, chunk->data, chunk->count);
+            AddIOV(iov, &i, &remain, padBuffer, chunk->pad);
+        }
+        AddIOV(iov, &i, &remain, extraBuf, extraLeft);
+        AddIOV(iov, &i, &remain, padBuffer, padsize);
+
+        if (!i)
+            break;              /* everything was written */
+        attempted = todo - remain;
+
+        errno = 0;
         if (trans_conn && (len = _XSERVTransWritev(trans_conn, iov, i)) >= 0) {
-            written += len;
-            notWritten -= len;
-            todo = notWritten;
+            if (len >= oco->count) {
+                len -= oco->count;
+                oco->count = 0;
+            }
+            else {
+                oco->count -= len;
+                memmove((char *) oco->buf, (char *) oco->buf + len, oco->count);
+                len = 0;
+            }
+
+            while (len && (chunk = oco->chunks)) {
+                long n = min(chunk->count, len);
+
+                chunk->data += n;
+                len = Consume(&chunk->count, len);
+                len = Consume(&chunk->pad, len);
+                if (chunk->count || chunk->pad)
+                    break;
+                oco->chunks = chunk->next;
+                if (!oco->chunks)
+                    oco->last_chunk = NULL;
+                free(chunk->owned);
+                free(chunk);
+            }
+
+            if (len) {
+                long n = min(extraLeft, len);
+
+                extraBuf += n;
+                len = Consume(&extraLeft, len);
+                len = Consume(&padsize, len);
+            }
+            todo = LONG_MAX;
         }
         else if (ETEST(errno)
 #ifdef EMSGSIZE                 /* check for another brain-damaged OS bug */
-                 || ((errno == EMSGSIZE) && (todo == 1))
+                 || ((errno == EMSGSIZE) && (attempted == 1))
 #endif
             ) {
             /* If we've arrived here, then the client is stuffed to the gills
-               and not ready to accept more.  Make a note of it and buffer
+               and not ready to accept more.  Make a note of it and queue
                the rest. */
             output_pending_mark(who);
+            oco->blocked = TRUE;
 
-            if (written < oco->count) {
-                if (written > 0) {
-                    oco->count -= written;
-                    memmove((char *) oco->buf,
-                            (char *) oco->buf + written, oco->count);
-                    written = 0;
-                }
-            }
-            else {
-                written -= oco->count;
+            if ((extraLeft || padsize) &&
+                !QueueOutput(oco, extraBuf, extraLeft, padsize, owned)) {
+                AbortClient(who);
+                MarkClientException(who);
+                FreeOutputChunks(oco);
                 oco->count = 0;
+                return -1;
             }
 
-            if (notWritten > oco->size) {
-                unsigned char *obuf = NULL;
-
-                if (notWritten + BUFSIZE <= INT_MAX) {
-                    obuf = realloc(oco->buf, notWritten + BUFSIZE);
-                }
-                if (!obuf) {
-                    AbortClient(who);
-                    MarkClientException(who);
-                    oco->count = 0;
-                    return -1;
-                }
-                oco->size = notWritten + BUFSIZE;
-                oco->buf = obuf;
-            }
-
-            /* If the amount written extended into the padBuffer, then the
-               difference "extraCount - written" may be less than 0 */
-            if ((len = extraCount - written) > 0)
-                memmove((char *) oco->buf + oco->count,
-                        extraBuf + written, len);
-
-            oco->count = notWritten;    /* this will include the pad */
             ospoll_listen(server_poll, oc->fd, X_NOTIFY_WRITE);
 
             /* return only the amount explicitly requested */
@@ -947,12 +1274,13 @@ FlushClient(ClientPtr who, OsCommPtr oc, const void *__extraBuf, int extraCount)
         }
 #ifdef EMSGSIZE                 /* check for another brain-damaged OS bug */
         else if (errno == EMSGSIZE) {
-            todo >>= 1;
+            todo = attempted >> 1;
         }
 #endif
         else {
             AbortClient(who);
             MarkClientException(who);
+            FreeOutputChunks(oco);
             oco->count = 0;
             return -1;
         }
@@ -960,6 +1288,7 @@ FlushClient(ClientPtr who, OsCommPtr oc, const void *__extraBuf, int extraCount)
 
     /* everything was flushed out */
     oco->count = 0;
+    oco->blocked = FALSE;
     output_pending_clear(who);
 
     if (oco->size > BUFWATERMARK) {
@@ -974,6 +1303,24 @@ FlushClient(ClientPtr who, OsCommPtr oc, const void *__extraBuf, int extraCount)
     return extraCount;          /* return only the amount explicitly requested */
 }
 
+static int
+FlushOutput(ClientPtr who, OsCommPtr oc, const char *extraBuf, int extraCount,
+            void **owned)
+{
+    ConnectionOutputPtr oco = oc->output;
+    CARD64 start;
+    int ret;
+
+    if (!reqStatsEnabled || !oco ||
+        (!oco->count && !oco->chunks && !extraCount))
+        return FlushOutputBuffers(who, oc, extraBuf, extraCount, owned);
+
+    start = GetTimeInMicros();
+    ret = FlushOutputBuffers(who, oc, extraBuf, extraCount, owned);
+    ReqStatsRecordFlush(who, start);
+    return ret;
+}
+
 static ConnectionInputPtr
 AllocateInputBuffer(void)
 {
@@ -1010,6 +1357,10 @@ AllocateOutputBuffer(void)
     }
     oco->size = BUFSIZE;
     oco->count = 0;
+    oco->chunks = NULL;
+    oco->last_chunk = NULL;
+    oco->blocked = FALSE;
+    oco->run_len = 0;
     return oco;
 }
 
@@ -1036,6 +1387,7 @@ FreeOsBuffers(OsCommPtr oc)
         }
     }
     if ((oco = oc->output)) {
+        FreeOutputChunks(oco);
         if (FreeOutputs) {
             free(oco->buf);
             free(oco);
@@ -1044,6 +1396,7 @@ FreeOsBuffers(OsCommPtr oc)
             FreeOutputs = oco;
             oco->next = (ConnectionOutputPtr) NULL;
             oco->count = 0;
+            oco->blocked = FALSE;
         }
     }
 }
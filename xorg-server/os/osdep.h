@@ -98,10 +98,12 @@ typedef struct _osComm {
     CARD32 conn_time;           /* timestamp if not established, else 0  */
     struct _XtransConnInfo *trans_conn; /* transport connection object */
     int flags;
+    CARD64 motion_compressed;   /* events dropped, see io.c */
 } OsCommRec, *OsCommPtr;
 
 #define OS_COMM_GRAB_IMPERVIOUS 1
 #define OS_COMM_IGNORED         2
+#define OS_COMM_COMPRESS_MOTION 4
 
 extern int FlushClient(ClientPtr /*who */ ,
                        OsCommPtr /*oc */ ,
@@ -112,6 +114,11 @@ extern int FlushClient(ClientPtr /*who */ ,
 extern void FreeOsBuffers(OsCommPtr     /*oc */
     );
 
+/* Motion event compression for clients that stopped reading, see io.c */
+int WriteMotionToClient(ClientPtr who, int count, const void *buf, CARD64 key);
+void SetMotionCompression(ClientPtr client, Bool enable);
+Bool GetMotionCompression(ClientPtr client, CARD64 *compressed, Bool reset);
+
 void
 CloseDownFileDescriptor(OsCommPtr oc);
 
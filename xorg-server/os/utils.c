@@ -109,6 +109,7 @@ __stdcall unsigned long GetTickCount(void);
 #endif
 
 #include "dix/dix_priv.h"
+#include "dix/reqstats_priv.h"
 #include "os/auth.h"
 #include "os/cmdline.h"
 #include "os/ddx_priv.h"
@@ -547,8 +548,10 @@ UseMsg(void)
     ErrorF("+byteswappedclients    Allow clients with endianess different to that of the server\n");
     ErrorF("-byteswappedclients    Prohibit clients with endianess different to that of the server\n");
     ErrorF("-cc int                default color visual class\n");
+    ErrorF("-compressmotion        drop stale motion events queued for clients not reading them\n");
     ErrorF("-nocursor              disable the cursor\n");
     ErrorF("-core                  generate core dump on fatal error\n");
+    ErrorF("-damageboxes int       coalesce internal damage beyond this many boxes (0 = never)\n");
     ErrorF("-displayfd fd          file descriptor to write display number to when ready to connect\n");
 #ifdef _MSC_VER
     ErrorF("-dpi [auto|int]        screen resolution set to native or this dpi\n");
@@ -592,6 +595,7 @@ UseMsg(void)
     ErrorF("-render [default|mono|gray|color] set render color alloc policy\n");
     ErrorF("-retro                 start with classic stipple\n");
     ErrorF("-seat string           seat to run on\n");
+    ErrorF("-shadowtiles int       tiled shadow framebuffer updates with this many threads (0 = off)\n");
     ErrorF("-t #                   default pointer threshold (pixels/t)\n");
     ErrorF("-terminate [delay]     terminate at server reset (optional delay in sec)\n");
     ErrorF("-tst                   disable testing extensions\n");
@@ -603,6 +607,8 @@ UseMsg(void)
     ErrorF
         ("-dumbSched             Disable smart scheduling and threaded input, enable old behavior\n");
     ErrorF("-schedInterval int     Set scheduler interval in msec\n");
+    ErrorF("-requeststats          Collect per-client request latency statistics\n");
+    ErrorF("-requeststatssignal n  Dump request statistics on signal n (0 = none)\n");
     ErrorF("+extension name        Enable extension\n");
     ErrorF("-extension name        Disable extension\n");
     ListStaticExtensions();
@@ -758,6 +764,8 @@ ProcessCommandLine(int argc, char *argv[])
             else
                 UseMsg();
         }
+        else if (strcmp(argv[i], "-compressmotion") == 0)
+            SetMotionCompression(NULL, TRUE);
         else if (strcmp(argv[i], "-core") == 0) {
 #if !defined(WIN32) || !defined(__MINGW32__)
             struct rlimit core_limit;
@@ -768,6 +776,23 @@ ProcessCommandLine(int argc, char *argv[])
 #endif
             CoreDump = TRUE;
         }
+        else if (strcmp(argv[i], "-damageboxes") == 0) {
+            if (++i < argc) {
+                damageMaxBoxes = atoi(argv[i]);
+                if (damageMaxBoxes < 0) {
+                    UseMsg();
+                    FatalError("damageboxes must not be negative\n");
+                }
+            }
+            else
+                UseMsg();
+        }
+        else if (strcmp(argv[i], "-shadowtiles") == 0) {
+            if (++i < argc)
+                shadowTileThreads = atoi(argv[i]);
+            else
+                UseMsg();
+        }
         else if (strcmp(argv[i], "-nocursor") == 0) {
             EnableCursor = FALSE;
         }
@@ -1034,6 +1059,15 @@ ProcessCommandLine(int argc, char *argv[])
             SmartScheduleSignalEnable = FALSE;
 #endif
         }
+        else if (strcmp(argv[i], "-requeststats") == 0) {
+            ReqStatsEnable(TRUE);
+        }
+        else if (strcmp(argv[i], "-requeststatssignal") == 0) {
+            if (++i < argc)
+                reqStatsDumpSignal = atoi(argv[i]);
+            else
+                UseMsg();
+        }
         else if (strcmp(argv[i], "-schedInterval") == 0) {
             if (++i < argc) {
                 SmartScheduleInterval = atoi(argv[i]);
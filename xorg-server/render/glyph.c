@@ -26,8 +26,6 @@
 #include <dix-config.h>
 #endif
 
-#include "os/xsha1.h"
-
 #include "misc.h"
 #include "scrnintstr.h"
 #include "os.h"
@@ -117,9 +115,158 @@ FindGlyphHashSet(CARD32 filled)
     return 0;
 }
 
+/*
+ * Glyphs are shared between glyphsets through the global tables, keyed by
+ * a 128-bit hash of their metrics and bitmap.  The hash is not meant to
+ * resist collisions, so a glyph only matches when its bitmap is the same
+ * as well; see GlyphBitsEqual.
+ */
+
+#define GlyphSignature(hash)	((CARD32) (hash)[0])
+
+typedef struct {
+    CARD64 *hash;
+    xGlyphInfo *gi;
+    CARD8 *bits;                /* the bitmap as sent by the client, or */
+    GlyphPtr glyph;             /* a glyph with the same bitmap */
+    Bool same;                  /* only glyph itself matches */
+} GlyphKeyRec, *GlyphKeyPtr;
+
+static PicturePtr
+GlyphBitsPicture(GlyphPtr glyph)
+{
+    PicturePtr pPicture;
+    int i;
+
+    for (i = 0; i < screenInfo.numScreens; i++) {
+        pPicture = GetGlyphPicture(glyph, screenInfo.screens[i]);
+        if (pPicture && pPicture->pDrawable)
+            return pPicture;
+    }
+    return NULL;
+}
+
+/*
+ * Compare one row of width pixels, ignoring the padding and the bits
+ * above depth in each pixel, neither of which is rendered.
+ */
+static Bool
+GlyphRowEqual(CARD8 *a, CARD8 *b, int width, int depth)
+{
+    int bpp = BitsPerPixel(depth);
+    int bits = width * bpp;
+    int i;
+
+    if (depth != bpp && bpp >= 8) {
+        CARD32 mask = (1U << depth) - 1;
+
+        for (i = 0; i < width; i++) {
+            switch (bpp) {
+            case 8:
+                if ((a[i] ^ b[i]) & mask)
+                    return FALSE;
+                break;
+            case 16:
+                if ((((CARD16 *) a)[i] ^ ((CARD16 *) b)[i]) & mask)
+                    return FALSE;
+                break;
+            default:
+                if ((((CARD32 *) a)[i] ^ ((CARD32 *) b)[i]) & mask)
+                    return FALSE;
+                break;
+            }
+        }
+        return TRUE;
+    }
+
+    if (memcmp(a, b, bits >> 3))
+        return FALSE;
+    if (bits & 7) {
+        CARD8 mask = screenInfo.bitmapBitOrder == LSBFirst ?
+            (1 << (bits & 7)) - 1 : 0xff << (8 - (bits & 7));
+
+        if ((a[bits >> 3] ^ b[bits >> 3]) & mask)
+            return FALSE;
+    }
+    return TRUE;
+}
+
+#define GLYPH_COMPARE_BYTES	1024
+
+/*
+ * Compare the bitmap of a glyph with the client's, or with another
+ * glyph's, reading it back from the first screen that realized it.  When
+ * there is no bitmap to read back the hash has to do.
+ */
+static Bool
+GlyphBitsEqual(GlyphPtr glyph, CARD8 *bits, GlyphPtr other)
+{
+    PicturePtr pPicture = GlyphBitsPicture(glyph);
+    PicturePtr pOther = other ? GlyphBitsPicture(other) : NULL;
+    CARD32 local[2][GLYPH_COMPARE_BYTES / sizeof(CARD32)];
+    CARD8 *a = (CARD8 *) local[0], *b = (CARD8 *) local[1];
+    DrawablePtr pDrawable;
+    int width = glyph->info.width, height = glyph->info.height;
+    int stride, rows, y, n, i;
+    Bool equal = TRUE;
+
+    if (!pPicture || (other && !pOther))
+        return TRUE;
+
+    pDrawable = pPicture->pDrawable;
+    stride = PixmapBytePad(width, pDrawable->depth);
+    rows = GLYPH_COMPARE_BYTES / stride;
+    if (!rows) {
+        rows = 1;
+        a = malloc(stride);
+        b = malloc(stride);
+        if (!a || !b) {
+            free(a);
+            free(b);
+            return TRUE;
+        }
+    }
+
+    for (y = 0; equal && y < height; y += n) {
+        n = min(rows, height - y);
+        (*pDrawable->pScreen->GetImage) (pDrawable, 0, y, width, n,
+                                         ZPixmap, ~0, (char *) a);
+        if (pOther)
+            (*pOther->pDrawable->pScreen->GetImage) (pOther->pDrawable,
+                                                     0, y, width, n,
+                                                     ZPixmap, ~0, (char *) b);
+        for (i = 0; equal && i < n; i++)
+            equal = GlyphRowEqual(a + i * stride,
+                                  pOther ? b + i * stride :
+                                  bits + (y + i) * stride,
+                                  width, pDrawable->depth);
+    }
+
+    if (a != (CARD8 *) local[0]) {
+        free(a);
+        free(b);
+    }
+    return equal;
+}
+
+static Bool
+GlyphKeyMatch(GlyphPtr glyph, GlyphKeyPtr key)
+{
+    if (glyph == key->glyph)
+        return TRUE;
+    if (key->same ||
+        memcmp(glyph->hash, key->hash, sizeof(glyph->hash)) != 0 ||
+        memcmp(&glyph->info, key->gi, sizeof(xGlyphInfo)) != 0)
+        return FALSE;
+    return GlyphBitsEqual(glyph, key->bits, key->glyph);
+}
+
+/*
+ * Look up signature in hash.  Glyphset tables are keyed by glyph id
+ * alone and pass no key; the global tables also need the key to match.
+ */
 static GlyphRefPtr
-FindGlyphRef(GlyphHashPtr hash,
-             CARD32 signature, Bool match, unsigned char sha1[20])
+FindGlyphRef(GlyphHashPtr hash, CARD32 signature, GlyphKeyPtr key)
 {
     CARD32 elt, step, s;
     GlyphPtr glyph;
@@ -145,8 +292,7 @@ FindGlyphRef(GlyphHashPtr hash,
             else if (gr == del)
                 break;
         }
-        else if (s == signature &&
-                 (!match || memcmp(glyph->sha1, sha1, 20) == 0)) {
+        else if (s == signature && (!key || GlyphKeyMatch(glyph, key))) {
             break;
         }
         if (!step) {
@@ -161,38 +307,114 @@ FindGlyphRef(GlyphHashPtr hash,
     return gr;
 }
 
-int
-HashGlyph(xGlyphInfo * gi,
-          CARD8 *bits, unsigned long size, unsigned char sha1[20])
-{
-    void *ctx = x_sha1_init();
-    int success;
-
-    if (!ctx)
-        return BadAlloc;
-
-    success = x_sha1_update(ctx, gi, sizeof(xGlyphInfo));
-    if (!success)
-        return BadAlloc;
-    success = x_sha1_update(ctx, bits, size);
-    if (!success)
-        return BadAlloc;
-    success = x_sha1_final(ctx, sha1);
-    if (!success)
-        return BadAlloc;
-    return Success;
+#define GLYPH_HASH_C1	0x87c37b91114253d5ULL
+#define GLYPH_HASH_C2	0x4cf5ad432745937fULL
+
+static inline CARD64
+GlyphHashRotate(CARD64 x, int r)
+{
+    return (x << r) | (x >> (64 - r));
 }
 
+static inline CARD64
+GlyphHashLoad(const CARD8 *p)
+{
+    CARD64 v;
+
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline CARD64
+GlyphHashFinish(CARD64 h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/*
+ * MurmurHash3 (x64, 128 bits) of the bitmap, seeded with the glyph
+ * metrics.  It needs no state beyond the two halves of the result, so
+ * a whole AddGlyphs request is hashed without allocating anything.
+ */
+void
+HashGlyph(xGlyphInfo * gi, CARD8 *bits, unsigned long size, CARD64 hash[2])
+{
+    CARD64 h1, h2, k1, k2;
+    CARD32 rest;
+    CARD8 tail[16];
+    unsigned long i;
+
+    memcpy(&h1, gi, sizeof(h1));
+    memcpy(&rest, (CARD8 *) gi + sizeof(h1), sizeof(rest));
+    h2 = rest | ((CARD64) size << 32);
+
+    for (i = 0; i + 16 <= size; i += 16) {
+        k1 = GlyphHashLoad(bits + i);
+        k2 = GlyphHashLoad(bits + i + 8);
+
+        k1 *= GLYPH_HASH_C1;
+        k1 = GlyphHashRotate(k1, 31);
+        k1 *= GLYPH_HASH_C2;
+        h1 ^= k1;
+        h1 = GlyphHashRotate(h1, 27);
+        h1 += h2;
+        h1 = h1 * 5 + 0x52dce729;
+
+        k2 *= GLYPH_HASH_C2;
+        k2 = GlyphHashRotate(k2, 33);
+        k2 *= GLYPH_HASH_C1;
+        h2 ^= k2;
+        h2 = GlyphHashRotate(h2, 31);
+        h2 += h1;
+        h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    if (i < size) {
+        memset(tail, 0, sizeof(tail));
+        memcpy(tail, bits + i, size - i);
+        k1 = GlyphHashLoad(tail);
+        k2 = GlyphHashLoad(tail + 8);
+
+        k1 *= GLYPH_HASH_C1;
+        k1 = GlyphHashRotate(k1, 31);
+        k1 *= GLYPH_HASH_C2;
+        h1 ^= k1;
+
+        k2 *= GLYPH_HASH_C2;
+        k2 = GlyphHashRotate(k2, 33);
+        k2 *= GLYPH_HASH_C1;
+        h2 ^= k2;
+    }
+
+    h1 ^= size;
+    h2 ^= size;
+    h1 += h2;
+    h2 += h1;
+    h1 = GlyphHashFinish(h1);
+    h2 = GlyphHashFinish(h2);
+    h1 += h2;
+    h2 += h1;
+
+    hash[0] = h1;
+    hash[1] = h2;
+}
+
+/* Find a glyph with the given metrics and bitmap */
 GlyphPtr
-FindGlyphByHash(unsigned char sha1[20], int format)
+FindGlyphByHash(CARD64 hash[2], xGlyphInfo * gi, CARD8 *bits, int format)
 {
+    GlyphKeyRec key = { .hash = hash, .gi = gi, .bits = bits };
     GlyphRefPtr gr;
-    CARD32 signature = *(CARD32 *) sha1;
 
     if (!globalGlyphs[format].hashSet)
         return NULL;
 
-    gr = FindGlyphRef(&globalGlyphs[format], signature, TRUE, sha1);
+    gr = FindGlyphRef(&globalGlyphs[format], GlyphSignature(hash), &key);
 
     if (gr->glyph && gr->glyph != DeletedGlyph)
         return gr->glyph;
@@ -251,10 +473,12 @@ FreeGlyph(GlyphPtr glyph, int format)
     CheckDuplicates(&globalGlyphs[format], "FreeGlyph");
     BUG_RETURN(glyph->refcnt == 0);
     if (--glyph->refcnt == 0) {
+        GlyphKeyRec key = { .glyph = glyph, .same = TRUE };
         GlyphRefPtr gr;
+
+#ifdef CHECK_DUPLICATES
         int i;
         int first;
-        CARD32 signature;
 
         first = -1;
         for (i = 0; i < globalGlyphs[format].hashSet->size; i++)
@@ -263,11 +487,14 @@ FreeGlyph(GlyphPtr glyph, int format)
                     DuplicateRef(glyph, "FreeGlyph check");
                 first = i;
             }
+#endif
 
-        signature = *(CARD32 *) glyph->sha1;
-        gr = FindGlyphRef(&globalGlyphs[format], signature, TRUE, glyph->sha1);
+        gr = FindGlyphRef(&globalGlyphs[format], GlyphSignature(glyph->hash),
+                          &key);
+#ifdef CHECK_DUPLICATES
         if (gr - globalGlyphs[format].table != first)
             DuplicateRef(glyph, "Found wrong one");
+#endif
         if (gr->glyph && gr->glyph != DeletedGlyph) {
             gr->glyph = DeletedGlyph;
             gr->signature = 0;
@@ -282,14 +509,15 @@ FreeGlyph(GlyphPtr glyph, int format)
 void
 AddGlyph(GlyphSetPtr glyphSet, GlyphPtr glyph, Glyph id)
 {
+    GlyphKeyRec key = { .hash = glyph->hash, .gi = &glyph->info,
+                        .glyph = glyph };
     GlyphRefPtr gr;
     CARD32 signature;
 
     CheckDuplicates(&globalGlyphs[glyphSet->fdepth], "AddGlyph top global");
     /* Locate existing matching glyph */
-    signature = *(CARD32 *) glyph->sha1;
-    gr = FindGlyphRef(&globalGlyphs[glyphSet->fdepth], signature,
-                      TRUE, glyph->sha1);
+    signature = GlyphSignature(glyph->hash);
+    gr = FindGlyphRef(&globalGlyphs[glyphSet->fdepth], signature, &key);
     if (gr->glyph && gr->glyph != DeletedGlyph && gr->glyph != glyph) {
         glyph = gr->glyph;
     }
@@ -300,7 +528,7 @@ AddGlyph(GlyphSetPtr glyphSet, GlyphPtr glyph, Glyph id)
     }
 
     /* Insert/replace glyphset value */
-    gr = FindGlyphRef(&glyphSet->hash, id, FALSE, 0);
+    gr = FindGlyphRef(&glyphSet->hash, id, NULL);
     ++glyph->refcnt;
     if (gr->glyph && gr->glyph != DeletedGlyph)
         FreeGlyph(gr->glyph, glyphSet->fdepth);
@@ -317,7 +545,7 @@ DeleteGlyph(GlyphSetPtr glyphSet, Glyph id)
     GlyphRefPtr gr;
     GlyphPtr glyph;
 
-    gr = FindGlyphRef(&glyphSet->hash, id, FALSE, 0);
+    gr = FindGlyphRef(&glyphSet->hash, id, NULL);
     glyph = gr->glyph;
     if (glyph && glyph != DeletedGlyph) {
         gr->glyph = DeletedGlyph;
@@ -333,7 +561,7 @@ FindGlyph(GlyphSetPtr glyphSet, Glyph id)
 {
     GlyphPtr glyph;
 
-    glyph = FindGlyphRef(&glyphSet->hash, id, FALSE, 0)->glyph;
+    glyph = FindGlyphRef(&glyphSet->hash, id, NULL)->glyph;
     if (glyph == DeletedGlyph)
         glyph = 0;
     return glyph;
@@ -418,8 +646,10 @@ ResizeGlyphHash(GlyphHashPtr hash, CARD32 change, Bool global)
         for (i = 0; i < oldSize; i++) {
             glyph = hash->table[i].glyph;
             if (glyph && glyph != DeletedGlyph) {
+                GlyphKeyRec key = { .glyph = glyph, .same = TRUE };
+
                 s = hash->table[i].signature;
-                gr = FindGlyphRef(&newHash, s, global, glyph->sha1);
+                gr = FindGlyphRef(&newHash, s, global ? &key : NULL);
 
                 gr->signature = s;
                 gr->glyph = glyph;
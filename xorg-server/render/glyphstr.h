@@ -38,7 +38,7 @@
 typedef struct _Glyph {
     CARD32 refcnt;
     PrivateRec *devPrivates;
-    unsigned char sha1[20];
+    CARD64 hash[2];             /* of info + bitmap, see HashGlyph */
     CARD32 size;                /* info + bitmap */
     xGlyphInfo info;
     /* per-screen pixmaps follow */
@@ -988,7 +988,8 @@ typedef struct _GlyphNew {
     Glyph id;
     GlyphPtr glyph;
     Bool found;
-    unsigned char sha1[20];
+    CARD8 *bits;
+    CARD64 hash[2];
 } GlyphNewRec, *GlyphNewPtr;
 
 #define NeedsComponent(f) (PICT_FORMAT_A(f) != 0 && PICT_FORMAT_RGB(f) != 0)
@@ -1056,6 +1057,7 @@ ProcRenderAddGlyphs(ClientPtr client)
         goto bail;
     }
 
+    /* Check and hash every glyph before uploading any of them */
     for (i = 0; i < nglyphs; i++) {
         size_t padded_width;
 
@@ -1071,11 +1073,25 @@ ProcRenderAddGlyphs(ClientPtr client)
         if (remain < size)
             break;
 
-        err = HashGlyph(&gi[i], bits, size, glyph_new->sha1);
-        if (err)
-            goto bail;
+        glyph_new->id = gids[i];
+        glyph_new->bits = bits;
+        HashGlyph(&gi[i], bits, size, glyph_new->hash);
 
-        glyph_new->glyph = FindGlyphByHash(glyph_new->sha1, glyphSet->fdepth);
+        if (size & 3)
+            size += 4 - (size & 3);
+        bits += size;
+        remain -= size;
+    }
+    if (remain || i < nglyphs) {
+        err = BadLength;
+        goto bail;
+    }
+
+    for (i = 0; i < nglyphs; i++) {
+        glyph_new = &glyphs[i];
+
+        glyph_new->glyph = FindGlyphByHash(glyph_new->hash, &gi[i],
+                                           glyph_new->bits, glyphSet->fdepth);
 
         if (glyph_new->glyph && glyph_new->glyph != DeletedGlyph) {
             glyph_new->found = TRUE;
@@ -1105,7 +1121,8 @@ ProcRenderAddGlyphs(ClientPtr client)
                 pScreen = screenInfo.screens[screen];
                 pSrcPix = GetScratchPixmapHeader(pScreen,
                                                  width, height,
-                                                 depth, depth, -1, bits);
+                                                 depth, depth, -1,
+                                                 glyph_new->bits);
                 if (!pSrcPix) {
                     err = BadAlloc;
                     goto bail;
@@ -1154,19 +1171,8 @@ ProcRenderAddGlyphs(ClientPtr client)
                 pSrcPix = NULL;
             }
 
-            memcpy(glyph_new->glyph->sha1, glyph_new->sha1, 20);
+            memcpy(glyph->hash, glyph_new->hash, sizeof(glyph->hash));
         }
-
-        glyph_new->id = gids[i];
-
-        if (size & 3)
-            size += 4 - (size & 3);
-        bits += size;
-        remain -= size;
-    }
-    if (remain || i < nglyphs) {
-        err = BadLength;
-        goto bail;
     }
     if (!ResizeGlyphSet(glyphSet, nglyphs)) {
         err = BadAlloc;
@@ -0,0 +1,146 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* Test relies on assert() */
+#undef NDEBUG
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <X11/Xatom.h>
+#include "misc.h"
+#include "dix.h"
+
+#include "tests-common.h"
+
+#define STRESS_ATOMS 300000
+
+static void
+atom_predefined(void)
+{
+    InitAtoms();
+
+    assert(MakeAtom("PRIMARY", 7, FALSE) == XA_PRIMARY);
+    assert(MakeAtom("WM_TRANSIENT_FOR", 16, TRUE) == XA_WM_TRANSIENT_FOR);
+    assert(strcmp(NameForAtom(XA_PRIMARY), "PRIMARY") == 0);
+    assert(strcmp(NameForAtom(XA_LAST_PREDEFINED), "WM_TRANSIENT_FOR") == 0);
+
+    assert(!ValidAtom(None));
+    assert(ValidAtom(XA_LAST_PREDEFINED));
+    assert(!ValidAtom(XA_LAST_PREDEFINED + 1));
+    assert(NameForAtom(None) == NULL);
+    assert(NameForAtom(XA_LAST_PREDEFINED + 1) == NULL);
+
+    /* the first new atom follows the built-in ones */
+    assert(MakeAtom("NOT_YET", 7, FALSE) == None);
+    assert(MakeAtom("NOT_YET", 7, TRUE) == XA_LAST_PREDEFINED + 1);
+    assert(MakeAtom("NOT_YET", 7, FALSE) == XA_LAST_PREDEFINED + 1);
+
+    FreeAllAtoms();
+}
+
+static void
+atom_lengths(void)
+{
+    Atom a, b;
+
+    InitAtoms();
+
+    /* only len bytes of the string are part of the name */
+    a = MakeAtom("PREFIX_AND_MORE", 6, TRUE);
+    assert(a != None);
+    assert(strcmp(NameForAtom(a), "PREFIX") == 0);
+    assert(MakeAtom("PREFIX", 6, FALSE) == a);
+    assert(MakeAtom("PREFIX_", 7, FALSE) == None);
+    assert(MakeAtom("PREFI", 5, FALSE) == None);
+
+    /* names stop at an embedded NUL */
+    b = MakeAtom("PREFIX\0TAIL", 11, TRUE);
+    assert(b == a);
+
+    /* the empty name is an atom of its own */
+    b = MakeAtom("", 0, TRUE);
+    assert(b != None && b != a);
+    assert(strcmp(NameForAtom(b), "") == 0);
+
+    FreeAllAtoms();
+}
+
+static void
+atom_stress(void)
+{
+    char name[32];
+    Atom first, a;
+    int i;
+
+    InitAtoms();
+
+    first = XA_LAST_PREDEFINED + 1;
+    for (i = 0; i < STRESS_ATOMS; i++) {
+        snprintf(name, sizeof(name), "STRESS_ATOM_%d", i);
+        a = MakeAtom(name, strlen(name), TRUE);
+        assert(a == first + i);
+    }
+    assert(ValidAtom(first + STRESS_ATOMS - 1));
+    assert(!ValidAtom(first + STRESS_ATOMS));
+
+    /* interning again must hand back the same atoms, in any order */
+    for (i = STRESS_ATOMS - 1; i >= 0; i -= 7) {
+        snprintf(name, sizeof(name), "STRESS_ATOM_%d", i);
+        assert(MakeAtom(name, strlen(name), TRUE) == first + i);
+        assert(MakeAtom(name, strlen(name), FALSE) == first + i);
+        assert(strcmp(NameForAtom(first + i), name) == 0);
+    }
+
+    for (i = 0; i < STRESS_ATOMS; i += 101) {
+        snprintf(name, sizeof(name), "STRESS_ATOM_%d_X", i);
+        assert(MakeAtom(name, strlen(name), FALSE) == None);
+    }
+    assert(!ValidAtom(first + STRESS_ATOMS));
+
+    /* the built-in atoms are still where they were */
+    assert(MakeAtom("WM_NAME", 7, FALSE) == XA_WM_NAME);
+    assert(strcmp(NameForAtom(XA_WM_NAME), "WM_NAME") == 0);
+
+    /* a reset starts numbering over */
+    InitAtoms();
+    assert(!ValidAtom(first));
+    assert(MakeAtom("STRESS_ATOM_0", 13, FALSE) == None);
+    assert(MakeAtom("STRESS_ATOM_0", 13, TRUE) == first);
+
+    FreeAllAtoms();
+}
+
+const testfunc_t*
+atom_test(void)
+{
+    static const testfunc_t testfuncs[] = {
+        atom_predefined,
+        atom_lengths,
+        atom_stress,
+        NULL,
+    };
+    return testfuncs;
+}
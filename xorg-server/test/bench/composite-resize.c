@@ -0,0 +1,259 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Drags the bottom-right corner of an automatically redirected window
+ * back and forth, the way an interactive resize under a compositing
+ * manager does, so the server replaces the window's backing pixmap on
+ * every ConfigureWindow.  The window is repainted after every step and
+ * its last pixel read back to check the recycled pixmap is usable.
+ *
+ * Afterwards a window hanging off the screen edge is painted and
+ * destroyed, and a window with no background is mapped in its place; its
+ * off-screen part must read back cleared, not with the old window's
+ * pixels.  The pool counters are printed from X-Resource.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/uio.h>
+#include <xcb/xcb.h>
+#include <xcb/xcbext.h>
+
+#include "bench.h"
+
+#define MIN_WIDTH 300
+#define MIN_HEIGHT 200
+#define STEPS 200
+#define ROUNDS 10
+
+#define X_CompositeRedirectWindow 1
+#define CompositeRedirectAutomatic 0
+#define X_XResQueryCompositePool 66
+
+typedef struct {
+    uint8_t type;
+    uint8_t disabled;
+    uint16_t sequence;
+    uint32_t length;
+    uint32_t num_pixmaps;
+    uint32_t bytes;
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t recycled;
+    uint32_t expired;
+    uint32_t evicted;
+    uint32_t pad;
+} pool_reply_t;
+
+static void
+redirect_window(xcb_connection_t *c, uint8_t opcode, xcb_window_t window)
+{
+    struct {
+        uint8_t major;
+        uint8_t minor;
+        uint16_t length;
+        uint32_t window;
+        uint8_t update;
+        uint8_t pad[3];
+    } req = { opcode, X_CompositeRedirectWindow, 3, window,
+              CompositeRedirectAutomatic };
+    static const xcb_protocol_request_t proto = {
+        .count = 1,
+        .ext = NULL,
+        .opcode = 0,
+        .isvoid = 1
+    };
+    struct iovec vec[3];
+
+    vec[2].iov_base = &req;
+    vec[2].iov_len = sizeof(req);
+    xcb_send_request(c, XCB_REQUEST_RAW, vec + 2, &proto);
+}
+
+static pool_reply_t *
+query_pool(xcb_connection_t *c, uint8_t opcode)
+{
+    struct {
+        uint8_t major;
+        uint8_t minor;
+        uint16_t length;
+        uint32_t screen;
+        uint32_t flags;
+    } req = { opcode, X_XResQueryCompositePool, 3, 0, 0 };
+    static const xcb_protocol_request_t proto = {
+        .count = 1,
+        .ext = NULL,
+        .opcode = 0,
+        .isvoid = 0
+    };
+    struct iovec vec[3];
+    unsigned int seq;
+
+    vec[2].iov_base = &req;
+    vec[2].iov_len = sizeof(req);
+    seq = xcb_send_request(c, XCB_REQUEST_RAW, vec + 2, &proto);
+    return xcb_wait_for_reply(c, seq, NULL);
+}
+
+/*
+ * Map a painted window half off the screen, destroy it, and map a window
+ * without background at the same place.  Returns the last pixel of the
+ * second window, which lies off the screen.
+ */
+static int
+stale_pixel(xcb_connection_t *c, uint8_t opcode, xcb_screen_t *screen)
+{
+    int16_t x = screen->width_in_pixels - MIN_WIDTH / 2;
+    xcb_get_image_reply_t *image;
+    xcb_window_t window;
+    uint32_t value = screen->white_pixel;
+    int pixel = -1;
+
+    window = xcb_generate_id(c);
+    xcb_create_window(c, XCB_COPY_FROM_PARENT, window, screen->root,
+                      x, 0, MIN_WIDTH, MIN_HEIGHT, 0,
+                      XCB_WINDOW_CLASS_INPUT_OUTPUT, screen->root_visual,
+                      XCB_CW_BACK_PIXEL, &value);
+    redirect_window(c, opcode, window);
+    xcb_map_window(c, window);
+    xcb_destroy_window(c, window);
+
+    window = xcb_generate_id(c);
+    xcb_create_window(c, XCB_COPY_FROM_PARENT, window, screen->root,
+                      x, 0, MIN_WIDTH, MIN_HEIGHT, 0,
+                      XCB_WINDOW_CLASS_INPUT_OUTPUT, screen->root_visual,
+                      0, NULL);
+    redirect_window(c, opcode, window);
+    xcb_map_window(c, window);
+
+    image = xcb_get_image_reply(c,
+                xcb_get_image(c, XCB_IMAGE_FORMAT_Z_PIXMAP, window,
+                              MIN_WIDTH - 1, MIN_HEIGHT - 1, 1, 1, ~0),
+                NULL);
+    if (image && xcb_get_image_data_length(image) >= 1)
+        pixel = xcb_get_image_data(image)[0];
+    free(image);
+    xcb_destroy_window(c, window);
+    return pixel;
+}
+
+int
+main(int argc, char **argv)
+{
+    xcb_connection_t *c = xcb_connect(NULL, NULL);
+    xcb_query_extension_reply_t *ext;
+    xcb_query_extension_reply_t *xres;
+    pool_reply_t *pool;
+    xcb_get_image_reply_t *image;
+    xcb_screen_t *screen;
+    xcb_window_t window;
+    xcb_gcontext_t gc;
+    xcb_rectangle_t rect;
+    uint32_t values[2];
+    double start;
+    int i, n, bad = 0;
+
+    if (xcb_connection_has_error(c)) {
+        fprintf(stderr, "cannot connect to the server\n");
+        return 1;
+    }
+    ext = xcb_query_extension_reply(c, xcb_query_extension(c, 9,
+                                                           "Composite"),
+                                    NULL);
+    if (!ext || !ext->present) {
+        fprintf(stderr, "Composite extension not present\n");
+        return 1;
+    }
+    screen = xcb_setup_roots_iterator(xcb_get_setup(c)).data;
+
+    window = xcb_generate_id(c);
+    values[0] = screen->black_pixel;
+    xcb_create_window(c, XCB_COPY_FROM_PARENT, window, screen->root,
+                      0, 0, MIN_WIDTH, MIN_HEIGHT, 0,
+                      XCB_WINDOW_CLASS_INPUT_OUTPUT, screen->root_visual,
+                      XCB_CW_BACK_PIXEL, values);
+    redirect_window(c, ext->major_opcode, window);
+    xcb_map_window(c, window);
+
+    gc = xcb_generate_id(c);
+    values[0] = screen->white_pixel;
+    values[1] = 0;
+    xcb_create_gc(c, gc, window, XCB_GC_FOREGROUND | XCB_GC_GRAPHICS_EXPOSURES,
+                  values);
+    free(xcb_get_input_focus_reply(c, xcb_get_input_focus(c), NULL));
+
+    start = now();
+    for (n = 0; n < ROUNDS; n++) {
+        for (i = 0; i < STEPS; i++) {
+            int step = n & 1 ? STEPS - 1 - i : i;
+
+            rect.x = rect.y = 0;
+            rect.width = MIN_WIDTH + step * 3;
+            rect.height = MIN_HEIGHT + step * 2;
+            values[0] = rect.width;
+            values[1] = rect.height;
+            xcb_configure_window(c, window, XCB_CONFIG_WINDOW_WIDTH |
+                                 XCB_CONFIG_WINDOW_HEIGHT, values);
+            xcb_poly_fill_rectangle(c, window, gc, 1, &rect);
+
+            image = xcb_get_image_reply(c,
+                        xcb_get_image(c, XCB_IMAGE_FORMAT_Z_PIXMAP, window,
+                                      rect.width - 1, rect.height - 1, 1, 1,
+                                      ~0), NULL);
+            if (!image || xcb_get_image_data_length(image) < 1 ||
+                xcb_get_image_data(image)[0] == 0)
+                bad++;
+            free(image);
+        }
+    }
+    report("resize steps", ROUNDS * STEPS, now() - start);
+
+    if (bad || xcb_connection_has_error(c)) {
+        fprintf(stderr, "%d steps read back the wrong contents\n", bad);
+        return 1;
+    }
+
+    if (stale_pixel(c, ext->major_opcode, screen) != 0) {
+        fprintf(stderr, "recycled pixmap kept the old window's contents\n");
+        return 1;
+    }
+
+    xres = xcb_query_extension_reply(c, xcb_query_extension(c, 10,
+                                                            "X-Resource"),
+                                     NULL);
+    if (xres && xres->present &&
+        (pool = query_pool(c, xres->major_opcode))) {
+        printf("pool: %u pixmaps, %u KiB; %u hits, %u misses, "
+               "%u recycled, %u expired, %u evicted%s\n",
+               pool->num_pixmaps, pool->bytes >> 10, pool->hits,
+               pool->misses, pool->recycled, pool->expired, pool->evicted,
+               pool->disabled ? " (disabled)" : "");
+        free(pool);
+    }
+    free(xres);
+
+    free(ext);
+    xcb_disconnect(c);
+    return 0;
+}
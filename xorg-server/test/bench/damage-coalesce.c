@@ -0,0 +1,149 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Scatters thousands of tiny rectangles per frame into an automatically
+ * redirected window, the way a terminal or chart redraws, so the server
+ * accumulates very fragmented damage for the window and composites it
+ * to the parent after every frame.  Run it once with the default damage
+ * box budget and once with -damageboxes 0 to compare frame times.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/uio.h>
+#include <xcb/xcb.h>
+#include <xcb/xcbext.h>
+
+#include "bench.h"
+
+#define WIDTH 1024
+#define HEIGHT 768
+#define RECTS_PER_FRAME 4000
+#define FRAMES 300
+
+#define X_CompositeRedirectWindow 1
+#define CompositeRedirectAutomatic 0
+
+static void
+redirect_window(xcb_connection_t *c, uint8_t opcode, xcb_window_t window)
+{
+    struct {
+        uint8_t major;
+        uint8_t minor;
+        uint16_t length;
+        uint32_t window;
+        uint8_t update;
+        uint8_t pad[3];
+    } req = { opcode, X_CompositeRedirectWindow, 3, window,
+              CompositeRedirectAutomatic };
+    static const xcb_protocol_request_t proto = {
+        .count = 1,
+        .ext = NULL,
+        .opcode = 0,
+        .isvoid = 1
+    };
+    struct iovec vec[3];
+
+    vec[2].iov_base = &req;
+    vec[2].iov_len = sizeof(req);
+    xcb_send_request(c, XCB_REQUEST_RAW, vec + 2, &proto);
+}
+
+int
+main(int argc, char **argv)
+{
+    xcb_connection_t *c = xcb_connect(NULL, NULL);
+    xcb_query_extension_reply_t *ext;
+    xcb_screen_t *screen;
+    xcb_rectangle_t *rects;
+    xcb_window_t parent, window;
+    xcb_gcontext_t gc;
+    uint32_t values[2];
+    unsigned int seed = 1;
+    double start;
+    int i, n;
+
+    if (xcb_connection_has_error(c)) {
+        fprintf(stderr, "cannot connect to the server\n");
+        return 1;
+    }
+    ext = xcb_query_extension_reply(c, xcb_query_extension(c, 9,
+                                                           "Composite"),
+                                    NULL);
+    if (!ext || !ext->present) {
+        fprintf(stderr, "Composite extension not present\n");
+        return 1;
+    }
+    screen = xcb_setup_roots_iterator(xcb_get_setup(c)).data;
+
+    parent = xcb_generate_id(c);
+    values[0] = screen->black_pixel;
+    xcb_create_window(c, XCB_COPY_FROM_PARENT, parent, screen->root,
+                      0, 0, WIDTH, HEIGHT, 0, XCB_WINDOW_CLASS_INPUT_OUTPUT,
+                      screen->root_visual, XCB_CW_BACK_PIXEL, values);
+    window = xcb_generate_id(c);
+    xcb_create_window(c, XCB_COPY_FROM_PARENT, window, parent,
+                      0, 0, WIDTH, HEIGHT, 0, XCB_WINDOW_CLASS_INPUT_OUTPUT,
+                      screen->root_visual, XCB_CW_BACK_PIXEL, values);
+    redirect_window(c, ext->major_opcode, window);
+    xcb_map_window(c, window);
+    xcb_map_window(c, parent);
+
+    gc = xcb_generate_id(c);
+    values[0] = screen->white_pixel;
+    values[1] = 0;
+    xcb_create_gc(c, gc, window, XCB_GC_FOREGROUND | XCB_GC_GRAPHICS_EXPOSURES,
+                  values);
+
+    rects = calloc(RECTS_PER_FRAME, sizeof(xcb_rectangle_t));
+    if (!rects)
+        return 1;
+    free(xcb_get_input_focus_reply(c, xcb_get_input_focus(c), NULL));
+
+    start = now();
+    for (n = 0; n < FRAMES; n++) {
+        for (i = 0; i < RECTS_PER_FRAME; i++) {
+            rects[i].x = rand_r(&seed) % (WIDTH - 3);
+            rects[i].y = rand_r(&seed) % (HEIGHT - 3);
+            rects[i].width = 1 + rand_r(&seed) % 3;
+            rects[i].height = 1 + rand_r(&seed) % 3;
+        }
+        values[0] = n & 1 ? screen->white_pixel : screen->black_pixel;
+        xcb_change_gc(c, gc, XCB_GC_FOREGROUND, values);
+        xcb_poly_fill_rectangle(c, window, gc, RECTS_PER_FRAME, rects);
+        /* The parent is repainted before the server waits for requests */
+        free(xcb_get_input_focus_reply(c, xcb_get_input_focus(c), NULL));
+    }
+    report("scattered-rect frames", FRAMES, now() - start);
+
+    if (xcb_connection_has_error(c)) {
+        fprintf(stderr, "connection error\n");
+        return 1;
+    }
+
+    free(rects);
+    free(ext);
+    xcb_disconnect(c);
+    return 0;
+}
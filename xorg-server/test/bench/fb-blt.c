@@ -0,0 +1,133 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Scrolls pixmaps of depth 8, 16 and 24 with CopyArea the way terminals
+ * do, sweeping the width of the area, the pixel offset of the source
+ * relative to the destination and the direction of the scroll.  Scrolling
+ * down and right overlap the source in a way pixman_blt() won't handle,
+ * so those go through fbBlt().
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <xcb/xcb.h>
+
+#include "bench.h"
+
+#define HEIGHT 512
+#define LINE 16
+#define COPIES 2000
+
+static const int depths[] = { 8, 16, 24 };
+static const int widths[] = { 16, 64, 256, 1024 };
+static const char *const directions[] = { "up", "down", "left", "right" };
+
+static void
+scroll(xcb_connection_t *c, xcb_pixmap_t pixmap, xcb_gcontext_t gc,
+       int width, int offset, int direction)
+{
+    int16_t sx = LINE, sy = LINE, dx = LINE, dy = LINE;
+    int i;
+
+    switch (direction) {
+    case 0:
+        sy += LINE;
+        break;
+    case 1:
+        dy += LINE;
+        break;
+    case 2:
+        sx += offset + 1;
+        break;
+    case 3:
+        dx += offset + 1;
+        break;
+    }
+    /* Vertical scrolls still shift by a few pixels to vary the alignment */
+    if (direction < 2)
+        sx += offset;
+
+    for (i = 0; i < COPIES; i++)
+        xcb_copy_area(c, pixmap, pixmap, gc, sx, sy, dx, dy,
+                      width, HEIGHT - 3 * LINE);
+    sync_server(c);
+}
+
+int
+main(int argc, char **argv)
+{
+    xcb_connection_t *c = xcb_connect(NULL, NULL);
+    xcb_screen_t *screen;
+    char name[32];
+    int d, w, offset, direction;
+
+    if (xcb_connection_has_error(c)) {
+        fprintf(stderr, "cannot connect to the server\n");
+        return 1;
+    }
+    screen = xcb_setup_roots_iterator(xcb_get_setup(c)).data;
+
+    for (d = 0; d < sizeof(depths) / sizeof(depths[0]); d++) {
+        xcb_pixmap_t pixmap = xcb_generate_id(c);
+        xcb_gcontext_t gc = xcb_generate_id(c);
+        uint32_t values[2] = { 0, 0 };
+        xcb_rectangle_t rect = { 0, 0, 1024 + 4 * LINE, HEIGHT };
+        xcb_void_cookie_t cookie;
+        xcb_generic_error_t *error;
+
+        cookie = xcb_create_pixmap_checked(c, depths[d], pixmap, screen->root,
+                                           rect.width, rect.height);
+        if ((error = xcb_request_check(c, cookie))) {
+            printf("depth %d pixmaps not supported, skipped\n", depths[d]);
+            free(error);
+            continue;
+        }
+        xcb_create_gc(c, gc, pixmap,
+                      XCB_GC_FOREGROUND | XCB_GC_GRAPHICS_EXPOSURES, values);
+        xcb_poly_fill_rectangle(c, pixmap, gc, 1, &rect);
+
+        for (w = 0; w < sizeof(widths) / sizeof(widths[0]); w++)
+            for (offset = 0; offset < 4; offset++)
+                for (direction = 0; direction < 4; direction++) {
+                    double start = now();
+
+                    scroll(c, pixmap, gc, widths[w], offset, direction);
+                    snprintf(name, sizeof(name), "d%d w%d +%d %s",
+                             depths[d], widths[w], offset,
+                             directions[direction]);
+                    report(name, COPIES, now() - start);
+                }
+
+        xcb_free_gc(c, gc);
+        xcb_free_pixmap(c, pixmap);
+    }
+
+    if (xcb_connection_has_error(c)) {
+        fprintf(stderr, "connection error\n");
+        return 1;
+    }
+
+    xcb_disconnect(c);
+    return 0;
+}
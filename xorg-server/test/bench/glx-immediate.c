@@ -0,0 +1,340 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Replays an immediate mode GL stream through indirect GLX, the way
+ * libGL sends it: every glColor, glNormal and glVertex becomes a render
+ * command, packed into GLXRender requests of RENDER_BUFFER bytes.  Each
+ * frame is a mesh of triangle strips followed by a glFinish.  The same
+ * frames are replayed with an EdgeFlag in every strip, which keeps the
+ * server from drawing them as vertex arrays, for comparison.  Finally the
+ * current color after a strip is checked to have survived it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/uio.h>
+#include <xcb/xcb.h>
+#include <xcb/xcbext.h>
+
+#include "bench.h"
+
+#define WIDTH 256
+#define HEIGHT 256
+#define ROWS 32
+#define COLUMNS 64
+#define FRAMES 200
+#define RENDER_BUFFER 65536
+
+#define X_GLXRender 1
+#define X_GLXCreateContext 3
+#define X_GLXMakeCurrent 5
+#define X_GLsop_Finish 108
+
+#define X_GLrop_Begin 4
+#define X_GLrop_Color4ubv 19
+#define X_GLrop_EdgeFlagv 22
+#define X_GLrop_End 23
+#define X_GLrop_Normal3fv 30
+#define X_GLrop_Vertex2fv 66
+#define X_GLrop_Vertex3fv 70
+#define X_GLrop_DrawBuffer 126
+
+#define GL_QUADS 7
+#define GL_TRIANGLE_STRIP 5
+#define GL_FRONT 0x0404
+
+typedef struct {
+    xcb_connection_t *c;
+    uint8_t opcode;
+    uint32_t tag;
+    int len;
+    struct {
+        uint8_t major;
+        uint8_t minor;
+        uint16_t length;
+        uint32_t tag;
+    } req;                      /* sent along with the commands after it */
+    uint8_t buf[RENDER_BUFFER];
+} stream_t;
+
+static unsigned int
+send_raw(xcb_connection_t *c, void *req, size_t len, int isvoid)
+{
+    xcb_protocol_request_t proto = {
+        .count = 1,
+        .ext = NULL,
+        .opcode = 0,
+        .isvoid = isvoid
+    };
+    struct iovec vec[3];
+
+    vec[2].iov_base = req;
+    vec[2].iov_len = len;
+    return xcb_send_request(c, XCB_REQUEST_RAW, vec + 2, &proto);
+}
+
+static void
+flush_render(stream_t *s)
+{
+    if (!s->len)
+        return;
+
+    s->req.major = s->opcode;
+    s->req.minor = X_GLXRender;
+    s->req.length = (sizeof(s->req) + s->len) >> 2;
+    s->req.tag = s->tag;
+    send_raw(s->c, &s->req, sizeof(s->req) + s->len, 1);
+    s->len = 0;
+}
+
+static void
+command(stream_t *s, uint16_t opcode, const void *data, uint16_t len)
+{
+    uint16_t header[2] = { 4 + len, opcode };
+
+    if (s->len + header[0] > RENDER_BUFFER)
+        flush_render(s);
+    memcpy(s->buf + s->len, header, sizeof(header));
+    memcpy(s->buf + s->len + 4, data, len);
+    s->len += header[0];
+}
+
+static void
+finish(stream_t *s)
+{
+    struct {
+        uint8_t major;
+        uint8_t minor;
+        uint16_t length;
+        uint32_t tag;
+    } req = { s->opcode, X_GLsop_Finish, 2, s->tag };
+
+    flush_render(s);
+    free(xcb_wait_for_reply(s->c, send_raw(s->c, &req, sizeof(req), 0),
+                            NULL));
+}
+
+static void
+color(stream_t *s, uint8_t r, uint8_t g, uint8_t b)
+{
+    uint8_t rgba[4] = { r, g, b, 255 };
+
+    command(s, X_GLrop_Color4ubv, rgba, sizeof(rgba));
+}
+
+static void
+vertex2(stream_t *s, float x, float y)
+{
+    float v[2] = { x, y };
+
+    command(s, X_GLrop_Vertex2fv, v, sizeof(v));
+}
+
+static void
+begin(stream_t *s, uint32_t mode)
+{
+    command(s, X_GLrop_Begin, &mode, sizeof(mode));
+}
+
+static void
+end(stream_t *s)
+{
+    command(s, X_GLrop_End, NULL, 0);
+}
+
+/* One frame: a mesh of strips with a color and a normal per vertex */
+static int
+frame(stream_t *s, int n, int edge_flags)
+{
+    uint32_t edge_flag = 1;
+    int row, column, vertices = 0;
+
+    for (row = 0; row < ROWS; row++) {
+        begin(s, GL_TRIANGLE_STRIP);
+        if (edge_flags)
+            command(s, X_GLrop_EdgeFlagv, &edge_flag, sizeof(edge_flag));
+        for (column = 0; column <= COLUMNS; column++) {
+            float x = column * 2.0f / COLUMNS - 1.0f;
+            float normal[3] = { 0.0f, 0.0f, 1.0f };
+            int i;
+
+            for (i = 0; i < 2; i++) {
+                float v[3] = { x, (row + i) * 2.0f / ROWS - 1.0f, 0.0f };
+
+                color(s, (column + n) * 4, row * 8, n);
+                command(s, X_GLrop_Normal3fv, normal, sizeof(normal));
+                command(s, X_GLrop_Vertex3fv, v, sizeof(v));
+                vertices++;
+            }
+        }
+        end(s);
+    }
+    finish(s);
+    return vertices;
+}
+
+static uint32_t
+pixel(xcb_connection_t *c, xcb_window_t window, int x, int y)
+{
+    xcb_get_image_reply_t *image;
+    uint32_t value = 0;
+
+    image = xcb_get_image_reply(c,
+                xcb_get_image(c, XCB_IMAGE_FORMAT_Z_PIXMAP, window,
+                              x, y, 1, 1, ~0), NULL);
+    if (image && xcb_get_image_data_length(image) >= 4)
+        memcpy(&value, xcb_get_image_data(image), 4);
+    free(image);
+    return value & 0xffffff;
+}
+
+int
+main(int argc, char **argv)
+{
+    xcb_connection_t *c = xcb_connect(NULL, NULL);
+    xcb_query_extension_reply_t *ext;
+    xcb_generic_error_t *error;
+    xcb_screen_t *screen;
+    xcb_window_t window;
+    uint32_t context, drawBuffer = GL_FRONT;
+    uint8_t *reply;
+    stream_t *s;
+    uint32_t values[1];
+    double start;
+    int i, n, vertices;
+
+    if (xcb_connection_has_error(c)) {
+        fprintf(stderr, "cannot connect to the server\n");
+        return 1;
+    }
+    ext = xcb_query_extension_reply(c, xcb_query_extension(c, 3, "GLX"),
+                                    NULL);
+    if (!ext || !ext->present) {
+        fprintf(stderr, "GLX extension not present\n");
+        return 1;
+    }
+    screen = xcb_setup_roots_iterator(xcb_get_setup(c)).data;
+
+    window = xcb_generate_id(c);
+    values[0] = screen->black_pixel;
+    xcb_create_window(c, XCB_COPY_FROM_PARENT, window, screen->root,
+                      0, 0, WIDTH, HEIGHT, 0,
+                      XCB_WINDOW_CLASS_INPUT_OUTPUT, screen->root_visual,
+                      XCB_CW_BACK_PIXEL, values);
+    xcb_map_window(c, window);
+
+    context = xcb_generate_id(c);
+    {
+        struct {
+            uint8_t major;
+            uint8_t minor;
+            uint16_t length;
+            uint32_t context;
+            uint32_t visual;
+            uint32_t screen;
+            uint32_t share;
+            uint8_t direct;
+            uint8_t pad[3];
+        } req = { ext->major_opcode, X_GLXCreateContext, 6, context,
+                  screen->root_visual, 0, 0, 0 };
+
+        send_raw(c, &req, sizeof(req), 1);
+    }
+    {
+        struct {
+            uint8_t major;
+            uint8_t minor;
+            uint16_t length;
+            uint32_t drawable;
+            uint32_t context;
+            uint32_t old_tag;
+        } req = { ext->major_opcode, X_GLXMakeCurrent, 4, window, context,
+                  0 };
+
+        reply = xcb_wait_for_reply(c, send_raw(c, &req, sizeof(req), 0),
+                                   &error);
+    }
+    if (!reply) {
+        fprintf(stderr, "cannot make a GLX context current on the root "
+                "visual (error %d)\n", error ? error->error_code : 0);
+        free(error);
+        return 1;
+    }
+
+    s = calloc(1, sizeof(*s));
+    s->c = c;
+    s->opcode = ext->major_opcode;
+    memcpy(&s->tag, reply + 8, sizeof(s->tag));
+    free(reply);
+
+    command(s, X_GLrop_DrawBuffer, &drawBuffer, sizeof(drawBuffer));
+    frame(s, 0, 0);
+
+    for (i = 0; i < 2; i++) {
+        start = now();
+        for (n = 0, vertices = 0; n < FRAMES; n++)
+            vertices += frame(s, n, i);
+        report(i ? "vertices, per command" : "vertices, batched", vertices,
+               now() - start);
+    }
+
+    /*
+     * Blue is current before a red strip, which must leave red current
+     * for a quad after it, drawn one command at a time.
+     */
+    color(s, 0, 0, 255);
+    begin(s, GL_TRIANGLE_STRIP);
+    color(s, 255, 0, 0);
+    for (i = 0; i < 10; i++) {
+        vertex2(s, i / 4.5f - 1.0f, -1.0f);
+        vertex2(s, i / 4.5f - 1.0f, 0.0f);
+    }
+    end(s);
+    begin(s, GL_QUADS);
+    vertex2(s, -1.0f, 0.0f);
+    vertex2(s, 1.0f, 0.0f);
+    vertex2(s, 1.0f, 1.0f);
+    vertex2(s, -1.0f, 1.0f);
+    end(s);
+    finish(s);
+
+    /* GL's origin is the bottom left */
+    if (pixel(c, window, WIDTH / 2, HEIGHT / 4) != 0xff0000 ||
+        pixel(c, window, WIDTH / 2, HEIGHT * 3 / 4) != 0xff0000) {
+        fprintf(stderr, "strip or quad drawn in the wrong color: "
+                "%06x %06x\n", pixel(c, window, WIDTH / 2, HEIGHT / 4),
+                pixel(c, window, WIDTH / 2, HEIGHT * 3 / 4));
+        return 1;
+    }
+
+    if (xcb_connection_has_error(c)) {
+        fprintf(stderr, "connection error\n");
+        return 1;
+    }
+
+    free(s);
+    free(ext);
+    xcb_disconnect(c);
+    return 0;
+}
@@ -0,0 +1,263 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Repaints a terminal's worth of anti-aliased text through RENDER
+ * CompositeGlyphs with an A8 mask format, the way toolkits redraw a text
+ * view on every expose and cursor blink.  The same page is drawn every
+ * frame first, then a page that changes every frame for comparison, and
+ * the frames per second of each are reported.
+ *
+ * Before that, the same two glyphs are drawn as one list and as an empty
+ * list followed by one with the rest of the offset, which must look the
+ * same however the server caches them.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <xcb/xcb.h>
+#include <xcb/render.h>
+
+#include "bench.h"
+
+#define COLUMNS 80
+#define ROWS 48
+#define GLYPH_WIDTH 8
+#define GLYPH_HEIGHT 14
+#define NUM_GLYPHS 95
+#define FRAMES 300
+
+static xcb_render_pictformat_t
+find_formats(xcb_connection_t *c, xcb_visualid_t visual,
+             xcb_render_pictformat_t *window_format)
+{
+    xcb_render_query_pict_formats_reply_t *reply;
+    xcb_render_pictforminfo_iterator_t fi;
+    xcb_render_pictscreen_iterator_t si;
+    xcb_render_pictformat_t a8 = 0;
+
+    reply = xcb_render_query_pict_formats_reply(c,
+                xcb_render_query_pict_formats(c), NULL);
+    if (!reply)
+        return 0;
+
+    for (fi = xcb_render_query_pict_formats_formats_iterator(reply);
+         fi.rem; xcb_render_pictforminfo_next(&fi)) {
+        if (fi.data->type == XCB_RENDER_PICT_TYPE_DIRECT &&
+            fi.data->depth == 8 && fi.data->direct.alpha_mask == 0xff &&
+            !fi.data->direct.red_mask)
+            a8 = fi.data->id;
+    }
+
+    *window_format = 0;
+    for (si = xcb_render_query_pict_formats_screens_iterator(reply);
+         si.rem; xcb_render_pictscreen_next(&si)) {
+        xcb_render_pictdepth_iterator_t di;
+
+        for (di = xcb_render_pictscreen_depths_iterator(si.data);
+             di.rem; xcb_render_pictdepth_next(&di)) {
+            xcb_render_pictvisual_t *v = xcb_render_pictdepth_visuals(di.data);
+            int i;
+
+            for (i = 0; i < di.data->num_visuals; i++)
+                if (v[i].visual == visual)
+                    *window_format = v[i].format;
+        }
+    }
+
+    free(reply);
+    return *window_format ? a8 : 0;
+}
+
+/* A line of text, as Xft sends it */
+static int
+build_row(uint8_t *cmds, int row, int frame)
+{
+    int16_t dx = 0, dy = row * (GLYPH_HEIGHT + 2) + GLYPH_HEIGHT;
+    int col;
+
+    cmds[0] = COLUMNS;
+    cmds[1] = cmds[2] = cmds[3] = 0;
+    memcpy(cmds + 4, &dx, 2);
+    memcpy(cmds + 6, &dy, 2);
+    for (col = 0; col < COLUMNS; col++)
+        cmds[8 + col] = 32 + (row * 7 + col * 3 + frame) % NUM_GLYPHS;
+    return 8 + ((COLUMNS + 3) & ~3);
+}
+
+static int
+glyph_elt(uint8_t *cmds, int16_t dx, int16_t dy, const char *text)
+{
+    int len = strlen(text);
+
+    cmds[0] = len;
+    cmds[1] = cmds[2] = cmds[3] = 0;
+    memcpy(cmds + 4, &dx, 2);
+    memcpy(cmds + 6, &dy, 2);
+    memcpy(cmds + 8, text, len);
+    return 8 + ((len + 3) & ~3);
+}
+
+static xcb_get_image_reply_t *
+draw_and_read(xcb_connection_t *c, xcb_window_t window,
+              xcb_render_picture_t src, xcb_render_picture_t dst,
+              xcb_render_pictformat_t a8, xcb_render_glyphset_t glyphset,
+              const uint8_t *cmds, int len)
+{
+    xcb_clear_area(c, 0, window, 0, 0, 0, 0);
+    xcb_render_composite_glyphs_8(c, XCB_RENDER_PICT_OP_OVER, src, dst, a8,
+                                  glyphset, 0, 0, len, cmds);
+    return xcb_get_image_reply(c,
+               xcb_get_image(c, XCB_IMAGE_FORMAT_Z_PIXMAP, window, 0, 0,
+                             8 * GLYPH_WIDTH, 2 * GLYPH_HEIGHT, ~0), NULL);
+}
+
+/* Returns 0 if both ways of offsetting the glyphs drew the same */
+static int
+split_lists(xcb_connection_t *c, xcb_window_t window,
+            xcb_render_picture_t src, xcb_render_picture_t dst,
+            xcb_render_pictformat_t a8, xcb_render_glyphset_t glyphset)
+{
+    uint8_t joined[16], split[24];
+    int joined_len, split_len, differ = 1;
+    xcb_get_image_reply_t *a, *b;
+
+    joined_len = glyph_elt(joined, 15, GLYPH_HEIGHT, "ab");
+    split_len = glyph_elt(split, 10, GLYPH_HEIGHT, "");
+    split_len += glyph_elt(split + split_len, 5, 0, "ab");
+
+    /* Drawn twice so the joined run is cached, then once more each */
+    free(draw_and_read(c, window, src, dst, a8, glyphset, joined,
+                       joined_len));
+    free(draw_and_read(c, window, src, dst, a8, glyphset, joined,
+                       joined_len));
+    a = draw_and_read(c, window, src, dst, a8, glyphset, split, split_len);
+    b = draw_and_read(c, window, src, dst, a8, glyphset, joined, joined_len);
+    if (a && b && xcb_get_image_data_length(a) ==
+        xcb_get_image_data_length(b))
+        differ = memcmp(xcb_get_image_data(a), xcb_get_image_data(b),
+                        xcb_get_image_data_length(a));
+    free(a);
+    free(b);
+    return differ;
+}
+
+static void
+pages(xcb_connection_t *c, xcb_render_picture_t src,
+      xcb_render_picture_t dst, xcb_render_pictformat_t a8,
+      xcb_render_glyphset_t glyphset, const char *name, int changing)
+{
+    uint8_t cmds[8 + COLUMNS + 3];
+    double start;
+    int n, row, len;
+
+    start = now();
+    for (n = 0; n < FRAMES; n++) {
+        for (row = 0; row < ROWS; row++) {
+            len = build_row(cmds, row, changing ? n : 0);
+            xcb_render_composite_glyphs_8(c, XCB_RENDER_PICT_OP_OVER,
+                                          src, dst, a8, glyphset, 0, 0,
+                                          len, cmds);
+        }
+    }
+    sync_server(c);
+    report(name, FRAMES, now() - start);
+}
+
+int
+main(int argc, char **argv)
+{
+    xcb_connection_t *c = xcb_connect(NULL, NULL);
+    xcb_screen_t *screen;
+    xcb_window_t window;
+    xcb_render_pictformat_t a8, window_format;
+    xcb_render_picture_t src, dst;
+    xcb_render_glyphset_t glyphset;
+    xcb_render_color_t white = { 0xffff, 0xffff, 0xffff, 0xffff };
+    xcb_render_glyphinfo_t info[NUM_GLYPHS];
+    uint32_t ids[NUM_GLYPHS];
+    static uint8_t bits[NUM_GLYPHS * GLYPH_WIDTH * GLYPH_HEIGHT];
+    uint32_t values[1];
+    unsigned int seed = 1;
+    int i;
+
+    if (xcb_connection_has_error(c)) {
+        fprintf(stderr, "cannot connect to the server\n");
+        return 1;
+    }
+    screen = xcb_setup_roots_iterator(xcb_get_setup(c)).data;
+
+    free(xcb_render_query_version_reply(c,
+             xcb_render_query_version(c, 0, 11), NULL));
+    a8 = find_formats(c, screen->root_visual, &window_format);
+    if (!a8) {
+        fprintf(stderr, "no A8 or window picture format\n");
+        return 1;
+    }
+
+    window = xcb_generate_id(c);
+    values[0] = screen->black_pixel;
+    xcb_create_window(c, XCB_COPY_FROM_PARENT, window, screen->root,
+                      0, 0, COLUMNS * GLYPH_WIDTH, ROWS * (GLYPH_HEIGHT + 2),
+                      0, XCB_WINDOW_CLASS_INPUT_OUTPUT, screen->root_visual,
+                      XCB_CW_BACK_PIXEL, values);
+    xcb_map_window(c, window);
+
+    dst = xcb_generate_id(c);
+    xcb_render_create_picture(c, dst, window, window_format, 0, NULL);
+    src = xcb_generate_id(c);
+    xcb_render_create_solid_fill(c, src, white);
+
+    glyphset = xcb_generate_id(c);
+    xcb_render_create_glyph_set(c, glyphset, a8);
+    for (i = 0; i < NUM_GLYPHS; i++) {
+        ids[i] = 32 + i;
+        info[i].width = GLYPH_WIDTH;
+        info[i].height = GLYPH_HEIGHT;
+        info[i].x = 0;
+        info[i].y = GLYPH_HEIGHT - 2;
+        info[i].x_off = GLYPH_WIDTH;
+        info[i].y_off = 0;
+    }
+    for (i = 0; i < (int) sizeof(bits); i++)
+        bits[i] = rand_r(&seed);
+    xcb_render_add_glyphs(c, glyphset, NUM_GLYPHS, ids, info,
+                          sizeof(bits), bits);
+    sync_server(c);
+
+    if (split_lists(c, window, src, dst, a8, glyphset)) {
+        fprintf(stderr, "glyphs after an empty list drawn misplaced\n");
+        return 1;
+    }
+
+    pages(c, src, dst, a8, glyphset, "unchanged page", 0);
+    pages(c, src, dst, a8, glyphset, "changing page", 1);
+
+    if (xcb_connection_has_error(c)) {
+        fprintf(stderr, "connection error\n");
+        return 1;
+    }
+
+    xcb_disconnect(c);
+    return 0;
+}
@@ -0,0 +1,160 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Uploads a CJK-sized font, 20000 A8 glyphs of 24x24, through RENDER
+ * AddGlyphs in batches the way Xft loads glyphs, then uploads the same
+ * font to a second glyphset, as a second client using the font would,
+ * which the server shares with the first.  The glyphs per second of each
+ * are reported.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <xcb/xcb.h>
+#include <xcb/render.h>
+
+#include "bench.h"
+
+#define GLYPH_SIZE 24
+#define NUM_GLYPHS 20000
+#define BATCH 256
+#define ROUNDS 5
+
+static xcb_render_pictformat_t
+find_a8(xcb_connection_t *c)
+{
+    xcb_render_query_pict_formats_reply_t *reply;
+    xcb_render_pictforminfo_iterator_t fi;
+    xcb_render_pictformat_t a8 = 0;
+
+    reply = xcb_render_query_pict_formats_reply(c,
+                xcb_render_query_pict_formats(c), NULL);
+    if (!reply)
+        return 0;
+
+    for (fi = xcb_render_query_pict_formats_formats_iterator(reply);
+         fi.rem; xcb_render_pictforminfo_next(&fi)) {
+        if (fi.data->type == XCB_RENDER_PICT_TYPE_DIRECT &&
+            fi.data->depth == 8 && fi.data->direct.alpha_mask == 0xff &&
+            !fi.data->direct.red_mask)
+            a8 = fi.data->id;
+    }
+
+    free(reply);
+    return a8;
+}
+
+static void
+upload(xcb_connection_t *c, xcb_render_glyphset_t glyphset,
+       const uint8_t *bits)
+{
+    xcb_render_glyphinfo_t info[BATCH];
+    uint32_t ids[BATCH];
+    int first, i, n;
+
+    for (i = 0; i < BATCH; i++) {
+        info[i].width = GLYPH_SIZE;
+        info[i].height = GLYPH_SIZE;
+        info[i].x = 0;
+        info[i].y = GLYPH_SIZE - 4;
+        info[i].x_off = GLYPH_SIZE;
+        info[i].y_off = 0;
+    }
+
+    for (first = 0; first < NUM_GLYPHS; first += n) {
+        n = NUM_GLYPHS - first < BATCH ? NUM_GLYPHS - first : BATCH;
+        for (i = 0; i < n; i++)
+            ids[i] = 0x4e00 + first + i;
+        xcb_render_add_glyphs(c, glyphset, n, ids, info,
+                              n * GLYPH_SIZE * GLYPH_SIZE,
+                              bits + (size_t) first * GLYPH_SIZE * GLYPH_SIZE);
+    }
+}
+
+int
+main(int argc, char **argv)
+{
+    xcb_connection_t *c = xcb_connect(NULL, NULL);
+    xcb_render_pictformat_t a8;
+    xcb_render_glyphset_t first, second;
+    double fresh = 0, shared = 0, start;
+    uint8_t *bits;
+    unsigned int seed = 1;
+    size_t i;
+    int round;
+
+    if (xcb_connection_has_error(c)) {
+        fprintf(stderr, "cannot connect to the server\n");
+        return 1;
+    }
+
+    free(xcb_render_query_version_reply(c,
+             xcb_render_query_version(c, 0, 11), NULL));
+    a8 = find_a8(c);
+    if (!a8) {
+        fprintf(stderr, "no A8 picture format\n");
+        return 1;
+    }
+
+    bits = malloc((size_t) NUM_GLYPHS * GLYPH_SIZE * GLYPH_SIZE);
+    if (!bits)
+        return 1;
+    for (i = 0; i < (size_t) NUM_GLYPHS * GLYPH_SIZE * GLYPH_SIZE; i++)
+        bits[i] = rand_r(&seed);
+
+    for (round = 0; round < ROUNDS; round++) {
+        first = xcb_generate_id(c);
+        xcb_render_create_glyph_set(c, first, a8);
+        sync_server(c);
+        start = now();
+        upload(c, first, bits);
+        sync_server(c);
+        fresh += now() - start;
+
+        second = xcb_generate_id(c);
+        xcb_render_create_glyph_set(c, second, a8);
+        sync_server(c);
+        start = now();
+        upload(c, second, bits);
+        sync_server(c);
+        shared += now() - start;
+
+        xcb_render_free_glyph_set(c, first);
+        xcb_render_free_glyph_set(c, second);
+        sync_server(c);
+    }
+
+    report("new glyphs", ROUNDS * NUM_GLYPHS, fresh);
+    report("shared glyphs", ROUNDS * NUM_GLYPHS, shared);
+
+    free(bits);
+
+    if (xcb_connection_has_error(c)) {
+        fprintf(stderr, "connection error\n");
+        return 1;
+    }
+
+    xcb_disconnect(c);
+    return 0;
+}
@@ -0,0 +1,184 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Moves the pointer over the window of a client that has stopped reading
+ * its events, once with motion compression disabled for that client and
+ * once with it enabled through the X-Resource QueryMotionCompression
+ * request.  Reports the warps per second in each case and how many motion
+ * events the client finally reads, and checks that the events received
+ * and the events the server reports as dropped add up.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/uio.h>
+#include <xcb/xcb.h>
+#include <xcb/xcbext.h>
+
+#include "bench.h"
+
+#define WARPS 200000
+#define SIZE 400
+
+#define X_XResQueryMotionCompression 65
+#define COMPRESS_ENABLE 0x01
+#define COMPRESS_DISABLE 0x02
+#define COMPRESS_RESET 0x04
+
+typedef struct {
+    uint8_t type;
+    uint8_t enabled;
+    uint16_t sequence;
+    uint32_t length;
+    uint32_t compressed_hi;
+    uint32_t compressed_lo;
+    uint8_t pad[16];
+} compression_reply_t;
+
+static compression_reply_t *
+query_compression(xcb_connection_t *c, uint8_t opcode, uint32_t client,
+                  uint32_t flags)
+{
+    struct {
+        uint8_t major;
+        uint8_t minor;
+        uint16_t length;
+        uint32_t client;
+        uint32_t flags;
+    } req = { opcode, X_XResQueryMotionCompression, 3, client, flags };
+    static const xcb_protocol_request_t proto = {
+        .count = 1,
+        .ext = NULL,
+        .opcode = 0,
+        .isvoid = 0
+    };
+    struct iovec vec[3];
+    unsigned int seq;
+
+    vec[2].iov_base = &req;
+    vec[2].iov_len = sizeof(req);
+    seq = xcb_send_request(c, XCB_REQUEST_RAW, vec + 2, &proto);
+    return xcb_wait_for_reply(c, seq, NULL);
+}
+
+static int
+drain(xcb_connection_t *c)
+{
+    xcb_generic_event_t *ev;
+    int motion = 0;
+
+    sync_server(c);
+    while ((ev = xcb_poll_for_queued_event(c))) {
+        if ((ev->response_type & 0x7f) == XCB_MOTION_NOTIFY)
+            motion++;
+        free(ev);
+    }
+    return motion;
+}
+
+static int
+run(xcb_connection_t *slow, xcb_connection_t *drive, xcb_window_t root,
+    uint8_t opcode, xcb_window_t window, int compress)
+{
+    compression_reply_t *rep;
+    uint64_t compressed;
+    double start;
+    int i, received;
+
+    xcb_warp_pointer(drive, XCB_NONE, root, 0, 0, 0, 0, 5, 5);
+    sync_server(drive);
+    drain(slow);
+    free(query_compression(drive, opcode, window, COMPRESS_RESET |
+                           (compress ? COMPRESS_ENABLE : COMPRESS_DISABLE)));
+
+    start = now();
+    for (i = 0; i < WARPS; i++)
+        xcb_warp_pointer(drive, XCB_NONE, root, 0, 0, 0, 0,
+                         10 + i % SIZE, 10 + (i / SIZE) % SIZE);
+    sync_server(drive);
+    report(compress ? "warps (compressed)" : "warps (not compressed)",
+           WARPS, now() - start);
+
+    rep = query_compression(drive, opcode, window, 0);
+    if (!rep || rep->enabled != compress) {
+        fprintf(stderr, "QueryMotionCompression failed\n");
+        return 1;
+    }
+    compressed = (uint64_t) rep->compressed_hi << 32 | rep->compressed_lo;
+    free(rep);
+
+    received = drain(slow);
+    printf("motion events received: %d, dropped: %llu\n", received,
+           (unsigned long long) compressed);
+    if (received + compressed != WARPS || (!compress && compressed)) {
+        fprintf(stderr, "%d motion events were lost\n",
+                WARPS - received - (int) compressed);
+        return 1;
+    }
+    return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+    xcb_connection_t *slow = xcb_connect(NULL, NULL);
+    xcb_connection_t *drive = xcb_connect(NULL, NULL);
+    xcb_query_extension_reply_t *ext;
+    xcb_screen_t *screen;
+    xcb_window_t window;
+    uint32_t values[2];
+    int ret;
+
+    if (xcb_connection_has_error(slow) || xcb_connection_has_error(drive)) {
+        fprintf(stderr, "cannot connect to the server\n");
+        return 1;
+    }
+    ext = xcb_query_extension_reply(drive,
+                                    xcb_query_extension(drive, 10,
+                                                        "X-Resource"),
+                                    NULL);
+    if (!ext || !ext->present) {
+        fprintf(stderr, "X-Resource extension not present\n");
+        return 1;
+    }
+    screen = xcb_setup_roots_iterator(xcb_get_setup(slow)).data;
+
+    window = xcb_generate_id(slow);
+    values[0] = 1;
+    values[1] = XCB_EVENT_MASK_POINTER_MOTION;
+    xcb_create_window(slow, XCB_COPY_FROM_PARENT, window, screen->root,
+                      0, 0, SIZE + 20, SIZE + 20, 0,
+                      XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT,
+                      XCB_CW_OVERRIDE_REDIRECT | XCB_CW_EVENT_MASK, values);
+    xcb_map_window(slow, window);
+    sync_server(slow);
+
+    ret = run(slow, drive, screen->root, ext->major_opcode, window, 0) ||
+        run(slow, drive, screen->root, ext->major_opcode, window, 1);
+
+    free(ext);
+    xcb_disconnect(drive);
+    xcb_disconnect(slow);
+    return ret;
+}
@@ -0,0 +1,146 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Measures property traffic on a root window carrying several hundred
+ * properties, as a busy desktop's root window does.  Every round changes,
+ * reads back and finally deletes and recreates properties scattered over
+ * the whole set, and every reply is checked for the value last written.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <xcb/xcb.h>
+
+#include "bench.h"
+
+#define NUM_PROPS 600
+#define ROUNDS 20000
+
+static int
+check_property(xcb_connection_t *c, xcb_window_t root, xcb_atom_t atom,
+               uint32_t expected)
+{
+    xcb_get_property_reply_t *rep;
+    int ok;
+
+    rep = xcb_get_property_reply(c, xcb_get_property(c, 0, root, atom,
+                                                     XCB_ATOM_CARDINAL, 0, 1),
+                                 NULL);
+    if (!rep)
+        return 0;
+    ok = xcb_get_property_value_length(rep) == 4 &&
+        *(uint32_t *) xcb_get_property_value(rep) == expected;
+    free(rep);
+    return ok;
+}
+
+int
+main(int argc, char **argv)
+{
+    xcb_connection_t *c = xcb_connect(NULL, NULL);
+    xcb_intern_atom_cookie_t cookies[NUM_PROPS];
+    xcb_intern_atom_reply_t *rep;
+    xcb_atom_t atoms[NUM_PROPS];
+    uint32_t values[NUM_PROPS];
+    xcb_window_t root;
+    char name[32];
+    double start;
+    int i, n;
+
+    if (xcb_connection_has_error(c)) {
+        fprintf(stderr, "cannot connect to the server\n");
+        return 1;
+    }
+    root = xcb_setup_roots_iterator(xcb_get_setup(c)).data->root;
+
+    for (i = 0; i < NUM_PROPS; i++) {
+        snprintf(name, sizeof(name), "BENCH_PROPERTY_%d", i);
+        cookies[i] = xcb_intern_atom(c, 0, strlen(name), name);
+    }
+    for (i = 0; i < NUM_PROPS; i++) {
+        if (!(rep = xcb_intern_atom_reply(c, cookies[i], NULL))) {
+            fprintf(stderr, "InternAtom failed\n");
+            return 1;
+        }
+        atoms[i] = rep->atom;
+        free(rep);
+    }
+
+    start = now();
+    for (i = 0; i < NUM_PROPS; i++) {
+        values[i] = i;
+        xcb_change_property(c, XCB_PROP_MODE_REPLACE, root, atoms[i],
+                            XCB_ATOM_CARDINAL, 32, 1, &values[i]);
+    }
+    if (!check_property(c, root, atoms[NUM_PROPS - 1], NUM_PROPS - 1)) {
+        fprintf(stderr, "GetProperty reply mismatch\n");
+        return 1;
+    }
+    report("ChangeProperty (create)", NUM_PROPS, now() - start);
+
+    /* Visit the properties in a scattered order, not list order. */
+    start = now();
+    for (n = 0; n < ROUNDS; n++) {
+        i = (n * 7919) % NUM_PROPS;
+        values[i] += NUM_PROPS;
+        xcb_change_property(c, XCB_PROP_MODE_REPLACE, root, atoms[i],
+                            XCB_ATOM_CARDINAL, 32, 1, &values[i]);
+        if (!check_property(c, root, atoms[i], values[i])) {
+            fprintf(stderr, "GetProperty reply mismatch\n");
+            return 1;
+        }
+    }
+    report("ChangeProperty+GetProperty", ROUNDS, now() - start);
+
+    start = now();
+    for (n = 0; n < ROUNDS; n++) {
+        i = (n * 7919) % NUM_PROPS;
+        xcb_delete_property(c, root, atoms[i]);
+        xcb_change_property(c, XCB_PROP_MODE_REPLACE, root, atoms[i],
+                            XCB_ATOM_CARDINAL, 32, 1, &values[i]);
+        if (!check_property(c, root, atoms[i], values[i])) {
+            fprintf(stderr, "GetProperty reply mismatch\n");
+            return 1;
+        }
+    }
+    report("DeleteProperty+recreate", ROUNDS, now() - start);
+
+    for (i = 0; i < NUM_PROPS; i++)
+        xcb_delete_property(c, root, atoms[i]);
+    for (i = 0; i < NUM_PROPS; i += 97) {
+        xcb_get_property_reply_t *prop =
+            xcb_get_property_reply(c, xcb_get_property(c, 0, root, atoms[i],
+                                                       XCB_ATOM_ANY, 0, 1),
+                                   NULL);
+
+        if (!prop || prop->type != XCB_NONE) {
+            fprintf(stderr, "DeleteProperty left a property behind\n");
+            return 1;
+        }
+        free(prop);
+    }
+
+    xcb_disconnect(c);
+    return 0;
+}
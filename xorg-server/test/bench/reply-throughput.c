@@ -0,0 +1,223 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Measures the throughput of large GetImage and GetProperty replies.
+ * Each request is run back to back (one reply in flight) and pipelined
+ * (several requests sent before any reply is read, so the server's output
+ * backs up), and every reply is checked for the expected size and content.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <xcb/xcb.h>
+
+#include "bench.h"
+
+#define IMAGE_SIZE 2048
+#define PROP_BYTES (4 * 1024 * 1024)
+#define ITERATIONS 16
+#define PIPELINE 8
+
+static int
+check_image(xcb_get_image_reply_t *rep, uint32_t expected_len)
+{
+    const uint8_t *data;
+
+    if (!rep)
+        return 0;
+    data = xcb_get_image_data(rep);
+    if ((uint32_t) xcb_get_image_data_length(rep) != expected_len ||
+        data[0] != data[expected_len - 1]) {
+        free(rep);
+        return 0;
+    }
+    free(rep);
+    return 1;
+}
+
+static int
+check_property(xcb_get_property_reply_t *rep)
+{
+    const uint8_t *data;
+    int i;
+
+    if (!rep)
+        return 0;
+    data = xcb_get_property_value(rep);
+    if (xcb_get_property_value_length(rep) != PROP_BYTES) {
+        free(rep);
+        return 0;
+    }
+    for (i = 0; i < PROP_BYTES; i += 4096) {
+        if (data[i] != (uint8_t) (i / 4096)) {
+            free(rep);
+            return 0;
+        }
+    }
+    free(rep);
+    return 1;
+}
+
+static int
+bench_get_image(xcb_connection_t *c, xcb_screen_t *screen)
+{
+    xcb_pixmap_t pixmap = xcb_generate_id(c);
+    xcb_gcontext_t gc = xcb_generate_id(c);
+    xcb_rectangle_t rect = { 0, 0, IMAGE_SIZE, IMAGE_SIZE };
+    uint32_t fg = 0x5a5a5a5a;
+    xcb_get_image_cookie_t cookies[PIPELINE];
+    xcb_get_image_reply_t *rep;
+    uint32_t len;
+    double start;
+    int i, j;
+
+    xcb_create_pixmap(c, screen->root_depth, pixmap, screen->root,
+                      IMAGE_SIZE, IMAGE_SIZE);
+    xcb_create_gc(c, gc, pixmap, XCB_GC_FOREGROUND, &fg);
+    xcb_poly_fill_rectangle(c, pixmap, gc, 1, &rect);
+
+    rep = xcb_get_image_reply(c,
+                              xcb_get_image(c, XCB_IMAGE_FORMAT_Z_PIXMAP,
+                                            pixmap, 0, 0,
+                                            IMAGE_SIZE, IMAGE_SIZE, ~0),
+                              NULL);
+    if (!rep)
+        return 0;
+    len = xcb_get_image_data_length(rep);
+    free(rep);
+
+    start = now();
+    for (i = 0; i < ITERATIONS; i++) {
+        rep = xcb_get_image_reply(c,
+                                  xcb_get_image(c, XCB_IMAGE_FORMAT_Z_PIXMAP,
+                                                pixmap, 0, 0,
+                                                IMAGE_SIZE, IMAGE_SIZE, ~0),
+                                  NULL);
+        if (!check_image(rep, len))
+            return 0;
+    }
+    report_bytes("GetImage", (double) len * ITERATIONS, now() - start);
+
+    start = now();
+    for (i = 0; i < ITERATIONS; i += PIPELINE) {
+        for (j = 0; j < PIPELINE; j++)
+            cookies[j] = xcb_get_image(c, XCB_IMAGE_FORMAT_Z_PIXMAP, pixmap,
+                                       0, 0, IMAGE_SIZE, IMAGE_SIZE, ~0);
+        for (j = 0; j < PIPELINE; j++) {
+            if (!check_image(xcb_get_image_reply(c, cookies[j], NULL), len))
+                return 0;
+        }
+    }
+    report_bytes("GetImage pipelined", (double) len * ITERATIONS,
+                 now() - start);
+
+    xcb_free_gc(c, gc);
+    xcb_free_pixmap(c, pixmap);
+    return 1;
+}
+
+static int
+bench_get_property(xcb_connection_t *c, xcb_screen_t *screen)
+{
+    xcb_window_t window = xcb_generate_id(c);
+    xcb_atom_t atom;
+    xcb_intern_atom_reply_t *atom_rep;
+    xcb_get_property_cookie_t cookies[PIPELINE];
+    uint8_t *data;
+    double start;
+    int i, j;
+
+    atom_rep = xcb_intern_atom_reply(c, xcb_intern_atom(c, 0, 14,
+                                                        "BENCH_PROPERTY"),
+                                     NULL);
+    if (!atom_rep)
+        return 0;
+    atom = atom_rep->atom;
+    free(atom_rep);
+
+    data = malloc(PROP_BYTES);
+    if (!data)
+        return 0;
+    for (i = 0; i < PROP_BYTES; i++)
+        data[i] = i / 4096;
+
+    xcb_create_window(c, XCB_COPY_FROM_PARENT, window, screen->root,
+                      0, 0, 1, 1, 0, XCB_WINDOW_CLASS_INPUT_OUTPUT,
+                      screen->root_visual, 0, NULL);
+    xcb_change_property(c, XCB_PROP_MODE_REPLACE, window, atom,
+                        XCB_ATOM_STRING, 8, PROP_BYTES, data);
+    free(data);
+
+    start = now();
+    for (i = 0; i < ITERATIONS; i++) {
+        xcb_get_property_cookie_t cookie =
+            xcb_get_property(c, 0, window, atom, XCB_ATOM_STRING, 0,
+                             PROP_BYTES / 4);
+        if (!check_property(xcb_get_property_reply(c, cookie, NULL)))
+            return 0;
+    }
+    report_bytes("GetProperty", (double) PROP_BYTES * ITERATIONS,
+                 now() - start);
+
+    start = now();
+    for (i = 0; i < ITERATIONS; i += PIPELINE) {
+        for (j = 0; j < PIPELINE; j++)
+            cookies[j] = xcb_get_property(c, 0, window, atom, XCB_ATOM_STRING,
+                                          0, PROP_BYTES / 4);
+        for (j = 0; j < PIPELINE; j++) {
+            if (!check_property(xcb_get_property_reply(c, cookies[j], NULL)))
+                return 0;
+        }
+    }
+    report_bytes("GetProperty pipelined", (double) PROP_BYTES * ITERATIONS,
+                 now() - start);
+
+    xcb_destroy_window(c, window);
+    return 1;
+}
+
+int
+main(int argc, char **argv)
+{
+    xcb_connection_t *c = xcb_connect(NULL, NULL);
+    xcb_screen_t *screen;
+
+    if (xcb_connection_has_error(c)) {
+        fprintf(stderr, "cannot connect to the server\n");
+        return 1;
+    }
+    screen = xcb_setup_roots_iterator(xcb_get_setup(c)).data;
+
+    if (!bench_get_image(c, screen)) {
+        fprintf(stderr, "GetImage reply mismatch\n");
+        return 1;
+    }
+    if (!bench_get_property(c, screen)) {
+        fprintf(stderr, "GetProperty reply mismatch\n");
+        return 1;
+    }
+
+    xcb_disconnect(c);
+    return 0;
+}
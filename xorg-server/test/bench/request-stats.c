@@ -0,0 +1,194 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Measures the cost of per-request dispatch statistics: the same stream of
+ * GetInputFocus round trips is timed with the statistics disabled and
+ * enabled, after which the counters are read back through the X-Resource
+ * QueryRequestStats request and checked against what was sent.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/uio.h>
+#include <xcb/xcb.h>
+#include <xcb/xcbext.h>
+
+#include "bench.h"
+
+#define ROUNDS 200
+#define BATCH 1000
+
+#define X_GetInputFocus 43
+#define X_XResQueryRequestStats 64
+#define STATS_ENABLE 0x01
+#define STATS_DISABLE 0x02
+#define STATS_RESET 0x04
+
+typedef struct {
+    uint8_t type;
+    uint8_t enabled;
+    uint16_t sequence;
+    uint32_t length;
+    uint32_t num_stats;
+    uint32_t num_buckets;
+    uint8_t pad[16];
+} stats_reply_t;
+
+typedef struct {
+    uint32_t resource_base;
+    uint8_t major;
+    uint8_t minor;
+    uint16_t pad;
+    uint32_t count;
+    uint32_t max;
+    uint32_t total_hi;
+    uint32_t total_lo;
+} stat_entry_t;
+
+static stats_reply_t *
+query_stats(xcb_connection_t *c, uint8_t opcode, uint32_t client,
+            uint32_t flags)
+{
+    struct {
+        uint8_t major;
+        uint8_t minor;
+        uint16_t length;
+        uint32_t client;
+        uint32_t flags;
+    } req = { opcode, X_XResQueryRequestStats, 3, client, flags };
+    static const xcb_protocol_request_t proto = {
+        .count = 1,
+        .ext = NULL,
+        .opcode = 0,
+        .isvoid = 0
+    };
+    struct iovec vec[3];
+    unsigned int seq;
+
+    vec[2].iov_base = &req;
+    vec[2].iov_len = sizeof(req);
+    seq = xcb_send_request(c, XCB_REQUEST_RAW, vec + 2, &proto);
+    return xcb_wait_for_reply(c, seq, NULL);
+}
+
+static double
+round_trips(xcb_connection_t *c)
+{
+    xcb_get_input_focus_cookie_t cookie;
+    double start = now();
+    int i, n;
+
+    for (n = 0; n < ROUNDS; n++) {
+        for (i = 0; i < BATCH; i++)
+            cookie = xcb_get_input_focus(c);
+        free(xcb_get_input_focus_reply(c, cookie, NULL));
+    }
+    return now() - start;
+}
+
+int
+main(int argc, char **argv)
+{
+    xcb_connection_t *c = xcb_connect(NULL, NULL);
+    xcb_query_extension_reply_t *ext;
+    stats_reply_t *rep;
+    stat_entry_t *entry;
+    uint32_t self;
+    double off, on;
+    int i, found = 0;
+
+    if (xcb_connection_has_error(c)) {
+        fprintf(stderr, "cannot connect to the server\n");
+        return 1;
+    }
+    ext = xcb_query_extension_reply(c, xcb_query_extension(c, 10,
+                                                           "X-Resource"),
+                                    NULL);
+    if (!ext || !ext->present) {
+        fprintf(stderr, "X-Resource extension not present\n");
+        return 1;
+    }
+    self = xcb_generate_id(c);
+
+    rep = query_stats(c, ext->major_opcode, 0, STATS_DISABLE | STATS_RESET);
+    if (!rep) {
+        fprintf(stderr, "QueryRequestStats failed\n");
+        return 1;
+    }
+    free(rep);
+
+    off = round_trips(c);
+    report("GetInputFocus (stats off)", ROUNDS * BATCH, off);
+
+    free(query_stats(c, ext->major_opcode, self, STATS_ENABLE | STATS_RESET));
+    on = round_trips(c);
+    report("GetInputFocus (stats on)", ROUNDS * BATCH, on);
+    printf("overhead: %.1f%%\n", (on - off) / off * 100);
+
+    rep = query_stats(c, ext->major_opcode, self, STATS_DISABLE | STATS_RESET);
+    if (!rep || !rep->enabled || !rep->num_stats) {
+        fprintf(stderr, "QueryRequestStats returned no statistics\n");
+        return 1;
+    }
+
+    entry = (stat_entry_t *) (rep + 1);
+    for (i = 0; i < rep->num_stats; i++) {
+        uint32_t *hist = (uint32_t *) (entry + 1);
+        uint64_t total = (uint64_t) entry->total_hi << 32 | entry->total_lo;
+        uint32_t sum = 0;
+        int b;
+
+        for (b = 0; b < rep->num_buckets; b++)
+            sum += hist[b];
+        if (sum != entry->count) {
+            fprintf(stderr, "histogram of %d.%d does not add up\n",
+                    entry->major, entry->minor);
+            return 1;
+        }
+        if (entry->major == X_GetInputFocus) {
+            if (entry->count != ROUNDS * BATCH) {
+                fprintf(stderr, "counted %u GetInputFocus, sent %d\n",
+                        entry->count, ROUNDS * BATCH);
+                return 1;
+            }
+            printf("GetInputFocus: mean %.2f us, max %u us\n",
+                   (double) total / entry->count, entry->max);
+            found = 1;
+        }
+        else if (entry->major == 0) {
+            printf("output flushes: %u, mean %.2f us, max %u us\n",
+                   entry->count, (double) total / entry->count, entry->max);
+        }
+        entry = (stat_entry_t *) (hist + rep->num_buckets);
+    }
+    if (!found) {
+        fprintf(stderr, "no GetInputFocus statistics\n");
+        return 1;
+    }
+    free(rep);
+
+    free(ext);
+    xcb_disconnect(c);
+    return 0;
+}
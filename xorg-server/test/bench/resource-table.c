@@ -0,0 +1,114 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Creates a large number of resources (1x1 pixmaps) from one client and
+ * looks them up again, to exercise the server's per-client resource
+ * table.  Creation is timed in batches, each ending in a round trip, so
+ * that stalls while the table grows show up as a slow batch.  Lookups
+ * are GetGeometry requests in scattered id order, pipelined a batch at
+ * a time, and every reply is checked.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <xcb/xcb.h>
+
+#include "bench.h"
+
+#define DEFAULT_RESOURCES 1000000
+#define BATCH 10000
+
+int
+main(int argc, char **argv)
+{
+    xcb_connection_t *c = xcb_connect(NULL, NULL);
+    xcb_get_geometry_cookie_t *cookies;
+    xcb_get_geometry_reply_t *rep;
+    xcb_pixmap_t *pixmaps;
+    xcb_window_t root;
+    double start, batch, worst = 0;
+    int count = DEFAULT_RESOURCES;
+    int i, j, n;
+
+    if (argc > 1)
+        count = atoi(argv[1]);
+    if (xcb_connection_has_error(c)) {
+        fprintf(stderr, "cannot connect to the server\n");
+        return 1;
+    }
+    root = xcb_setup_roots_iterator(xcb_get_setup(c)).data->root;
+
+    pixmaps = malloc(count * sizeof(*pixmaps));
+    cookies = malloc(BATCH * sizeof(*cookies));
+    if (!pixmaps || !cookies)
+        return 1;
+
+    start = now();
+    for (i = 0; i < count; i += BATCH) {
+        batch = now();
+        for (j = i; j < count && j < i + BATCH; j++) {
+            pixmaps[j] = xcb_generate_id(c);
+            xcb_create_pixmap(c, 1, pixmaps[j], root, 1, 1);
+        }
+        sync_server(c);
+        batch = now() - batch;
+        if (batch > worst)
+            worst = batch;
+    }
+    report("create", count, now() - start);
+    printf("slowest batch of %d: %.3f ms\n", BATCH, worst * 1e3);
+
+    /* Visit the pixmaps in a scattered order, not creation order. */
+    start = now();
+    for (i = 0; i < count; i += BATCH) {
+        n = count - i < BATCH ? count - i : BATCH;
+        for (j = 0; j < n; j++)
+            cookies[j] = xcb_get_geometry(c, pixmaps[((i + j) * 7919LL) % count]);
+        for (j = 0; j < n; j++) {
+            rep = xcb_get_geometry_reply(c, cookies[j], NULL);
+            if (!rep || rep->width != 1 || rep->height != 1 || rep->depth != 1) {
+                fprintf(stderr, "GetGeometry reply mismatch\n");
+                return 1;
+            }
+            free(rep);
+        }
+    }
+    report("lookup", count, now() - start);
+
+    start = now();
+    for (i = 0; i < count; i++)
+        xcb_free_pixmap(c, pixmaps[i]);
+    sync_server(c);
+    report("free", count, now() - start);
+
+    rep = xcb_get_geometry_reply(c, xcb_get_geometry(c, pixmaps[0]), NULL);
+    if (rep) {
+        fprintf(stderr, "freed pixmap still exists\n");
+        return 1;
+    }
+
+    free(cookies);
+    free(pixmaps);
+    xcb_disconnect(c);
+    return 0;
+}
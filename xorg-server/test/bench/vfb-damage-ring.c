@@ -0,0 +1,340 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Reference consumer for Xvfb -memfd, and a measure of what it saves.  The
+ * screen is mirrored into a local buffer by following the damage ring in
+ * the memfd, while a client keeps drawing small rectangles.  The same
+ * frames are then mirrored the old way, with a GetImage of the whole
+ * screen per frame.  Last, another client draws while the ring is followed
+ * without round trips, so that rects are read while the server rewrites
+ * them.  After each phase the mirror is checked against GetImage.
+ */
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <xcb/xcb.h>
+
+#include "bench.h"
+
+#include "vfbring.h"
+
+#define FRAMES 2000
+#define RECTS_PER_FRAME 8
+
+typedef struct {
+    const VfbRingHeader *ring;
+    const VfbRingRect *rects;
+    const uint8_t *pixels;
+    size_t size;
+    uint64_t last;
+    uint8_t *mirror;
+    uint64_t copied;            /* bytes */
+    uint64_t full_copies;
+} consumer_t;
+
+/* Find the memfd named name among the open files of our processes */
+static int
+find_memfd(const char *name)
+{
+    char target[PATH_MAX], path[PATH_MAX], link[PATH_MAX];
+    struct dirent *proc, *fd;
+    DIR *procdir, *fddir;
+    ssize_t len;
+    int ret = -1;
+
+    snprintf(target, sizeof(target), "/memfd:%s", name);
+    procdir = opendir("/proc");
+    if (!procdir)
+        return -1;
+    while (ret == -1 && (proc = readdir(procdir))) {
+        snprintf(path, sizeof(path), "/proc/%s/fd", proc->d_name);
+        fddir = opendir(path);
+        if (!fddir)
+            continue;
+        while (ret == -1 && (fd = readdir(fddir))) {
+            snprintf(path, sizeof(path), "/proc/%s/fd/%s", proc->d_name,
+                     fd->d_name);
+            len = readlink(path, link, sizeof(link) - 1);
+            if (len < 0)
+                continue;
+            link[len] = '\0';
+            if (strncmp(link, target, strlen(target)) == 0 &&
+                (link[strlen(target)] == '\0' || link[strlen(target)] == ' '))
+                ret = open(path, O_RDONLY | O_CLOEXEC);
+        }
+        closedir(fddir);
+    }
+    closedir(procdir);
+    return ret;
+}
+
+static int
+consumer_open(consumer_t *c, const char *display, int screen)
+{
+    char name[64];
+    struct stat st;
+    void *map;
+    int fd;
+
+    memset(c, 0, sizeof(*c));
+    snprintf(name, sizeof(name), "Xvfb:%s.%d", display, screen);
+    fd = find_memfd(name);
+    if (fd < 0 || fstat(fd, &st) < 0)
+        return -1;
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return -1;
+
+    c->ring = map;
+    c->size = st.st_size;
+    if (c->ring->magic != VFB_RING_MAGIC ||
+        c->ring->version != VFB_RING_VERSION)
+        return -1;
+    c->rects = (const VfbRingRect *) ((const char *) map +
+                                      c->ring->rects_offset);
+    c->pixels = (const uint8_t *) map + c->ring->fb_offset +
+        c->ring->pixels_offset;
+    c->mirror = calloc(c->ring->height, c->ring->stride);
+    return c->mirror ? 0 : -1;
+}
+
+static void
+consumer_copy(consumer_t *c, int x, int y, int width, int height)
+{
+    int bytes = c->ring->bits_per_pixel / 8;
+    size_t offset = (size_t) y * c->ring->stride + x * bytes;
+
+    while (height--) {
+        memcpy(c->mirror + offset, c->pixels + offset, width * bytes);
+        offset += c->ring->stride;
+        c->copied += width * bytes;
+    }
+}
+
+/* Bring the mirror up to date with everything the server published */
+static void
+consumer_poll(consumer_t *c)
+{
+    uint64_t seq = __atomic_load_n(&c->ring->seq, __ATOMIC_ACQUIRE);
+    uint64_t mask = c->ring->num_rects - 1;
+    uint64_t i;
+
+    if (seq - c->last > c->ring->num_rects)
+        goto full;
+
+    for (i = c->last; i < seq; i++) {
+        const VfbRingRect *rect = &c->rects[i & mask];
+        uint64_t s = __atomic_load_n(&rect->seq, __ATOMIC_ACQUIRE);
+        int x = rect->x, y = rect->y, w = rect->width, h = rect->height;
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (s != i + 1 || __atomic_load_n(&rect->seq, __ATOMIC_RELAXED) != s)
+            goto full;
+        consumer_copy(c, x, y, w, h);
+    }
+    c->last = seq;
+    return;
+
+ full:
+    consumer_copy(c, 0, 0, c->ring->width, c->ring->height);
+    c->full_copies++;
+    c->last = seq;
+}
+
+static void
+draw_frame(xcb_connection_t *conn, xcb_window_t window, xcb_gcontext_t gc,
+           unsigned int *seed, int width, int height)
+{
+    xcb_rectangle_t rects[RECTS_PER_FRAME];
+    uint32_t pixel = rand_r(seed);
+    int i;
+
+    for (i = 0; i < RECTS_PER_FRAME; i++) {
+        rects[i].width = 8 + rand_r(seed) % 64;
+        rects[i].height = 8 + rand_r(seed) % 64;
+        rects[i].x = rand_r(seed) % (width - rects[i].width);
+        rects[i].y = rand_r(seed) % (height - rects[i].height);
+    }
+    xcb_change_gc(conn, gc, XCB_GC_FOREGROUND, &pixel);
+    /* Damage takes the extents of a request, so send one per rectangle */
+    for (i = 0; i < RECTS_PER_FRAME; i++)
+        xcb_poly_fill_rectangle(conn, window, gc, 1, &rects[i]);
+}
+
+/* Draw frames from a second connection, as a forked child */
+static void
+draw_from_child(int frames)
+{
+    xcb_connection_t *conn = xcb_connect(NULL, NULL);
+    xcb_screen_t *screen;
+    xcb_gcontext_t gc;
+    unsigned int seed = 2;
+    int n;
+
+    if (xcb_connection_has_error(conn))
+        _exit(1);
+    screen = xcb_setup_roots_iterator(xcb_get_setup(conn)).data;
+    gc = xcb_generate_id(conn);
+    xcb_create_gc(conn, gc, screen->root, 0, NULL);
+    for (n = 0; n < frames; n++)
+        draw_frame(conn, screen->root, gc, &seed, screen->width_in_pixels,
+                   screen->height_in_pixels);
+    sync_server(conn);
+    _exit(xcb_connection_has_error(conn) ? 1 : 0);
+}
+
+/* Count the rows of the mirror that differ from what GetImage returns */
+static int
+compare_screen(xcb_connection_t *conn, xcb_window_t window, consumer_t *c)
+{
+    int bytes = c->ring->bits_per_pixel / 8;
+    xcb_get_image_reply_t *image;
+    const uint8_t *data;
+    int y, stride, mismatches = 0;
+
+    sync_server(conn);
+    consumer_poll(c);
+    image = xcb_get_image_reply(conn,
+                                xcb_get_image(conn, XCB_IMAGE_FORMAT_Z_PIXMAP,
+                                              window, 0, 0, c->ring->width,
+                                              c->ring->height, ~0), NULL);
+    if (!image)
+        return c->ring->height;
+    data = xcb_get_image_data(image);
+    stride = xcb_get_image_data_length(image) / c->ring->height;
+    for (y = 0; y < c->ring->height; y++)
+        if (memcmp(c->mirror + (size_t) y * c->ring->stride,
+                   data + (size_t) y * stride, c->ring->width * bytes))
+            mismatches++;
+    free(image);
+    return mismatches;
+}
+
+int
+main(int argc, char **argv)
+{
+    xcb_connection_t *conn;
+    const char *display = getenv("DISPLAY");
+    char number[16];
+    xcb_screen_t *screen;
+    xcb_window_t window;
+    xcb_gcontext_t gc;
+    consumer_t c;
+    uint32_t values[2];
+    unsigned int seed = 1;
+    uint64_t full_copies;
+    double start;
+    pid_t child;
+    int n, polls, status, mismatches;
+
+    conn = xcb_connect(NULL, NULL);
+    if (xcb_connection_has_error(conn) || !display) {
+        fprintf(stderr, "cannot connect to the server\n");
+        return 1;
+    }
+    snprintf(number, sizeof(number), "%.*s",
+             (int) strcspn(display + 1, "."), display + 1);
+    if (consumer_open(&c, number, 0) < 0) {
+        fprintf(stderr, "no Xvfb -memfd ring for display %s\n", display);
+        return 1;
+    }
+    screen = xcb_setup_roots_iterator(xcb_get_setup(conn)).data;
+    window = screen->root;
+
+    gc = xcb_generate_id(conn);
+    values[0] = screen->white_pixel;
+    values[1] = 0;
+    xcb_create_gc(conn, gc, window,
+                  XCB_GC_FOREGROUND | XCB_GC_GRAPHICS_EXPOSURES, values);
+    sync_server(conn);
+    consumer_copy(&c, 0, 0, c.ring->width, c.ring->height);
+    c.last = __atomic_load_n(&c.ring->seq, __ATOMIC_ACQUIRE);
+    c.copied = 0;
+
+    start = now();
+    for (n = 0; n < FRAMES; n++) {
+        draw_frame(conn, window, gc, &seed, screen->width_in_pixels,
+                   screen->height_in_pixels);
+        /* The ring is updated before the reply is sent */
+        sync_server(conn);
+        consumer_poll(&c);
+    }
+    report("ring mirror frames", FRAMES, now() - start);
+    printf("  %.1f MiB copied, %llu full copies\n", c.copied / 1048576.0,
+           (unsigned long long) c.full_copies);
+    mismatches = compare_screen(conn, window, &c);
+
+    start = now();
+    for (n = 0; n < FRAMES / 10; n++) {
+        draw_frame(conn, window, gc, &seed, screen->width_in_pixels,
+                   screen->height_in_pixels);
+        free(xcb_get_image_reply(conn,
+                                 xcb_get_image(conn,
+                                               XCB_IMAGE_FORMAT_Z_PIXMAP,
+                                               window, 0, 0,
+                                               screen->width_in_pixels,
+                                               screen->height_in_pixels,
+                                               ~0), NULL));
+    }
+    report("GetImage mirror frames", FRAMES / 10, now() - start);
+
+    full_copies = c.full_copies;
+    polls = 0;
+    start = now();
+    child = fork();
+    if (child < 0) {
+        perror("fork");
+        return 1;
+    }
+    if (child == 0)
+        draw_from_child(FRAMES);
+    while (waitpid(child, &status, WNOHANG) == 0) {
+        consumer_poll(&c);
+        polls++;
+    }
+    report("concurrent ring polls", polls, now() - start);
+    printf("  %llu full copies\n",
+           (unsigned long long) (c.full_copies - full_copies));
+    mismatches += compare_screen(conn, window, &c);
+
+    if (mismatches || !WIFEXITED(status) || WEXITSTATUS(status) ||
+        xcb_connection_has_error(conn)) {
+        fprintf(stderr, "%d mirrored rows differ from the screen\n",
+                mismatches);
+        return 1;
+    }
+
+    free(c.mirror);
+    munmap((void *) c.ring, c.size);
+    xcb_disconnect(conn);
+    return 0;
+}
@@ -0,0 +1,142 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Redraws the same frame of thick solid and dashed polylines, circles and
+ * arcs over and over, the way plotting tools and CAD viewers repaint, and
+ * reports frames per second for each kind of primitive.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <xcb/xcb.h>
+
+#include "bench.h"
+
+#define WIDTH 1024
+#define HEIGHT 768
+#define POINTS 200
+#define ARCS 200
+#define FRAMES 200
+
+static void
+lines(xcb_connection_t *c, xcb_window_t window, xcb_gcontext_t gc,
+      const char *name, uint32_t style, const xcb_point_t *points)
+{
+    uint32_t values[2] = { 5, style };
+    double start;
+    int n;
+
+    xcb_change_gc(c, gc, XCB_GC_LINE_WIDTH | XCB_GC_LINE_STYLE, values);
+    start = now();
+    for (n = 0; n < FRAMES; n++)
+        xcb_poly_line(c, XCB_COORD_MODE_ORIGIN, window, gc, POINTS, points);
+    sync_server(c);
+    report(name, FRAMES, now() - start);
+}
+
+static void
+arcs(xcb_connection_t *c, xcb_window_t window, xcb_gcontext_t gc,
+     const char *name, uint32_t style, const xcb_arc_t *list)
+{
+    uint32_t values[2] = { 3, style };
+    double start;
+    int n;
+
+    xcb_change_gc(c, gc, XCB_GC_LINE_WIDTH | XCB_GC_LINE_STYLE, values);
+    start = now();
+    for (n = 0; n < FRAMES; n++)
+        xcb_poly_arc(c, window, gc, ARCS, list);
+    sync_server(c);
+    report(name, FRAMES, now() - start);
+}
+
+int
+main(int argc, char **argv)
+{
+    xcb_connection_t *c = xcb_connect(NULL, NULL);
+    xcb_screen_t *screen;
+    xcb_window_t window;
+    xcb_gcontext_t gc;
+    xcb_point_t points[POINTS];
+    xcb_arc_t circles[ARCS], partial[ARCS];
+    uint8_t dashes[2] = { 12, 6 };
+    uint32_t values[2];
+    unsigned int seed = 1;
+    int i;
+
+    if (xcb_connection_has_error(c)) {
+        fprintf(stderr, "cannot connect to the server\n");
+        return 1;
+    }
+    screen = xcb_setup_roots_iterator(xcb_get_setup(c)).data;
+
+    window = xcb_generate_id(c);
+    values[0] = screen->black_pixel;
+    xcb_create_window(c, XCB_COPY_FROM_PARENT, window, screen->root,
+                      0, 0, WIDTH, HEIGHT, 0, XCB_WINDOW_CLASS_INPUT_OUTPUT,
+                      screen->root_visual, XCB_CW_BACK_PIXEL, values);
+    xcb_map_window(c, window);
+
+    gc = xcb_generate_id(c);
+    values[0] = screen->white_pixel;
+    values[1] = screen->black_pixel;
+    xcb_create_gc(c, gc, window, XCB_GC_FOREGROUND | XCB_GC_BACKGROUND,
+                  values);
+    xcb_set_dashes(c, gc, 0, 2, dashes);
+
+    for (i = 0; i < POINTS; i++) {
+        points[i].x = rand_r(&seed) % WIDTH;
+        points[i].y = rand_r(&seed) % HEIGHT;
+    }
+    for (i = 0; i < ARCS; i++) {
+        /* A handful of sizes, as symbols on a plot would use */
+        circles[i].width = circles[i].height = 8 << (i % 4);
+        circles[i].x = rand_r(&seed) % (WIDTH - circles[i].width);
+        circles[i].y = rand_r(&seed) % (HEIGHT - circles[i].height);
+        circles[i].angle1 = 0;
+        circles[i].angle2 = 360 * 64;
+        partial[i] = circles[i];
+        partial[i].height = circles[i].width / 2 + 4;
+        partial[i].angle1 = (i * 37 % 360) * 64;
+        partial[i].angle2 = 200 * 64;
+    }
+    sync_server(c);
+
+    lines(c, window, gc, "solid polyline", XCB_LINE_STYLE_SOLID, points);
+    lines(c, window, gc, "dashed polyline", XCB_LINE_STYLE_ON_OFF_DASH,
+          points);
+    lines(c, window, gc, "double-dashed polyline",
+          XCB_LINE_STYLE_DOUBLE_DASH, points);
+    arcs(c, window, gc, "solid circles", XCB_LINE_STYLE_SOLID, circles);
+    arcs(c, window, gc, "solid arcs", XCB_LINE_STYLE_SOLID, partial);
+    arcs(c, window, gc, "dashed arcs", XCB_LINE_STYLE_ON_OFF_DASH, partial);
+
+    if (xcb_connection_has_error(c)) {
+        fprintf(stderr, "connection error\n");
+        return 1;
+    }
+
+    xcb_disconnect(c);
+    return 0;
+}
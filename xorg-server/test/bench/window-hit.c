@@ -0,0 +1,193 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Maps WINDOWS small override-redirect windows, as IDEs and Java
+ * applications end up with, then replays pointer motion over them with
+ * WarpPointer and reports motions per second.  Every motion makes the
+ * server look up the window under the pointer.  Afterwards the child
+ * QueryPointer reports is checked against the topmost window the client
+ * expects at random points, again after moving, raising and unmapping
+ * some of the windows.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <xcb/xcb.h>
+
+#include "bench.h"
+
+#define WINDOWS 10000
+#define MOTIONS 100000
+#define CHECKS 2000
+
+typedef struct {
+    xcb_window_t id;
+    int x, y, width, height;
+    int mapped;
+} window_t;
+
+static window_t windows[WINDOWS];
+static int stack[WINDOWS];      /* indices into windows, bottom first */
+
+static xcb_window_t
+expected_child(int x, int y)
+{
+    int i;
+
+    for (i = WINDOWS - 1; i >= 0; i--) {
+        window_t *w = &windows[stack[i]];
+
+        if (w->mapped && x >= w->x && x < w->x + w->width &&
+            y >= w->y && y < w->y + w->height)
+            return w->id;
+    }
+    return XCB_WINDOW_NONE;
+}
+
+static int
+check(xcb_connection_t *c, xcb_window_t root, int width, int height,
+      unsigned int *seed, const char *name)
+{
+    int i, bad = 0;
+
+    for (i = 0; i < CHECKS; i++) {
+        int x = rand_r(seed) % width;
+        int y = rand_r(seed) % height;
+        xcb_query_pointer_reply_t *reply;
+
+        xcb_warp_pointer(c, XCB_WINDOW_NONE, root, 0, 0, 0, 0, x, y);
+        reply = xcb_query_pointer_reply(c, xcb_query_pointer(c, root), NULL);
+        if (!reply)
+            return 1;
+        if (reply->child != expected_child(x, y)) {
+            if (!bad)
+                fprintf(stderr, "%s: child at %d,%d is 0x%x, expected 0x%x\n",
+                        name, x, y, reply->child, expected_child(x, y));
+            bad++;
+        }
+        free(reply);
+    }
+    printf("%-26s %7d checks, %d wrong\n", name, CHECKS, bad);
+    return bad != 0;
+}
+
+static void
+raise_window(int i)
+{
+    int j, k;
+
+    for (j = 0; stack[j] != i; j++)
+        ;
+    for (k = j; k < WINDOWS - 1; k++)
+        stack[k] = stack[k + 1];
+    stack[WINDOWS - 1] = i;
+}
+
+int
+main(int argc, char **argv)
+{
+    xcb_connection_t *c = xcb_connect(NULL, NULL);
+    xcb_screen_t *screen;
+    int width, height;
+    unsigned int seed = 1;
+    uint32_t values[4];
+    double start;
+    int i, failed = 0;
+
+    if (xcb_connection_has_error(c)) {
+        fprintf(stderr, "cannot connect to the server\n");
+        return 1;
+    }
+    screen = xcb_setup_roots_iterator(xcb_get_setup(c)).data;
+    width = screen->width_in_pixels;
+    height = screen->height_in_pixels;
+
+    for (i = 0; i < WINDOWS; i++) {
+        window_t *w = &windows[i];
+
+        w->width = 8 + rand_r(&seed) % 120;
+        w->height = 8 + rand_r(&seed) % 80;
+        w->x = rand_r(&seed) % (width - w->width);
+        w->y = rand_r(&seed) % (height - w->height);
+        w->mapped = 1;
+        w->id = xcb_generate_id(c);
+        values[0] = 1;
+        xcb_create_window(c, XCB_COPY_FROM_PARENT, w->id, screen->root,
+                          w->x, w->y, w->width, w->height, 0,
+                          i % 4 ? XCB_WINDOW_CLASS_INPUT_OUTPUT :
+                          XCB_WINDOW_CLASS_INPUT_ONLY,
+                          XCB_COPY_FROM_PARENT, XCB_CW_OVERRIDE_REDIRECT,
+                          values);
+        xcb_map_window(c, w->id);
+        stack[i] = i;
+    }
+    sync_server(c);
+
+    start = now();
+    for (i = 0; i < MOTIONS; i++)
+        xcb_warp_pointer(c, XCB_WINDOW_NONE, screen->root, 0, 0, 0, 0,
+                         (i * 7) % width, (i * 13 / 7) % height);
+    sync_server(c);
+    report("motion over 10k windows", MOTIONS, now() - start);
+
+    failed |= check(c, screen->root, width, height, &seed, "mapped");
+
+    for (i = 0; i < WINDOWS / 10; i++) {
+        int n = rand_r(&seed) % WINDOWS;
+        window_t *w = &windows[n];
+
+        switch (i % 3) {
+        case 0:
+            w->x = rand_r(&seed) % (width - w->width);
+            w->y = rand_r(&seed) % (height - w->height);
+            values[0] = w->x;
+            values[1] = w->y;
+            xcb_configure_window(c, w->id,
+                                 XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y,
+                                 values);
+            break;
+        case 1:
+            values[0] = XCB_STACK_MODE_ABOVE;
+            xcb_configure_window(c, w->id, XCB_CONFIG_WINDOW_STACK_MODE,
+                                 values);
+            raise_window(n);
+            break;
+        case 2:
+            xcb_unmap_window(c, w->id);
+            w->mapped = 0;
+            break;
+        }
+    }
+    sync_server(c);
+
+    failed |= check(c, screen->root, width, height, &seed, "reconfigured");
+
+    if (xcb_connection_has_error(c)) {
+        fprintf(stderr, "connection error\n");
+        return 1;
+    }
+
+    xcb_disconnect(c);
+    return failed;
+}
@@ -40,7 +40,16 @@ THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #include <X11/extensions/XI.h>
 #include <X11/extensions/XKM.h>
 
+#include <sys/stat.h>
+#ifndef WIN32
+#include <dirent.h>
+#else
+#include <io.h>
+#endif
+
 #include "os/osdep.h"
+#include "os/xsha1.h"
+#include "xkb/xkbsrv_priv.h"
 
 #include "inputstr.h"
 #include "scrnintstr.h"
@@ -59,7 +68,11 @@ THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #endif
 
 static unsigned
-LoadXKM(unsigned want, unsigned need, const char *keymap, XkbDescPtr *xkbRtrn);
+LoadXKM(unsigned want, unsigned need, const char *keymap,
+        const char *cacheName, XkbDescPtr *xkbRtrn);
+
+static FILE *
+XkbDDXOpenConfigFile(const char *mapName, char *fileNameRtrn, int fileNameRtrnLen);
 
 static void
 OutputDirectory(char *outdir, size_t size)
@@ -101,15 +114,425 @@ OutputDirectory(char *outdir, size_t size)
  */
 typedef void (*xkbcomp_buffer_callback)(FILE *out, void *userdata);
 
+/*
+ * Compiled keymaps are kept in the output directory as server-<key>.xkm,
+ * so that a server started again with the same keymap, or a keyboard
+ * reconfigured to one it had before, doesn't run xkbcomp.  The key is
+ * the SHA1 of the keymap source given to xkbcomp, the options it would
+ * run with, and the contents of every layout file the source includes,
+ * followed through the files' own include statements.  A file is only
+ * added once it has been loaded successfully, and is removed if it ever
+ * fails to load.  Only the XKB_KEYMAP_CACHE_MAX newest files are kept.
+ *
+ * Keymaps that include more than XKB_KEYMAP_MAX_FILES layout files,
+ * nest includes deeper than XKB_KEYMAP_MAX_DEPTH, or include a file
+ * larger than XKB_KEYMAP_MAX_FILE_SIZE are not cached.
+ *
+ * As the names are predictable, the cache is only used in an output
+ * directory no one else can write to, which rules out the /tmp/
+ * fallback, and only files owned by the server are loaded from it.
+ */
+
+#define XKB_KEYMAP_CACHE_MAX		16
+#define XKB_KEYMAP_MAX_FILES		256
+#define XKB_KEYMAP_MAX_DEPTH		16
+#define XKB_KEYMAP_MAX_FILE_SIZE	(1 << 20)
+
+#define XKB_KEYMAP_CACHE_NAME_LEN	(sizeof("server-") - 1 + 40)
+
+typedef struct {
+    void *sha1;
+    Bool incomplete;            /* a limit was hit, don't cache */
+    int depth;
+    int numFiles;
+    char *files[XKB_KEYMAP_MAX_FILES];  /* hashed already */
+} XkbKeymapHashRec, *XkbKeymapHashPtr;
+
+/* Capture what callback writes, or return NULL */
+static char *
+XkbKeymapSource(xkbcomp_buffer_callback callback, void *userdata,
+                size_t *len)
+{
+    char tmpname[PATH_MAX];
+    FILE *tmp;
+    char *source = NULL;
+    long size;
+
+    /* Not tmpfile(), the Windows C runtime creates it in the drive root */
+    OutputDirectory(tmpname, sizeof(tmpname));
+    if (strlcat(tmpname, "xkbsrc_XXXXXX", sizeof(tmpname)) >= sizeof(tmpname))
+        return NULL;
+#ifndef WIN32
+    {
+        int fd = mkstemp(tmpname);
+
+        if (fd < 0)
+            return NULL;
+        if (!(tmp = fdopen(fd, "w+"))) {
+            close(fd);
+            unlink(tmpname);
+            return NULL;
+        }
+    }
+#else
+    if (!mktemp(tmpname) || !(tmp = fopen(tmpname, "w+b")))
+        return NULL;
+#endif
+
+    (*callback)(tmp, userdata);
+    if (!ferror(tmp) && (size = ftell(tmp)) > 0 && fseek(tmp, 0, SEEK_SET) == 0 &&
+        (source = malloc(size)) && fread(source, size, 1, tmp) != 1) {
+        free(source);
+        source = NULL;
+    }
+    fclose(tmp);
+    unlink(tmpname);
+    *len = source ? size : 0;
+    return source;
+}
+
+static void
+XkbKeymapHashComponent(XkbKeymapHashPtr h, const char *dir,
+                       const char *component, size_t len);
+
+/*
+ * Hash the layout files named by the include, augment, override and
+ * replace statements in text, which starts out in dir.  The xkb_keycodes,
+ * xkb_types, xkb_compat, xkb_symbols and xkb_geometry sections of a
+ * complete keymap switch to the directory of their component.
+ */
+static void
+XkbKeymapHashIncludes(XkbKeymapHashPtr h, const char *dir,
+                      const char *text, size_t len)
+{
+    static const struct {
+        const char *section;
+        const char *dir;
+    } sections[] = {
+        { "xkb_keycodes", "keycodes" },
+        { "xkb_types", "types" },
+        { "xkb_compat", "compat" },
+        { "xkb_symbols", "symbols" },
+        { "xkb_geometry", "geometry" },
+    };
+    const char *p = text, *end = text + len;
+    Bool include = FALSE;
+
+    while (p < end && !h->incomplete) {
+        if (*p == '"') {
+            const char *str = ++p;
+
+            while (p < end && *p != '"')
+                p++;
+            if (include && dir)
+                XkbKeymapHashComponent(h, dir, str, p - str);
+            include = FALSE;
+            p++;
+        }
+        else if (*p == '#' || (*p == '/' && p + 1 < end && p[1] == '/')) {
+            while (p < end && *p != '\n')
+                p++;
+        }
+        else if (*p == '/' && p + 1 < end && p[1] == '*') {
+            for (p += 2; p < end; p++)
+                if (*p == '*' && p + 1 < end && p[1] == '/') {
+                    p += 2;
+                    break;
+                }
+        }
+        else if (isalpha((unsigned char) *p) || *p == '_') {
+            const char *word = p;
+            size_t n;
+            int i;
+
+            while (p < end && (isalnum((unsigned char) *p) || *p == '_'))
+                p++;
+            n = p - word;
+            include = ((n == 7 && !strncmp(word, "include", n)) ||
+                       (n == 7 && !strncmp(word, "augment", n)) ||
+                       (n == 8 && !strncmp(word, "override", n)) ||
+                       (n == 7 && !strncmp(word, "replace", n)));
+            for (i = 0; i < ARRAY_SIZE(sections); i++)
+                if (n >= strlen(sections[i].section) &&
+                    !strncmp(word, sections[i].section,
+                             strlen(sections[i].section)))
+                    dir = sections[i].dir;
+        }
+        else {
+            if (!isspace((unsigned char) *p))
+                include = FALSE;
+            p++;
+        }
+    }
+}
+
+/* Hash the name and contents of dir/file, then the files it includes */
+static void
+XkbKeymapHashFile(XkbKeymapHashPtr h, const char *dir, const char *file,
+                  size_t len)
+{
+    char path[PATH_MAX];
+    struct stat st;
+    long long size = -1;
+    char *contents = NULL;
+    FILE *f;
+    int i;
+
+    if (snprintf(path, sizeof(path), "%s/%s/%.*s", XkbBaseDirectory, dir,
+                 (int) len, file) >= (int) sizeof(path)) {
+        h->incomplete = TRUE;
+        return;
+    }
+    for (i = 0; i < h->numFiles; i++)
+        if (!strcmp(h->files[i], path))
+            return;
+    if (h->numFiles == XKB_KEYMAP_MAX_FILES ||
+        h->depth == XKB_KEYMAP_MAX_DEPTH ||
+        !(h->files[h->numFiles] = strdup(path))) {
+        h->incomplete = TRUE;
+        return;
+    }
+    h->numFiles++;
+
+    if (stat(path, &st) == 0 && S_ISREG(st.st_mode)) {
+        if (st.st_size > XKB_KEYMAP_MAX_FILE_SIZE ||
+            !(contents = malloc(st.st_size + 1))) {
+            h->incomplete = TRUE;
+            return;
+        }
+        if ((f = fopen(path, "rb"))) {
+            size = fread(contents, 1, st.st_size, f);
+            fclose(f);
+        }
+    }
+
+    x_sha1_update(h->sha1, path, strlen(path) + 1);
+    x_sha1_update(h->sha1, &size, sizeof(size));
+    if (size > 0) {
+        x_sha1_update(h->sha1, contents, size);
+        h->depth++;
+        XkbKeymapHashIncludes(h, dir, contents, size);
+        h->depth--;
+    }
+    free(contents);
+}
+
+/*
+ * Hash the files a component expression such as "pc+us(intl):2+inet(evdev)"
+ * names in dir.
+ */
+static void
+XkbKeymapHashComponent(XkbKeymapHashPtr h, const char *dir,
+                       const char *component, size_t len)
+{
+    const char *p = component, *end = component + len;
+
+    while (p < end && !h->incomplete) {
+        size_t n = 0;
+
+        while (p + n < end && !strchr("+|(:", p[n]))
+            n++;
+        if (n)
+            XkbKeymapHashFile(h, dir, p, n);
+        p += n;
+        while (p < end && *p != '+' && *p != '|')
+            p++;
+        if (p < end)
+            p++;
+    }
+}
+
+/* Set cacheName to the name the compiled keymap is cached under */
+static Bool
+XkbKeymapCacheName(const char *source, size_t len,
+                   char *cacheName, size_t cacheNameLen)
+{
+    XkbKeymapHashRec h = { 0 };
+    unsigned char sha1[20];
+    int level = (xkbDebugFlags < 2) ? 1 :
+        ((xkbDebugFlags > 10) ? 10 : (int) xkbDebugFlags);
+    Bool ok;
+    int i;
+
+    if (cacheNameLen <= XKB_KEYMAP_CACHE_NAME_LEN ||
+        !(h.sha1 = x_sha1_init()))
+        return FALSE;
+
+    x_sha1_update(h.sha1, (void *) source, len);
+    x_sha1_update(h.sha1, &level, sizeof(level));
+    if (XkbBinDirectory)
+        x_sha1_update(h.sha1, (void *) XkbBinDirectory,
+                      strlen(XkbBinDirectory) + 1);
+    XkbKeymapHashIncludes(&h, NULL, source, len);
+    ok = x_sha1_final(h.sha1, sha1) && !h.incomplete;
+    for (i = 0; i < h.numFiles; i++)
+        free(h.files[i]);
+    if (!ok)
+        return FALSE;
+
+    strcpy(cacheName, "server-");
+    for (i = 0; i < sizeof(sha1); i++)
+        snprintf(cacheName + 7 + 2 * i, 3, "%02x", sha1[i]);
+    return TRUE;
+}
+
+/* Is name, without directory, a keymap cached by XkbKeymapCacheName? */
+static Bool
+XkbIsCachedKeymap(const char *name)
+{
+    return strlen(name) == XKB_KEYMAP_CACHE_NAME_LEN + 4 &&
+        !strncmp(name, "server-", 7) &&
+        strspn(name + 7, "0123456789abcdef") == 40 &&
+        !strcmp(name + XKB_KEYMAP_CACHE_NAME_LEN, ".xkm");
+}
+
+/* Can the output directory hold cached keymaps? */
+static Bool
+XkbKeymapCacheDirSafe(void)
+{
+#ifndef WIN32
+    static Bool warned;
+    char dir[PATH_MAX], xkm_output_dir[PATH_MAX];
+    struct stat st;
+
+    OutputDirectory(xkm_output_dir, sizeof(xkm_output_dir));
+    if (XkbBaseDirectory != NULL && xkm_output_dir[0] != '/')
+        snprintf(dir, sizeof(dir), "%s/%s", XkbBaseDirectory, xkm_output_dir);
+    else
+        strlcpy(dir, xkm_output_dir, sizeof(dir));
+
+    if (strcmp(xkm_output_dir, "/tmp/") == 0 || stat(dir, &st) != 0 ||
+        (st.st_uid != geteuid() && st.st_uid != 0) ||
+        (st.st_mode & (S_IWGRP | S_IWOTH))) {
+        if (!warned)
+            LogMessage(X_INFO, "XKB: Not caching compiled keymaps in %s, "
+                       "others can write to it\n", dir);
+        warned = TRUE;
+        return FALSE;
+    }
+#endif
+    return TRUE;
+}
+
+/* Is the cached keymap file one the server wrote? */
+static Bool
+XkbCachedKeymapOwned(FILE *file)
+{
+#ifndef WIN32
+    struct stat st;
+
+    if (fstat(fileno(file), &st) != 0 || !S_ISREG(st.st_mode) ||
+        st.st_uid != geteuid())
+        return FALSE;
+#endif
+    return TRUE;
+}
+
+typedef struct {
+    time_t mtime;
+    char name[XKB_KEYMAP_CACHE_NAME_LEN + sizeof(".xkm")];
+} XkbCachedKeymapRec;
+
+static int
+XkbCachedKeymapNewer(const void *a, const void *b)
+{
+    time_t ta = ((const XkbCachedKeymapRec *) a)->mtime;
+    time_t tb = ((const XkbCachedKeymapRec *) b)->mtime;
+
+    return (ta < tb) - (ta > tb);
+}
+
+/*
+ * Remove the oldest cached keymaps from the directory of cacheFileName,
+ * which was just added, so that at most XKB_KEYMAP_CACHE_MAX are left.
+ */
+static void
+XkbKeymapCachePrune(const char *cacheFileName)
+{
+    XkbCachedKeymapRec *keymaps = NULL, *tmp;
+    char dir[PATH_MAX], path[PATH_MAX];
+    const char *added;
+    size_t dirLen;
+    int num = 0, size = 0, i;
+    struct stat st;
+#ifndef WIN32
+    struct dirent *ent;
+    DIR *d;
+#else
+    struct _finddata_t ent;
+    intptr_t d;
+#endif
+
+    dirLen = strlen(cacheFileName) - (XKB_KEYMAP_CACHE_NAME_LEN + 4);
+    added = cacheFileName + dirLen;
+    if (dirLen >= sizeof(dir) || !XkbIsCachedKeymap(added))
+        return;
+    memcpy(dir, cacheFileName, dirLen);
+    dir[dirLen] = '\0';
+
+#ifndef WIN32
+    if (!(d = opendir(dirLen ? dir : ".")))
+        return;
+    while ((ent = readdir(d))) {
+        const char *name = ent->d_name;
+#else
+    snprintf(path, sizeof(path), "%sserver-*.xkm", dir);
+    if ((d = _findfirst(path, &ent)) == -1)
+        return;
+    do {
+        const char *name = ent.name;
+#endif
+
+        if (!XkbIsCachedKeymap(name) || !strcmp(name, added))
+            continue;
+        snprintf(path, sizeof(path), "%s%s", dir, name);
+        if (stat(path, &st) != 0)
+            continue;
+        if (num == size) {
+            size = size ? size * 2 : 32;
+            if (!(tmp = reallocarray(keymaps, size, sizeof(*keymaps))))
+                break;
+            keymaps = tmp;
+        }
+        keymaps[num].mtime = st.st_mtime;
+        strcpy(keymaps[num].name, name);
+        num++;
+#ifndef WIN32
+    }
+    closedir(d);
+#else
+    } while (_findnext(d, &ent) == 0);
+    _findclose(d);
+#endif
+
+    /* The one just added is the newest and counts against the limit */
+    if (num >= XKB_KEYMAP_CACHE_MAX) {
+        qsort(keymaps, num, sizeof(*keymaps), XkbCachedKeymapNewer);
+        for (i = XKB_KEYMAP_CACHE_MAX - 1; i < num; i++) {
+            snprintf(path, sizeof(path), "%s%s", dir, keymaps[i].name);
+            (void) unlink(path);
+        }
+    }
+    free(keymaps);
+}
+
 /**
  * Start xkbcomp, let the callback write into xkbcomp's stdin. When done,
  * return a strdup'd copy of the file name we've written to.
+ *
+ * If cacheName is not NULL, it is set to the name the keymap is cached
+ * under, or to an empty string if it can't be cached.  If the cache
+ * already has the keymap, xkbcomp isn't run and a copy of cacheName is
+ * returned.
  */
 static char *
-RunXkbComp(xkbcomp_buffer_callback callback, void *userdata)
+RunXkbComp(xkbcomp_buffer_callback callback, void *userdata,
+           char *cacheName, size_t cacheNameLen)
 {
     FILE *out;
     char *buf = NULL, keymap[PATH_MAX], xkm_output_dir[PATH_MAX];
+    char *source = NULL;
+    size_t sourceLen = 0;
 
     const char *emptystring = "";
     char *xkbbasedirflag = NULL;
@@ -125,6 +548,28 @@ RunXkbComp(xkbcomp_buffer_callback callback, void *userdata)
     const char *xkmfile = "-";
 #endif
 
+    if (cacheName) {
+        *cacheName = '\0';
+        if (XkbKeymapCacheEnabled && XkbKeymapCacheDirSafe() &&
+            (source = XkbKeymapSource(callback, userdata, &sourceLen)) &&
+            XkbKeymapCacheName(source, sourceLen, cacheName, cacheNameLen)) {
+            FILE *cached = XkbDDXOpenConfigFile(cacheName, NULL, 0);
+
+            if (cached && !XkbCachedKeymapOwned(cached)) {
+                fclose(cached);
+                cached = NULL;
+            }
+            if (cached) {
+                fclose(cached);
+                free(source);
+                DebugF("[xkb] Using cached keymap %s\n", cacheName);
+                return xnfstrdup(cacheName);
+            }
+        }
+        else
+            *cacheName = '\0';
+    }
+
     snprintf(keymap, sizeof(keymap), "server-%s", display);
 
     OutputDirectory(xkm_output_dir, sizeof(xkm_output_dir));
@@ -167,6 +612,7 @@ RunXkbComp(xkbcomp_buffer_callback callback, void *userdata)
     if (!buf) {
         LogMessage(X_ERROR,
                    "XKB: Could not invoke xkbcomp: not enough memory\n");
+        free(source);
         return NULL;
     }
 
@@ -178,7 +624,10 @@ RunXkbComp(xkbcomp_buffer_callback callback, void *userdata)
 
     if (out != NULL) {
         /* Now write to xkbcomp */
-        (*callback)(out, userdata);
+        if (source)
+            fwrite(source, sourceLen, 1, out);
+        else
+            (*callback)(out, userdata);
 
 #ifndef WIN32
         if (Pclose(out) == 0)
@@ -189,6 +638,7 @@ RunXkbComp(xkbcomp_buffer_callback callback, void *userdata)
             if (xkbDebugFlags)
                 DebugF("[xkb] xkb executes: %s\n", buf);
             free(buf);
+            free(source);
 #ifdef WIN32
             unlink(tmpname);
 #endif
@@ -211,6 +661,7 @@ RunXkbComp(xkbcomp_buffer_callback callback, void *userdata)
 #endif
     }
     free(buf);
+    free(source);
     return NULL;
 }
 
@@ -238,7 +689,8 @@ static Bool
 XkbDDXCompileKeymapByNames(XkbDescPtr xkb,
                            XkbComponentNamesPtr names,
                            unsigned want,
-                           unsigned need, char *nameRtrn, int nameRtrnLen)
+                           unsigned need, char *nameRtrn, int nameRtrnLen,
+                           char *cacheName, size_t cacheNameLen)
 {
     char *keymap;
     Bool rc = FALSE;
@@ -249,7 +701,8 @@ XkbDDXCompileKeymapByNames(XkbDescPtr xkb,
         .need = need
     };
 
-    keymap = RunXkbComp(xkb_write_keymap_for_names_cb, &ctx);
+    keymap = RunXkbComp(xkb_write_keymap_for_names_cb, &ctx,
+                        cacheName, cacheNameLen);
 
     if (keymap) {
         if(nameRtrn)
@@ -284,6 +737,7 @@ XkbDDXLoadKeymapFromString(DeviceIntPtr keybd,
 {
     unsigned int have;
     char *map_name;
+    char cacheName[PATH_MAX];
     XkbKeymapString map = {
         .keymap = keymap,
         .len = keymap_length
@@ -291,13 +745,25 @@ XkbDDXLoadKeymapFromString(DeviceIntPtr keybd,
 
     *xkbRtrn = NULL;
 
-    map_name = RunXkbComp(xkb_write_keymap_string_cb, &map);
+    map_name = RunXkbComp(xkb_write_keymap_string_cb, &map,
+                          cacheName, sizeof(cacheName));
     if (!map_name) {
         LogMessage(X_ERROR, "XKB: Couldn't compile keymap\n");
         return 0;
     }
 
-    have = LoadXKM(want, need, map_name, xkbRtrn);
+    have = LoadXKM(want, need, map_name, cacheName, xkbRtrn);
+    if (*xkbRtrn == NULL && *cacheName && !strcmp(map_name, cacheName)) {
+        /* LoadXKM removed the bad cached keymap, so this compiles it */
+        free(map_name);
+        map_name = RunXkbComp(xkb_write_keymap_string_cb, &map,
+                              cacheName, sizeof(cacheName));
+        if (!map_name) {
+            LogMessage(X_ERROR, "XKB: Couldn't compile keymap\n");
+            return 0;
+        }
+        have = LoadXKM(want, need, map_name, cacheName, xkbRtrn);
+    }
     free(map_name);
 
     return have;
@@ -339,11 +805,16 @@ XkbDDXOpenConfigFile(const char *mapName, char *fileNameRtrn, int fileNameRtrnLe
     return file;
 }
 
+/*
+ * Load the compiled keymap, then delete it unless it is cacheName.  A
+ * keymap compiled by xkbcomp is renamed to cacheName if that is set.
+ */
 static unsigned
-LoadXKM(unsigned want, unsigned need, const char *keymap, XkbDescPtr *xkbRtrn)
+LoadXKM(unsigned want, unsigned need, const char *keymap,
+        const char *cacheName, XkbDescPtr *xkbRtrn)
 {
     FILE *file;
-    char fileName[PATH_MAX];
+    char fileName[PATH_MAX], cacheFileName[PATH_MAX];
     unsigned missing;
 
     file = XkbDDXOpenConfigFile(keymap, fileName, PATH_MAX);
@@ -364,7 +835,23 @@ LoadXKM(unsigned want, unsigned need, const char *keymap, XkbDescPtr *xkbRtrn)
                (*xkbRtrn)->defined);
     }
     fclose(file);
-    (void) unlink(fileName);
+    if (!cacheName || !*cacheName)
+        (void) unlink(fileName);
+    else if (strcmp(keymap, cacheName) != 0) {
+        FILE *cached = XkbDDXOpenConfigFile(cacheName, cacheFileName,
+                                            PATH_MAX);
+
+        if (cached)
+            fclose(cached);
+#ifdef WIN32
+        /* rename() fails on Windows if another server cached it first */
+        (void) unlink(cacheFileName);
+#endif
+        if (!cacheFileName[0] || rename(fileName, cacheFileName) != 0)
+            (void) unlink(fileName);
+        else
+            XkbKeymapCachePrune(cacheFileName);
+    }
     return (need | want) & (~missing);
 }
 
@@ -376,6 +863,8 @@ XkbDDXLoadKeymapByNames(DeviceIntPtr keybd,
                         XkbDescPtr *xkbRtrn, char *nameRtrn, int nameRtrnLen)
 {
     XkbDescPtr xkb;
+    char cacheName[PATH_MAX];
+    unsigned have;
 
     *xkbRtrn = NULL;
     if ((keybd == NULL) || (keybd->key == NULL) ||
@@ -391,12 +880,24 @@ XkbDDXLoadKeymapByNames(DeviceIntPtr keybd,
         return 0;
     }
     else if (!XkbDDXCompileKeymapByNames(xkb, names, want, need,
-                                         nameRtrn, nameRtrnLen)) {
+                                         nameRtrn, nameRtrnLen,
+                                         cacheName, sizeof(cacheName))) {
         LogMessage(X_ERROR, "XKB: Couldn't compile keymap\n");
         return 0;
     }
 
-    return LoadXKM(want, need, nameRtrn, xkbRtrn);
+    have = LoadXKM(want, need, nameRtrn, cacheName, xkbRtrn);
+    if (*xkbRtrn == NULL && *cacheName && !strcmp(nameRtrn, cacheName)) {
+        /* LoadXKM removed the bad cached keymap, so this compiles it */
+        if (!XkbDDXCompileKeymapByNames(xkb, names, want, need,
+                                        nameRtrn, nameRtrnLen,
+                                        cacheName, sizeof(cacheName))) {
+            LogMessage(X_ERROR, "XKB: Couldn't compile keymap\n");
+            return 0;
+        }
+        have = LoadXKM(want, need, nameRtrn, cacheName, xkbRtrn);
+    }
+    return have;
 }
 
 Bool
@@ -90,6 +90,7 @@ typedef struct _SrvXkmInfo {
 
 const char *XkbBaseDirectory = XKB_BASE_DIRECTORY;
 const char *XkbBinDirectory = XKB_BIN_DIRECTORY;
+Bool XkbKeymapCacheEnabled = TRUE;
 static int XkbWantAccessX = 0;
 
 static char *XkbRulesDflt = NULL;
@@ -808,6 +809,10 @@ XkbProcessArguments(int argc, char *argv[], int i)
         }
         return j;
     }
+    if (strcmp(argv[i], "-noxkbcache") == 0) {
+        XkbKeymapCacheEnabled = FALSE;
+        return 1;
+    }
 #ifndef _MSC_VER
     if ((strcmp(argv[i], "-ardelay") == 0) || (strcmp(argv[i], "-ar1") == 0)) { /* -ardelay int */
         if (++i >= argc)
@@ -833,6 +838,7 @@ XkbUseMsg(void)
     ErrorF
         ("[+-]accessx [ timeout [ timeout_mask [ feedback [ options_mask] ] ] ]\n");
     ErrorF("                       enable/disable accessx key sequences\n");
+    ErrorF("-noxkbcache            don't reuse keymaps compiled earlier\n");
 #ifndef _MSC_VER
     ErrorF("-ardelay               set XKB autorepeat delay\n");
     ErrorF("-arinterval            set XKB autorepeat interval\n");
@@ -24,4 +24,7 @@ void XkbMergeLockedPtrBtns(DeviceIntPtr master);
 
 void XkbFakeDeviceButton(DeviceIntPtr dev, int press, int button);
 
+/* Keep compiled keymaps for reuse, see ddxLoad.c */
+extern Bool XkbKeymapCacheEnabled;
+
 #endif /* _XSERVER_XKBSRV_PRIV_H_ */